@@ -0,0 +1,291 @@
+/**
+ *  @file   LArRecoND/benchmarks/InterfaceBenchmarks.cxx
+ *
+ *  @brief  Micro-benchmarks of the voxelisation, geometry and clustering kernels used by the PandoraInterface application
+ *
+ *  $Log: $
+ */
+
+#include "Api/PandoraApi.h"
+#include "Xml/tinyxml.h"
+
+#include "larpandoracontent/LArObjects/LArCaloHit.h"
+#include "larpandoracontent/LArPlugins/LArPseudoLayerPlugin.h"
+#include "larpandoracontent/LArPlugins/LArRotationalTransformationPlugin.h"
+
+#include "LArNDCaloHitFactory.h"
+#include "LArNDContent.h"
+#include "PandoraInterface.h"
+
+#include "LArRecoNDBenchmarks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+using namespace pandora;
+using namespace lar_nd_reco;
+
+namespace
+{
+
+/**
+ *  @brief  Make a modular ND-LAr-like geometry: 7 x 5 modules in x and z, each with two TPCs sharing a central cathode
+ *
+ *  @param  geom to receive the TPCs
+ */
+void MakeBenchmarkGeometry(LArNDGeomSimple &geom)
+{
+    const double moduleWidthX(100.), moduleWidthY(300.), moduleWidthZ(100.);
+    int tpcID(0);
+
+    for (int moduleZ = 0; moduleZ < 5; ++moduleZ)
+    {
+        for (int moduleX = 0; moduleX < 7; ++moduleX)
+        {
+            const double minX(-350. + moduleX * moduleWidthX), minZ(400. + moduleZ * moduleWidthZ);
+            geom.AddTPC(minX, minX + 0.5 * moduleWidthX, -0.5 * moduleWidthY, 0.5 * moduleWidthY, minZ, minZ + moduleWidthZ, tpcID++);
+            geom.AddTPC(minX + 0.5 * moduleWidthX, minX + moduleWidthX, -0.5 * moduleWidthY, 0.5 * moduleWidthY, minZ, minZ + moduleWidthZ,
+                tpcID++);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get a random position inside the surrounding box of a geometry
+ *
+ *  @param  geom the geometry
+ *  @param  generator the random number generator
+ *
+ *  @return the position
+ */
+CartesianVector GetRandomPosition(const LArNDGeomSimple &geom, std::mt19937 &generator)
+{
+    double minX(0.), maxX(0.), minY(0.), maxY(0.), minZ(0.), maxZ(0.);
+    geom.GetSurroundingBox(minX, maxX, minY, maxY, minZ, maxZ);
+
+    std::uniform_real_distribution<float> xDistribution(minX, maxX), yDistribution(minY, maxY), zDistribution(minZ, maxZ);
+    const float x(xDistribution(generator)), y(yDistribution(generator)), z(zDistribution(generator));
+
+    return CartesianVector(x, y, z);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get a random isotropic unit vector
+ *
+ *  @param  generator the random number generator
+ *
+ *  @return the unit vector
+ */
+CartesianVector GetRandomDirection(std::mt19937 &generator)
+{
+    std::uniform_real_distribution<float> cosThetaDistribution(-1.f, 1.f), phiDistribution(0.f, 2.f * M_PI);
+    const float cosTheta(cosThetaDistribution(generator)), phi(phiDistribution(generator));
+    const float sinTheta(std::sqrt(1.f - cosTheta * cosTheta));
+
+    return CartesianVector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Create a pandora instance running only the SimpleClusterCreationThreeD algorithm on the input hit list
+ *
+ *  @return address of the pandora instance
+ */
+std::unique_ptr<Pandora> CreateClusteringPandora()
+{
+    std::unique_ptr<Pandora> pPandora(new Pandora("ClusteringBenchmark"));
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArNDContent::RegisterAlgorithms(*pPandora));
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPandora, new lar_content::LArPseudoLayerPlugin));
+    PANDORA_THROW_RESULT_IF(
+        STATUS_CODE_SUCCESS, !=, PandoraApi::SetLArTransformationPlugin(*pPandora, new lar_content::LArRotationalTransformationPlugin));
+
+    TiXmlDocument xmlDocument;
+    xmlDocument.Parse("<pandora>"
+                      "    <algorithm type = \"LArSimpleClusterCreationThreeD\">"
+                      "        <InputCaloHitListName3D>Input</InputCaloHitListName3D>"
+                      "        <OutputClusterListName3D>ClustersBenchmark</OutputClusterListName3D>"
+                      "    </algorithm>"
+                      "</pandora>");
+
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, xmlDocument.RootElement()));
+
+    return pPandora;
+}
+
+} // namespace
+
+namespace lar_nd_benchmarks
+{
+
+KernelTiming TimeMakeVoxels(const unsigned int size, std::mt19937 &generator)
+{
+    Parameters parameters;
+    parameters.m_useModularGeometry = true;
+
+    LArNDGeomSimple geom;
+    MakeBenchmarkGeometry(geom);
+    const LArGrid grid(MakeVoxelisationGrid(geom, parameters));
+
+    // Steps of up to a few mm, as written by edep-sim, each depositing about 2 MeV/cm
+    std::uniform_real_distribution<float> lengthDistribution(0.05f, 0.5f);
+    std::uniform_int_distribution<int> trackIDDistribution(1, 50);
+    std::vector<LArHitInfo> hitInfoList;
+    hitInfoList.reserve(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const CartesianVector start(GetRandomPosition(geom, generator));
+        const float length(lengthDistribution(generator));
+        const CartesianVector stop(start + GetRandomDirection(generator) * length);
+        hitInfoList.emplace_back(start, stop, 2.e-3f * length, trackIDDistribution(generator), 1.f, 1.f);
+    }
+
+    const auto startTime(std::chrono::steady_clock::now());
+    LArVoxelAccumulator voxelAccumulator;
+
+    for (const LArHitInfo &hitInfo : hitInfoList)
+        MakeVoxels(hitInfo, grid, parameters, geom, voxelAccumulator);
+
+    return KernelTiming(startTime, voxelAccumulator.GetMergedVoxels().GetNVoxels());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+KernelTiming TimeMergeSameVoxels(const unsigned int size, std::mt19937 &generator)
+{
+    const long nUniqueVoxels(std::max(1u, size / 4));
+    std::uniform_int_distribution<long> voxelIDDistribution(0, nUniqueVoxels - 1);
+    std::uniform_int_distribution<int> trackIDDistribution(1, 5);
+    std::uniform_real_distribution<float> energyDistribution(1.e-5f, 1.e-3f);
+    LArVoxelArray voxels;
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const long voxelID(voxelIDDistribution(generator));
+        const float energy(energyDistribution(generator));
+        voxels.AddVoxel(voxelID, energy, trackIDDistribution(generator), 0);
+    }
+
+    const auto startTime(std::chrono::steady_clock::now());
+    const LArVoxelArray mergedVoxels(MergeSameVoxels(voxels));
+
+    return KernelTiming(startTime, mergedVoxels.GetNVoxels());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+KernelTiming TimeGetTPCNumber(const unsigned int size, std::mt19937 &generator)
+{
+    LArNDGeomSimple geom;
+    MakeBenchmarkGeometry(geom);
+
+    std::vector<CartesianVector> positions;
+    positions.reserve(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+        positions.emplace_back(GetRandomPosition(geom, generator));
+
+    const auto startTime(std::chrono::steady_clock::now());
+    std::size_t nInsideTPC(0);
+
+    for (const CartesianVector &position : positions)
+    {
+        if (geom.GetTPCNumber(position) >= 0)
+            ++nInsideTPC;
+    }
+
+    return KernelTiming(startTime, nInsideTPC);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+KernelTiming TimeSimpleClusterCreation(const unsigned int size, std::mt19937 &generator)
+{
+    static const std::unique_ptr<Pandora> pPandora(CreateClusteringPandora());
+
+    // Straight tracks of 200 hits, 0.3 cm apart so that each track is within the default 0.5 cm clustering window
+    const float voxelWidth(0.4f), hitSpacing(0.3f);
+    const unsigned int nHitsPerTrack(200);
+
+    LArNDGeomSimple geom;
+    MakeBenchmarkGeometry(geom);
+
+    lar_content::LArCaloHitFactory caloHitFactory;
+    lar_content::LArCaloHitParameters caloHitParameters(MakeDefaultCaloHitParams(voxelWidth));
+    CartesianVector trackStart(0.f, 0.f, 0.f), trackDirection(0.f, 0.f, 1.f);
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        if (0 == i % nHitsPerTrack)
+        {
+            trackStart = GetRandomPosition(geom, generator);
+            trackDirection = GetRandomDirection(generator);
+        }
+
+        caloHitParameters.m_positionVector = trackStart + trackDirection * (hitSpacing * (i % nHitsPerTrack));
+        caloHitParameters.m_inputEnergy = 1.e-3f;
+        caloHitParameters.m_mipEquivalentEnergy = 1.f;
+        caloHitParameters.m_electromagneticEnergy = 1.e-3f;
+        caloHitParameters.m_hadronicEnergy = 1.e-3f;
+        caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(i + 1));
+        caloHitParameters.m_larTPCVolumeId = std::max(0, geom.GetTPCNumber(caloHitParameters.m_positionVector.Get()));
+        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPandora, caloHitParameters, caloHitFactory));
+    }
+
+    const auto startTime(std::chrono::steady_clock::now());
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPandora));
+    const KernelTiming kernelTiming(startTime, size);
+
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPandora));
+
+    return kernelTiming;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+KernelTiming TimeCaloHitCreation(const unsigned int size, std::mt19937 &generator)
+{
+    // ATTN The factory is declared after the pandora instance, so it is destroyed first, but no hits remain after each reset
+    static const std::unique_ptr<Pandora> pPandora(CreateClusteringPandora());
+    static const LArNDCaloHitFactory caloHitFactory;
+
+    const float voxelWidth(0.4f);
+
+    LArNDGeomSimple geom;
+    MakeBenchmarkGeometry(geom);
+
+    std::vector<CartesianVector> positions;
+    positions.reserve(size);
+
+    for (unsigned int i = 0; i < size; ++i)
+        positions.emplace_back(GetRandomPosition(geom, generator));
+
+    lar_content::LArCaloHitParameters caloHitParameters(MakeDefaultCaloHitParams(voxelWidth));
+    caloHitParameters.m_inputEnergy = 1.e-3f;
+    caloHitParameters.m_mipEquivalentEnergy = 1.f;
+    caloHitParameters.m_electromagneticEnergy = 1.e-3f;
+    caloHitParameters.m_hadronicEnergy = 1.e-3f;
+
+    const auto startTime(std::chrono::steady_clock::now());
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        caloHitParameters.m_positionVector = positions[i];
+        caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(i + 1));
+        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPandora, caloHitParameters, caloHitFactory));
+    }
+
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPandora));
+
+    return KernelTiming(startTime, size);
+}
+
+} // namespace lar_nd_benchmarks
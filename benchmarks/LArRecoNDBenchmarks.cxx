@@ -0,0 +1,258 @@
+/**
+ *  @file   LArRecoND/benchmarks/LArRecoNDBenchmarks.cxx
+ *
+ *  @brief  Implementation of the micro-benchmarks of the LArRecoND hot kernels
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/StatusCodes.h"
+
+#include "LArRecoNDBenchmarks.h"
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <getopt.h>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+using namespace pandora;
+using namespace lar_nd_benchmarks;
+
+namespace
+{
+
+typedef std::function<KernelTiming(const unsigned int, std::mt19937 &)> KernelFunction;
+
+/**
+ *  @brief  Kernel class
+ */
+class Kernel
+{
+public:
+    std::string m_name;              ///< The kernel name
+    KernelFunction m_kernelFunction; ///< The function timing one run of the kernel
+};
+
+typedef std::vector<Kernel> KernelList;
+
+/**
+ *  @brief  Get the list of available kernels
+ *
+ *  @return the kernel list
+ */
+KernelList GetKernels()
+{
+    return KernelList{{"MakeVoxels", TimeMakeVoxels}, {"MergeSameVoxels", TimeMergeSameVoxels}, {"GetTPCNumber", TimeGetTPCNumber},
+        {"SimpleClusterCreationThreeD", TimeSimpleClusterCreation}, {"CaloHitCreation", TimeCaloHitCreation}, {"Chi2PID", TimeChi2PID}};
+}
+
+bool ParseCommandLine(int argc, char *argv[], BenchmarkParameters &parameters);
+bool PrintOptions();
+void RunBenchmarks(const BenchmarkParameters &parameters);
+
+} // namespace
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int main(int argc, char *argv[])
+{
+    int errorNo(0);
+
+    try
+    {
+        BenchmarkParameters parameters;
+
+        if (!ParseCommandLine(argc, argv, parameters))
+            return 1;
+
+        RunBenchmarks(parameters);
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        std::cerr << "Pandora StatusCodeException: " << statusCodeException.ToString() << statusCodeException.GetBackTrace() << std::endl;
+        errorNo = 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception: " << std::endl;
+        errorNo = 1;
+    }
+
+    return errorNo;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_nd_benchmarks
+{
+
+KernelTiming::KernelTiming(const std::chrono::steady_clock::time_point &startTime, const std::size_t nOutput) :
+    m_seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count()),
+    m_nOutput(nOutput)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+BenchmarkParameters::BenchmarkParameters() :
+    m_minSize(1000),
+    m_maxSize(1000000),
+    m_sizeFactor(10),
+    m_nRepeats(5),
+    m_seed(12345),
+    m_outputFileName("LArRecoND_benchmarks.csv")
+{
+}
+
+} // namespace lar_nd_benchmarks
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace
+{
+
+bool ParseCommandLine(int argc, char *argv[], BenchmarkParameters &parameters)
+{
+    int cOpt(0);
+    std::string kernelOption("");
+
+    while ((cOpt = getopt(argc, argv, "k:n:x:f:r:s:o:h")) != -1)
+    {
+        switch (cOpt)
+        {
+            case 'k':
+                kernelOption = optarg;
+                break;
+            case 'n':
+                parameters.m_minSize = std::stoul(optarg);
+                break;
+            case 'x':
+                parameters.m_maxSize = std::stoul(optarg);
+                break;
+            case 'f':
+                parameters.m_sizeFactor = std::stoul(optarg);
+                break;
+            case 'r':
+                parameters.m_nRepeats = std::stoul(optarg);
+                break;
+            case 's':
+                parameters.m_seed = std::stoul(optarg);
+                break;
+            case 'o':
+                parameters.m_outputFileName = optarg;
+                break;
+            case 'h':
+            default:
+                return PrintOptions();
+        }
+    }
+
+    std::istringstream kernelNames(kernelOption);
+    std::string kernelName;
+
+    while (std::getline(kernelNames, kernelName, ','))
+    {
+        const KernelList kernels(GetKernels());
+        const auto hasName([&kernelName](const Kernel &kernel) { return kernel.m_name == kernelName; });
+
+        if (kernels.end() == std::find_if(kernels.begin(), kernels.end(), hasName))
+        {
+            std::cout << "Unknown kernel " << kernelName << std::endl;
+            return PrintOptions();
+        }
+
+        parameters.m_kernelNames.push_back(kernelName);
+    }
+
+    if ((parameters.m_minSize < 1) || (parameters.m_maxSize < parameters.m_minSize) || (parameters.m_sizeFactor < 2) ||
+        (parameters.m_nRepeats < 1))
+    {
+        std::cout << "The sizes must satisfy 1 <= min <= max, with a size factor of at least 2 and at least one repeat" << std::endl;
+        return PrintOptions();
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool PrintOptions()
+{
+    std::cout << std::endl
+              << "./bin/LArRecoND_benchmarks " << std::endl
+              << "    -k Kernels             (optional) [Comma-separated list of MakeVoxels, MergeSameVoxels, GetTPCNumber, "
+              << "SimpleClusterCreationThreeD, CaloHitCreation and Chi2PID (default = all)]" << std::endl
+              << "    -n MinSize             (optional) [Smallest input size, in hits, voxels, positions or calo points (default = 1000)]"
+              << std::endl
+              << "    -x MaxSize             (optional) [Largest input size (default = 1000000)]" << std::endl
+              << "    -f SizeFactor          (optional) [Factor between successive input sizes (default = 10)]" << std::endl
+              << "    -r NRepeats            (optional) [Number of timed runs for each kernel and size (default = 5)]" << std::endl
+              << "    -s Seed                (optional) [Random number seed for the synthetic inputs (default = 12345)]" << std::endl
+              << "    -o OutputFile          (optional) [Comma-separated results file (default = LArRecoND_benchmarks.csv)]" << std::endl
+              << std::endl;
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void RunBenchmarks(const BenchmarkParameters &parameters)
+{
+    std::ofstream outputFile(parameters.m_outputFileName);
+
+    if (!outputFile.is_open())
+    {
+        std::cout << "Unable to create benchmark results file " << parameters.m_outputFileName << std::endl;
+        throw StatusCodeException(STATUS_CODE_FAILURE);
+    }
+
+    outputFile << "kernel,size,repeats,min_s,median_s,mean_s,max_s,min_ns_per_item,output_size" << std::endl;
+    std::cout << std::left << std::setw(30) << "Kernel" << std::right << std::setw(10) << "Size" << std::setw(14) << "Min [s]"
+              << std::setw(14) << "Median [s]" << std::setw(14) << "ns/item" << std::setw(12) << "Output" << std::endl;
+
+    for (const Kernel &kernel : GetKernels())
+    {
+        const std::vector<std::string> &kernelNames(parameters.m_kernelNames);
+
+        if (!kernelNames.empty() && (kernelNames.end() == std::find(kernelNames.begin(), kernelNames.end(), kernel.m_name)))
+            continue;
+
+        for (unsigned long size = parameters.m_minSize; size <= parameters.m_maxSize; size *= parameters.m_sizeFactor)
+        {
+            // Each kernel and size has its own seed, so results can be reproduced for a subset of the kernels or sizes
+            std::mt19937 generator(parameters.m_seed + size);
+            std::vector<double> times;
+            std::size_t nOutput(0);
+
+            for (unsigned int repeat = 0; repeat < parameters.m_nRepeats; ++repeat)
+            {
+                const KernelTiming kernelTiming(kernel.m_kernelFunction(size, generator));
+                times.push_back(kernelTiming.m_seconds);
+                nOutput = kernelTiming.m_nOutput;
+            }
+
+            std::sort(times.begin(), times.end());
+            const std::size_t nTimes(times.size());
+            const double minTime(times.front()), maxTime(times.back());
+            const double medianTime((nTimes % 2) ? times[nTimes / 2] : 0.5 * (times[nTimes / 2 - 1] + times[nTimes / 2]));
+            double meanTime(0.);
+
+            for (const double runTime : times)
+                meanTime += runTime / nTimes;
+
+            const double nsPerItem(1.e9 * minTime / size);
+
+            outputFile << kernel.m_name << "," << size << "," << parameters.m_nRepeats << "," << minTime << "," << medianTime << ","
+                       << meanTime << "," << maxTime << "," << nsPerItem << "," << nOutput << std::endl;
+            std::cout << std::left << std::setw(30) << kernel.m_name << std::right << std::setw(10) << size << std::setw(14) << minTime
+                      << std::setw(14) << medianTime << std::setw(14) << nsPerItem << std::setw(12) << nOutput << std::endl;
+        }
+    }
+
+    std::cout << "Benchmark results written to " << parameters.m_outputFileName << std::endl;
+}
+
+} // namespace
@@ -0,0 +1,120 @@
+/**
+ *  @file   LArRecoND/benchmarks/LArRecoNDBenchmarks.h
+ *
+ *  @brief  Header file for the micro-benchmarks of the LArRecoND hot kernels
+ *
+ *  $Log: $
+ */
+#ifndef LAR_RECO_ND_BENCHMARKS_H
+#define LAR_RECO_ND_BENCHMARKS_H 1
+
+#include <chrono>
+#include <cstddef>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace lar_nd_benchmarks
+{
+
+/**
+ *  @brief  KernelTiming class, holding the time taken by one run of a kernel
+ */
+class KernelTiming
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  startTime the time at which the kernel started, after its input had been prepared
+     *  @param  nOutput the size of the kernel output
+     */
+    KernelTiming(const std::chrono::steady_clock::time_point &startTime, const std::size_t nOutput);
+
+    double m_seconds;      ///< The time taken by the kernel, excluding the preparation of its input, in s
+    std::size_t m_nOutput; ///< The size of the kernel output, which also stops the kernel being optimised away
+};
+
+/**
+ *  @brief  BenchmarkParameters class
+ */
+class BenchmarkParameters
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    BenchmarkParameters();
+
+    std::vector<std::string> m_kernelNames; ///< The names of the kernels to benchmark (default all)
+    unsigned int m_minSize;                 ///< The smallest input size
+    unsigned int m_maxSize;                 ///< The largest input size
+    unsigned int m_sizeFactor;              ///< The factor between successive input sizes
+    unsigned int m_nRepeats;                ///< The number of timed runs for each kernel and size
+    unsigned int m_seed;                    ///< The random number seed for the synthetic inputs
+    std::string m_outputFileName;           ///< The name of the comma-separated results file
+};
+
+/**
+ *  @brief  Time lar_nd_reco::MakeVoxels, voxelising and merging edep-sim-like track segments in a modular ND-LAr-like geometry
+ *
+ *  @param  size the number of track segments
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of voxels made as output
+ */
+KernelTiming TimeMakeVoxels(const unsigned int size, std::mt19937 &generator);
+
+/**
+ *  @brief  Time lar_nd_reco::MergeSameVoxels, merging voxels that share their IDs (about four segment crossings per voxel)
+ *
+ *  @param  size the number of voxels to merge
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of merged voxels as output
+ */
+KernelTiming TimeMergeSameVoxels(const unsigned int size, std::mt19937 &generator);
+
+/**
+ *  @brief  Time lar_nd_reco::LArNDGeomSimple::GetTPCNumber for random positions in a modular ND-LAr-like geometry
+ *
+ *  @param  size the number of positions
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of positions found inside a TPC as output
+ */
+KernelTiming TimeGetTPCNumber(const unsigned int size, std::mt19937 &generator);
+
+/**
+ *  @brief  Time the SimpleClusterCreationThreeD algorithm, clustering 3D hits placed along straight tracks
+ *
+ *  @param  size the number of 3D hits
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of hits as output
+ */
+KernelTiming TimeSimpleClusterCreation(const unsigned int size, std::mt19937 &generator);
+
+/**
+ *  @brief  Time the creation and deletion (via PandoraApi::Reset) of 3D hits made by the pooled lar_nd_reco::LArNDCaloHitFactory
+ *
+ *  @param  size the number of 3D hits
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of hits as output
+ */
+KernelTiming TimeCaloHitCreation(const unsigned int size, std::mt19937 &generator);
+
+/**
+ *  @brief  Time lar_nd_postreco::Chi2PID for muon-like tracks, against synthetic dE/dx vs residual range templates
+ *
+ *  @param  size the total number of track calorimetry points
+ *  @param  generator the random number generator for the synthetic input
+ *
+ *  @return the kernel timing, with the number of identified tracks as output
+ */
+KernelTiming TimeChi2PID(const unsigned int size, std::mt19937 &generator);
+
+} // namespace lar_nd_benchmarks
+
+#endif // #ifndef LAR_RECO_ND_BENCHMARKS_H
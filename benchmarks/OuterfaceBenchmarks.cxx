@@ -0,0 +1,108 @@
+/**
+ *  @file   LArRecoND/benchmarks/OuterfaceBenchmarks.cxx
+ *
+ *  @brief  Micro-benchmarks of the particle identification kernel used by the PandoraOuterface application
+ *
+ *  $Log: $
+ */
+
+#include "TProfile.h"
+
+#include "PandoraOuterface.h"
+
+#include "LArRecoNDBenchmarks.h"
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+
+using namespace lar_nd_postreco;
+
+namespace
+{
+
+/**
+ *  @brief  Make a dE/dx vs residual range template, following a power law in the residual range
+ *
+ *  @param  name the template name
+ *  @param  scale the dE/dx at a residual range of 1 cm, in MeV/cm
+ *  @param  generator the random number generator, smearing the entries so that the template bins have errors
+ *
+ *  @return the template
+ */
+std::unique_ptr<TProfile> MakeTemplate(const std::string &name, const float scale, std::mt19937 &generator)
+{
+    std::unique_ptr<TProfile> pTemplate(new TProfile(("benchmark_dedxrr_" + name).c_str(), name.c_str(), 100, 0., 30.));
+    std::normal_distribution<float> smearing(1.f, 0.05f);
+
+    for (int bin = 1; bin <= pTemplate->GetNbinsX(); ++bin)
+    {
+        const double residualRange(pTemplate->GetBinCenter(bin));
+
+        for (int entry = 0; entry < 20; ++entry)
+            pTemplate->Fill(residualRange, scale * std::pow(residualRange, -0.42) * smearing(generator));
+    }
+
+    return pTemplate;
+}
+
+} // namespace
+
+namespace lar_nd_benchmarks
+{
+
+KernelTiming TimeChi2PID(const unsigned int size, std::mt19937 &generator)
+{
+    // The templates are owned here rather than by the current ROOT directory, so they can be remade for each run
+    TH1::AddDirectory(false);
+
+    std::unique_ptr<TProfile> pProtonTemplate(MakeTemplate("proton", 17.f, generator));
+    std::unique_ptr<TProfile> pKaonTemplate(MakeTemplate("kaon", 14.f, generator));
+    std::unique_ptr<TProfile> pPionTemplate(MakeTemplate("pion", 9.f, generator));
+    std::unique_ptr<TProfile> pMuonTemplate(MakeTemplate("muon", 8.f, generator));
+
+    ParameterStruct parameters;
+    parameters.templatesdEdxRR["proton"] = pProtonTemplate.get();
+    parameters.templatesdEdxRR["kaon"] = pKaonTemplate.get();
+    parameters.templatesdEdxRR["pion"] = pPionTemplate.get();
+    parameters.templatesdEdxRR["muon"] = pMuonTemplate.get();
+
+    // Muon-like tracks of 100 calorimetry points with the 0.4 cm pixel pitch, stopping in the detector
+    const unsigned int nPointsPerTrack(100);
+    const float dx(0.4f);
+    std::normal_distribution<float> smearing(1.f, 0.1f);
+    std::vector<std::vector<float>> trackVecDXs, trackVecDEDXs, trackVecRRs;
+
+    for (unsigned int i = 0; i < size; ++i)
+    {
+        const unsigned int pointIndex(i % nPointsPerTrack);
+
+        if (0 == pointIndex)
+        {
+            const unsigned int nPoints(std::min(nPointsPerTrack, size - i));
+            trackVecDXs.emplace_back(nPoints, dx);
+            trackVecDEDXs.emplace_back();
+            trackVecRRs.emplace_back();
+        }
+
+        const float residualRange(dx * (trackVecDXs.back().size() - pointIndex));
+        trackVecRRs.back().push_back(residualRange);
+        trackVecDEDXs.back().push_back(8.f * std::pow(residualRange, -0.42f) * smearing(generator));
+    }
+
+    const auto startTime(std::chrono::steady_clock::now());
+    std::size_t nIdentified(0);
+
+    for (unsigned int track = 0; track < trackVecDXs.size(); ++track)
+    {
+        int pdg(0), ndf(0);
+        float muScore(0.f), piScore(0.f), kScore(0.f), proScore(0.f);
+
+        if (Chi2PID(parameters, trackVecDXs[track], trackVecDEDXs[track], trackVecRRs[track], pdg, ndf, muScore, piScore, kScore, proScore))
+            ++nIdentified;
+    }
+
+    return KernelTiming(startTime, nIdentified);
+}
+
+} // namespace lar_nd_benchmarks
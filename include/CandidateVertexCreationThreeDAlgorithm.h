@@ -17,6 +17,13 @@
 namespace lar_content
 {
 
+template <typename, unsigned int>
+class KDTreeLinkerAlgo;
+template <typename, unsigned int>
+class KDTreeNodeInfoT;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  CandidateVertexCreationThreeDAlgorithm::Algorithm class
  */
@@ -28,6 +35,11 @@ public:
      */
     CandidateVertexCreationThreeDAlgorithm();
 
+    /**
+     *  @brief  Destructor
+     */
+    ~CandidateVertexCreationThreeDAlgorithm();
+
 private:
     pandora::StatusCode Run();
 
@@ -68,15 +80,82 @@ private:
      */
     void GetSpacepoints(const pandora::Cluster *const pCluster, pandora::CartesianPointVector &spacePoints) const;
 
+    typedef KDTreeLinkerAlgo<unsigned int, 2> PointKDTree2D;
+    typedef KDTreeNodeInfoT<unsigned int, 2> PointKDNode2D;
+    typedef std::vector<PointKDNode2D> PointKDNode2DList;
+
     /**
-     *  @brief  Identify where clusters plausibly cross in 3D
+     *  @brief  ClusterCrossing class, the closest approach between the spacepoints of a pair of clusters
+     */
+    class ClusterCrossing
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        ClusterCrossing();
+
+        bool m_isCrossing;                     ///< Whether the clusters plausibly cross
+        pandora::CartesianVector m_position1A; ///< Crossing position on cluster 1, as found when scanning cluster 1 first
+        pandora::CartesianVector m_position2A; ///< Crossing position on cluster 2, as found when scanning cluster 1 first
+        pandora::CartesianVector m_position1B; ///< Crossing position on cluster 1, as found when scanning cluster 2 first
+        pandora::CartesianVector m_position2B; ///< Crossing position on cluster 2, as found when scanning cluster 2 first
+    };
+
+    /**
+     *  @brief  Identify where a pair of clusters plausibly cross in 3D
      *
      *  @param  spacepoints1 space points for cluster 1
      *  @param  spacepoints2 space points for cluster 2
-     *  @param  crossingPoints to receive the list of plausible 3D crossing points
+     *  @param  kdTree2 kd tree of the space points for cluster 2, holding indices into spacepoints2
+     *  @param  clusterCrossing to receive the closest approach, resolving ties as the full pairwise scan in either cluster order would
      */
     void FindCrossingPoints(const pandora::CartesianPointVector &spacepoints1, const pandora::CartesianPointVector &spacepoints2,
-        pandora::CartesianPointVector &crossingPoints) const;
+        PointKDTree2D &kdTree2, ClusterCrossing &clusterCrossing) const;
+
+    typedef std::unordered_map<long long, pandora::CartesianPointVector> CrossingPointGrid;
+
+    /**
+     *  @brief  Get the crossing point grid cell containing a position
+     *
+     *  @param  position the position
+     *  @param  ix to receive the cell index in x
+     *  @param  iy to receive the cell index in y
+     *  @param  iz to receive the cell index in z
+     */
+    void GetCrossingGridCell(const pandora::CartesianVector &position, int &ix, int &iy, int &iz) const;
+
+    /**
+     *  @brief  Get the key of a crossing point grid cell
+     *
+     *  @param  ix the cell index in x
+     *  @param  iy the cell index in y
+     *  @param  iz the cell index in z
+     *
+     *  @return the grid cell key
+     */
+    long long GetCrossingGridKey(const int ix, const int iy, const int iz) const;
+
+    /**
+     *  @brief  Add a pair of crossing positions, unless either lies close to an existing crossing point
+     *
+     *  @param  position1 the crossing position on the first cluster
+     *  @param  position2 the crossing position on the second cluster
+     *  @param  crossingPointGrid the spatial hash of existing crossing points
+     *  @param  crossingPoints the list of crossing points
+     */
+    void AddCrossingPoints(const pandora::CartesianVector &position1, const pandora::CartesianVector &position2,
+        CrossingPointGrid &crossingPointGrid, pandora::CartesianPointVector &crossingPoints) const;
+
+    /**
+     *  @brief  Whether a position lies close to an existing crossing point
+     *
+     *  @param  position the position
+     *  @param  crossingPointGrid the spatial hash of existing crossing points
+     *
+     *  @return whether there is a nearby crossing point
+     */
+    bool IsNearbyCrossingPoint(const pandora::CartesianVector &position, const CrossingPointGrid &crossingPointGrid) const;
 
     /**
      *  @brief  Attempt to create candidate vertex positions, using 3D crossing points
@@ -92,7 +171,7 @@ private:
     void AddInputVertices() const;
 
     /**
-     *  @brief  Creates a 2D sliding fit of a cluster and stores it for later use
+     *  @brief  Gets the 3D sliding fit of a cluster from the shared sliding fit cache and stores it for later use
      *
      *  @param  pCluster address of the relevant cluster
      */
@@ -112,17 +191,22 @@ private:
      */
     void TidyUp();
 
-    pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
+    /**
+     *  @brief  Clear the shared sliding fit cache at the end of each event
+     */
+    pandora::StatusCode Reset();
 
-    typedef std::unordered_map<const pandora::Cluster *, pandora::CartesianPointVector> ClusterToSpacepointsMap;
+    pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     std::string m_inputClusterListName; ///< The list of cluster list name
     std::string m_inputVertexListName;  ///< The list name for existing candidate vertices
     std::string m_outputVertexListName; ///< The name under which to save the output vertex list
     bool m_replaceCurrentVertexList;    ///< Whether to replace the current vertex list with the output list
 
-    unsigned int m_slidingFitWindow;                 ///< The layer window for the sliding linear fits
-    ThreeDSlidingFitResultMap m_slidingFitResultMap; ///< The sliding fit result map
+    typedef std::unordered_map<const pandora::Cluster *, const ThreeDSlidingFitResult *> ClusterToSlidingFitMap;
+
+    unsigned int m_slidingFitWindow;              ///< The layer window for the sliding linear fits
+    ClusterToSlidingFitMap m_slidingFitResultMap; ///< The sliding fit results used this event, owned by the shared sliding fit cache
 
     unsigned int m_minClusterCaloHits; ///< The min number of hits in base cluster selection method
     float m_minClusterLengthSquared;   ///< The min length (squared) in base cluster selection method
@@ -12,6 +12,7 @@
 #include "Pandora/Algorithm.h"
 
 #include <unordered_map>
+#include <vector>
 
 namespace lar_content
 {
@@ -30,27 +31,47 @@ public:
 private:
     pandora::StatusCode Run();
 
+    typedef std::pair<int, int> QuantizedPosition;
+
+    /**
+     *  @brief  SpatialHitEntry class, one entry of the flat spatial map of 2D hits
+     */
+    class SpatialHitEntry
+    {
+    public:
+        QuantizedPosition m_position;       ///< The quantized (x, wire) position of the hit
+        const pandora::CaloHit *m_pCaloHit; ///< The 2D hit
+        bool m_isUsed;                      ///< Whether the hit has already been added to a 2D cluster
+    };
+
     typedef std::unordered_map<const pandora::CaloHit *, pandora::CaloHitList> HitAssociationMap;
-    typedef std::unordered_map<const pandora::CaloHit *, bool> HitUsedMap;
-    typedef std::map<std::pair<int, int>, const pandora::CaloHit *> SpatialHitMap;
+    typedef std::vector<SpatialHitEntry> SpatialHitMap;
+
+    /**
+     *  @brief Fill a flat spatial map of the available 2D hits in a view, sorted by quantized position for binary search
+     *
+     *  @param caloHitList the 2D hit list for the view
+     *  @param hitMap the spatial map of 2D hits to be filled
+     */
+    void FillSpatialHitMap(const pandora::CaloHitList &caloHitList, SpatialHitMap &hitMap) const;
 
     /**
      *  @brief Get the hits in each view matching to the clustered 3D hits
      *
      *  @param pCaloHit3D a pointer to the 3D hit
-     *  @param hitMap a spatial map of 2D hits
+     *  @param hitMap a spatial map of 2D hits, in which matched hits are flagged as used
      *  @param associatedHits reference to empty hit list to be filled with 2D hits
-     *  @param usedHits2D list of already used 2D hits
      *  @param hitType the type of hits in the hit list
      */
-    void GetAssociatedTwoDHit(const pandora::CaloHit *const pCaloHit3D, const SpatialHitMap &hitMap, pandora::CaloHitList &associatedHits,
-        HitUsedMap &usedHits2D, const pandora::HitType &hitType) const;
+    void GetAssociatedTwoDHit(const pandora::CaloHit *const pCaloHit3D, SpatialHitMap &hitMap, pandora::CaloHitList &associatedHits,
+        const pandora::HitType &hitType) const;
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     std::vector<std::string> m_inputCaloHitListNames2D; ///< Names of the input 2D hit lists
     std::string m_inputClusterListName3D;               ///< Name of the input 3D cluster list
     std::vector<std::string> m_outputClusterListNames;  ///< Names of the output 2D cluster lists
+    bool m_printTimings;                                ///< Whether to print the time spent building and querying the spatial hit maps
 };
 
 } // namespace lar_content
@@ -24,6 +24,11 @@ public:
      */
     CutClusterCharacterisationThreeDAlgorithm();
 
+    /**
+     *  @brief  Destructor
+     */
+    ~CutClusterCharacterisationThreeDAlgorithm();
+
 private:
     /**
      *  @brief  Whether cluster is identified as a clear track
@@ -34,6 +39,11 @@ private:
      */
     virtual bool IsClearTrack(const pandora::Cluster *const pCluster) const;
 
+    /**
+     *  @brief  Clear the shared sliding fit cache at the end of each event
+     */
+    pandora::StatusCode Reset();
+
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
     unsigned int m_slidingFitWindow; ///< The layer window for the sliding linear fits
@@ -43,6 +43,11 @@ public:
      */
     EventSlicingThreeDTool();
 
+    /**
+     *  @brief  Destructor
+     */
+    ~EventSlicingThreeDTool();
+
     /**
      *  @brief  Run the 3D slicing tool
      *
@@ -55,6 +60,11 @@ public:
         const HitTypeToNameMap &clusterListNames, Slice3DList &sliceList);
 
 private:
+    /**
+     *  @brief  Clear the shared sliding fit cache at the end of each event
+     */
+    pandora::StatusCode Reset();
+
     /**
      *  @brief  Copy all the input hits in an event into a single slice
      *
@@ -79,6 +89,7 @@ private:
         ClusterToPfoMap &clusterToPfoMap) const;
 
     typedef std::vector<pandora::ClusterVector> ClusterSliceList;
+    typedef std::unordered_map<const pandora::Cluster *, const ThreeDSlidingFitResult *> ClusterToSlidingFitMap;
 
     /**
      *  @brief  Divide the provided lists of 3D track and shower clusters into slices
@@ -95,13 +106,13 @@ private:
      *
      *  @param  pClusterInSlice the address of the cluster already in a slice
      *  @param  candidateClusters the list of candidate clusters
-     *  @param  trackFitResults the map of sliding fit results for track candidate clusters
+     *  @param  trackFitResults the map to the shared sliding fit results for track candidate clusters
      *  @param  showerConeFitResults the map of sliding const fit results for shower candidate clusters
      *  @param  clusterSlice the cluster slice
      *  @param  usedClusters the list of clusters already added to slices
      */
     void CollectAssociatedClusters(const pandora::Cluster *const pClusterInSlice, const pandora::ClusterVector &candidateClusters,
-        const ThreeDSlidingFitResultMap &trackFitResults, const ThreeDSlidingConeFitResultMap &showerConeFitResults,
+        const ClusterToSlidingFitMap &trackFitResults, const ThreeDSlidingConeFitResultMap &showerConeFitResults,
         pandora::ClusterVector &clusterSlice, pandora::ClusterSet &usedClusters) const;
 
     /**
@@ -109,22 +120,26 @@ private:
      *
      *  @param  pClusterInSlice address of a cluster already in the slice
      *  @param  pCandidateCluster address of the candidate cluster
-     *  @param  trackFitResults the map of sliding fit results for track candidate clusters
+     *  @param  trackFitResults the map to the shared sliding fit results for track candidate clusters
      *
      *  @return whether an addition to the cluster slice should be made
      */
     bool PassPointing(const pandora::Cluster *const pClusterInSlice, const pandora::Cluster *const pCandidateCluster,
-        const ThreeDSlidingFitResultMap &trackFitResults) const;
+        const ClusterToSlidingFitMap &trackFitResults) const;
+
+    typedef KDTreeLinkerAlgo<const pandora::CaloHit *, 2> HitKDTree2D;
+    typedef KDTreeNodeInfoT<const pandora::CaloHit *, 2> HitKDNode2D;
+    typedef std::vector<HitKDNode2D> HitKDNode2DList;
 
     /**
-     *  @brief  Compare the provided clusters to assess whether they are associated via pointing
+     *  @brief  Compare the provided clusters to assess whether they are associated via proximity
      *
-     *  @param  pClusterInSlice address of a cluster already in the slice
+     *  @param  clusterInSliceKDTree kd tree holding the hits of the cluster already in the slice
      *  @param  pCandidateCluster address of the candidate cluster
      *
      *  @return whether an addition to the cluster slice should be made
      */
-    bool PassProximity(const pandora::Cluster *const pClusterInSlice, const pandora::Cluster *const pCandidateCluster) const;
+    bool PassProximity(HitKDTree2D &clusterInSliceKDTree, const pandora::Cluster *const pCandidateCluster) const;
 
     /**
      *  @brief  Compare the provided clusters to assess whether they are associated via cone fits to the shower cluster (single "direction" check)
@@ -233,12 +248,27 @@ private:
     void AssignRemainingHitsToSlices(
         const pandora::ClusterList &remainingClusters, const ClusterToSliceIndexMap &clusterToSliceIndexMap, Slice3DList &sliceList) const;
 
-    typedef KDTreeLinkerAlgo<const pandora::CartesianVector *, 2> PointKDTree2D;
-    typedef KDTreeNodeInfoT<const pandora::CartesianVector *, 2> PointKDNode2D;
+    typedef KDTreeLinkerAlgo<unsigned int, 2> PointKDTree2D;
+    typedef KDTreeNodeInfoT<unsigned int, 2> PointKDNode2D;
     typedef std::vector<PointKDNode2D> PointKDNode2DList;
 
-    typedef std::list<const pandora::CartesianVector *> PointList;
-    typedef std::unordered_map<const pandora::CartesianVector *, unsigned int> PointToSliceIndexMap;
+    /**
+     *  @brief  SlicePoints class, contiguous storage of the points in a view with the parallel indices of their slices
+     */
+    class SlicePoints
+    {
+    public:
+        /**
+         *  @brief  Add a point
+         *
+         *  @param  point the point
+         *  @param  sliceIndex the index of the slice containing the point
+         */
+        void AddPoint(const pandora::CartesianVector &point, const unsigned int sliceIndex);
+
+        pandora::CartesianPointVector m_points; ///< The points
+        pandora::UIntVector m_sliceIndices;     ///< The slice index for each point
+    };
 
     /**
      *  @brief  Use projections of 3D hits already assigned to slices to populate kd trees to aid assignment of remaining clusters
@@ -247,10 +277,8 @@ private:
      *  @param  pointsU to receive the points in the u view
      *  @param  pointsV to receive the points in the v view
      *  @param  pointsW to receive the points in the w view
-     *  @param  pointToSliceIndexMap to receive the mapping from points to slice index
      */
-    void GetKDTreeEntries2D(const Slice3DList &sliceList, PointList &pointsU, PointList &pointsV, PointList &pointsW,
-        PointToSliceIndexMap &pointToSliceIndexMap) const;
+    void GetKDTreeEntries2D(const Slice3DList &sliceList, SlicePoints &pointsU, SlicePoints &pointsV, SlicePoints &pointsW) const;
 
     /**
      *  @brief  Use 2D hits already assigned to slices to populate kd trees to aid assignment of remaining clusters
@@ -259,10 +287,17 @@ private:
      *  @param  pointsU to receive the points in the u view
      *  @param  pointsV to receive the points in the v view
      *  @param  pointsW to receive the points in the w view
-     *  @param  pointToSliceIndexMap to receive the mapping from points to slice index
      */
-    void GetKDTreeEntries3D(const ClusterToSliceIndexMap &clusterToSliceIndexMap, PointList &pointsU, PointList &pointsV,
-        PointList &pointsW, PointToSliceIndexMap &pointToSliceIndexMap) const;
+    void GetKDTreeEntries3D(const ClusterToSliceIndexMap &clusterToSliceIndexMap, SlicePoints &pointsU, SlicePoints &pointsV, SlicePoints &pointsW) const;
+
+    /**
+     *  @brief  Build a kd tree over the points in a view, with nodes holding indices into the point storage
+     *
+     *  @param  slicePoints the points in the view
+     *  @param  kDNode2DList to receive the kd tree nodes
+     *  @param  kdTree the kd tree to build
+     */
+    void BuildKDTree(const SlicePoints &slicePoints, PointKDNode2DList &kDNode2DList, PointKDTree2D &kdTree) const;
 
     /**
      *  @brief  Use the provided kd tree to efficiently identify the most appropriate slice for the provided 2D cluster
@@ -277,12 +312,12 @@ private:
     /**
      *  @brief  Sort points (use Z, followed by X, followed by Y)
      *
-     *  @param  pLhs address of first point
-     *  @param  pRhs address of second point
+     *  @param  lhs the first point
+     *  @param  rhs the second point
      *
      *  @return whether the points could be sorted
      */
-    static bool SortPoints(const pandora::CartesianVector *const pLhs, const pandora::CartesianVector *const pRhs);
+    static bool SortPoints(const pandora::CartesianVector &lhs, const pandora::CartesianVector &rhs);
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
 
@@ -11,22 +11,29 @@
 #include "Objects/CartesianVector.h"
 #include "Objects/Cluster.h"
 #include "Objects/ParticleFlowObject.h"
-#include "Pandora/Algorithm.h"
+#include "Pandora/ExternallyConfiguredAlgorithm.h"
 
 #include "larpandoracontent/LArHelpers/LArHierarchyHelper.h"
 
-class TFile;
-class TTree;
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class TChain;
 
 namespace lar_content
 {
 
-typedef std::map<long, long> MCIdUniqueLocalMap;
+class AnalysisTreeWriter;
+
+typedef std::unordered_map<long, long> MCIdUniqueLocalMap;
 
 /**
  *  @brief  HierarchyAnalysisAlgorithm class
  */
-class HierarchyAnalysisAlgorithm : public pandora::Algorithm
+class HierarchyAnalysisAlgorithm : public pandora::ExternallyConfiguredAlgorithm
 {
 public:
     /**
@@ -36,6 +43,22 @@ public:
 
     virtual ~HierarchyAnalysisAlgorithm();
 
+    /**
+     *  @brief  External instance parameters, used when several primary pandora instances share the input events
+     */
+    class ExternalInstanceParameters : public pandora::ExternalParameters
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        ExternalInstanceParameters();
+
+        const pandora::IntVector *m_pInputEvents; ///< The input events passed to this instance so far, current event last (not owned)
+        std::string m_analysisFileName;           ///< The analysis ROOT file to write for this instance (overrides the settings file)
+        pandora::StringVector m_eventFileNames;   ///< The input event files, in the order they are read (overrides the settings file)
+    };
+
     /**
      *  @brief  RecoMCMatch class
      */
@@ -61,6 +84,111 @@ public:
         float m_purity;                          ///< The purity of the match
     };
 
+    /**
+     *  @brief  HitMatchIndex class, mapping the hits in an event to the MC and reco hierarchy nodes used for the matching
+     */
+    class HitMatchIndex
+    {
+    public:
+        /**
+         *  @brief  Constructor, filling the maps once per event
+         *
+         *  @param  matchInfo The object storing all of the MC match hierarchy
+         *  @param  rootMCParticles The root MC particles
+         */
+        HitMatchIndex(const LArHierarchyHelper::MatchInfo &matchInfo, const pandora::MCParticleList &rootMCParticles);
+
+        typedef std::pair<const pandora::MCParticle *, const LArHierarchyHelper::MCMatches *> RootMatch;
+        typedef std::vector<RootMatch> RootMatchVector;
+        typedef std::unordered_map<const pandora::CaloHit *, const LArHierarchyHelper::MCHierarchy::Node *> HitToMCNodeMap;
+        typedef std::unordered_map<const pandora::CaloHit *, const LArHierarchyHelper::RecoHierarchy::Node *> HitToRecoNodeMap;
+        typedef std::unordered_map<const LArHierarchyHelper::RecoHierarchy::Node *, RootMatchVector> RecoNodeToMatchesMap;
+
+        HitToMCNodeMap m_hitToMCNodeMap;             ///< The map from each MC node hit to its MC node
+        HitToRecoNodeMap m_hitToRecoNodeMap;         ///< The map from each selected reco hit (with a corresponding MC hit) to its reco node
+        RecoNodeToMatchesMap m_recoNodeToMatchesMap; ///< The (root MC particle, match) pairs containing each reco node, in match order
+    };
+
+    /**
+     *  @brief  AnalysisOutput class, holding the analysis tree branch buffers, which are reused from one event to the next.
+     *          The 3D hit buffers have one entry per hit of each PFO, following the order PFO1[n3DHits1], PFO2[n3DHits2] etc.
+     */
+    class AnalysisOutput
+    {
+    public:
+        /**
+         *  @brief  Clear all of the buffers, keeping their capacity
+         */
+        void Clear();
+
+        pandora::IntVector m_sliceId;          ///< The slice id, per PFO
+        pandora::FloatVector m_nuVtxX;         ///< The reco neutrino vertex x, per PFO
+        pandora::FloatVector m_nuVtxY;         ///< The reco neutrino vertex y, per PFO
+        pandora::FloatVector m_nuVtxZ;         ///< The reco neutrino vertex z, per PFO
+        pandora::IntVector m_clusterId;        ///< The cluster id within the slice, per PFO
+        pandora::IntVector m_n3DHits;          ///< The number of 3D hits, per PFO
+        pandora::IntVector m_nUHits;           ///< The number of U view hits, per PFO
+        pandora::IntVector m_nVHits;           ///< The number of V view hits, per PFO
+        pandora::IntVector m_nWHits;           ///< The number of W view hits, per PFO
+        pandora::IntVector m_isShower;         ///< Whether the cluster is shower-like, per PFO
+        pandora::FloatVector m_trackScore;     ///< The track score, per PFO
+        pandora::IntVector m_recoPDG;          ///< The reco PDG hypothesis, per PFO
+        pandora::IntVector m_isRecoPrimary;    ///< Whether the PFO is a reco primary, per PFO
+        pandora::FloatVector m_startX;         ///< The cluster start x, per PFO
+        pandora::FloatVector m_startY;         ///< The cluster start y, per PFO
+        pandora::FloatVector m_startZ;         ///< The cluster start z, per PFO
+        pandora::FloatVector m_endX;           ///< The cluster end x, per PFO
+        pandora::FloatVector m_endY;           ///< The cluster end y, per PFO
+        pandora::FloatVector m_endZ;           ///< The cluster end z, per PFO
+        pandora::FloatVector m_dirX;           ///< The cluster direction x, per PFO
+        pandora::FloatVector m_dirY;           ///< The cluster direction y, per PFO
+        pandora::FloatVector m_dirZ;           ///< The cluster direction z, per PFO
+        pandora::FloatVector m_centroidX;      ///< The cluster centroid x, per PFO
+        pandora::FloatVector m_centroidY;      ///< The cluster centroid y, per PFO
+        pandora::FloatVector m_centroidZ;      ///< The cluster centroid z, per PFO
+        pandora::FloatVector m_length1;        ///< The PCA primary axis length, per PFO
+        pandora::FloatVector m_length2;        ///< The PCA secondary axis length, per PFO
+        pandora::FloatVector m_length3;        ///< The PCA tertiary axis length, per PFO
+        pandora::FloatVector m_energy;         ///< The total cluster hit energy, per PFO
+        pandora::IntVector m_recoHitId;        ///< The 3D hit id, per 3D hit
+        pandora::IntVector m_recoHitSliceId;   ///< The 3D hit slice id, per 3D hit
+        pandora::IntVector m_recoHitClusterId; ///< The 3D hit cluster id, per 3D hit
+        pandora::FloatVector m_recoHitX;       ///< The 3D hit x, per 3D hit
+        pandora::FloatVector m_recoHitY;       ///< The 3D hit y, per 3D hit
+        pandora::FloatVector m_recoHitZ;       ///< The 3D hit z, per 3D hit
+        pandora::FloatVector m_recoHitE;       ///< The 3D hit energy, per 3D hit
+        pandora::IntVector m_gotMatch;         ///< Whether an MC match was found, per PFO
+        pandora::IntVector m_mcPDG;            ///< The matched MC PDG code, per PFO
+        std::vector<long> m_mcId;              ///< The matched MC unique id, per PFO
+        std::vector<long> m_mcLocalId;         ///< The matched MC local id, per PFO
+        pandora::IntVector m_isPrimary;        ///< Whether the matched MC particle is primary, per PFO
+        pandora::IntVector m_nSharedHits;      ///< The number of shared hits, per PFO
+        pandora::FloatVector m_completeness;   ///< The match completeness, per PFO
+        pandora::FloatVector m_purity;         ///< The match purity, per PFO
+        pandora::FloatVector m_mcEnergy;       ///< The matched MC energy, per PFO
+        pandora::FloatVector m_mcPx;           ///< The matched MC momentum x, per PFO
+        pandora::FloatVector m_mcPy;           ///< The matched MC momentum y, per PFO
+        pandora::FloatVector m_mcPz;           ///< The matched MC momentum z, per PFO
+        pandora::FloatVector m_mcVtxX;         ///< The matched MC vertex x, per PFO
+        pandora::FloatVector m_mcVtxY;         ///< The matched MC vertex y, per PFO
+        pandora::FloatVector m_mcVtxZ;         ///< The matched MC vertex z, per PFO
+        pandora::FloatVector m_mcEndX;         ///< The matched MC end x, per PFO
+        pandora::FloatVector m_mcEndY;         ///< The matched MC end y, per PFO
+        pandora::FloatVector m_mcEndZ;         ///< The matched MC end z, per PFO
+        pandora::IntVector m_mcNuPDG;          ///< The MC neutrino PDG code, per PFO
+        std::vector<long> m_mcNuId;            ///< The MC neutrino (vertex) id, per PFO
+        pandora::IntVector m_mcNuCode;         ///< The MC neutrino Nuance code, per PFO
+        pandora::FloatVector m_mcNuVtxX;       ///< The MC neutrino vertex x, per PFO
+        pandora::FloatVector m_mcNuVtxY;       ///< The MC neutrino vertex y, per PFO
+        pandora::FloatVector m_mcNuVtxZ;       ///< The MC neutrino vertex z, per PFO
+        pandora::FloatVector m_mcNuE;          ///< The MC neutrino energy, per PFO
+        pandora::FloatVector m_mcNuPx;         ///< The MC neutrino momentum x, per PFO
+        pandora::FloatVector m_mcNuPy;         ///< The MC neutrino momentum y, per PFO
+        pandora::FloatVector m_mcNuPz;         ///< The MC neutrino momentum z, per PFO
+        pandora::IntVector m_mcParentPDG;      ///< The matched MC parent PDG code, per PFO
+        std::vector<long> m_mcParentId;        ///< The matched MC parent unique id, per PFO
+    };
+
 private:
     pandora::StatusCode Run();
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
@@ -71,12 +199,30 @@ private:
      */
     void SetEventRunMCIdInfo();
 
+    /**
+     *  @brief  Open the chain of event trees, binding the event info leaves to their buffers
+     *
+     *  @param  eventFileNames the names of the event files, or empty to use the (possibly glob) event file name from the settings
+     */
+    void OpenEventChain(const pandora::StringVector &eventFileNames);
+
+    /**
+     *  @brief  Index the event tree entries processed by a sole primary instance, reading only the number of hits for each entry.
+     *          Entries with too few hits are skipped by PandoraInterface, so the n-th call to Run() uses the n-th indexed entry
+     */
+    void FillEventEntryIndex();
+
     /**
      *  @brief  Create the analysis output using hierarchy tools
      *
      *  @param  matchInfo The object containing the reco and MC hierarchies
      */
-    void EventAnalysisOutput(const LArHierarchyHelper::MatchInfo &matchInfo) const;
+    void EventAnalysisOutput(const LArHierarchyHelper::MatchInfo &matchInfo);
+
+    /**
+     *  @brief  Create the analysis tree writer, binding the event info and PFO branch buffers to the analysis tree branches
+     */
+    pandora::StatusCode CreateAnalysisTreeWriter();
 
     /**
      *  @brief  Get the required cluster from the PFO
@@ -93,13 +239,14 @@ private:
      *
      *  @param  pPfo The PFO pointer
      *  @param  pRecoNode The reco node
-     *  @param  matchInfo The object storing all of the MC match hierarchy
-     *  @param  rootMCParticles The root MC particles
+     *  @param  hitMatchIndex The hit to MC and reco node maps for the event
      *
      *  @return A summary of the match info
      */
     const RecoMCMatch GetRecoMCMatch(const pandora::ParticleFlowObject *pPfo, const LArHierarchyHelper::RecoHierarchy::Node *pRecoNode,
-        const LArHierarchyHelper::MatchInfo &matchInfo, pandora::MCParticleList &rootMCParticles) const;
+        const HitMatchIndex &hitMatchIndex) const;
+
+    typedef std::vector<long long> EventEntryVector;
 
     int m_count;                        ///< The number of times the Run() function has been called
     int m_event;                        ///< The actual event number
@@ -111,9 +258,13 @@ private:
     int m_endTime;                      ///< The event trigger end time (ticks = 0.1 usec)
     int m_triggers;                     ///< The event trigger flag
     int m_nhits;                        ///< The event number of hits.
+    float m_voxelWidth;                 ///< The voxel width used to make the input hits, which is larger for oversized events (cm)
+    int m_timeBudgetExceeded;           ///< Whether optional stages were skipped because the event exceeded its time budget
+    std::string m_inputFileName;        ///< The input file containing the event (empty without an event file)
+    int m_inputFileEntry;               ///< The entry of the event in its input file (-1 without an event file)
     std::vector<long> *m_mcIDs;         ///< The vector of unique MC particle IDs for the event
     std::vector<long> *m_mcLocalIDs;    ///< The vector of local MC particle IDs for the event
-    std::string m_eventFileName;        ///< Name of the ROOT TFile containing the event numbers
+    std::string m_eventFileName;        ///< Name of the ROOT TFile(s) containing the event numbers, which may be a glob
     std::string m_eventTreeName;        ///< Name of the ROOT TTree containing the event numbers
     std::string m_eventLeafName;        ///< Name of the event number leaf/variable
     std::string m_runLeafName;          ///< Name of the run number leaf/variable
@@ -128,13 +279,15 @@ private:
     std::string m_mcLocalIdLeafName;    ///< Name of the local MC particle ID leaf/variable
     int m_eventsToSkip;                 ///< The number of events to skip (from the start of the event file)
     int m_minHitsToSkip;                ///< The number of events where PandoraInterface is being told to skip the event
-    TFile *m_eventFile;                 ///< The ROOT event file pointer
-    TTree *m_eventTree;                 ///< The ROOT event tree pointer
+    TChain *m_eventChain;               ///< The ROOT chain of event trees, which owns their files
+    EventEntryVector m_eventEntries;    ///< The event tree entries for the events reconstructed by a sole instance, in order
     std::string m_caloHitListName;      ///< Name of input calo hit list
     std::string m_pfoListName;          ///< Name of input PFO list
     float m_minTrackScore;              ///< Minimum track score to call a PFO a track
     std::string m_analysisFileName;     ///< The name of the analysis ROOT file to write
     std::string m_analysisTreeName;     ///< The name of the analysis ROOT tree to write
+    int m_analysisCompression;          ///< The analysis ROOT file compression settings (algorithm * 100 + level, negative for default)
+    int m_analysisBasketSize;           ///< The analysis tree basket size for each branch, in bytes
     bool m_foldToPrimaries;             ///< Whether or not to fold the hierarchy back to primary particles
     bool m_foldToLeadingShowers;        ///< Whether or not to fold the hierarchy back to leading shower particles
     bool m_foldDynamic;                 ///< Whether or not to fold the hierarchy dynamically
@@ -148,6 +301,10 @@ private:
     bool m_storeClusterRecoHits;        ///< Whether to store all of the hits for each reconstructed PFO cluster
     bool m_gotMCEventInput;             ///< Boolean to specify if the input event file corresponds to MC
     MCIdUniqueLocalMap m_mcIdMap;       ///< The map of unique-local MCParticle Ids for the given event
+
+    const pandora::IntVector *m_pInputEvents;                   ///< The input events passed to this instance, if shared (not owned)
+    std::unique_ptr<AnalysisTreeWriter> m_pAnalysisTreeWriter; ///< The analysis tree writer, owning the output file and tree
+    AnalysisOutput m_analysisOutput;                            ///< The analysis tree PFO branch buffers
 };
 
 } // namespace lar_content
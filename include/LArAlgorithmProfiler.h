@@ -0,0 +1,217 @@
+/**
+ *  @file   include/LArAlgorithmProfiler.h
+ *
+ *  @brief  Header file for the algorithm profiler class.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_ALGORITHM_PROFILER_H
+#define LAR_ALGORITHM_PROFILER_H 1
+
+#include "Pandora/StatusCodes.h"
+
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pandora
+{
+class Pandora;
+class TiXmlDocument;
+class TiXmlElement;
+} // namespace pandora
+
+namespace lar_content
+{
+
+/**
+ *  @brief  AlgorithmProfiler class, recording the wall time, cpu time, peak memory growth and current list sizes for each top-level
+ *          algorithm in every pandora instance. Profiling checkpoint algorithms are inserted around the algorithms in the settings,
+ *          and each checkpoint attributes everything since the previous checkpoint (including daughter algorithms and tools) to
+ *          the algorithm it follows.
+ */
+class AlgorithmProfiler
+{
+public:
+    /**
+     *  @brief  ListSizes class
+     */
+    class ListSizes
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        ListSizes();
+
+        unsigned int m_nCaloHits;  ///< The number of hits in the current calo hit list
+        unsigned int m_nClusters;  ///< The number of clusters in the current cluster list
+        unsigned int m_nPfos;      ///< The number of pfos in the current pfo list
+        unsigned int m_nVertices;  ///< The number of vertices in the current vertex list
+    };
+
+    /**
+     *  @brief  InstanceProfile class, holding the previous checkpoint of a pandora instance and its records not yet written. It is
+     *          only used by the thread processing the instance, so is updated without locking.
+     */
+    class InstanceProfile
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  instanceName the instance name
+         */
+        InstanceProfile(const std::string &instanceName);
+
+        /**
+         *  @brief  Record class, the resources used by an algorithm in a single call
+         */
+        class Record
+        {
+        public:
+            std::string m_algorithmName; ///< The algorithm name
+            int m_event;                 ///< The number of events processed by the instance, counting from zero
+            double m_wallTime;           ///< The wall time, in ms
+            double m_cpuTime;            ///< The cpu time of the processing thread, in ms
+            long m_peakRssDelta;         ///< The growth of the process peak resident set size, in kB
+            ListSizes m_listSizesIn;     ///< The list sizes before the algorithm ran
+            ListSizes m_listSizesOut;    ///< The list sizes after the algorithm ran
+        };
+
+        typedef std::vector<Record> RecordVector;
+
+        std::string m_instanceName; ///< The instance name
+        bool m_hasCheckpoint;       ///< Whether the instance has recorded a checkpoint
+        int m_event;                ///< The number of events processed by the instance, counting from zero
+        double m_wallTime;          ///< The wall time at the previous checkpoint, in ms
+        double m_cpuTime;           ///< The cpu time of the processing thread at the previous checkpoint, in ms
+        long m_peakRss;             ///< The process peak resident set size at the previous checkpoint, in kB
+        ListSizes m_listSizes;      ///< The list sizes at the previous checkpoint
+        RecordVector m_records;     ///< The records not yet written to the profile file
+    };
+
+    /**
+     *  @brief  Get the process-wide algorithm profiler
+     *
+     *  @return the algorithm profiler
+     */
+    static AlgorithmProfiler &GetInstance();
+
+    /**
+     *  @brief  Enable profiling, for all pandora instances whose settings are read from now on
+     *
+     *  @param  profileFileName the name of the profile file, receiving one line per algorithm per event in each instance
+     */
+    pandora::StatusCode Enable(const std::string &profileFileName);
+
+    /**
+     *  @brief  Whether profiling is enabled
+     *
+     *  @return boolean
+     */
+    bool IsEnabled() const;
+
+    /**
+     *  @brief  Read the settings for a pandora instance, inserting the profiling checkpoints if profiling is enabled
+     *
+     *  @param  pandora the pandora instance
+     *  @param  settingsFile the pandora settings file
+     */
+    pandora::StatusCode ReadSettings(const pandora::Pandora &pandora, const std::string &settingsFile);
+
+    /**
+     *  @brief  Insert a profiling checkpoint algorithm before the first top-level algorithm and after every top-level algorithm
+     *
+     *  @param  pXmlElement address of the root element of the pandora settings
+     */
+    static void InsertCheckpoints(pandora::TiXmlElement *const pXmlElement);
+
+    /**
+     *  @brief  Get the profile of a pandora instance, creating it on first use
+     *
+     *  @param  pandora the pandora instance
+     *
+     *  @return the instance profile, shared by the profiling checkpoints in the instance
+     */
+    std::shared_ptr<InstanceProfile> GetInstanceProfile(const pandora::Pandora &pandora);
+
+    /**
+     *  @brief  Record a checkpoint in a pandora instance, attributing the resources used since the previous checkpoint to an algorithm.
+     *          The record is buffered in the instance profile, and only written once enough records have built up.
+     *
+     *  @param  instanceProfile the instance profile
+     *  @param  algorithmName the name of the algorithm that has just run, or empty for the checkpoint at the start of the event
+     *  @param  listSizes the current list sizes
+     */
+    void RecordCheckpoint(InstanceProfile &instanceProfile, const std::string &algorithmName, const ListSizes &listSizes);
+
+    /**
+     *  @brief  Write the buffered records of a pandora instance and delete its profile, when the instance is torn down
+     *
+     *  @param  pandora the pandora instance
+     */
+    void DeleteInstanceProfile(const pandora::Pandora &pandora);
+
+    /**
+     *  @brief  Close the profile file, after writing the records of any remaining instances and printing and writing the summary table
+     *          for each instance type and algorithm
+     */
+    void Finish();
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    AlgorithmProfiler();
+
+    /**
+     *  @brief  Write the buffered records of an instance to the profile file and add them to the summaries, with the mutex held
+     *
+     *  @param  instanceProfile the instance profile
+     */
+    void WriteRecords(InstanceProfile &instanceProfile);
+
+    /**
+     *  @brief  Summary class, accumulating the profile of an algorithm in a type of instance over the run
+     */
+    class Summary
+    {
+    public:
+        /**
+         *  @brief  Constructor
+         *
+         *  @param  instanceType the instance type
+         *  @param  algorithmName the algorithm name
+         */
+        Summary(const std::string &instanceType, const std::string &algorithmName);
+
+        std::string m_instanceType;  ///< The instance type, i.e. the instance name without any index
+        std::string m_algorithmName; ///< The algorithm name
+        unsigned int m_nCalls;       ///< The number of times the algorithm has run
+        double m_totalWallTime;      ///< The total wall time, in ms
+        double m_maxWallTime;        ///< The maximum wall time in a single call, in ms
+        double m_totalCpuTime;       ///< The total cpu time, in ms
+        long m_maxPeakRssDelta;      ///< The maximum growth of the process peak resident set size in a single call, in kB
+    };
+
+    typedef std::unordered_map<const pandora::Pandora *, std::shared_ptr<InstanceProfile>> InstanceProfileMap;
+    typedef std::vector<Summary> SummaryVector;
+    typedef std::unordered_map<std::string, unsigned int> SummaryIndexMap;
+    typedef std::vector<std::unique_ptr<pandora::TiXmlDocument>> SettingsDocumentList;
+
+    mutable std::mutex m_mutex;               ///< The mutex serialising access to the profile file and summaries
+    bool m_isEnabled;                         ///< Whether profiling is enabled
+    std::ofstream m_profileFile;              ///< The profile file
+    InstanceProfileMap m_instanceProfileMap;  ///< The profile of each instance
+    SummaryVector m_summaries;                ///< The summaries, in the order in which the algorithms first ran
+    SummaryIndexMap m_summaryIndexMap;        ///< The index of the summary for each instance type and algorithm
+    SettingsDocumentList m_settingsDocuments; ///< The instrumented settings documents read by the profiler
+};
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_ALGORITHM_PROFILER_H
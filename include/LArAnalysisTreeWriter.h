@@ -0,0 +1,104 @@
+/**
+ *  @file   include/LArAnalysisTreeWriter.h
+ *
+ *  @brief  Header file for the analysis tree writer class.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_ANALYSIS_TREE_WRITER_H
+#define LAR_ANALYSIS_TREE_WRITER_H 1
+
+#include "Pandora/StatusCodes.h"
+
+#include <string>
+#include <vector>
+
+class TFile;
+class TTree;
+
+namespace lar_content
+{
+
+/**
+ *  @brief  AnalysisTreeWriter class, owning an output ROOT tree whose branches are bound once to caller-owned buffers
+ */
+class AnalysisTreeWriter
+{
+public:
+    /**
+     *  @brief  Constructor, recreating the output file
+     *
+     *  @param  fileName the name of the output ROOT file
+     *  @param  treeName the name of the output tree
+     *  @param  compressionSettings the ROOT compression settings (algorithm * 100 + level), or negative for the ROOT default
+     *  @param  basketSize the basket size for each branch, in bytes
+     */
+    AnalysisTreeWriter(const std::string &fileName, const std::string &treeName, const int compressionSettings, const int basketSize);
+
+    /**
+     *  @brief  Destructor, writing the tree and closing the output file
+     */
+    ~AnalysisTreeWriter();
+
+    /**
+     *  @brief  Add a branch, bound to an integer buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  value the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, int &value);
+
+    /**
+     *  @brief  Add a branch, bound to a float buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  value the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, float &value);
+
+    /**
+     *  @brief  Add a branch, bound to a string buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  value the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, std::string &value);
+
+    /**
+     *  @brief  Add a branch, bound to an integer vector buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  values the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, std::vector<int> &values);
+
+    /**
+     *  @brief  Add a branch, bound to a long integer vector buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  values the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, std::vector<long> &values);
+
+    /**
+     *  @brief  Add a branch, bound to a float vector buffer that must outlive the writer
+     *
+     *  @param  branchName the branch name
+     *  @param  values the buffer, read on each call to Fill()
+     */
+    void AddBranch(const std::string &branchName, std::vector<float> &values);
+
+    /**
+     *  @brief  Fill the tree with the current contents of the bound buffers
+     */
+    pandora::StatusCode Fill();
+
+private:
+    TFile *m_pFile;   ///< The output ROOT file, which owns the tree
+    TTree *m_pTree;   ///< The output tree
+    int m_basketSize; ///< The basket size for each branch, in bytes
+};
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_ANALYSIS_TREE_WRITER_H
@@ -57,7 +57,7 @@ inline LArBox::LArBox(const pandora::CartesianVector &bottom, const pandora::Car
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
+inline bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
 {
     // Brian Smits ray-box intersection algorithm with improvements from Amy Williams et al. Code based on
     // https://github.com/chenel/larcv2/tree/edepsim-formattruth/larcv/app/Supera/Voxelize.cxx (MIT license)
@@ -134,7 +134,7 @@ bool LArBox::Intersect(const LArRay &ray, double &t0, double &t1) const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool LArBox::Inside(const pandora::CartesianVector &point) const
+inline bool LArBox::Inside(const pandora::CartesianVector &point) const
 {
     const float x = point.GetX();
     const float y = point.GetY();
@@ -0,0 +1,113 @@
+/**
+ *  @file   include/LArEventTimeBudget.h
+ *
+ *  @brief  Header file for the per-event time budget class.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_EVENT_TIME_BUDGET_H
+#define LAR_EVENT_TIME_BUDGET_H 1
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+namespace pandora
+{
+class Pandora;
+} // namespace pandora
+
+namespace lar_content
+{
+
+/**
+ *  @brief  EventTimeBudget class, holding the deadline for the event being processed by a primary pandora instance. Algorithms check
+ *          the deadline at the boundaries of optional stages, skipping those stages once it has passed, so that a pathological event
+ *          is reconstructed with reduced detail rather than stalling the job. Worker instances share the budget of their primary.
+ */
+class EventTimeBudget
+{
+public:
+    /**
+     *  @brief  Get the time budget for a pandora instance, i.e. that of its primary instance if it is a registered worker instance
+     *
+     *  @param  pandora the pandora instance
+     *
+     *  @return the event time budget
+     */
+    static EventTimeBudget &GetInstance(const pandora::Pandora &pandora);
+
+    /**
+     *  @brief  Register a worker instance, so that it shares the time budget of its primary instance
+     *
+     *  @param  primaryPandora the primary pandora instance
+     *  @param  workerPandora the worker pandora instance
+     */
+    static void AddWorkerInstance(const pandora::Pandora &primaryPandora, const pandora::Pandora &workerPandora);
+
+    /**
+     *  @brief  Delete the time budget of a primary instance, along with the entries of the worker instances sharing it
+     *
+     *  @param  primaryPandora the primary pandora instance
+     */
+    static void DeleteInstance(const pandora::Pandora &primaryPandora);
+
+    /**
+     *  @brief  Start the clock for a new event, before it is processed by the primary instance
+     *
+     *  @param  timeBudget the time allowed for the event, in ms (no deadline if not positive)
+     */
+    void StartEvent(const double timeBudget);
+
+    /**
+     *  @brief  Whether an optional stage should be skipped, because the deadline for the event has passed
+     *
+     *  @param  stageName the name of the stage, printed when it is skipped
+     *
+     *  @return boolean
+     */
+    bool ShouldSkipStage(const std::string &stageName);
+
+    /**
+     *  @brief  Whether any optional stage has been skipped this event
+     *
+     *  @return boolean
+     */
+    bool IsExceeded() const;
+
+    /**
+     *  @brief  Get the number of optional stages skipped this event
+     *
+     *  @return the number of skipped stages
+     */
+    unsigned int GetNSkippedStages() const;
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    EventTimeBudget();
+
+    bool m_hasDeadline;                               ///< Whether the current event has a deadline
+    double m_timeBudget;                              ///< The time allowed for the current event, in ms
+    std::chrono::steady_clock::time_point m_deadline; ///< The deadline for the current event
+    std::atomic<unsigned int> m_nSkippedStages;       ///< The number of optional stages skipped this event, by any thread
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline bool EventTimeBudget::IsExceeded() const
+{
+    return (m_nSkippedStages > 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int EventTimeBudget::GetNSkippedStages() const
+{
+    return m_nSkippedStages;
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_EVENT_TIME_BUDGET_H
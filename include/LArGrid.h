@@ -39,6 +39,15 @@ public:
      */
     LongBin4Array GetBinIndices(const pandora::CartesianVector &point) const;
 
+    /**
+     *  @brief  Get the (x,y,z,total) bin indices for the given total bin number, as returned by GetBinIndices for a point
+     *
+     *  @param  totalBin The total bin number (long integer, since it can be > 2^31)
+     *
+     *  @return The array of (x,y,z,total) bin long integer indices
+     */
+    LongBin4Array GetBinIndices(const long totalBin) const;
+
     /**
      *  @brief  Get the position for the given x, y and z bins
      *
@@ -59,6 +68,16 @@ public:
      */
     pandora::CartesianVector GetPoint(const LongBin4Array &bins) const;
 
+    /**
+     *  @brief  Get a coarser grid over the same box, with each bin width multiplied by the given factor. The number of bins is rounded
+     *          up, so that each bin of this grid lies inside a single coarse bin and no part of the box is lost.
+     *
+     *  @param  factor The (positive) factor by which to increase the bin widths
+     *
+     *  @return The coarse grid
+     */
+    LArGrid GetCoarseGrid(const long factor) const;
+
     pandora::CartesianVector m_bottom;    ///< The bottom corner of the box
     pandora::CartesianVector m_top;       ///< The top corner of the box
     pandora::CartesianVector m_binWidths; ///< The bin widths (dx, dy, dz)
@@ -117,6 +136,19 @@ inline LongBin4Array LArGrid::GetBinIndices(const pandora::CartesianVector &poin
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+inline LongBin4Array LArGrid::GetBinIndices(const long totalBin) const
+{
+    // Inverse of the total bin calculation: totBin = (zBin * NyBins + yBin) * NxBins + xBin
+    const long xBin = totalBin % m_nBins[0];
+    const long yBin = (totalBin / m_nBins[0]) % m_nBins[1];
+    const long zBin = totalBin / (m_nBins[0] * m_nBins[1]);
+
+    LongBin4Array binIndices = {xBin, yBin, zBin, totalBin};
+    return binIndices;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 inline pandora::CartesianVector LArGrid::GetPoint(const long xBin, const long yBin, const long zBin) const
 {
     const float x = m_bottom.GetX() + xBin * m_binWidths.GetX();
@@ -133,6 +165,19 @@ inline pandora::CartesianVector LArGrid::GetPoint(const LongBin4Array &bins) con
     return GetPoint(bins[0], bins[1], bins[2]);
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArGrid LArGrid::GetCoarseGrid(const long factor) const
+{
+    if (factor < 1)
+        throw pandora::StatusCodeException(pandora::STATUS_CODE_OUT_OF_RANGE);
+
+    LArGrid coarseGrid(m_bottom, m_top, m_binWidths * static_cast<float>(factor));
+    coarseGrid.m_nBins = {(m_nBins[0] + factor - 1) / factor, (m_nBins[1] + factor - 1) / factor, (m_nBins[2] + factor - 1) / factor};
+
+    return coarseGrid;
+}
+
 } // namespace lar_nd_reco
 
 #endif
@@ -10,6 +10,8 @@
 
 #include "Pandora/PandoraInputTypes.h"
 
+#include <vector>
+
 namespace lar_nd_reco
 {
 
@@ -35,6 +37,8 @@ public:
     int m_trackID;                    ///< The ID of the (main) contributing particle
 };
 
+typedef std::vector<LArHitInfo> LArHitInfoList;
+
 inline LArHitInfo::LArHitInfo(const pandora::CartesianVector &start, const pandora::CartesianVector &stop, const float energy,
     const int trackID, const float lengthScale, const float energyScale) :
     m_start(start * lengthScale), m_stop(stop * lengthScale), m_energy(energy * energyScale), m_trackID(trackID)
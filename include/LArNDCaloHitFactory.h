@@ -0,0 +1,539 @@
+/**
+ *  @file   LArRecoND/include/LArNDCaloHitFactory.h
+ *
+ *  @brief  Header file for the LArND calo hit factory, which recycles the memory of the hits deleted by PandoraApi::Reset
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_CALO_HIT_FACTORY_H
+#define PANDORA_LAR_ND_CALO_HIT_FACTORY_H 1
+
+#include "larpandoracontent/LArObjects/LArCaloHit.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <sstream>
+#include <vector>
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  LArNDCaloHitPool class, handing out fixed-size blocks from slabs that are kept for the lifetime of the pool. Released
+ *          blocks are reused first, and once every block has been released (i.e. after PandoraApi::Reset) the slabs are handed
+ *          out again from the start, so each event fills the same memory in order. Not thread safe: a pool must only be used by
+ *          the thread processing a single pandora instance. A pool whose owner goes away while blocks are still in use can be
+ *          detached, so that it deletes itself once the last of them is released.
+ */
+class LArNDCaloHitPool
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  blockSize the size of each block, in bytes
+     *  @param  nBlocksPerSlab the number of blocks allocated at once when the pool needs to grow
+     */
+    LArNDCaloHitPool(const std::size_t blockSize, const std::size_t nBlocksPerSlab);
+
+    LArNDCaloHitPool(const LArNDCaloHitPool &) = delete;
+    LArNDCaloHitPool &operator=(const LArNDCaloHitPool &) = delete;
+
+    /**
+     *  @brief  Get a block, growing the pool by a slab if no block is free
+     *
+     *  @return address of the block
+     */
+    void *Allocate();
+
+    /**
+     *  @brief  Return a block to the pool
+     *
+     *  @param  pBlock address of the block
+     */
+    void Release(void *const pBlock);
+
+    /**
+     *  @brief  Get the size of each block, in bytes
+     *
+     *  @return the block size
+     */
+    std::size_t GetBlockSize() const;
+
+    /**
+     *  @brief  Get the total number of blocks held in the slabs of the pool
+     *
+     *  @return the number of pooled blocks
+     */
+    std::size_t GetNPooledBlocks() const;
+
+    /**
+     *  @brief  Get the number of blocks currently in use
+     *
+     *  @return the number of blocks in use
+     */
+    std::size_t GetNBlocksInUse() const;
+
+    /**
+     *  @brief  Get the number of blocks handed out since the counters were last reset
+     *
+     *  @return the number of allocations
+     */
+    std::size_t GetNAllocations() const;
+
+    /**
+     *  @brief  Get the number of allocations since the counters were last reset that reused a block from an existing slab
+     *
+     *  @return the number of recycled allocations
+     */
+    std::size_t GetNRecycled() const;
+
+    /**
+     *  @brief  Get the number of slabs allocated since the counters were last reset
+     *
+     *  @return the number of new slabs
+     */
+    std::size_t GetNNewSlabs() const;
+
+    /**
+     *  @brief  Reset the allocation counters, e.g. at the end of each event
+     */
+    void ResetCounters();
+
+    /**
+     *  @brief  Give up the ownership of a pool, which must have been allocated with new. The pool is deleted now if no blocks are in
+     *          use, or else once the last block in use is released
+     *
+     *  @param  pPool address of the pool
+     */
+    static void Detach(LArNDCaloHitPool *const pPool);
+
+private:
+    /**
+     *  @brief  FreeBlock class, linking the released blocks through their own memory
+     */
+    class FreeBlock
+    {
+    public:
+        FreeBlock *m_pNext; ///< The next free block
+    };
+
+    typedef std::vector<std::unique_ptr<char[]>> SlabList;
+
+    const std::size_t m_blockSize;      ///< The size of each block, in bytes
+    const std::size_t m_nBlocksPerSlab; ///< The number of blocks in each slab
+    SlabList m_slabs;                   ///< The slabs of blocks
+    std::size_t m_currentSlab;          ///< The index of the slab currently being filled
+    std::size_t m_nextBlockInSlab;      ///< The index of the next unused block in the current slab
+    FreeBlock *m_pFreeList;             ///< The blocks released since all blocks were last free
+    std::size_t m_nBlocksInUse;         ///< The number of blocks in use
+    std::size_t m_nUsedBlocks;          ///< The number of blocks, from the start of the first slab, that have ever been handed out
+    std::size_t m_nAllocations;         ///< The number of blocks handed out since the counters were reset
+    std::size_t m_nRecycled;            ///< The number of allocations reusing a block from an existing slab since the counters were reset
+    std::size_t m_nNewSlabs;            ///< The number of slabs allocated since the counters were reset
+    bool m_isDetached;                  ///< Whether the pool deletes itself once the last block in use is released
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDCaloHit class, an LArCaloHit placed in a block of an LArNDCaloHitPool. Pandora deletes calo hits through their base
+ *          class, which uses the class-specific deallocation functions below via the virtual destructor, so the block is returned
+ *          to the pool recorded in front of the hit.
+ */
+class LArNDCaloHit : public lar_content::LArCaloHit
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  parameters the lar calo hit parameters
+     */
+    LArNDCaloHit(const lar_content::LArCaloHitParameters &parameters);
+
+    /**
+     *  @brief  Allocate a hit in a block of a pool
+     *
+     *  @param  size the size of the hit
+     *  @param  pool the pool
+     *
+     *  @return address of the memory for the hit
+     */
+    static void *operator new(std::size_t size, LArNDCaloHitPool &pool);
+
+    /**
+     *  @brief  Return the memory of a hit to its pool if the hit constructor throws
+     *
+     *  @param  pObject address of the memory for the hit
+     *  @param  pool the pool
+     */
+    static void operator delete(void *pObject, LArNDCaloHitPool &pool);
+
+    /**
+     *  @brief  Return the memory of a deleted hit to its pool
+     *
+     *  @param  pObject address of the memory for the hit
+     */
+    static void operator delete(void *pObject);
+
+    /**
+     *  @brief  Get the size of the pool block needed for each hit, including the record of its pool
+     *
+     *  @return the block size
+     */
+    static std::size_t GetBlockSize();
+
+private:
+    /**
+     *  @brief  Get the size reserved in front of each hit to record its pool, keeping the hit suitably aligned
+     *
+     *  @return the header size
+     */
+    static std::size_t GetHeaderSize();
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDCaloHitFactory class, creating LArNDCaloHits in a pool owned by the factory. If the factory is destroyed while a
+ *          pandora instance still owns some of its hits, e.g. when an exception unwinds the event loop, the pool is detached and
+ *          lives on until those hits are deleted.
+ */
+class LArNDCaloHitFactory : public lar_content::LArCaloHitFactory
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  nHitsPerSlab the number of hits allocated at once when the pool needs to grow
+     */
+    LArNDCaloHitFactory(const std::size_t nHitsPerSlab = 16384);
+
+    /**
+     *  @brief  Destructor, detaching the pool if any of its hits are still in use
+     */
+    ~LArNDCaloHitFactory();
+
+    LArNDCaloHitFactory(const LArNDCaloHitFactory &) = delete;
+    LArNDCaloHitFactory &operator=(const LArNDCaloHitFactory &) = delete;
+
+    /**
+     *  @brief  Create an object with the given parameters
+     *
+     *  @param  parameters the parameters to pass in constructor
+     *  @param  pObject to receive the address of the object created
+     */
+    pandora::StatusCode Create(const Parameters &parameters, const Object *&pObject) const;
+
+    /**
+     *  @brief  Get the pool holding the hits
+     *
+     *  @return the pool
+     */
+    const LArNDCaloHitPool &GetPool() const;
+
+    /**
+     *  @brief  Get the time spent creating hits since the counters were last reset
+     *
+     *  @return the creation time (ms)
+     */
+    double GetCreationTime() const;
+
+    /**
+     *  @brief  Print the number of hits created, the pool usage and the time spent creating hits since the counters were last reset
+     *
+     *  @param  resetTime the time taken to reset the pandora instance, deleting the hits (ms)
+     */
+    void PrintEventSummary(const double resetTime) const;
+
+    /**
+     *  @brief  Reset the allocation and timing counters, at the end of each event
+     */
+    void ResetCounters();
+
+private:
+    std::unique_ptr<LArNDCaloHitPool> m_pPool;                  ///< The pool holding the hits
+    mutable std::chrono::steady_clock::duration m_creationTime; ///< The time spent creating hits since the counters were reset
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArNDCaloHitPool::LArNDCaloHitPool(const std::size_t blockSize, const std::size_t nBlocksPerSlab) :
+    m_blockSize(std::max(blockSize, sizeof(FreeBlock))),
+    m_nBlocksPerSlab(std::max(nBlocksPerSlab, std::size_t(1))),
+    m_currentSlab(0),
+    m_nextBlockInSlab(0),
+    m_pFreeList(nullptr),
+    m_nBlocksInUse(0),
+    m_nUsedBlocks(0),
+    m_nAllocations(0),
+    m_nRecycled(0),
+    m_nNewSlabs(0),
+    m_isDetached(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void *LArNDCaloHitPool::Allocate()
+{
+    ++m_nAllocations;
+    ++m_nBlocksInUse;
+
+    if (m_pFreeList)
+    {
+        FreeBlock *const pFreeBlock(m_pFreeList);
+        m_pFreeList = pFreeBlock->m_pNext;
+        ++m_nRecycled;
+        return pFreeBlock;
+    }
+
+    if (m_nextBlockInSlab == m_nBlocksPerSlab)
+    {
+        ++m_currentSlab;
+        m_nextBlockInSlab = 0;
+    }
+
+    if (m_currentSlab == m_slabs.size())
+    {
+        m_slabs.emplace_back(new char[m_blockSize * m_nBlocksPerSlab]);
+        ++m_nNewSlabs;
+    }
+
+    if (m_currentSlab * m_nBlocksPerSlab + m_nextBlockInSlab < m_nUsedBlocks)
+    {
+        ++m_nRecycled;
+    }
+    else
+    {
+        ++m_nUsedBlocks;
+    }
+
+    return m_slabs[m_currentSlab].get() + m_blockSize * m_nextBlockInSlab++;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHitPool::Release(void *const pBlock)
+{
+    --m_nBlocksInUse;
+
+    // Once every block is free, forget the free list and refill the slabs in order
+    if (0 == m_nBlocksInUse)
+    {
+        if (m_isDetached)
+        {
+            delete this;
+            return;
+        }
+
+        m_pFreeList = nullptr;
+        m_currentSlab = 0;
+        m_nextBlockInSlab = 0;
+        return;
+    }
+
+    m_pFreeList = new (pBlock) FreeBlock{m_pFreeList};
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetBlockSize() const
+{
+    return m_blockSize;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetNPooledBlocks() const
+{
+    return m_slabs.size() * m_nBlocksPerSlab;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetNBlocksInUse() const
+{
+    return m_nBlocksInUse;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetNAllocations() const
+{
+    return m_nAllocations;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetNRecycled() const
+{
+    return m_nRecycled;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHitPool::GetNNewSlabs() const
+{
+    return m_nNewSlabs;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHitPool::ResetCounters()
+{
+    m_nAllocations = 0;
+    m_nRecycled = 0;
+    m_nNewSlabs = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHitPool::Detach(LArNDCaloHitPool *const pPool)
+{
+    if (0 == pPool->m_nBlocksInUse)
+    {
+        delete pPool;
+        return;
+    }
+
+    pPool->m_isDetached = true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArNDCaloHit::LArNDCaloHit(const lar_content::LArCaloHitParameters &parameters) :
+    lar_content::LArCaloHit(parameters)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void *LArNDCaloHit::operator new(std::size_t size, LArNDCaloHitPool &pool)
+{
+    if (GetHeaderSize() + size > pool.GetBlockSize())
+        throw std::bad_alloc();
+
+    char *const pBlock(static_cast<char *>(pool.Allocate()));
+    *reinterpret_cast<LArNDCaloHitPool **>(pBlock) = &pool;
+
+    return pBlock + GetHeaderSize();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHit::operator delete(void *pObject, LArNDCaloHitPool &pool)
+{
+    pool.Release(static_cast<char *>(pObject) - GetHeaderSize());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHit::operator delete(void *pObject)
+{
+    if (!pObject)
+        return;
+
+    char *const pBlock(static_cast<char *>(pObject) - GetHeaderSize());
+    (*reinterpret_cast<LArNDCaloHitPool **>(pBlock))->Release(pBlock);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHit::GetBlockSize()
+{
+    // Keep every block in a slab aligned, as well as the hit within each block
+    const std::size_t alignment(alignof(std::max_align_t));
+
+    return ((GetHeaderSize() + sizeof(LArNDCaloHit) + alignment - 1) / alignment) * alignment;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArNDCaloHit::GetHeaderSize()
+{
+    static_assert(alignof(LArNDCaloHit) <= alignof(std::max_align_t), "LArNDCaloHit: over-aligned hits cannot be pooled");
+    const std::size_t alignment(alignof(std::max_align_t));
+
+    return ((sizeof(LArNDCaloHitPool *) + alignment - 1) / alignment) * alignment;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArNDCaloHitFactory::LArNDCaloHitFactory(const std::size_t nHitsPerSlab) :
+    m_pPool(new LArNDCaloHitPool(LArNDCaloHit::GetBlockSize(), nHitsPerSlab)),
+    m_creationTime(std::chrono::steady_clock::duration::zero())
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArNDCaloHitFactory::~LArNDCaloHitFactory()
+{
+    // ATTN Each hit returns its block to the pool recorded in front of it when it is deleted, which may happen after the factory has
+    // gone, e.g. when the pandora instances are deleted after an exception, so the pool must outlive the hits
+    if (m_pPool->GetNBlocksInUse() > 0)
+    {
+        std::cout << "LArNDCaloHitFactory: " << m_pPool->GetNBlocksInUse() << " hits still in use, keeping their pool until they are "
+                  << "deleted" << std::endl;
+    }
+
+    LArNDCaloHitPool::Detach(m_pPool.release());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline pandora::StatusCode LArNDCaloHitFactory::Create(const Parameters &parameters, const Object *&pObject) const
+{
+    const auto startTime(std::chrono::steady_clock::now());
+    const lar_content::LArCaloHitParameters &larCaloHitParameters(dynamic_cast<const lar_content::LArCaloHitParameters &>(parameters));
+    pObject = new (*m_pPool) LArNDCaloHit(larCaloHitParameters);
+    m_creationTime += std::chrono::steady_clock::now() - startTime;
+
+    return pandora::STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline const LArNDCaloHitPool &LArNDCaloHitFactory::GetPool() const
+{
+    return *m_pPool;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline double LArNDCaloHitFactory::GetCreationTime() const
+{
+    return std::chrono::duration<double, std::milli>(m_creationTime).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHitFactory::PrintEventSummary(const double resetTime) const
+{
+    // Written with a single call, so that the summaries of concurrently running instances do not interleave within a line
+    std::ostringstream summary;
+    summary << "LArNDCaloHitFactory: created " << m_pPool->GetNAllocations() << " hits (" << m_pPool->GetNRecycled()
+            << " in recycled memory, " << m_pPool->GetNNewSlabs() << " new slabs, " << m_pPool->GetNPooledBlocks() << " pooled) in "
+            << this->GetCreationTime() << " ms, deleted in " << resetTime << " ms\n";
+    std::cout << summary.str() << std::flush;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArNDCaloHitFactory::ResetCounters()
+{
+    m_pPool->ResetCounters();
+    m_creationTime = std::chrono::steady_clock::duration::zero();
+}
+
+} // namespace lar_nd_reco
+
+#endif
@@ -0,0 +1,409 @@
+/**
+ *  @file   LArRecoND/include/LArNDEventGenerator.h
+ *
+ *  @brief  Header file for the synthetic ND LAr event generator, writing LArSP/LArSPMC format trees.
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_EVENT_GENERATOR_H
+#define PANDORA_LAR_ND_EVENT_GENERATOR_H 1
+
+#include "Pandora/PandoraInputTypes.h"
+
+#include "TGeoManager.h"
+#include "TTree.h"
+
+#include "LArNDGeomSimple.h"
+
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_nd_generator
+{
+
+/**
+ *  @brief  GeneratorParameters class
+ */
+class GeneratorParameters
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    GeneratorParameters();
+
+    std::string m_outputFileName;   ///< The output ROOT file name (mandatory parameter)
+    std::string m_outputTreeName;   ///< The output event TTree name (default = events)
+    std::string m_geomFileName;     ///< The ROOT file containing the TGeoManager (default none, i.e. a built-in 7 x 5 module geometry)
+    std::string m_geomManagerName;  ///< The name of the TGeoManager (default = Default)
+    std::string m_sensitiveDetName; ///< The name of the TPC active volumes (default = volTPCActive)
+
+    int m_nEvents;         ///< The number of events to generate (default = 100)
+    unsigned int m_seed;   ///< The random number seed (default = 12345)
+    float m_intensity;     ///< The beam intensity relative to nominal, scaling the interaction and noise rates (default = 1)
+    float m_nInteractions; ///< The mean number of interactions per event at nominal intensity (default = 5)
+    float m_nTracks;       ///< The mean number of straight tracks per interaction (default = 2)
+    float m_nShowers;      ///< The mean number of showers per interaction (default = 1)
+    float m_nMichels;      ///< The mean number of Michel-like stubs per interaction (default = 0.3)
+    float m_nNoiseHits;    ///< The mean number of noise hits per event at nominal intensity (default = 200)
+    float m_pixelPitch;    ///< The pixel pitch, setting the hit spacing in cm (default = 0.4)
+    int m_run;             ///< The run number written to each event (default = 0)
+    int m_subrun;          ///< The subrun number written to each event (default = 0)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline GeneratorParameters::GeneratorParameters() :
+    m_outputFileName(""),
+    m_outputTreeName("events"),
+    m_geomFileName(""),
+    m_geomManagerName("Default"),
+    m_sensitiveDetName("volTPCActive"),
+    m_nEvents(100),
+    m_seed(12345),
+    m_intensity(1.f),
+    m_nInteractions(5.f),
+    m_nTracks(2.f),
+    m_nShowers(1.f),
+    m_nMichels(0.3f),
+    m_nNoiseHits(200.f),
+    m_pixelPitch(0.4f),
+    m_run(0),
+    m_subrun(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  SyntheticEvent class, holding the branch contents of one event in the LArSP/LArSPMC layout
+ */
+class SyntheticEvent
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    SyntheticEvent();
+
+    /**
+     *  @brief  Create the event branches in the output tree, using the branch names read by LArSP and LArSPMC
+     *
+     *  @param  pTree address of the output tree
+     */
+    void CreateBranches(TTree *const pTree);
+
+    /**
+     *  @brief  Clear the event contents, keeping the file-wide particle and vertex counters
+     */
+    void Clear();
+
+    /**
+     *  @brief  Copy the accumulated hits and their truth contributions into the hit branches
+     */
+    void FillHits();
+
+    /**
+     *  @brief  HitContent class, the energy deposited in a pixel voxel and its split between the MC particles
+     */
+    class HitContent
+    {
+    public:
+        pandora::CartesianVector m_position;   ///< The voxel centre
+        float m_energy;                        ///< The total deposited energy, in GeV
+        std::vector<long> m_particleIDs;       ///< The unique ids of the contributing MC particles
+        std::vector<float> m_particleEnergies; ///< The energy deposited by each contributing MC particle, in GeV
+    };
+
+    typedef std::unordered_map<long, unsigned int> VoxelToHitMap;
+
+    int m_event;        ///< The event number
+    int m_subrun;       ///< The subrun number
+    int m_run;          ///< The run number
+    int m_unixTime;     ///< The unix trigger time (seconds)
+    int m_unixTimeUsec; ///< The unix trigger time (microsecond component)
+    int m_startTime;    ///< The event trigger start time (ticks = 0.1 usec)
+    int m_endTime;      ///< The event trigger end time (ticks = 0.1 usec)
+    int m_triggers;     ///< The event trigger flag
+    int m_nhits;        ///< The number of hits
+
+    std::vector<float> m_x;                           ///< The hit x positions, in cm
+    std::vector<float> m_y;                           ///< The hit y positions, in cm
+    std::vector<float> m_z;                           ///< The hit z positions, in cm
+    std::vector<float> m_ts;                          ///< The hit times
+    std::vector<float> m_charge;                      ///< The hit charges, as deposited energy in GeV
+    std::vector<float> m_E;                           ///< The hit energies, in GeV
+    std::vector<std::vector<long>> m_hit_particleID;  ///< The unique ids of the MC particles contributing to each hit
+    std::vector<std::vector<float>> m_hit_packetFrac; ///< The fraction of each hit energy from each contributing MC particle
+
+    std::vector<float> m_mcp_energy;   ///< The MC particle total energies, in GeV
+    std::vector<int> m_mcp_pdg;        ///< The MC particle pdg codes
+    std::vector<long> m_mcp_nuid;      ///< The MC particle neutrino ids
+    std::vector<long> m_mcp_vertex_id; ///< The MC particle interaction vertex ids
+    std::vector<long> m_mcp_idLocal;   ///< The MC particle ids within their interaction
+    std::vector<long> m_mcp_id;        ///< The MC particle unique ids
+    std::vector<long> m_mcp_mother;    ///< The local id of the MC particle parents, or -1 for primaries
+    std::vector<float> m_mcp_px;       ///< The MC particle x momenta, in GeV
+    std::vector<float> m_mcp_py;       ///< The MC particle y momenta, in GeV
+    std::vector<float> m_mcp_pz;       ///< The MC particle z momenta, in GeV
+    std::vector<float> m_mcp_startx;   ///< The MC particle start x positions, in cm
+    std::vector<float> m_mcp_starty;   ///< The MC particle start y positions, in cm
+    std::vector<float> m_mcp_startz;   ///< The MC particle start z positions, in cm
+    std::vector<float> m_mcp_endx;     ///< The MC particle end x positions, in cm
+    std::vector<float> m_mcp_endy;     ///< The MC particle end y positions, in cm
+    std::vector<float> m_mcp_endz;     ///< The MC particle end z positions, in cm
+
+    std::vector<long> m_vertex_id; ///< The interaction vertex ids
+    std::vector<long> m_nuID;      ///< The neutrino ids
+    std::vector<float> m_nue;      ///< The neutrino energies, in GeV
+    std::vector<int> m_nuPDG;      ///< The neutrino pdg codes
+    std::vector<float> m_nupx;     ///< The neutrino x momenta, in GeV
+    std::vector<float> m_nupy;     ///< The neutrino y momenta, in GeV
+    std::vector<float> m_nupz;     ///< The neutrino z momenta, in GeV
+    std::vector<float> m_nuvtxx;   ///< The interaction vertex x positions, in cm
+    std::vector<float> m_nuvtxy;   ///< The interaction vertex y positions, in cm
+    std::vector<float> m_nuvtxz;   ///< The interaction vertex z positions, in cm
+    std::vector<int> m_mode;       ///< The interaction modes
+    std::vector<int> m_ccnc;       ///< Whether each interaction is charged current (1) or neutral current (0)
+
+    std::vector<HitContent> m_hitContents; ///< The hits accumulated for the current event
+    VoxelToHitMap m_voxelToHitMap;         ///< The index of the hit for each occupied voxel in the current event
+    long m_nextParticleID;                 ///< The next unique MC particle id in the file
+    long m_nextVertexID;                   ///< The next unique interaction vertex id in the file
+
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  TrackType class, the parameters of a particle species drawn as straight tracks
+ */
+class TrackType
+{
+public:
+    int m_pdg;          ///< The pdg code
+    float m_mass;       ///< The mass, in GeV
+    float m_minLength;  ///< The minimum track length, in cm
+    float m_maxLength;  ///< The maximum track length, in cm
+    float m_braggScale; ///< The dE/dx at a residual range of 1 cm, in MeV/cm
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Create the simple TPC geometry, from the TGeoManager in the geometry file or the built-in modular geometry
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom to receive the TPC boxes
+ *
+ *  @return success
+ */
+bool CreateGeometry(const GeneratorParameters &parameters, lar_nd_reco::LArNDGeomSimple &geom);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Recursively search for volumes with the target name
+ *
+ *  @param  pSimGeom pointer to the input geometry
+ *  @param  targetName the volume name that we want to find
+ *  @param  nodePaths daughter indices to recreate the path to the target nodes
+ *  @param  currentPath path to the current position in the geometry
+ */
+void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetName, std::vector<std::vector<unsigned int>> &nodePaths,
+    std::vector<unsigned int> &currentPath);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Generate the events and write them to the output tree
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *
+ *  @return success
+ */
+bool GenerateEvents(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Generate the interactions and noise hits of a single event
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  generator the random number generator
+ *  @param  event to receive the event contents
+ */
+void GenerateEvent(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom, std::mt19937 &generator,
+    SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Generate an interaction at a random vertex inside the TPCs, with its tracks, showers and Michel-like stubs
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  generator the random number generator
+ *  @param  event to receive the interaction
+ */
+void GenerateInteraction(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom, std::mt19937 &generator,
+    SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Add a straight track with a Bragg-like dE/dx profile to the event
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  trackType the particle species
+ *  @param  start the track start position
+ *  @param  direction the track direction
+ *  @param  length the track length, in cm
+ *  @param  vertexID the interaction vertex id
+ *  @param  motherLocalID the local id of the parent particle, or -1 for primaries
+ *  @param  event to receive the particle and its hits
+ *
+ *  @return the momentum of the particle
+ */
+pandora::CartesianVector AddTrack(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom,
+    const TrackType &trackType, const pandora::CartesianVector &start, const pandora::CartesianVector &direction, const float length,
+    const long vertexID, const long motherLocalID, SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Add an electromagnetic shower, with a gamma function longitudinal profile and a widening transverse profile, to the event
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  generator the random number generator
+ *  @param  pdg the pdg code of the shower parent (11 or 22)
+ *  @param  energy the shower energy, in GeV
+ *  @param  start the shower parent start position
+ *  @param  direction the shower direction
+ *  @param  vertexID the interaction vertex id
+ *  @param  event to receive the particle and its hits
+ *
+ *  @return the momentum of the particle
+ */
+pandora::CartesianVector AddShower(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom,
+    std::mt19937 &generator, const int pdg, const float energy, const pandora::CartesianVector &start,
+    const pandora::CartesianVector &direction, const long vertexID, SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Add the noise hits, uniformly distributed in randomly chosen TPCs and without MC particle contributions
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  generator the random number generator
+ *  @param  nNoiseHits the number of noise hits
+ *  @param  event to receive the hits
+ */
+void AddNoiseHits(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom, std::mt19937 &generator,
+    const unsigned int nNoiseHits, SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Add an MC particle to the event
+ *
+ *  @param  pdg the pdg code
+ *  @param  energy the total energy, in GeV
+ *  @param  momentum the momentum, in GeV
+ *  @param  start the start position
+ *  @param  end the end position
+ *  @param  vertexID the interaction vertex id
+ *  @param  motherLocalID the local id of the parent particle, or -1 for primaries
+ *  @param  event to receive the particle
+ *
+ *  @return the unique id of the particle
+ */
+long AddMCParticle(const int pdg, const float energy, const pandora::CartesianVector &momentum, const pandora::CartesianVector &start,
+    const pandora::CartesianVector &end, const long vertexID, const long motherLocalID, SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Deposit energy in the pixel voxel containing a position, if it is inside a TPC
+ *
+ *  @param  parameters the generator parameters
+ *  @param  geom the simple TPC geometry
+ *  @param  position the deposit position
+ *  @param  energy the deposited energy, in GeV
+ *  @param  particleID the unique id of the depositing MC particle, or -1 for noise
+ *  @param  event to receive the deposit
+ *
+ *  @return whether the position is inside a TPC
+ */
+bool DepositEnergy(const GeneratorParameters &parameters, const lar_nd_reco::LArNDGeomSimple &geom,
+    const pandora::CartesianVector &position, const float energy, const long particleID, SyntheticEvent &event);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Draw a number from a Poisson distribution, allowing a zero mean to switch a component off
+ *
+ *  @param  mean the mean
+ *  @param  generator the random number generator
+ *
+ *  @return the number
+ */
+int GetPoissonNumber(const float mean, std::mt19937 &generator);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get a random position inside a randomly chosen TPC, with each TPC chosen in proportion to its volume
+ *
+ *  @param  geom the simple TPC geometry
+ *  @param  generator the random number generator
+ *
+ *  @return the position
+ */
+pandora::CartesianVector GetRandomPositionInTPC(const lar_nd_reco::LArNDGeomSimple &geom, std::mt19937 &generator);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get a random isotropic unit vector
+ *
+ *  @param  generator the random number generator
+ *  @param  minCosTheta the minimum cosine of the angle to the z axis, -1 for isotropic directions
+ *
+ *  @return the unit vector
+ */
+pandora::CartesianVector GetRandomDirection(std::mt19937 &generator, const float minCosTheta = -1.f);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Parse the command line arguments, setting the generator parameters
+ *
+ *  @param  argc argument count
+ *  @param  argv argument vector
+ *  @param  parameters to receive the generator parameters
+ *
+ *  @return success
+ */
+bool ParseCommandLine(int argc, char *argv[], GeneratorParameters &parameters);
+
+/**
+ *  @brief  Print the list of configurable options
+ *
+ *  @return false, to force abort
+ */
+bool PrintOptions();
+
+} // namespace lar_nd_generator
+
+#endif // #ifndef PANDORA_LAR_ND_EVENT_GENERATOR_H
@@ -155,7 +155,7 @@ private:
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArNDGeomSimple::LArNDGeomSimple()
+inline LArNDGeomSimple::LArNDGeomSimple()
 {
 }
 
@@ -0,0 +1,131 @@
+/**
+ *  @file   LArRecoND/include/LArNDGeometryCache.h
+ *
+ *  @brief  Header file for the cache of the ND LAr TPC volumes found in the ROOT geometry
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_GEOMETRY_CACHE_H
+#define PANDORA_LAR_ND_GEOMETRY_CACHE_H 1
+
+#include <string>
+#include <vector>
+
+class TGeoManager;
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  LArNDTPCBox class, the placement of a TPC volume in the world volume, in the length units of the ROOT geometry
+ */
+class LArNDTPCBox
+{
+public:
+    unsigned int m_tpcID; ///< The TPC id, given by the order in which the volumes are found
+    double m_centreX;     ///< The x coordinate of the volume centre
+    double m_centreY;     ///< The y coordinate of the volume centre
+    double m_centreZ;     ///< The z coordinate of the volume centre
+    double m_halfWidthX;  ///< The half width of the volume along x
+    double m_halfWidthY;  ///< The half width of the volume along y
+    double m_halfWidthZ;  ///< The half width of the volume along z
+};
+
+typedef std::vector<LArNDTPCBox> LArNDTPCBoxList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDGeometryCache class. Searching the TGeoManager node tree of the full ND hall geometry takes seconds and hundreds of MB,
+ *          so the TPC boxes and anode positions it gives are written to a small text cache file, keyed on the geometry file checksum
+ *          and the TGeoManager and volume names, and read back by later jobs with the same geometry
+ */
+class LArNDGeometryCache
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  geomFileName the ROOT file containing the TGeoManager
+     *  @param  geomManagerName the name of the TGeoManager
+     *  @param  volumeName the name (or part of the name) of the TPC volumes
+     */
+    LArNDGeometryCache(const std::string &geomFileName, const std::string &geomManagerName, const std::string &volumeName);
+
+    /**
+     *  @brief  Find the TPC boxes and anode positions, from the cache file if it matches the geometry, or otherwise from the ROOT
+     *          geometry, then writing the cache file
+     *
+     *  @param  cacheFileName the cache file name (empty to always use the ROOT geometry, without a cache file)
+     *
+     *  @return whether the geometry could be read
+     */
+    bool Load(const std::string &cacheFileName);
+
+    /**
+     *  @brief  Get the TPC boxes
+     *
+     *  @return the TPC boxes, ordered by TPC id
+     */
+    const LArNDTPCBoxList &GetTPCBoxes() const;
+
+    /**
+     *  @brief  Get the anode x positions, found from the TPC x boundaries with the Anode - Cathode - Cathode - Anode module structure
+     *
+     *  @return the anode x positions, ordered in x
+     */
+    const std::vector<float> &GetAnodePositions() const;
+
+private:
+    /**
+     *  @brief  Read the cache file, if it was written for the same geometry file checksum, TGeoManager name and volume name, and ends
+     *          with the end of file marker
+     *
+     *  @param  cacheFileName the cache file name
+     *
+     *  @return whether the cache file could be used
+     */
+    bool ReadCacheFile(const std::string &cacheFileName);
+
+    /**
+     *  @brief  Write the cache file, to a temporary file that is only renamed to the cache file name once it is complete
+     *
+     *  @param  cacheFileName the cache file name
+     */
+    void WriteCacheFile(const std::string &cacheFileName) const;
+
+    /**
+     *  @brief  Find the TPC boxes by searching the ROOT geometry node tree
+     *
+     *  @return whether the ROOT geometry could be read
+     */
+    bool ReadROOTGeometry();
+
+    /**
+     *  @brief  Recursively search the geometry for the TPC volumes, storing the daughter indices of each path
+     *
+     *  @param  pSimGeom the TGeoManager, whose current node is the start of the search
+     *  @param  nodePaths to receive the paths to the TPC volumes
+     *  @param  currentPath the path to the current node
+     */
+    void RecursiveGeometrySearch(
+        TGeoManager *pSimGeom, std::vector<std::vector<unsigned int>> &nodePaths, std::vector<unsigned int> &currentPath) const;
+
+    /**
+     *  @brief  Fill the anode positions from the TPC boxes
+     */
+    void FillAnodePositions();
+
+    std::string m_geomFileName;          ///< The ROOT file containing the TGeoManager
+    std::string m_geomManagerName;       ///< The name of the TGeoManager
+    std::string m_volumeName;            ///< The name (or part of the name) of the TPC volumes
+    std::string m_checksum;              ///< The MD5 checksum of the geometry file
+    LArNDTPCBoxList m_tpcBoxes;          ///< The TPC boxes, ordered by TPC id
+    std::vector<float> m_anodePositions; ///< The anode x positions, ordered in x
+
+    static constexpr int m_cacheVersion{2}; ///< The cache file format version
+};
+
+} // namespace lar_nd_reco
+
+#endif
@@ -0,0 +1,289 @@
+/**
+ *  @file   LArRecoND/include/LArNDHitCache.h
+ *
+ *  @brief  Header file for the memory-mapped cache of the pre-decoded input event hits
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_HIT_CACHE_H
+#define PANDORA_LAR_ND_HIT_CACHE_H 1
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  LArNDHitCacheHeader class, the fixed size header at the start of a hit cache file. The header is followed by the event
+ *          table, one column per hit quantity and the table of source files, each starting on a 64 byte boundary so that it can be
+ *          read in place
+ */
+class LArNDHitCacheHeader
+{
+public:
+    /**
+     *  @brief  The sections of the file following the header, in file order
+     */
+    enum Section
+    {
+        HitOffsets = 0,        ///< The index of the first hit of each event, plus the total number of hits (uint64)
+        EventNumbers = 1,      ///< The event number of each event (int32)
+        X = 2,                 ///< The hit x positions (float)
+        Y = 3,                 ///< The hit y positions (float)
+        Z = 4,                 ///< The hit z positions (float)
+        Charge = 5,            ///< The hit charges (float)
+        TrackID = 6,           ///< The id of the MC particle making the largest contribution to each hit (int64)
+        EnergyFrac = 7,        ///< The energy fraction of the largest contribution to each hit (float)
+        HasMCContribution = 8, ///< Whether any MC particle contributes to each hit (uint8)
+        SourceFileEntries = 9, ///< The number of events in each of the files the hits were converted from, in chain order (uint64)
+        SourceFileNames = 10,  ///< The names of the files the hits were converted from, each terminated by a null character (char)
+        NSections = 11
+    };
+
+    /**
+     *  @brief  Set the file layout for the given numbers of events and hits
+     *
+     *  @param  nEvents the number of events
+     *  @param  nHits the total number of hits
+     *  @param  hasMCTruth whether the hits have MC truth
+     *  @param  nSourceFiles the number of source files
+     *  @param  sourceFileNamesSize the total size of the source file names, including their terminating null characters
+     */
+    void SetLayout(const std::uint64_t nEvents, const std::uint64_t nHits, const bool hasMCTruth, const std::uint64_t nSourceFiles,
+        const std::uint64_t sourceFileNamesSize);
+
+    /**
+     *  @brief  Get the size of each element of a section
+     *
+     *  @param  section the section
+     *
+     *  @return the element size, in bytes
+     */
+    static std::uint64_t GetElementSize(const Section section);
+
+    /**
+     *  @brief  Get the number of elements in a section
+     *
+     *  @param  section the section
+     *
+     *  @return the number of elements
+     */
+    std::uint64_t GetNElements(const Section section) const;
+
+    char m_magic[8];                           ///< The file type identifier
+    std::uint32_t m_version;                   ///< The cache format version
+    std::uint32_t m_hasMCTruth;                ///< Whether the hits have MC truth, i.e. were converted from the SPMC format
+    std::uint64_t m_nEvents;                   ///< The number of events
+    std::uint64_t m_nHits;                     ///< The total number of hits
+    std::uint64_t m_nSourceFiles;              ///< The number of source files
+    std::uint64_t m_sourceFileNamesSize;       ///< The total size of the source file names, in bytes
+    std::uint64_t m_fileSize;                  ///< The size of the file, in bytes
+    std::uint64_t m_sectionOffsets[NSections]; ///< The offset of each section from the start of the file, in bytes
+
+    static constexpr char m_cacheMagic[8]{'L', 'A', 'R', 'N', 'D', 'H', 'I', 'T'}; ///< The file type identifier
+    static constexpr std::uint32_t m_cacheVersion{2};                             ///< The cache format version
+    static constexpr std::uint64_t m_alignment{64};                               ///< The alignment of each section, in bytes
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDCachedHits class, the hits of one event, held as one vector per quantity in the layout of the hit cache columns
+ */
+class LArNDCachedHits
+{
+public:
+    /**
+     *  @brief  Clear the hits
+     */
+    void Clear();
+
+    std::vector<float> m_x;                        ///< The hit x positions
+    std::vector<float> m_y;                        ///< The hit y positions
+    std::vector<float> m_z;                        ///< The hit z positions
+    std::vector<float> m_charge;                   ///< The hit charges
+    std::vector<std::int64_t> m_trackID;           ///< The id of the largest MC particle contribution to each hit
+    std::vector<float> m_energyFrac;               ///< The energy fraction of the largest contribution to each hit
+    std::vector<std::uint8_t> m_hasMCContribution; ///< Whether any MC particle contributes to each hit
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDHitCacheEvent class, a view of the hits of one event in a memory-mapped hit cache, valid while the cache is open
+ */
+class LArNDHitCacheEvent
+{
+public:
+    std::size_t m_nHits{0};                           ///< The number of hits
+    int m_eventNumber{-1};                            ///< The event number
+    const float *m_x{nullptr};                        ///< The hit x positions
+    const float *m_y{nullptr};                        ///< The hit y positions
+    const float *m_z{nullptr};                        ///< The hit z positions
+    const float *m_charge{nullptr};                   ///< The hit charges
+    const std::int64_t *m_trackID{nullptr};           ///< The id of the largest MC particle contribution to each hit
+    const float *m_energyFrac{nullptr};               ///< The energy fraction of the largest contribution to each hit
+    const std::uint8_t *m_hasMCContribution{nullptr}; ///< Whether any MC particle contributes to each hit
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDHitCacheWriter class. The number of hits in each event must be known up front, so that the event table and the
+ *          column positions are fixed before the events are written in order, each event appending its hits to every column. The
+ *          header is written last, so an incomplete file is never mistaken for a hit cache
+ */
+class LArNDHitCacheWriter
+{
+public:
+    /**
+     *  @brief  Constructor, creating the file and writing its event table and the table of source files
+     *
+     *  @param  fileName the hit cache file name
+     *  @param  nEventHits the number of hits in each event
+     *  @param  hasMCTruth whether the hits have MC truth
+     *  @param  sourceFileNames the names of the files the hits are converted from, in chain order
+     *  @param  nSourceFileEntries the number of events in each source file, which must add up to the number of events
+     */
+    LArNDHitCacheWriter(const std::string &fileName, const std::vector<std::uint64_t> &nEventHits, const bool hasMCTruth,
+        const std::vector<std::string> &sourceFileNames, const std::vector<std::uint64_t> &nSourceFileEntries);
+
+    /**
+     *  @brief  Whether the file could be created
+     *
+     *  @return boolean
+     */
+    bool IsOpen() const;
+
+    /**
+     *  @brief  Write the next event
+     *
+     *  @param  eventNumber the event number
+     *  @param  hits the event hits, whose number must match that given to the constructor
+     *
+     *  @return success
+     */
+    bool WriteEvent(const int eventNumber, const LArNDCachedHits &hits);
+
+    /**
+     *  @brief  Write the header and close the file, once every event has been written
+     *
+     *  @return success
+     */
+    bool Close();
+
+private:
+    /**
+     *  @brief  Write the next elements of a section
+     *
+     *  @param  section the section
+     *  @param  pElements the address of the first element
+     *  @param  nElements the number of elements
+     */
+    void WriteElements(const LArNDHitCacheHeader::Section section, const void *const pElements, const std::uint64_t nElements);
+
+    std::string m_fileName;                                           ///< The hit cache file name
+    std::ofstream m_file;                                             ///< The hit cache file
+    LArNDHitCacheHeader m_header;                                     ///< The file header
+    std::vector<std::uint64_t> m_nEventHits;                          ///< The number of hits in each event
+    std::uint64_t m_nWrittenEvents;                                   ///< The number of events written so far
+    std::uint64_t m_nWrittenElements[LArNDHitCacheHeader::NSections]; ///< The number of elements written to each section so far
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArNDHitCache class, reading the pre-decoded hits of each event from a memory-mapped hit cache file. The columns are used
+ *          in place, so reading an event costs no more than touching its pages, which stay in the page cache between runs
+ */
+class LArNDHitCache
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    LArNDHitCache();
+
+    /**
+     *  @brief  Destructor, unmapping the file
+     */
+    ~LArNDHitCache();
+
+    LArNDHitCache(const LArNDHitCache &) = delete;
+    LArNDHitCache &operator=(const LArNDHitCache &) = delete;
+
+    /**
+     *  @brief  Map the hit cache file, checking that its header, event table and table of source files are consistent with its size
+     *
+     *  @param  fileName the hit cache file name
+     *
+     *  @return success
+     */
+    bool Open(const std::string &fileName);
+
+    /**
+     *  @brief  Get the number of events
+     *
+     *  @return the number of events
+     */
+    std::size_t GetNEvents() const;
+
+    /**
+     *  @brief  Whether the hits have MC truth
+     *
+     *  @return boolean
+     */
+    bool HasMCTruth() const;
+
+    /**
+     *  @brief  Get a view of the hits of an event
+     *
+     *  @param  iEvent the event index, which must be less than the number of events
+     *
+     *  @return the event hits
+     */
+    LArNDHitCacheEvent GetEvent(const std::size_t iEvent) const;
+
+    /**
+     *  @brief  Get the names of the files the hits were converted from
+     *
+     *  @return the source file names, in chain order
+     */
+    const std::vector<std::string> &GetSourceFileNames() const;
+
+    /**
+     *  @brief  Get the number of events in each of the files the hits were converted from
+     *
+     *  @return the number of events in each source file, in chain order
+     */
+    const std::vector<std::uint64_t> &GetNSourceFileEntries() const;
+
+private:
+    /**
+     *  @brief  Get the address of the first element of a section
+     *
+     *  @param  section the section
+     *
+     *  @return the address of the first element
+     */
+    template <typename T>
+    const T *GetSection(const LArNDHitCacheHeader::Section section) const;
+
+    /**
+     *  @brief  Unmap the file
+     */
+    void Close();
+
+    const unsigned char *m_pData;                    ///< The address of the mapped file
+    std::size_t m_dataSize;                          ///< The size of the mapped file, in bytes
+    LArNDHitCacheHeader m_header;                    ///< The file header
+    std::vector<std::string> m_sourceFileNames;      ///< The names of the files the hits were converted from
+    std::vector<std::uint64_t> m_nSourceFileEntries; ///< The number of events in each source file
+};
+
+} // namespace lar_nd_reco
+
+#endif
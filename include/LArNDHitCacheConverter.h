@@ -0,0 +1,115 @@
+/**
+ *  @file   LArRecoND/include/LArNDHitCacheConverter.h
+ *
+ *  @brief  Header file for the converter writing the hits of LArSP/LArSPMC format trees to a memory-mapped hit cache.
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_HIT_CACHE_CONVERTER_H
+#define PANDORA_LAR_ND_HIT_CACHE_CONVERTER_H 1
+
+#include "TChain.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_nd_converter
+{
+
+/**
+ *  @brief  ConverterParameters class
+ */
+class ConverterParameters
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    ConverterParameters();
+
+    std::string m_inputFileName;               ///< The input file(s), given as to PandoraInterface: a file, a glob, a comma-separated
+                                               ///< list or a .txt/.list file listing one file per line (mandatory parameter)
+    std::vector<std::string> m_inputFileNames; ///< The input files, read in order through a single chain
+    std::string m_inputTreeName;               ///< The input event TTree name (default = events)
+    std::string m_outputFileName;              ///< The output hit cache file name (mandatory parameter)
+    bool m_hasMCTruth;                         ///< Whether the input uses the SPMC format, so the hits have MC truth (default = true)
+
+    const long long m_inputCacheSize{32 * 1024 * 1024}; ///< The read cache size for the input chain (bytes)
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline ConverterParameters::ConverterParameters() :
+    m_inputFileName(""),
+    m_inputFileNames(),
+    m_inputTreeName("events"),
+    m_outputFileName(""),
+    m_hasMCTruth(true)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Create the chain of input event trees, in the order in which PandoraInterface reads the input files
+ *
+ *  @param  parameters the converter parameters
+ *
+ *  @return the input chain, or nullptr if it has no entries
+ */
+std::unique_ptr<TChain> MakeInputChain(const ConverterParameters &parameters);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Count the hits in each event, reading only the hit x positions
+ *
+ *  @param  parameters the converter parameters
+ *  @param  nEventHits to receive the number of hits in each event
+ *
+ *  @return success
+ */
+bool CountEventHits(const ConverterParameters &parameters, std::vector<std::uint64_t> &nEventHits);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Convert the event hits and write them to the hit cache
+ *
+ *  @param  parameters the converter parameters
+ *  @param  nEventHits the number of hits in each event
+ *
+ *  @return success
+ */
+bool ConvertEvents(const ConverterParameters &parameters, const std::vector<std::uint64_t> &nEventHits);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Parse the command line arguments, setting the converter parameters
+ *
+ *  @param  argc argument count
+ *  @param  argv argument vector
+ *  @param  parameters to receive the converter parameters
+ *
+ *  @return success
+ */
+bool ParseCommandLine(int argc, char *argv[], ConverterParameters &parameters);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Print the list of configurable options
+ *
+ *  @return false, to force abort
+ */
+bool PrintOptions();
+
+} // namespace lar_nd_converter
+
+#endif // #ifndef PANDORA_LAR_ND_HIT_CACHE_CONVERTER_H
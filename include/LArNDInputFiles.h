@@ -0,0 +1,55 @@
+/**
+ *  @file   LArRecoND/include/LArNDInputFiles.h
+ *
+ *  @brief  Header file for the functions finding the input event files and chaining their event trees, shared by the executables
+ *
+ *  $Log: $
+ */
+#ifndef PANDORA_LAR_ND_INPUT_FILES_H
+#define PANDORA_LAR_ND_INPUT_FILES_H 1
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+class TChain;
+
+namespace lar_nd_reco
+{
+
+/**
+ *  @brief  Expand an input events option into the list of input files. The option is a comma-separated list, in which each item
+ *          is a file, a glob, or a .txt/.list file naming one file (or glob) per line
+ *
+ *  @param  inputFilesOption The input events option
+ *  @param  inputFileNames To receive the input files, in the order in which their events are read
+ *
+ *  @return success
+ */
+bool ExpandInputFileNames(const std::string &inputFilesOption, std::vector<std::string> &inputFileNames);
+
+/**
+ *  @brief  Make the chain reading the event tree from each of the input files, with one read cache shared across all of them
+ *
+ *  @param  inputTreeName The name of the event tree
+ *  @param  inputFileNames The input files, in the order in which their events are read
+ *  @param  cacheSize The read cache size (bytes)
+ *
+ *  @return The input chain, or nullptr if none of the input files contain any events
+ */
+std::unique_ptr<TChain> MakeInputChain(
+    const std::string &inputTreeName, const std::vector<std::string> &inputFileNames, const long long cacheSize);
+
+/**
+ *  @brief  Get the files read by an input chain, along with the number of events in each of them
+ *
+ *  @param  inputChain The input chain
+ *  @param  fileNames To receive the names of the files, in chain order
+ *  @param  nFileEntries To receive the number of entries in each file
+ */
+void GetInputFileEntries(const TChain &inputChain, std::vector<std::string> &fileNames, std::vector<std::uint64_t> &nFileEntries);
+
+} // namespace lar_nd_reco
+
+#endif // #ifndef PANDORA_LAR_ND_INPUT_FILES_H
@@ -202,7 +202,7 @@ public:
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArRecoNDFormat::LArRecoNDFormat(TTree *tree) :
+inline LArRecoNDFormat::LArRecoNDFormat(TTree *tree) :
     m_fChain(nullptr)
 {
     // if parameter tree is not specified (or zero), connect the file
@@ -217,7 +217,7 @@ LArRecoNDFormat::LArRecoNDFormat(TTree *tree) :
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArRecoNDFormat::~LArRecoNDFormat()
+inline LArRecoNDFormat::~LArRecoNDFormat()
 {
     if (!m_fChain)
         return;
@@ -226,7 +226,7 @@ LArRecoNDFormat::~LArRecoNDFormat()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-Int_t LArRecoNDFormat::GetEntry(Long64_t entry)
+inline Int_t LArRecoNDFormat::GetEntry(Long64_t entry)
 {
     // Read contents of entry.
     if (!m_fChain)
@@ -236,7 +236,7 @@ Int_t LArRecoNDFormat::GetEntry(Long64_t entry)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArRecoNDFormat::Init(TTree *tree)
+inline void LArRecoNDFormat::Init(TTree *tree)
 {
     // The Init() function is called when the selector needs to initialize
     // a new tree or chain. Typically here the branch addresses and branch
@@ -156,7 +156,7 @@ public:
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArSED::LArSED(TTree *tree) : m_fChain(nullptr)
+inline LArSED::LArSED(TTree *tree) : m_fChain(nullptr)
 {
     // if parameter tree is not specified (or zero), connect the file
     // used to generate this class and read the Tree.
@@ -175,16 +175,17 @@ LArSED::LArSED(TTree *tree) : m_fChain(nullptr)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArSED::~LArSED()
+inline LArSED::~LArSED()
 {
-    if (!m_fChain)
+    // A chain owns its files, and closes them itself when it is deleted
+    if (!m_fChain || dynamic_cast<TChain *>(m_fChain))
         return;
     delete m_fChain->GetCurrentFile();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-Int_t LArSED::GetEntry(Long64_t entry)
+inline Int_t LArSED::GetEntry(Long64_t entry)
 {
     // Read contents of entry.
     if (!m_fChain)
@@ -194,7 +195,7 @@ Int_t LArSED::GetEntry(Long64_t entry)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArSED::Init(TTree *tree)
+inline void LArSED::Init(TTree *tree)
 {
     // The Init() function is called when the selector needs to initialize
     // a new tree or chain. Typically here the branch addresses and branch
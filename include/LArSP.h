@@ -82,7 +82,7 @@ public:
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArSP::LArSP(TTree *tree) :
+inline LArSP::LArSP(TTree *tree) :
     m_fChain(nullptr)
 {
     // if parameter tree is not specified (or zero), connect the file
@@ -97,16 +97,17 @@ LArSP::LArSP(TTree *tree) :
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArSP::~LArSP()
+inline LArSP::~LArSP()
 {
-    if (!m_fChain)
+    // A chain owns its files, and closes them itself when it is deleted
+    if (!m_fChain || dynamic_cast<TChain *>(m_fChain))
         return;
     delete m_fChain->GetCurrentFile();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-Int_t LArSP::GetEntry(Long64_t entry)
+inline Int_t LArSP::GetEntry(Long64_t entry)
 {
     // Read contents of entry.
     if (!m_fChain)
@@ -116,7 +117,7 @@ Int_t LArSP::GetEntry(Long64_t entry)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void LArSP::Init(TTree *tree)
+inline void LArSP::Init(TTree *tree)
 {
     // The Init() function is called when the selector needs to initialize
     // a new tree or chain. Typically here the branch addresses and branch
@@ -16,6 +16,11 @@
 #include "TROOT.h"
 
 // Header file for the classes stored in the TTree if any.
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <limits>
+#include <numeric>
 #include <vector>
 
 namespace lar_nd_reco
@@ -43,6 +48,16 @@ public:
      */
     virtual void InitMC(TTree *tree);
 
+    /**
+     *  @brief  Find the MC particle making the largest contribution to a hit of the current entry, and its share of the hit energy
+     *
+     *  @param  iHit The hit index
+     *  @param  hasMCContribution To receive whether any MC particle contributes to the hit
+     *  @param  trackID To receive the id of the largest contributor (0 if there is none)
+     *  @param  energyFrac To receive the normalised energy fraction of the largest contributor
+     */
+    void GetDominantContribution(const std::size_t iHit, bool &hasMCContribution, long &trackID, float &energyFrac) const;
+
     // Hit level truth information
     std::vector<std::vector<long>> *m_hit_particleID = nullptr;
     std::vector<std::vector<float>> *m_hit_packetFrac = nullptr;
@@ -110,7 +125,7 @@ public:
     TBranch *m_b_ccnc = nullptr;
 };
 
-LArSPMC::LArSPMC(TTree *tree) : LArSP(tree)
+inline LArSPMC::LArSPMC(TTree *tree) : LArSP(tree)
 {
     if (tree == nullptr)
     {
@@ -119,11 +134,11 @@ LArSPMC::LArSPMC(TTree *tree) : LArSP(tree)
     InitMC(tree);
 }
 
-LArSPMC::~LArSPMC()
+inline LArSPMC::~LArSPMC()
 {
 }
 
-void LArSPMC::InitMC(TTree *tree)
+inline void LArSPMC::InitMC(TTree *tree)
 {
     // The Init() function is called when the selector needs to initialize
     // a new tree or chain. Typically here the branch addresses and branch
@@ -172,6 +187,24 @@ void LArSPMC::InitMC(TTree *tree)
     m_fChain->SetBranchAddress("ccnc", &m_ccnc, &m_b_ccnc);
 }
 
+inline void LArSPMC::GetDominantContribution(const std::size_t iHit, bool &hasMCContribution, long &trackID, float &energyFrac) const
+{
+    const std::vector<float> &mcContribs = (*m_hit_packetFrac)[iHit];
+    const std::size_t biggestContribIndex = std::distance(mcContribs.begin(), std::max_element(mcContribs.begin(), mcContribs.end()));
+    const std::vector<long> &hitPartIDVect = (*m_hit_particleID)[iHit];
+    hasMCContribution = !hitPartIDVect.empty();
+    trackID = (hitPartIDVect.size() > biggestContribIndex) ? hitPartIDVect[biggestContribIndex] : 0;
+
+    // Due to the merging of hits, the contributions can sometimes add up to more than 1.
+    // Normalise first
+    const float sum = std::accumulate(mcContribs.begin(), mcContribs.end(), 0.f);
+    energyFrac = (biggestContribIndex < mcContribs.size() && std::abs(sum) > 0.0) ? mcContribs[biggestContribIndex] / sum : 0.f;
+
+    // Make sure the energy fraction is not larger than 1
+    if (energyFrac > 1.f + std::numeric_limits<float>::epsilon())
+        energyFrac = 1.f;
+}
+
 } // namespace lar_nd_reco
 
 #endif
@@ -0,0 +1,132 @@
+/**
+ *  @file   include/LArSlidingFitCache.h
+ *
+ *  @brief  Header file for the event-scoped sliding fit cache class.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_SLIDING_FIT_CACHE_H
+#define LAR_SLIDING_FIT_CACHE_H 1
+
+#include "larpandoracontent/LArObjects/LArThreeDSlidingFitResult.h"
+
+#include <cstddef>
+#include <map>
+#include <memory>
+#include <tuple>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  SlidingFitCache class, holding the 3D sliding fits made by all algorithms in a pandora instance during an event
+ */
+class SlidingFitCache
+{
+public:
+    /**
+     *  @brief  Get the sliding fit cache for a pandora instance, creating it on first use
+     *
+     *  @param  pandora the pandora instance
+     *
+     *  @return the sliding fit cache
+     */
+    static SlidingFitCache &GetInstance(const pandora::Pandora &pandora);
+
+    /**
+     *  @brief  Delete the sliding fit cache for a pandora instance, so that a new instance created at the same address starts with an
+     *          empty cache. Called by each algorithm using the cache when it is destroyed with its instance, the first call deleting it.
+     *
+     *  @param  pandora the pandora instance
+     */
+    static void DeleteInstance(const pandora::Pandora &pandora);
+
+    /**
+     *  @brief  Get the 3D sliding fit of a cluster, only fitting if there is no cached fit of its current hits with the same window
+     *          and pitch. A fit is invalidated automatically when the hits in the cluster change, e.g. after a merge. The returned
+     *          reference remains valid until the cluster is next fitted with different hits, or the cache is reset.
+     *
+     *  @param  pCluster address of the cluster
+     *  @param  slidingFitWindow the layer window for the sliding fit
+     *  @param  slidingFitPitch the layer pitch for the sliding fit
+     *
+     *  @return the sliding fit result, throwing the original status code if the fit failed
+     */
+    const ThreeDSlidingFitResult &GetSlidingFitResult(
+        const pandora::Cluster *const pCluster, const unsigned int slidingFitWindow, const float slidingFitPitch);
+
+    /**
+     *  @brief  Clear the cached fits and the hit/miss counters, at the end of each event
+     */
+    void Reset();
+
+    /**
+     *  @brief  Get the number of requests served from the cache this event
+     *
+     *  @return the number of cache hits
+     */
+    unsigned int GetNHits() const;
+
+    /**
+     *  @brief  Get the number of requests that needed a new fit this event
+     *
+     *  @return the number of cache misses
+     */
+    unsigned int GetNMisses() const;
+
+private:
+    /**
+     *  @brief  Default constructor
+     */
+    SlidingFitCache();
+
+    /**
+     *  @brief  Get an order-independent fingerprint of the hits in a cluster, covering both the hit addresses and their positions
+     *
+     *  @param  pCluster address of the cluster
+     *
+     *  @return the hit fingerprint
+     */
+    static std::size_t GetHitFingerprint(const pandora::Cluster *const pCluster);
+
+    /**
+     *  @brief  FitEntry class
+     */
+    class FitEntry
+    {
+    public:
+        /**
+         *  @brief  Default constructor, for an entry that has not yet been fitted
+         */
+        FitEntry();
+
+        std::size_t m_hitFingerprint;                          ///< The fingerprint of the cluster hits when the fit was made
+        pandora::StatusCode m_statusCode;                      ///< The status code of the fit
+        std::unique_ptr<ThreeDSlidingFitResult> m_pFitResult; ///< The fit result (nullptr if the fit failed)
+    };
+
+    typedef std::tuple<const pandora::Cluster *, unsigned int, float> FitKey;
+    typedef std::map<FitKey, FitEntry> FitEntryMap;
+
+    FitEntryMap m_fitEntryMap; ///< The cached fits, keyed by cluster, window and pitch
+    unsigned int m_nHits;      ///< The number of requests served from the cache this event
+    unsigned int m_nMisses;    ///< The number of requests that needed a new fit this event
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int SlidingFitCache::GetNHits() const
+{
+    return m_nHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline unsigned int SlidingFitCache::GetNMisses() const
+{
+    return m_nMisses;
+}
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_SLIDING_FIT_CACHE_H
@@ -1,7 +1,7 @@
 /**
  *  @file   LArRecoND/include/LArVoxel.h
  *
- *  @brief  Header file for LArVoxel and LArVoxelProjection
+ *  @brief  Header file for LArVoxelArray, LArVoxelAccumulator and LArVoxelProjection
  *
  *  $Log: $
  */
@@ -9,85 +9,209 @@
 #define PANDORA_LAR_VOXEL_H 1
 
 #include "Pandora/PandoraInputTypes.h"
+#include <algorithm>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace lar_nd_reco
 {
 
-class LArVoxel
+/**
+ *  @brief  LArVoxelArray class, holding voxels as a structure of arrays. The voxel bottom corners are not stored, since they are
+ *          given by the voxelisation grid for each voxel ID (LArGrid::GetBinIndices and LArGrid::GetPoint)
+ */
+class LArVoxelArray
 {
 public:
     /**
-     *  @brief  Constructor
+     *  @brief  Add a voxel
      *
      *  @param  voxelID Total bin number for the voxel (long integer, since it can be > 2^31)
      *  @param  energyInVoxel The total deposited energy in the voxel (GeV)
-     *  @param  voxelPosVect Voxel position, set as the first corner of the voxel bin
-     *  @param  trackID The Geant4 ID of the (first) contributing track to this voxel
+     *  @param  trackID The Geant4 ID of the (main) contributing track to this voxel
+     *  @param  tpcID ID of the tpc containing this voxel
      */
-    LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID);
+    void AddVoxel(const long voxelID, const float energyInVoxel, const int trackID, const int tpcID);
 
     /**
-     *  @brief  Constructor
+     *  @brief  Get the number of voxels
+     *
+     *  @return the number of voxels
+     */
+    std::size_t GetNVoxels() const;
+
+    /**
+     *  @brief  Clear the voxels
+     */
+    void Clear();
+
+    std::vector<long> m_voxelIDs;         ///< The long integer IDs of the voxels (can be larger than 2^31)
+    std::vector<float> m_energiesInVoxel; ///< The energies in the voxels (GeV)
+    std::vector<int> m_trackIDs;          ///< The Geant4 IDs of the (main) contributing tracks to the voxels
+    std::vector<int> m_tpcIDs;            ///< The IDs of the tpcs containing the voxels
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArVoxelArray::AddVoxel(const long voxelID, const float energyInVoxel, const int trackID, const int tpcID)
+{
+    m_voxelIDs.emplace_back(voxelID);
+    m_energiesInVoxel.emplace_back(energyInVoxel);
+    m_trackIDs.emplace_back(trackID);
+    m_tpcIDs.emplace_back(tpcID);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline std::size_t LArVoxelArray::GetNVoxels() const
+{
+    return m_voxelIDs.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline void LArVoxelArray::Clear()
+{
+    m_voxelIDs.clear();
+    m_energiesInVoxel.clear();
+    m_trackIDs.clear();
+    m_tpcIDs.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+class LArVoxelAccumulator
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    LArVoxelAccumulator();
+
+    /**
+     *  @brief  Add a voxel contribution, merging it with any previous contribution with the same voxel ID. The merged voxel keeps the
+     *          tpc ID of its first contribution, and is assigned the track ID with the largest summed energy
      *
      *  @param  voxelID Total bin number for the voxel (long integer, since it can be > 2^31)
-     *  @param  energyInVoxel The total deposited energy in the voxel (GeV)
-     *  @param  voxelPosVect Voxel position, set as the first corner of the voxel bin
-     *  @param  trackID The Geant4 ID of the (first) contributing track to this voxel
+     *  @param  energyInVoxel The deposited energy of this contribution (GeV)
+     *  @param  trackID The Geant4 ID of the contributing track
      *  @param  tpcID ID of the tpc containing this voxel
      */
-    LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID, const unsigned int tpcID);
+    void AddVoxel(const long voxelID, const float energyInVoxel, const int trackID, const int tpcID);
 
     /**
-     *  @brief  Set voxel energy (GeV)
+     *  @brief  Get the merged voxels, in the order of their first contributions
      *
-     *  @param  E voxel energy
+     *  @return the merged voxel array
      */
-    void SetEnergy(const float E);
+    const LArVoxelArray &GetMergedVoxels() const;
 
     /**
-     *  @brief  Set voxel track id
+     *  @brief  Get the number of voxel contributions added since the last clear
      *
-     *  @param  trackid is the track id
+     *  @return the number of added voxel contributions
      */
-    void SetTrackID(const int trackid);
+    std::size_t GetNAddedVoxels() const;
 
-    long m_voxelID;                          ///< The long integer ID of the voxel (can be larger than 2^31)
-    float m_energyInVoxel;                   ///< The energy in the voxel (GeV)
-    pandora::CartesianVector m_voxelPosVect; ///< Position vector (x,y,z) of the first voxel corner
-    int m_trackID;                           ///< The Geant4 ID of the (first) contributing track to this voxel
-    int m_tpcID;
+    /**
+     *  @brief  Clear the accumulated voxels
+     */
+    void Clear();
+
+private:
+    typedef std::pair<int, float> TrackEnergy;
+    typedef std::vector<TrackEnergy> TrackEnergyList;
+
+    LArVoxelArray m_mergedVoxels;                                        ///< The merged voxels, in the order of their first contributions
+    std::unordered_map<std::size_t, TrackEnergyList> m_trackEnergyLists; ///< The summed energy per track, only for merged voxel indices
+    std::unordered_map<long, std::size_t> m_voxelIndexMap;               ///< The map from voxel ID to the index of the merged voxel
+    std::size_t m_nAddedVoxels;                                          ///< The number of voxel contributions added since the last clear
 };
 
-typedef std::vector<LArVoxel> LArVoxelList;
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArVoxelAccumulator::LArVoxelAccumulator() :
+    m_nAddedVoxels(0)
+{
+}
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline LArVoxel::LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID) :
-    m_voxelID(voxelID), m_energyInVoxel(energyInVoxel), m_voxelPosVect(voxelPosVect), m_trackID(trackID), m_tpcID(0)
+inline void LArVoxelAccumulator::AddVoxel(const long voxelID, const float energyInVoxel, const int trackID, const int tpcID)
 {
+    ++m_nAddedVoxels;
+    const auto iter(m_voxelIndexMap.find(voxelID));
+
+    if (m_voxelIndexMap.end() == iter)
+    {
+        m_voxelIndexMap.emplace(voxelID, m_mergedVoxels.GetNVoxels());
+        m_mergedVoxels.AddVoxel(voxelID, energyInVoxel, trackID, tpcID);
+        return;
+    }
+
+    const std::size_t index(iter->second);
+    float &mergedEnergy(m_mergedVoxels.m_energiesInVoxel[index]);
+    int &mergedTrackID(m_mergedVoxels.m_trackIDs[index]);
+    TrackEnergyList &trackEnergyList(m_trackEnergyLists[index]);
+
+    // Single contributions don't need their track energies, so only store them once a voxel is merged
+    if (trackEnergyList.empty())
+        trackEnergyList.emplace_back(mergedTrackID, mergedEnergy);
+
+    mergedEnergy += energyInVoxel;
+
+    const auto hasTrackID([trackID](const TrackEnergy &trackEnergy) { return trackEnergy.first == trackID; });
+    const auto trackIter(std::find_if(trackEnergyList.begin(), trackEnergyList.end(), hasTrackID));
+
+    if (trackEnergyList.end() != trackIter)
+        trackIter->second += energyInVoxel;
+    else
+        trackEnergyList.emplace_back(trackID, energyInVoxel);
+
+    if (trackEnergyList.size() < 2)
+        return;
+
+    // Choose the track with the highest energy, preferring the lowest track ID for equal energies
+    float highestEnergy{0.f};
+    int bestTrackID{-1};
+
+    for (const TrackEnergy &trackEnergy : trackEnergyList)
+    {
+        const bool isTie((trackEnergy.second == highestEnergy) && (highestEnergy > 0.f) && (trackEnergy.first < bestTrackID));
+
+        if ((trackEnergy.second > highestEnergy) || isTie)
+        {
+            highestEnergy = trackEnergy.second;
+            bestTrackID = trackEnergy.first;
+        }
+    }
+
+    mergedTrackID = bestTrackID;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline LArVoxel::LArVoxel(const long voxelID, const float energyInVoxel, const pandora::CartesianVector &voxelPosVect, const int trackID,
-    const unsigned int tpcID) :
-    m_voxelID(voxelID), m_energyInVoxel(energyInVoxel), m_voxelPosVect(voxelPosVect), m_trackID(trackID), m_tpcID(tpcID)
+inline const LArVoxelArray &LArVoxelAccumulator::GetMergedVoxels() const
 {
+    return m_mergedVoxels;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline void LArVoxel::SetEnergy(const float E)
+inline std::size_t LArVoxelAccumulator::GetNAddedVoxels() const
 {
-    m_energyInVoxel = E;
+    return m_nAddedVoxels;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-inline void LArVoxel::SetTrackID(const int trackid)
+inline void LArVoxelAccumulator::Clear()
 {
-    m_trackID = trackid;
+    m_mergedVoxels.Clear();
+    m_trackEnergyLists.clear();
+    m_voxelIndexMap.clear();
+    m_nAddedVoxels = 0;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
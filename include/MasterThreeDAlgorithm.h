@@ -15,6 +15,9 @@
 #include "larpandoracontent/LArControlFlow/MultiPandoraApi.h"
 #include "larpandoracontent/LArObjects/LArCaloHit.h"
 
+#include <atomic>
+#include <memory>
+#include <string>
 #include <unordered_map>
 
 namespace lar_content
@@ -31,11 +34,105 @@ public:
     /**
      *  @brief  Default constructor
      */
-    MasterThreeDAlgorithm() = default;
+    MasterThreeDAlgorithm();
+
+    /**
+     *  @brief  Destructor
+     */
+    ~MasterThreeDAlgorithm();
+
+    /**
+     *  @brief  External steering parameters, adding the number of primary pandora instances processing events concurrently
+     */
+    class ExternalThreeDSteeringParameters : public MasterAlgorithm::ExternalSteeringParameters
+    {
+    public:
+        /**
+         *  @brief  Default constructor
+         */
+        ExternalThreeDSteeringParameters();
+
+        int m_nPrimaryInstances; ///< The number of primary pandora instances processing events concurrently
+    };
 
 protected:
     pandora::StatusCode Run() override;
 
+    /**
+     *  @brief  Run the per-volume cosmic-ray worker instances, concurrently if configured, returning only once all have finished
+     *
+     *  @param  volumeIdToHitListMap the volume id to hit list map
+     */
+    pandora::StatusCode RunCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap) const;
+
+    /**
+     *  @brief  Copy the hits in a single volume to the corresponding cosmic-ray worker instance and process the event
+     *
+     *  @param  pCRWorker the address of the cosmic-ray worker instance
+     *  @param  volumeIdToHitListMap the volume id to hit list map
+     */
+    pandora::StatusCode RunCosmicRayWorker(const pandora::Pandora *const pCRWorker, const VolumeIdToHitListMap &volumeIdToHitListMap) const;
+
+    /**
+     *  @brief  Reconstruct the slices using the pool of neutrino and cosmic-ray slice worker pairs, concurrently if configured
+     *
+     *  @param  sliceVector the slice vector
+     *  @param  nuSliceHypotheses to receive the neutrino slice hypotheses, in slice order
+     *  @param  crSliceHypotheses to receive the cosmic-ray slice hypotheses, in slice order
+     *  @param  nuOnlySliceHypotheses to receive the neutrino hypotheses of the slices whose cosmic-ray reconstruction was skipped, which
+     *          are left out of the other hypotheses
+     */
+    pandora::StatusCode RunSliceWorkerPairs(const SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses,
+        SliceHypotheses &crSliceHypotheses, SliceHypotheses &nuOnlySliceHypotheses) const;
+
+    /**
+     *  @brief  Reconstruct the slices assigned to a single neutrino and cosmic-ray slice worker pair
+     *
+     *  @param  workerPairIndex the index of the worker pair in the pool
+     *  @param  nWorkerPairs the number of worker pairs in use, giving the stride between the slices assigned to each pair
+     *  @param  sliceVector the slice vector
+     *  @param  nuSliceHypotheses to receive the neutrino hypotheses for the assigned slices (pre-sized, indexed by slice)
+     *  @param  crSliceHypotheses to receive the cosmic-ray hypotheses for the assigned slices (pre-sized, indexed by slice)
+     *  @param  nuOnlySliceFlags to receive, for the assigned slices, whether the cosmic-ray reconstruction was skipped (pre-sized,
+     *          indexed by slice, and not a bool vector so that the pairs can write their own entries concurrently)
+     */
+    pandora::StatusCode RunSliceWorkerPair(const unsigned int workerPairIndex, const unsigned int nWorkerPairs,
+        const SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses, SliceHypotheses &crSliceHypotheses,
+        pandora::IntVector &nuOnlySliceFlags) const;
+
+    /**
+     *  @brief  Copy the hits in a slice to a slice worker instance, process the event and extract the resulting pfos
+     *
+     *  @param  pPandora the address of the slice worker instance
+     *  @param  sliceHits the slice hits
+     *  @param  slicePfos to receive the pfos reconstructed for the slice
+     */
+    pandora::StatusCode ProcessSlice(
+        const pandora::Pandora *const pPandora, const pandora::CaloHitList &sliceHits, pandora::PfoList &slicePfos) const;
+
+    /**
+     *  @brief  Whether monitoring is enabled in any worker instance. The monitoring and event display are not thread safe, so the
+     *          worker instances are then run on a single thread
+     *
+     *  @return boolean
+     */
+    bool IsWorkerMonitoringEnabled() const;
+
+    /**
+     *  @brief  Recreate in the current pandora instance the pfos of the slices that only have a neutrino hypothesis, which bypass
+     *          slice id
+     *
+     *  @param  nuOnlySliceHypotheses the neutrino hypotheses of the slices whose cosmic-ray reconstruction was skipped
+     */
+    pandora::StatusCode RecreateNuOnlySlicePfos(const SliceHypotheses &nuOnlySliceHypotheses) const;
+
+    /**
+     *  @brief  Label the pfos in each slice hypothesis with their slice index
+     *
+     *  @param  sliceHypotheses the slice hypotheses
+     */
+    pandora::StatusCode SetSliceIndices(const SliceHypotheses &sliceHypotheses) const;
+
     /**
      *  @brief  Run cosmic-ray hit removal, freeing hits in ambiguous pfos for further processing
      *
@@ -94,6 +191,47 @@ protected:
      */
     pandora::StatusCode InitializeWorkerInstances();
 
+    /**
+     *  @brief  Reset all worker instances, including every instance in the slice worker pools
+     */
+    pandora::StatusCode ResetWorkerInstances();
+
+    /**
+     *  @brief  Create the per-volume cosmic-ray worker instances for any volumes with hits that do not yet have one
+     *
+     *  @param  volumeIdToHitListMap the volume id to hit list map
+     */
+    pandora::StatusCode CreateCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap);
+
+    /**
+     *  @brief  Parse a worker settings file once, so that the document can be shared by all worker instances using it
+     *
+     *  @param  settingsFile the pandora settings file
+     */
+    pandora::StatusCode LoadSettingsDocument(const std::string &settingsFile);
+
+    /**
+     *  @brief  Configure a worker instance, using the cached settings document if available
+     *
+     *  @param  pPandora the address of the pandora worker instance
+     *  @param  settingsFile the pandora settings file
+     */
+    pandora::StatusCode ReadWorkerSettings(const pandora::Pandora *const pPandora, const std::string &settingsFile) const;
+
+    /**
+     *  @brief  Hand a master hit to a worker instance, creating the worker hit from parameters built from the master hit and
+     *          setting its mc particle relationships if mc particles are passed to the worker instances
+     *
+     *  @param  pPandora the address of the pandora worker instance
+     *  @param  pCaloHitInMaster the address of the hit owned by the master instance
+     */
+    pandora::StatusCode HandOffCaloHit(const pandora::Pandora *const pPandora, const pandora::CaloHit *const pCaloHitInMaster) const;
+
+    /**
+     *  @brief  Print the number of hits handed to worker instances this event, with the memory they take up
+     */
+    void PrintHandOffSummary() const;
+
     /**
      *  @brief  Get the mapping from lar tpc volume id to lists of all hits, and truncated hits
      *
@@ -104,6 +242,17 @@ protected:
     pandora::StatusCode GetVolumeIdToHitListMap(VolumeIdToHitListMap &volumeIdToHitListMap) const;
 
     pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle) override;
+
+    typedef std::unordered_map<std::string, std::unique_ptr<pandora::TiXmlDocument>> SettingsDocumentMap;
+
+    bool m_createCRWorkersOnDemand;                         ///< Whether to create per-volume cosmic-ray worker instances only once their volume has hits
+    SettingsDocumentMap m_settingsDocumentMap;              ///< The parsed worker settings documents, keyed by settings file
+    LArCaloHitFactory m_workerCaloHitFactory;               ///< The factory used to create the worker hits from master hits
+    mutable std::atomic<unsigned int> m_nWorkerHitsCreated; ///< The number of worker hits created from master hits this event
+    unsigned int m_nCosmicRayThreads;                       ///< The number of threads used to run the per-volume cosmic-ray worker instances
+    unsigned int m_nSliceWorkerPairs;                       ///< The number of neutrino and cosmic-ray slice worker pairs used to reconstruct slices concurrently
+    PandoraInstanceList m_sliceNuWorkerPool;                ///< The pool of neutrino slice worker instances (the first entry is the standard slice nu worker)
+    PandoraInstanceList m_sliceCRWorkerPool;                ///< The pool of cosmic-ray slice worker instances (the first entry is the standard slice cr worker)
 };
 
 } // namespace lar_content
@@ -9,11 +9,22 @@
 #define LAR_MERGE_CLEAR_TRACKS_THREE_D_ALGORITHM_H 1
 
 #include "Pandora/Algorithm.h"
+#include "larpandoracontent/LArObjects/LArPointingCluster.h"
 #include "larpandoracontent/LArObjects/LArThreeDSlidingFitResult.h"
 
+#include <memory>
+#include <unordered_map>
+
 namespace lar_content
 {
 
+template <typename, unsigned int>
+class KDTreeLinkerAlgo;
+template <typename, unsigned int>
+class KDTreeNodeInfoT;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 /**
  *  @brief  MergeClearTracksThreeDAlgorithm class
  */
@@ -25,29 +36,68 @@ public:
      */
     MergeClearTracksThreeDAlgorithm();
 
+    /**
+     *  @brief  Destructor
+     */
+    ~MergeClearTracksThreeDAlgorithm();
+
     pandora::StatusCode Run();
 
 private:
     typedef std::map<const pandora::Cluster *const, float> ClusterFloatMap;
     typedef std::map<const pandora::Cluster *const, const pandora::Cluster *> ClusterMergeMap;
 
+    typedef std::unordered_map<const pandora::Cluster *, std::unique_ptr<LArPointingCluster>> PointingClusterCache; ///< nullptr for failed fits
+    typedef std::unordered_map<const pandora::Cluster *, unsigned int> ClusterToIndexMap;
+
+    typedef KDTreeLinkerAlgo<const pandora::Cluster *, 2> VertexKDTree2D;
+    typedef KDTreeNodeInfoT<const pandora::Cluster *, 2> VertexKDNode2D;
+    typedef std::vector<VertexKDNode2D> VertexKDNode2DList;
+
+    /**
+     *  @brief  Clear the shared sliding fit cache at the end of each event
+     */
+    pandora::StatusCode Reset();
+
     /**
      *  @brief  Look for possible merges between hit-sorted track-like clusters
      *  @param  pClusterList the list of clusters
+     *  @param  pointingClusterCache the cache of pointing clusters, updated with any missing entries and invalidated for merged clusters
      *
      *  @return whether we have found possible cluster merges
      */
-    bool FindMerges(const pandora::ClusterList *const pClusterList) const;
+    bool FindMerges(const pandora::ClusterList *const pClusterList, PointingClusterCache &pointingClusterCache) const;
+
+    /**
+     *  @brief  Get the pointing cluster for a cluster, building and caching it if required
+     *  @param  pCluster the cluster
+     *  @param  pointingClusterCache the cache of pointing clusters
+     *
+     *  @return address of the pointing cluster, or nullptr if the sliding fit failed
+     */
+    const LArPointingCluster *GetPointingCluster(const pandora::Cluster *const pCluster, PointingClusterCache &pointingClusterCache) const;
+
+    /**
+     *  @brief  Find, for each track-like cluster, the later clusters in the sorted vector with an end point close enough to allow a merge
+     *  @param  sortedClusters the hit-sorted track-like clusters with valid pointing clusters
+     *  @param  pointingClusterCache the cache of pointing clusters
+     *  @param  candidateIndices to receive, for each cluster, the sorted indices of the candidate partner clusters
+     */
+    void GetCandidatePairs(const pandora::ClusterVector &sortedClusters, PointingClusterCache &pointingClusterCache,
+        std::vector<std::vector<unsigned int>> &candidateIndices) const;
 
     /**
      *  @brief  Try to merge small clusters with large ones depending on their relative distances
      *  @param  pLargeCluster the large cluster
      *  @param  pSmallCluster the small cluster (reduced number of hits)
+     *  @param  largePointingCluster the pointing cluster for the large cluster
+     *  @param  smallPointingCluster the pointing cluster for the small cluster
      *  @param  mergeCandidates large-small cluster pair that can be merged
      *  @param  mergeDistances large-small cluster separation within distance and angle cuts
      */
     void CanMergeClusters(const pandora::Cluster *const pLargeCluster, const pandora::Cluster *const pSmallCluster,
-        ClusterMergeMap &mergeCandidates, ClusterFloatMap &mergeDistances) const;
+        const LArPointingCluster &largePointingCluster, const LArPointingCluster &smallPointingCluster, ClusterMergeMap &mergeCandidates,
+        ClusterFloatMap &mergeDistances) const;
 
     /**
      *  @brief  Merge the small cluster with the large one
@@ -14,17 +14,21 @@
 #include "TG4Event.h"
 #endif
 
-#include "TGeoManager.h"
-#include "TGeoNode.h"
-
 #include "LArGrid.h"
 #include "LArHitInfo.h"
+#include "LArNDCaloHitFactory.h"
 #include "LArNDGeomSimple.h"
+#include "LArNDGeometryCache.h"
+#include "LArNDHitCache.h"
 #include "LArSED.h"
 #include "LArSP.h"
 #include "LArSPMC.h"
 #include "LArVoxel.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
 namespace pandora
 {
 class Pandora;
@@ -36,7 +40,6 @@ namespace lar_nd_reco
 {
 
 typedef std::map<int, float> MCParticleEnergyMap;
-typedef std::vector<LArVoxel> LArVoxelList;
 
 /**
  *  @brief  Parameters class
@@ -61,12 +64,16 @@ public:
 
     std::string m_settingsFile;  ///< The path to the pandora settings file
                                  ///< (mandatory parameter)
-    std::string m_inputFileName; ///< The path to the input file containing events
-                                 ///< and/or geometry information
+    std::string m_inputFileName; ///< The input file(s) containing events: a file, a glob, a comma-separated
+                                 ///< list or a .txt/.list file listing one file per line
     std::string m_inputTreeName; ///< The optional name of the event TTree
 
-    std::string m_geomFileName;    ///< The ROOT file name containing the TGeoManager info
-    std::string m_geomManagerName; ///< The name of the TGeoManager
+    std::vector<std::string> m_inputFileNames; ///< The input files containing events, read in order through a single chain
+    std::string m_hitCacheFileName;            ///< The hit cache holding the pre-decoded SP/SPMC hits of the input files (default none)
+
+    std::string m_geomFileName;      ///< The ROOT file name containing the TGeoManager info
+    std::string m_geomManagerName;   ///< The name of the TGeoManager
+    std::string m_geomCacheFileName; ///< The geometry cache file, read instead of the TGeoManager when it matches (default none)
 
     std::string m_geometryVolName;  ///< The name of the Geant4 detector placement volume
     std::string m_sensitiveDetName; ///< The name of the Geant4 sensitive hit detector
@@ -86,8 +93,13 @@ public:
     bool m_shouldPerformSliceId;        ///< Whether to identify slices and select most appropriate pfos
     bool m_printOverallRecoStatus;      ///< Whether to print current operation status messages
 
+    std::string m_profileFileName; ///< The file to receive the per-algorithm profile (default none, i.e. no profiling)
+    float m_eventTimeBudget;       ///< The time allowed per event before optional stages are skipped (s, default 0, i.e. no limit)
+
     int m_nEventsToSkip;       ///< The number of events to skip
+    int m_nPrimaryInstances;   ///< The number of primary pandora instances processing events concurrently (default = 1)
     int m_maxMergedVoxels;     ///< The max number of merged voxels to process (default all)
+    int m_maxVoxelCoarsening;  ///< The max factor by which to widen the voxels of events with too many voxels (default = 1, skip them)
     int m_minNSpacePoints;     ///< The minimum number of space points for processing an event (default = 2)
     float m_minVoxelMipEquivE; ///< The minimum required voxel equivalent MIP energy (default = 0.3)
 
@@ -98,6 +110,8 @@ public:
     float m_lengthScale; ///< The scaling factor to set all lengths to cm
     float m_energyScale; ///< The scaling factor to set all energies to GeV
 
+    const long long m_inputCacheSize{32 * 1024 * 1024}; ///< The read cache size for the input chain, shared by all of its files (bytes)
+
     const float m_mm2cm{0.1f};          ///< mm to cm conversion
     const float m_MeV2GeV{1e-3};        ///< Geant4 MeV to GeV conversion
     const float m_voxelPathShift{1e-3}; ///< Small path shift to find next voxel
@@ -110,8 +124,11 @@ inline Parameters::Parameters() :
     m_settingsFile(""),
     m_inputFileName(""),
     m_inputTreeName(""),
+    m_inputFileNames(),
+    m_hitCacheFileName(""),
     m_geomFileName(""),
     m_geomManagerName(""),
+    m_geomCacheFileName(""),
     m_geometryVolName(""),
     m_sensitiveDetName(""),
     m_useModularGeometry(false),
@@ -125,8 +142,12 @@ inline Parameters::Parameters() :
     m_shouldRunCosmicRecoOption(true),
     m_shouldPerformSliceId(true),
     m_printOverallRecoStatus(false),
+    m_profileFileName(""),
+    m_eventTimeBudget(0.f),
     m_nEventsToSkip(0),
+    m_nPrimaryInstances(1),
     m_maxMergedVoxels(-1),
+    m_maxVoxelCoarsening(1),
     m_minNSpacePoints(2),
     m_minVoxelMipEquivE(0.3f),
     m_use3D(true),
@@ -137,6 +158,139 @@ inline Parameters::Parameters() :
 {
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  InstanceStartupGate class, running the first event of each concurrent primary pandora instance while no other instance is
+ *          processing an event. The first event creates the worker instances, so writes the process-wide multi-pandora registry,
+ *          which the instances read without locking.
+ */
+class InstanceStartupGate
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  nInstances The number of primary pandora instances
+     */
+    InstanceStartupGate(const int nInstances);
+
+    /**
+     *  @brief  Wait until no other instance is processing its first event, then start the first event of this instance
+     */
+    void EnterFirstEvent();
+
+    /**
+     *  @brief  Finish the first event of this instance, letting the next instance start its first event
+     */
+    void LeaveFirstEvent();
+
+    /**
+     *  @brief  Withdraw an instance that will not process any events, so that the other instances do not wait for it
+     */
+    void Withdraw();
+
+    /**
+     *  @brief  Wait until every instance has finished its first event, or has been withdrawn
+     */
+    void WaitForFirstEvents();
+
+private:
+    std::mutex m_mutex;                          ///< The mutex guarding the gate state
+    std::condition_variable m_conditionVariable; ///< The condition variable signalled whenever the gate state changes
+    int m_nPendingInstances;                     ///< The number of instances yet to finish their first event or be withdrawn
+    bool m_isFirstEventRunning;                  ///< Whether an instance is processing its first event
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  EventSubset class, the input events handled by a single primary pandora instance
+ */
+class EventSubset
+{
+public:
+    /**
+     *  @brief  Default constructor, selecting every input event
+     */
+    EventSubset();
+
+    /**
+     *  @brief  Get the next input event for this instance: the event after the previous one, or, if the input events are shared
+     *          between concurrent primary instances, the next event not yet claimed by any instance
+     *
+     *  @param  startEvt the first input event to process
+     *  @param  previousEvt the event previously returned, or startEvt - 1 before the first call
+     *
+     *  @return the next input event
+     */
+    int GetNextEvent(const int startEvt, const int previousEvt) const;
+
+    std::atomic<int> *m_pNextEventOffset; ///< The offset from the start event of the next unclaimed event, if shared between instances
+    std::vector<int> m_processedEvents;   ///< The selected events that were passed to pandora, in input order
+    InstanceStartupGate *m_pStartupGate;  ///< The gate for the first event of each concurrent primary instance, if any
+};
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline EventSubset::EventSubset() :
+    m_pNextEventOffset(nullptr),
+    m_pStartupGate(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline int EventSubset::GetNextEvent(const int startEvt, const int previousEvt) const
+{
+    // ATTN Each event is claimed by exactly one instance, which then reads it from its own input chain
+    return m_pNextEventOffset ? startEvt + (*m_pNextEventOffset)++ : previousEvt + 1;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  LArSpacePoint class, an input space point, or a voxel of merged space points, with its main contributing true particle
+ */
+class LArSpacePoint
+{
+public:
+    /**
+     *  @brief  Constructor
+     *
+     *  @param  position the position (cm)
+     *  @param  energy the energy (GeV)
+     *  @param  tpcID the ID of the tpc containing the space point
+     *  @param  hasMCContribution whether any true particle contributed to the space point
+     *  @param  trackID the file ID of the true particle contributing the most energy
+     *  @param  energyFrac the fraction of the space point energy from that true particle
+     */
+    LArSpacePoint(const pandora::CartesianVector &position, const float energy, const int tpcID, const bool hasMCContribution,
+        const long trackID, const float energyFrac);
+
+    pandora::CartesianVector m_position; ///< The position (cm)
+    float m_energy;                      ///< The energy (GeV)
+    int m_tpcID;                         ///< The ID of the tpc containing the space point
+    bool m_hasMCContribution;            ///< Whether any true particle contributed to the space point
+    long m_trackID;                      ///< The file ID of the true particle contributing the most energy
+    float m_energyFrac;                  ///< The fraction of the space point energy from that true particle
+};
+
+typedef std::vector<LArSpacePoint> LArSpacePointList;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+inline LArSpacePoint::LArSpacePoint(const pandora::CartesianVector &position, const float energy, const int tpcID,
+    const bool hasMCContribution, const long trackID, const float energyFrac) :
+    m_position(position),
+    m_energy(energy),
+    m_tpcID(tpcID),
+    m_hasMCContribution(hasMCContribution),
+    m_trackID(trackID),
+    m_energyFrac(energyFrac)
+{
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -152,41 +306,136 @@ void CreateGeometry(const Parameters &parameters, const pandora::Pandora *const
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  Recursively search for volumes with the target name
+ *  @brief  Create and register a tpc in pandora
  *
- *  @param  pSimGeom pointer to the input geometry
- *  @param  targetName the volume name that we want to find
- *  @param  nodeVector daughter indices to recreate the path to the target nodes
- *  @param  currentPath path to the current position in the geometry
+ *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  parameters The application parameters
+ *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  tpcBox the TPC volume box in the world volume, in the geometry length units
  */
-void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetName, std::vector<std::vector<unsigned int>> &nodePaths,
-    std::vector<unsigned int> &currentPath);
+void MakePandoraTPC(
+    const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom, const LArNDTPCBox &tpcBox);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  Create and register a tpc in pandora
+ *  @brief  Copy the detector geometry from one primary pandora instance to another, avoiding re-reading the geometry file
+ *
+ *  @param  pSourcePandora The address of the primary pandora instance holding the geometry
+ *  @param  pTargetPandora The address of the primary pandora instance to receive the geometry
+ */
+void CopyGeometry(const pandora::Pandora *const pSourcePandora, const pandora::Pandora *const pTargetPandora);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Process events using the supplied pandora instance
  *
- *  @param  pPrimaryPandora The address of the primary pandora instance
  *  @param  parameters The application parameters
+ *  @param  pPrimaryPandora The address of the primary pandora instance
  *  @param  geom Simple representation of the geometry for assigning TPC numbers
- *  @param  pVolMatrix matrix required to convert TPC coordinates to world
- *  @param  targetNode pointer to the TPC geometry node
- *  @param  tpcNumber the number for the TPC volume
+ *  @param  eventSubset The input events to process, receiving the list of events passed to pandora
  */
-void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom,
-    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *targetNode, const unsigned int tpcNumber);
+void ProcessEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  Process events using the supplied pandora instance
+ *  @brief  Pass the current event to pandora, running it through the startup gate if it is the first event of a concurrent instance
  *
  *  @param  parameters The application parameters
  *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  iEvt The input event number
+ *  @param  eventSubset The input events to process, receiving the event number
+ */
+void ProcessPandoraEvent(
+    const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const int iEvt, EventSubset &eventSubset);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Process events using several primary pandora instances concurrently, each taking an interleaved subset of the input events
+ *
+ *  @param  parameters The application parameters
+ *  @param  primaryPandoraInstances The addresses of the primary pandora instances
  *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  eventSubsets To receive the input events processed by each primary pandora instance
+ */
+void ProcessEventsConcurrently(const Parameters &parameters, const std::vector<const pandora::Pandora *> &primaryPandoraInstances,
+    const LArNDGeomSimple &geom, std::vector<EventSubset> &eventSubsets);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the analysis output file and tree names from the hierarchy analysis algorithm in the settings file
+ *
+ *  @param  settingsFile The pandora settings file
+ *  @param  analysisFileName To receive the analysis output file name
+ *  @param  analysisTreeName To receive the analysis output tree name
+ *
+ *  @return whether the settings file runs the hierarchy analysis algorithm
+ */
+bool GetAnalysisOutputNames(const std::string &settingsFile, std::string &analysisFileName, std::string &analysisTreeName);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the name of the analysis output file written by a single primary pandora instance
+ *
+ *  @param  analysisFileName The analysis output file name
+ *  @param  instanceIndex The index of the primary pandora instance
+ *
+ *  @return The analysis output file name for the instance
+ */
+std::string GetAnalysisPartFileName(const std::string &analysisFileName, const int instanceIndex);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Merge the analysis output files written by each primary pandora instance into one file, in input event order
+ *
+ *  @param  analysisFileName The analysis output file name
+ *  @param  analysisTreeName The analysis output tree name
+ *  @param  eventSubsets The input events processed by each primary pandora instance
+ */
+void MergeAnalysisOutput(
+    const std::string &analysisFileName, const std::string &analysisTreeName, const std::vector<EventSubset> &eventSubsets);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Make the chain reading the event tree from each of the input files, with one read cache shared across all of them
+ *
+ *  @param  parameters The application parameters
+ *
+ *  @return The input chain, or nullptr if none of the input files contain any events
+ */
+std::unique_ptr<TChain> MakeInputChain(const Parameters &parameters);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Print the input event about to be processed, along with the input file it is read from and its entry in that file
+ *
+ *  @param  pInputChain The address of the input chain
+ *  @param  iEvt The input event index, i.e. the chain entry
+ */
+void PrintInputEvent(TChain *const pInputChain, const int iEvt);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Open the hit cache and check it was converted from the input files, in the same order, then stop reading the cached hit
+ *          branches from the input chain
+ *
+ *  @param  parameters The application parameters
+ *  @param  pInputChain The address of the input chain
+ *  @param  hitCache To receive the mapped hit cache
+ *
+ *  @return success
  */
-void ProcessEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom);
+bool OpenHitCache(const Parameters &parameters, TChain *const pInputChain, LArNDHitCache &hitCache);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -195,8 +444,11 @@ void ProcessEvents(const Parameters &parameters, const pandora::Pandora *const p
  *
  *  @param  parameters The application parameters
  *  @param  pPrimaryPandora The address of the primary pandora instance
+ *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  eventSubset The input events to process, receiving the list of events passed to pandora
  */
-void ProcessSPEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom);
+void ProcessSPEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -209,6 +461,35 @@ void ProcessSPEvents(const Parameters &parameters, const pandora::Pandora *const
  */
 void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters);
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Merge the space points in each voxel of a grid, conserving their energy. Each merged space point is placed at the centre of
+ *          its voxel, and is assigned the true particle with the largest summed energy
+ *
+ *  @param  spacePoints the space points
+ *  @param  grid the voxelisation grid
+ *
+ *  @return the merged space points, in the order of their first space points
+ */
+LArSpacePointList MergeSpacePoints(const LArSpacePointList &spacePoints, const LArGrid &grid);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Create the pandora calohits from space points
+ *
+ *  @param  spacePoints the space points
+ *  @param  voxelWidth the hit cell size (cm)
+ *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  caloHitFactory the factory for the hits, which must remain in scope until the event is reset
+ *  @param  parameters the application parameters
+ *  @param  hitCounter reference to keep track of the number of hits
+ */
+void MakeCaloHitsFromSpacePoints(const LArSpacePointList &spacePoints, const float voxelWidth,
+    const pandora::Pandora *const pPrimaryPandora, const LArNDCaloHitFactory &caloHitFactory, const Parameters &parameters,
+    int &hitCounter);
+
 #ifdef USE_EDEPSIM
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -218,8 +499,10 @@ void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const p
  *  @param  parameters The application parameters
  *  @param  pPrimaryPandora The address of the primary pandora instance
  *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  eventSubset The input events to process, receiving the list of events passed to pandora
  */
-void ProcessEDepSimEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom);
+void ProcessEDepSimEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -244,8 +527,10 @@ MCParticleEnergyMap CreateEDepSimMCParticles(const TG4Event &event, const pandor
  *  @param  parameters The application parameters
  *  @param  pPrimaryPandora The address of the primary pandora instance
  *  @param  geom Simple representation of the geometry for assigning TPC numbers
+ *  @param  eventSubset The input events to process, receiving the list of events passed to pandora
  */
-void ProcessSEDEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom);
+void ProcessSEDEvents(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -308,27 +593,44 @@ LArGrid MakeVoxelisationGrid(const LArNDGeomSimple &geom, const Parameters &para
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
- *  @brief  Make voxels from a given Geant4 energy deposition step
+ *  @brief  Make voxels from a given Geant4 energy deposition step, merging them with the voxels already in the accumulator
  *
  *  @param  hitInfo Information about the hit
  *  @param  grid Voxelisation grid
  *  @param  parameters The application parameters
  *  @param  simple geometry information
+ *  @param  voxelAccumulator to receive the voxels, merged by voxel ID
+ */
+void MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom,
+    LArVoxelAccumulator &voxelAccumulator);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Make the voxels for the hit segments of an event. If there are more merged voxels than the maximum, the segments are
+ *          voxelised again on grids with bins 2, 4, ... times wider, up to the maximum voxel coarsening, until they fit
+ *
+ *  @param  hitInfos the hit segments
+ *  @param  grid the nominal voxelisation grid
+ *  @param  parameters the application parameters
+ *  @param  geom the simple geometry to assign TPC numbers
+ *  @param  voxelAccumulator to receive the merged voxels
  *
- *  @return vector of LArVoxels
+ *  @return the grid used to make the merged voxels
  */
-LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom);
+LArGrid VoxeliseHits(const LArHitInfoList &hitInfos, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom,
+    LArVoxelAccumulator &voxelAccumulator);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
  *  @brief  Combine energies for voxels with the same ID
  *
- *  @param  voxelList The unmerged list (vector) of voxels
+ *  @param  voxels The unmerged voxels
  *
- *  @return vector of merged LArVoxels
+ *  @return the merged voxels
  */
-LArVoxelList MergeSameVoxels(const LArVoxelList &voxelList);
+LArVoxelArray MergeSameVoxels(const LArVoxelArray &voxels);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -347,13 +649,28 @@ LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits);
  *  @brief  Create the pandora calohits from voxels
  *
  *  @param  voxels the voxels to use to create the hits
+ *  @param  grid the voxelisation grid, giving the voxel positions
  *  @param  mcEnergyMap map of mc particle to its energy
  *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  caloHitFactory the factory for the hits, which must remain in scope until the event is reset
  *  @param  parameters the application parameters
  *  @param  hitCounter reference to keep track of the number of hits
  */
-void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMap &mcEnergyMap,
-    const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, int &hitCounter);
+void MakeCaloHitsFromVoxels(const LArVoxelArray &voxels, const LArGrid &grid, const MCParticleEnergyMap &mcEnergyMap,
+    const pandora::Pandora *const pPrimaryPandora, const LArNDCaloHitFactory &caloHitFactory, const Parameters &parameters,
+    int &hitCounter);
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Reset the primary pandora instance at the end of an event, reporting the calo hit allocations and timing for the event
+ *          if status messages are enabled (-p)
+ *
+ *  @param  parameters the application parameters
+ *  @param  pPrimaryPandora address of the primary pandora instance
+ *  @param  caloHitFactory the factory used to create the hits for the event
+ */
+void ResetEvent(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, LArNDCaloHitFactory &caloHitFactory);
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
@@ -408,6 +725,60 @@ bool PrintOptions();
  */
 void ProcessViewOption(const std::string &viewOption, Parameters &parameters);
 
+/**
+ *  @brief  Check the requested number of primary pandora instances is supported
+ *
+ *  @param  parameters the application parameters
+ *
+ *  @return success
+ */
+bool ProcessInstancesOption(const Parameters &parameters);
+
+/**
+ *  @brief  Check the requested algorithm profiling is supported
+ *
+ *  @param  parameters the application parameters
+ *
+ *  @return success
+ */
+bool ProcessProfileOption(const Parameters &parameters);
+
+/**
+ *  @brief  Check the requested maximum voxel coarsening is supported
+ *
+ *  @param  parameters the application parameters
+ *
+ *  @return success
+ */
+bool ProcessCoarseningOption(const Parameters &parameters);
+
+/**
+ *  @brief  Check the requested event time budget is supported
+ *
+ *  @param  parameters the application parameters
+ *
+ *  @return success
+ */
+bool ProcessTimeBudgetOption(const Parameters &parameters);
+
+/**
+ *  @brief  Expand the input events option into the list of input files
+ *
+ *  @param  parameters to receive the list of input files
+ *
+ *  @return success
+ */
+bool ProcessInputFilesOption(Parameters &parameters);
+
+/**
+ *  @brief  Check the requested hit cache is supported by the input data format
+ *
+ *  @param  parameters the application parameters
+ *
+ *  @return success
+ */
+bool ProcessHitCacheOption(const Parameters &parameters);
+
 /**
  *  @brief  Process the provided reco option string to perform high-level steering
  *
@@ -441,6 +812,17 @@ bool ProcessFormatOption(const std::string &formatOption, const std::string &inp
  */
 void ProcessExternalParameters(const Parameters &parameters, const pandora::Pandora *const pPandora);
 
+/**
+ *  @brief  Pass the analysis output file name, processed events and input files to the hierarchy analysis algorithm of a primary instance
+ *
+ *  @param  analysisFileName the analysis output file name for the instance (empty to keep the settings file name)
+ *  @param  eventSubset the event subset of the instance, which must outlive it
+ *  @param  parameters the parameters
+ *  @param  pPandora the address of the pandora instance
+ */
+void ProcessInstanceParameters(const std::string &analysisFileName, const EventSubset &eventSubset, const Parameters &parameters,
+    const pandora::Pandora *const pPandora);
+
 } // namespace lar_nd_reco
 
 #endif // #ifndef PANDORA_ND_INTERFACE_H
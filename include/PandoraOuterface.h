@@ -98,6 +98,8 @@ struct ParameterStruct
     std::string fGeoManagerName = "Default";
     bool fGeoVolumeSetCmdLine = false;
     std::string fGeoVolumeName = "volTPCActive";
+    bool fGeoCacheSetCmdLine = false;
+    std::string fGeoCacheFileName = ""; // TPC volume cache, read instead of the geometry manager when it matches the geometry
 
     // Containment volumes
     float ContainDistX = 5.f; // cm
@@ -193,6 +195,25 @@ float pFromRange_proton(const float inputRange);
  */
 float KEFromRange_proton(const float inputRange);
 
+/**
+ *  @brief  Chi2 particle identification of a track, comparing its dE/dx against the dE/dx vs residual range templates
+ *
+ *  @param  parameters the input parameters, holding the templates and the dE/dx and dx restrictions
+ *  @param  trackVecDX the dx of each track calorimetry point
+ *  @param  trackVecDEDX the dE/dx of each track calorimetry point
+ *  @param  trackVecRR the residual range of each track calorimetry point
+ *  @param  pdg to receive the pdg code of the hypothesis with the smallest chi2 per point
+ *  @param  ndf to receive the number of points used
+ *  @param  muScore to receive the muon chi2 per point
+ *  @param  piScore to receive the pion chi2 per point
+ *  @param  kScore to receive the kaon chi2 per point
+ *  @param  proScore to receive the proton chi2 per point
+ *
+ *  @return whether any points were used, i.e. whether the outputs have been set
+ */
+bool Chi2PID(const ParameterStruct &parameters, const std::vector<float> &trackVecDX, const std::vector<float> &trackVecDEDX,
+    const std::vector<float> &trackVecRR, int &pdg, int &ndf, float &muScore, float &piScore, float &kScore, float &proScore);
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 /**
@@ -439,7 +460,7 @@ private:
     std::vector<float> m_out_shwrEndZ;
 };
 
-NDRecoOutputData::NDRecoOutputData(const std::string filename)
+inline NDRecoOutputData::NDRecoOutputData(const std::string filename)
 {
 
     m_fileOut = new TFile(filename.c_str(), "RECREATE");
@@ -613,7 +634,7 @@ NDRecoOutputData::NDRecoOutputData(const std::string filename)
     m_treeOut->Branch("shwrEndZ", &m_out_shwrEndZ);
 }
 
-void NDRecoOutputData::ClearData()
+inline void NDRecoOutputData::ClearData()
 {
     m_out_event = 0;
     m_out_subrun = 0;
@@ -743,13 +764,13 @@ void NDRecoOutputData::ClearData()
     m_out_shwrEndZ.clear();
 }
 
-void NDRecoOutputData::WriteToFile()
+inline void NDRecoOutputData::WriteToFile()
 {
     m_treeOut->Fill();
     ClearData();
 }
 
-void NDRecoOutputData::CloseFile()
+inline void NDRecoOutputData::CloseFile()
 {
     m_treeMeta->Write();
     m_treeOut->Write();
@@ -757,7 +778,7 @@ void NDRecoOutputData::CloseFile()
     std::cout << "NDRecoOutputData File has been closed." << std::endl;
 }
 
-void NDRecoOutputData::FillMetadata(const ParameterStruct &parameters)
+inline void NDRecoOutputData::FillMetadata(const ParameterStruct &parameters)
 {
     parRunTrackFit = parameters.runTrackFit;
     parRunShowerFit = parameters.runShowerFit;
@@ -794,7 +815,7 @@ void NDRecoOutputData::FillMetadata(const ParameterStruct &parameters)
     m_treeMeta->Fill();
 }
 
-void NDRecoOutputData::FillBasicBranches(const std::unique_ptr<LArRecoNDFormat> &inputSpill)
+inline void NDRecoOutputData::FillBasicBranches(const std::unique_ptr<LArRecoNDFormat> &inputSpill)
 {
     m_out_event = inputSpill->m_event;
     m_out_subrun = inputSpill->m_subrun;
@@ -869,7 +890,7 @@ void NDRecoOutputData::FillBasicBranches(const std::unique_ptr<LArRecoNDFormat>
     m_out_mcNuPz.insert(m_out_mcNuPz.end(), inputSpill->m_mcNuPz->begin(), inputSpill->m_mcNuPz->end());
 }
 
-void NDRecoOutputData::FillTrackBranches(const std::vector<float> &startX, const std::vector<float> &startY,
+inline void NDRecoOutputData::FillTrackBranches(const std::vector<float> &startX, const std::vector<float> &startY,
     const std::vector<float> &startZ, const std::vector<float> &dirX, const std::vector<float> &dirY, const std::vector<float> &dirZ,
     const std::vector<float> &endX, const std::vector<float> &endY, const std::vector<float> &endZ, const std::vector<float> &enddirX,
     const std::vector<float> &enddirY, const std::vector<float> &enddirZ, const std::vector<float> &length,
@@ -897,7 +918,7 @@ void NDRecoOutputData::FillTrackBranches(const std::vector<float> &startX, const
     m_out_pFromLengthProton.insert(m_out_pFromLengthProton.end(), pFromRangeP.begin(), pFromRangeP.end());
 }
 
-void NDRecoOutputData::FillTrackCaloBranches(const ParameterStruct &parameters, const std::vector<float> &tfCaloE,
+inline void NDRecoOutputData::FillTrackCaloBranches(const ParameterStruct &parameters, const std::vector<float> &tfCaloE,
     const std::vector<float> &tfVisE, const std::vector<int> &tfSliceId, const std::vector<int> &tfPfoId, const std::vector<float> &tfX,
     const std::vector<float> &tfY, const std::vector<float> &tfZ, const std::vector<float> &tfQ, const std::vector<float> &tfRR,
     const std::vector<float> &tfdx, const std::vector<float> &tfdQdx, const std::vector<float> &tfdEdx)
@@ -921,7 +942,7 @@ void NDRecoOutputData::FillTrackCaloBranches(const ParameterStruct &parameters,
     }
 }
 
-void NDRecoOutputData::FillTrackPID(const std::vector<int> &pidPDG, const std::vector<int> &pidNDF, const std::vector<float> &pidMu,
+inline void NDRecoOutputData::FillTrackPID(const std::vector<int> &pidPDG, const std::vector<int> &pidNDF, const std::vector<float> &pidMu,
     const std::vector<float> &pidPi, const std::vector<float> &pidK, const std::vector<float> &pidPro)
 {
     m_out_pid_pdg.insert(m_out_pid_pdg.end(), pidPDG.begin(), pidPDG.end());
@@ -932,7 +953,7 @@ void NDRecoOutputData::FillTrackPID(const std::vector<int> &pidPDG, const std::v
     m_out_pid_pro.insert(m_out_pid_pro.end(), pidPro.begin(), pidPro.end());
 }
 
-void NDRecoOutputData::FillShowerBranches(const std::vector<float> &shwrcentX, const std::vector<float> &shwrcentY,
+inline void NDRecoOutputData::FillShowerBranches(const std::vector<float> &shwrcentX, const std::vector<float> &shwrcentY,
     const std::vector<float> &shwrcentZ, const std::vector<float> &shwrstartX, const std::vector<float> &shwrstartY,
     const std::vector<float> &shwrstartZ, const std::vector<float> &shwrdirX, const std::vector<float> &shwrdirY,
     const std::vector<float> &shwrdirZ, const std::vector<float> &shwrlength, const std::vector<int> &shwrSlice,
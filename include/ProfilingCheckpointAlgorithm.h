@@ -0,0 +1,49 @@
+/**
+ *  @file   include/ProfilingCheckpointAlgorithm.h
+ *
+ *  @brief  Header file for the profiling checkpoint algorithm class.
+ *
+ *  $Log: $
+ */
+#ifndef LAR_PROFILING_CHECKPOINT_ALGORITHM_H
+#define LAR_PROFILING_CHECKPOINT_ALGORITHM_H 1
+
+#include "Pandora/Algorithm.h"
+
+#include "LArAlgorithmProfiler.h"
+
+#include <memory>
+#include <string>
+
+namespace lar_content
+{
+
+/**
+ *  @brief  ProfilingCheckpointAlgorithm class, inserted around the top-level algorithms in the settings by the algorithm profiler
+ */
+class ProfilingCheckpointAlgorithm : public pandora::Algorithm
+{
+public:
+    /**
+     *  @brief  Default constructor
+     */
+    ProfilingCheckpointAlgorithm();
+
+    /**
+     *  @brief  Destructor, writing out the profile of the instance when it is torn down
+     */
+    ~ProfilingCheckpointAlgorithm();
+
+private:
+    pandora::StatusCode Initialize();
+    pandora::StatusCode Run();
+
+    pandora::StatusCode ReadSettings(const pandora::TiXmlHandle xmlHandle);
+
+    std::string m_profiledAlgorithm;                                        ///< The algorithm run before the checkpoint, or empty at start
+    std::shared_ptr<AlgorithmProfiler::InstanceProfile> m_pInstanceProfile; ///< The profile of the instance, shared by its checkpoints
+};
+
+} // namespace lar_content
+
+#endif // #ifndef LAR_PROFILING_CHECKPOINT_ALGORITHM_H
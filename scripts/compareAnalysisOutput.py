@@ -0,0 +1,86 @@
+# Script to check that two LArRecoND analysis output files hold the same reconstruction,
+# e.g. the output of a serial run and a run of the same input events with the -P option
+
+import argparse
+import math
+import ROOT
+import sys
+
+def getValues(tree, branchName):
+    value = getattr(tree, branchName)
+    # Vector branches are compared element by element
+    try:
+        return [v for v in value]
+    except TypeError:
+        return [value]
+
+def isEqual(value1, value2, tolerance):
+    if isinstance(value1, float) or isinstance(value2, float):
+        if math.isnan(value1) and math.isnan(value2):
+            return True
+        return math.fabs(value1 - value2) <= tolerance * max(math.fabs(value1), math.fabs(value2))
+    return value1 == value2
+
+def compare(fileName1, fileName2, treeName, tolerance, maxReports):
+    file1 = ROOT.TFile.Open(fileName1, 'read')
+    file2 = ROOT.TFile.Open(fileName2, 'read')
+
+    if not file1 or not file2:
+        print('Unable to open {0} and {1}'.format(fileName1, fileName2))
+        return False
+
+    tree1 = file1.Get(treeName)
+    tree2 = file2.Get(treeName)
+
+    if not tree1 or not tree2:
+        print('Unable to find the {0} tree in both files'.format(treeName))
+        return False
+
+    branches1 = set(b.GetName() for b in tree1.GetListOfBranches())
+    branches2 = set(b.GetName() for b in tree2.GetListOfBranches())
+
+    if branches1 != branches2:
+        print('Branches only in one file: {0}'.format(sorted(branches1.symmetric_difference(branches2))))
+        return False
+
+    nEntries = tree1.GetEntries()
+
+    if nEntries != tree2.GetEntries():
+        print('Different numbers of entries: {0} and {1}'.format(nEntries, tree2.GetEntries()))
+        return False
+
+    nDifferences = 0
+    differentBranches = set()
+
+    for entry in range(nEntries):
+        tree1.GetEntry(entry)
+        tree2.GetEntry(entry)
+
+        for branchName in sorted(branches1):
+            values1 = getValues(tree1, branchName)
+            values2 = getValues(tree2, branchName)
+
+            if len(values1) == len(values2) and all(isEqual(v1, v2, tolerance) for v1, v2 in zip(values1, values2)):
+                continue
+
+            nDifferences += 1
+            differentBranches.add(branchName)
+
+            if nDifferences <= maxReports:
+                print('Entry {0} (event {1}) branch {2}: {3} != {4}'.format(entry, tree1.event, branchName, values1, values2))
+
+    print('Compared {0} entries of {1} branches: {2} differences in {3} branches'.format(nEntries, len(branches1),
+                                                                                       nDifferences, len(differentBranches)))
+    return 0 == nDifferences
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description = 'Compare two LArRecoND analysis output files entry by entry')
+    parser.add_argument('fileName1', help = 'First analysis output file, e.g. from a serial run')
+    parser.add_argument('fileName2', help = 'Second analysis output file, e.g. from a run with -P')
+    parser.add_argument('--tree', default = 'LArRecoND', help = 'Analysis output tree name')
+    parser.add_argument('--tolerance', type = float, default = 0.0, help = 'Relative tolerance for floating point values')
+    parser.add_argument('--maxReports', type = int, default = 20, help = 'Maximum number of differences to print')
+    args = parser.parse_args()
+
+    sys.exit(0 if compare(args.fileName1, args.fileName2, args.tree, args.tolerance, args.maxReports) else 1)
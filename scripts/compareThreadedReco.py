@@ -0,0 +1,86 @@
+# Script to check that the threaded LArMasterThreeD worker options reproduce the serial reconstruction. The same events are
+# reconstructed twice, first with NCosmicRayThreads and NSliceWorkerPairs set to 1 and then with the requested values, and the
+# two hierarchy analysis outputs, which hold the output pfo hierarchy, are compared entry by entry
+
+import argparse
+import os
+import subprocess
+import sys
+import xml.etree.ElementTree as ElementTree
+
+from compareAnalysisOutput import compare
+
+def writeSettings(settingsFile, nCosmicRayThreads, nSliceWorkerPairs, analysisFileName, suffix):
+    tree = ElementTree.parse(settingsFile)
+    foundMaster = False
+    foundAnalysis = False
+    analysisTreeName = 'LArRecoND'
+
+    for algorithm in tree.getroot().iter('algorithm'):
+        if algorithm.get('type') == 'LArMasterThreeD':
+            foundMaster = True
+            for name, value in (('NCosmicRayThreads', nCosmicRayThreads), ('NSliceWorkerPairs', nSliceWorkerPairs)):
+                element = algorithm.find(name)
+                if element is None:
+                    element = ElementTree.SubElement(algorithm, name)
+                element.text = str(value)
+        elif algorithm.get('type') == 'LArHierarchyAnalysis':
+            foundAnalysis = True
+            element = algorithm.find('AnalysisFileName')
+            if element is None:
+                element = ElementTree.SubElement(algorithm, 'AnalysisFileName')
+            element.text = analysisFileName
+            treeElement = algorithm.find('AnalysisTreeName')
+            if treeElement is not None:
+                analysisTreeName = treeElement.text.strip()
+
+    if not foundMaster or not foundAnalysis:
+        print('{0} needs both the LArMasterThreeD and LArHierarchyAnalysis algorithms'.format(settingsFile))
+        return None, None
+
+    # Written next to the original, so that any settings files it names are found in the same way
+    root, extension = os.path.splitext(settingsFile)
+    outputSettingsFile = '{0}_{1}{2}'.format(root, suffix, extension)
+    tree.write(outputSettingsFile)
+    return outputSettingsFile, analysisTreeName
+
+def runReco(pandoraInterface, settingsFile, recoArgs):
+    command = [pandoraInterface, '-i', settingsFile] + recoArgs
+    print('Running {0}'.format(' '.join(command)))
+    return 0 == subprocess.call(command)
+
+if __name__ == '__main__':
+
+    parser = argparse.ArgumentParser(description = 'Compare the serial and threaded LArMasterThreeD reconstruction of the same events',
+                                     epilog = 'Any further arguments, e.g. -r AllHitsNu -e Events.root -g Geometry.root -f SPMC -n 100, are '
+                                              'passed on to PandoraInterface')
+    parser.add_argument('settingsFile', help = 'Master settings file, e.g. settings/PandoraSettings_LArRecoND_ThreeD.xml')
+    parser.add_argument('--nCosmicRayThreads', type = int, default = 4, help = 'Number of cosmic-ray threads for the threaded run')
+    parser.add_argument('--nSliceWorkerPairs', type = int, default = 4, help = 'Number of slice worker pairs for the threaded run')
+    parser.add_argument('--pandoraInterface', default = './bin/PandoraInterface', help = 'PandoraInterface executable')
+    parser.add_argument('--outputPrefix', default = 'ThreadedRecoCheck', help = 'Prefix of the two analysis output files')
+    parser.add_argument('--tolerance', type = float, default = 0.0, help = 'Relative tolerance for floating point values')
+    args, recoArgs = parser.parse_known_args()
+
+    runs = (('serial', 1, 1), ('threaded', args.nCosmicRayThreads, args.nSliceWorkerPairs))
+    analysisFileNames = []
+
+    for suffix, nCosmicRayThreads, nSliceWorkerPairs in runs:
+        analysisFileName = '{0}_{1}.root'.format(args.outputPrefix, suffix)
+        settingsFile, analysisTreeName = writeSettings(args.settingsFile, nCosmicRayThreads, nSliceWorkerPairs, analysisFileName, suffix)
+
+        if settingsFile is None:
+            sys.exit(1)
+
+        try:
+            succeeded = runReco(args.pandoraInterface, settingsFile, recoArgs)
+        finally:
+            os.remove(settingsFile)
+
+        if not succeeded:
+            print('The {0} reconstruction failed'.format(suffix))
+            sys.exit(1)
+
+        analysisFileNames.append(analysisFileName)
+
+    sys.exit(0 if compare(analysisFileNames[0], analysisFileNames[1], analysisTreeName, args.tolerance, 20) else 1)
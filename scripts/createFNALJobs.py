@@ -11,7 +11,7 @@ import sys
 class setupPars(object):
 
     def __init__(self, sample, minSample, nSamples, inputDir, firstEvt,
-                 nEvtJob, eventTree, dataFormat):
+                 nEvtJob, eventTree, dataFormat, filesPerJob = 1):
 
         # Sample name
         self.sample = sample
@@ -33,6 +33,9 @@ class setupPars(object):
         self.eventTree = eventTree
         # Data format
         self.dataFormat = dataFormat
+        # Number of input files per job. If this is more than 1, each job
+        # reconstructs all of the events in its files (nEvtJob is not used)
+        self.filesPerJob = filesPerJob
 
 
 # Input file parameters
@@ -205,7 +208,7 @@ def getInFileLabel(sample, iS):
     return label
 
 
-def createJobScript(jobScript, jobDir, ePars, gPars, iPars, jPars, rPars):
+def createJobScript(jobScript, jobDir, ePars, gPars, iParsList, jPars, rPars):
 
     # If jobScript exists, delete it
     if os.path.exists(jobScript):
@@ -258,8 +261,9 @@ def createJobScript(jobScript, jobDir, ePars, gPars, iPars, jPars, rPars):
     FWSPath2 = '$_CONDOR_SCRATCH_DIR/LArRecoND/settings'
     jobFile.write('export FW_SEARCH_PATH={0}:{1}\n'.format(FWSPath1, FWSPath2))
 
-    # Copy inputFile to local batch dir
-    jobFile.write('ifdh cp -D {0} $_CONDOR_SCRATCH_DIR\n'.format(iPars.inFileCopy))
+    # Copy the input files to local batch dir
+    for iPars in iParsList:
+        jobFile.write('ifdh cp -D {0} $_CONDOR_SCRATCH_DIR\n'.format(iPars.inFileCopy))
 
     # Copy geometry file to local batch dir if required
     if gPars.geomFile != '':
@@ -268,12 +272,14 @@ def createJobScript(jobScript, jobDir, ePars, gPars, iPars, jPars, rPars):
     # Print directory contents to check presence of directories and inputFile
     jobFile.write('ls -tral {0}\n\n'.format(jPars.batchDir))
 
-    # LArRecoND run command: required parameters (and print events)
+    # LArRecoND run command: required parameters (and print events).
+    # Several input files are given as a comma-separated list, and read in order
+    inFiles = ','.join([iPars.inFileCopy.split('/')[-1] for iPars in iParsList])
     runCmd = './{0} -i {1} -r {2} -e {3} -N'.format(jPars.recoExe, rPars.xmlFile, rPars.recoOption,
-                                                    iPars.inFileCopy.split('/')[-1])
+                                                    inFiles)
     # Data format, projection, event tree and numbers
-    runCmd = '{0} -f {1} -j {2} -k {3} -s {4} -n {5}'.format(runCmd, iPars.dataFormat,
-                                                             rPars.projection, iPars.eventTree,
+    runCmd = '{0} -f {1} -j {2} -k {3} -s {4} -n {5}'.format(runCmd, iParsList[0].dataFormat,
+                                                             rPars.projection, iParsList[0].eventTree,
                                                              ePars.startEvt, ePars.NEvents)
     # Geometry parameters
     if gPars.geomFile != '':
@@ -327,6 +333,9 @@ def createJobs(sPars, gPars, rPars):
         else:
             print('Copied geometry file {0} exists\n'.format(geomCopy))
 
+    # Input files to be split into groups of filesPerJob
+    groupPars = []
+
     # Loop over input samples
     for iS in range(sPars.minSample, sPars.nSamples+1):
 
@@ -349,6 +358,12 @@ def createJobs(sPars, gPars, rPars):
         print('inFileCopy = {0}'.format(iPars.inFileCopy))
 
         print('Number of events in {0} = {1}'.format(iPars.inFileCopy, iPars.N))
+
+        # Several files per job: collect them, and create their jobs after the loop
+        if sPars.filesPerJob > 1:
+            groupPars.append(iPars)
+            continue
+
         # Set the end event remainder for the final job
         remainder = iPars.N%sPars.nEvtJob
         print('Event remainder = {0}'.format(remainder))
@@ -390,7 +405,7 @@ def createJobs(sPars, gPars, rPars):
             ePars = eventPars(startEvt, endEvt)
 
             # Create the job script using the various parameter objects
-            createJobScript(jobScript, jobDir, ePars, gPars, iPars, jPars, rPars)
+            createJobScript(jobScript, jobDir, ePars, gPars, [iPars], jPars, rPars)
 
             # Set job log file
             logFile = '{0}/submitJob.log'.format(jobDir)
@@ -408,6 +423,37 @@ def createJobs(sPars, gPars, rPars):
         print('Writing job submission script {0}'.format(runSampleName))
         runSampleFile.close()
 
+    # Jobs that each reconstruct all of the events in filesPerJob input files
+    for iG in range(0, len(groupPars), sPars.filesPerJob):
+
+        iParsList = groupPars[iG:iG+sPars.filesPerJob]
+        NEvents = sum([iPars.N for iPars in iParsList])
+
+        # Create job directory in scratch area
+        iJob = iG//sPars.filesPerJob + 1
+        jobDir = '{0}/group_job{1}'.format(jPars.scratchSample, iJob)
+        print('jobDir = {0} for {1} files with {2} events'.format(jobDir, len(iParsList), NEvents))
+        if not os.path.exists(jobDir):
+            print('Creating {0}'.format(jobDir))
+            os.makedirs(jobDir)
+            os.chmod(jobDir, 0o744)
+
+        # Create the job script, processing all events in the files
+        jobScript = '{0}/job.sh'.format(jobDir)
+        ePars = eventPars(0, NEvents - 1)
+        createJobScript(jobScript, jobDir, ePars, gPars, iParsList, jPars, rPars)
+
+        # Set job log file
+        logFile = '{0}/submitJob.log'.format(jobDir)
+
+        # Set job submission command
+        jobCmd = 'jobsub_submit -N 1 --resource-provides=usage_model=OPPORTUNISTIC ' \
+                 '--expected-lifetime={0} --singularity-image={1} ' \
+                 '--append_condor_requirements={2} --group=dune --memory={3} -L {4} ' \
+                 'file://{5}\n\n'.format(jPars.runtime, jPars.singularity, jPars.cvmfs,
+                                         jPars.memory, logFile, jobScript)
+        runAllFile.write(jobCmd)
+
     print('Writing job submission script {0}'.format(runAllFileName))
     runAllFile.close()
 
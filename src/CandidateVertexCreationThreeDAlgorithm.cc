@@ -11,7 +11,11 @@
 #include "larpandoracontent/LArHelpers/LArClusterHelper.h"
 #include "larpandoracontent/LArHelpers/LArGeometryHelper.h"
 
+#include "larpandoracontent/LArUtility/KDTreeLinkerAlgoT.h"
+
 #include "CandidateVertexCreationThreeDAlgorithm.h"
+#include "LArEventTimeBudget.h"
+#include "LArSlidingFitCache.h"
 
 #include <utility>
 
@@ -43,6 +47,13 @@ CandidateVertexCreationThreeDAlgorithm::CandidateVertexCreationThreeDAlgorithm()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+CandidateVertexCreationThreeDAlgorithm::~CandidateVertexCreationThreeDAlgorithm()
+{
+    SlidingFitCache::DeleteInstance(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode CandidateVertexCreationThreeDAlgorithm::Run()
 {
     try
@@ -59,8 +70,11 @@ StatusCode CandidateVertexCreationThreeDAlgorithm::Run()
             this->CreateEndpointVertices(clusterVector3D);
         }
 
-        if (m_enableCrossingCandidates)
+        if (m_enableCrossingCandidates &&
+            !EventTimeBudget::GetInstance(this->GetPandora()).ShouldSkipStage("CandidateVertexCreationThreeD crossing candidates"))
+        {
             this->CreateCrossingCandidates(clusterVector3D);
+        }
 
         if (!m_inputVertexListName.empty())
             this->AddInputVertices();
@@ -81,6 +95,13 @@ StatusCode CandidateVertexCreationThreeDAlgorithm::Run()
 
     this->TidyUp();
 
+    if (PandoraContentApi::GetSettings(*this)->ShouldDisplayAlgorithmInfo())
+    {
+        const SlidingFitCache &slidingFitCache(SlidingFitCache::GetInstance(this->GetPandora()));
+        std::cout << "CandidateVertexCreationThreeDAlgorithm: sliding fit cache " << slidingFitCache.GetNHits() << " hits, "
+                  << slidingFitCache.GetNMisses() << " misses this event" << std::endl;
+    }
+
     return STATUS_CODE_SUCCESS;
 }
 
@@ -199,22 +220,88 @@ void CandidateVertexCreationThreeDAlgorithm::CreateCrossingCandidates(const Clus
 
 void CandidateVertexCreationThreeDAlgorithm::FindCrossingPoints(const ClusterVector &clusterVector, CartesianPointVector &crossingPoints) const
 {
-    ClusterToSpacepointsMap clusterToSpacepointsMap;
+    const unsigned int nClusters(clusterVector.size());
+    const float maxCrossingSeparation(std::sqrt(m_maxCrossingSeparationSquared));
+
+    std::vector<CartesianPointVector> clusterSpacepoints(nClusters);
+    std::vector<CartesianVector> minPositions, maxPositions;
 
-    for (const Cluster *const pCluster : clusterVector)
+    for (unsigned int i = 0; i < nClusters; ++i)
     {
-        ClusterToSpacepointsMap::iterator mapIter(clusterToSpacepointsMap.emplace(pCluster, CartesianPointVector()).first);
-        this->GetSpacepoints(pCluster, mapIter->second);
+        CartesianPointVector &spacepoints(clusterSpacepoints.at(i));
+        this->GetSpacepoints(clusterVector.at(i), spacepoints);
+
+        CartesianVector minPosition(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max());
+        CartesianVector maxPosition(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max());
+
+        for (const CartesianVector &position : spacepoints)
+        {
+            minPosition.SetValues(std::min(minPosition.GetX(), position.GetX()), std::min(minPosition.GetY(), position.GetY()),
+                std::min(minPosition.GetZ(), position.GetZ()));
+            maxPosition.SetValues(std::max(maxPosition.GetX(), position.GetX()), std::max(maxPosition.GetY(), position.GetY()),
+                std::max(maxPosition.GetZ(), position.GetZ()));
+        }
+
+        minPositions.push_back(minPosition);
+        maxPositions.push_back(maxPosition);
     }
 
-    for (const Cluster *const pCluster1 : clusterVector)
+    // Find the closest approach once per unordered cluster pair, using a kd tree of the spacepoints of the later cluster in the pair.
+    // The crossings are stored in a triangular array, holding only the pairs i < j
+    const auto pairIndex = [nClusters](const unsigned int i, const unsigned int j)
+    { return i * (2 * nClusters - i - 1) / 2 + j - i - 1; };
+    std::vector<ClusterCrossing> clusterCrossings((nClusters > 1) ? nClusters * (nClusters - 1) / 2 : 0);
+
+    for (unsigned int j = 1; j < nClusters; ++j)
     {
-        for (const Cluster *const pCluster2 : clusterVector)
+        const CartesianPointVector &spacepoints2(clusterSpacepoints.at(j));
+
+        if (spacepoints2.empty())
+            continue;
+
+        PointKDNode2DList kDNode2DList;
+        for (unsigned int index = 0; index < spacepoints2.size(); ++index)
+            kDNode2DList.emplace_back(index, spacepoints2.at(index).GetX(), spacepoints2.at(index).GetZ());
+
+        PointKDTree2D kdTree;
+        kdTree.build(kDNode2DList, KDTreeBox(minPositions.at(j).GetX(), maxPositions.at(j).GetX(), minPositions.at(j).GetZ(), maxPositions.at(j).GetZ()));
+
+        for (unsigned int i = 0; i < j; ++i)
         {
-            if (pCluster1 == pCluster2)
+            // Bounding box rejection: a pair of spacepoints closer than the max separation must be within it along every axis
+            const CartesianVector &min1(minPositions.at(i)), &max1(maxPositions.at(i));
+            const CartesianVector &min2(minPositions.at(j)), &max2(maxPositions.at(j));
+
+            if ((min1.GetX() - max2.GetX() > maxCrossingSeparation) || (min2.GetX() - max1.GetX() > maxCrossingSeparation) ||
+                (min1.GetY() - max2.GetY() > maxCrossingSeparation) || (min2.GetY() - max1.GetY() > maxCrossingSeparation) ||
+                (min1.GetZ() - max2.GetZ() > maxCrossingSeparation) || (min2.GetZ() - max1.GetZ() > maxCrossingSeparation))
+            {
                 continue;
+            }
 
-            this->FindCrossingPoints(clusterToSpacepointsMap.at(pCluster1), clusterToSpacepointsMap.at(pCluster2), crossingPoints);
+            this->FindCrossingPoints(clusterSpacepoints.at(i), spacepoints2, kdTree, clusterCrossings.at(pairIndex(i, j)));
+        }
+    }
+
+    // Add the crossing points in the order of the original ordered-pair scan, so that the deduplication gives identical results
+    CrossingPointGrid crossingPointGrid;
+
+    for (unsigned int i = 0; i < nClusters; ++i)
+    {
+        for (unsigned int j = 0; j < nClusters; ++j)
+        {
+            if (i == j)
+                continue;
+
+            const ClusterCrossing &clusterCrossing(clusterCrossings.at(pairIndex(std::min(i, j), std::max(i, j))));
+
+            if (!clusterCrossing.m_isCrossing)
+                continue;
+
+            if (i < j)
+                this->AddCrossingPoints(clusterCrossing.m_position1A, clusterCrossing.m_position2A, crossingPointGrid, crossingPoints);
+            else
+                this->AddCrossingPoints(clusterCrossing.m_position2B, clusterCrossing.m_position1B, crossingPointGrid, crossingPoints);
         }
     }
 }
@@ -246,49 +333,149 @@ void CandidateVertexCreationThreeDAlgorithm::GetSpacepoints(const Cluster *const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void CandidateVertexCreationThreeDAlgorithm::FindCrossingPoints(
-    const CartesianPointVector &spacepoints1, const CartesianPointVector &spacepoints2, CartesianPointVector &crossingPoints) const
+void CandidateVertexCreationThreeDAlgorithm::FindCrossingPoints(const CartesianPointVector &spacepoints1,
+    const CartesianPointVector &spacepoints2, PointKDTree2D &kdTree2, ClusterCrossing &clusterCrossing) const
 {
+    const float maxCrossingSeparation(std::sqrt(m_maxCrossingSeparationSquared));
+
+    // Collect all spacepoint index pairs sharing the smallest separation, so ties can be resolved as in a full scan
     bool bestCrossingFound(false);
     float bestSeparationSquared(m_maxCrossingSeparationSquared);
-    CartesianVector bestPosition1(0.f, 0.f, 0.f), bestPosition2(0.f, 0.f, 0.f);
+    std::vector<std::pair<unsigned int, unsigned int>> bestIndexPairs;
 
-    for (const CartesianVector &position1 : spacepoints1)
+    for (unsigned int index1 = 0; index1 < spacepoints1.size(); ++index1)
     {
-        for (const CartesianVector &position2 : spacepoints2)
+        const CartesianVector &position1(spacepoints1.at(index1));
+        const KDTreeBox searchRegion(position1.GetX() - maxCrossingSeparation, position1.GetX() + maxCrossingSeparation,
+            position1.GetZ() - maxCrossingSeparation, position1.GetZ() + maxCrossingSeparation);
+
+        PointKDNode2DList found;
+        kdTree2.search(searchRegion, found);
+
+        for (const PointKDNode2D &node : found)
         {
-            const float separationSquared((position1 - position2).GetMagnitudeSquared());
+            const float separationSquared((position1 - spacepoints2.at(node.data)).GetMagnitudeSquared());
 
             if (separationSquared < bestSeparationSquared)
             {
                 bestCrossingFound = true;
                 bestSeparationSquared = separationSquared;
-                bestPosition1 = position1;
-                bestPosition2 = position2;
+                bestIndexPairs.clear();
+                bestIndexPairs.emplace_back(index1, node.data);
+            }
+            else if (bestCrossingFound && (separationSquared == bestSeparationSquared))
+            {
+                bestIndexPairs.emplace_back(index1, node.data);
             }
         }
     }
 
-    if (bestCrossingFound)
+    if (!bestCrossingFound)
+        return;
+
+    // Scanning cluster 1 first selects the lowest (index1, index2) pair, scanning cluster 2 first the lowest (index2, index1) pair
+    std::pair<unsigned int, unsigned int> bestPairA(bestIndexPairs.front()), bestPairB(bestIndexPairs.front());
+
+    for (const auto &indexPair : bestIndexPairs)
     {
-        bool alreadyPopulated(false);
+        if (indexPair < bestPairA)
+            bestPairA = indexPair;
+
+        if (std::make_pair(indexPair.second, indexPair.first) < std::make_pair(bestPairB.second, bestPairB.first))
+            bestPairB = indexPair;
+    }
 
-        for (const CartesianVector &existingPosition : crossingPoints)
+    clusterCrossing.m_isCrossing = true;
+    clusterCrossing.m_position1A = spacepoints1.at(bestPairA.first);
+    clusterCrossing.m_position2A = spacepoints2.at(bestPairA.second);
+    clusterCrossing.m_position1B = spacepoints1.at(bestPairB.first);
+    clusterCrossing.m_position2B = spacepoints2.at(bestPairB.second);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+long long CandidateVertexCreationThreeDAlgorithm::GetCrossingGridKey(const int ix, const int iy, const int iz) const
+{
+    const long long mask((1LL << 21) - 1);
+    return ((static_cast<long long>(ix) & mask) << 42) | ((static_cast<long long>(iy) & mask) << 21) | (static_cast<long long>(iz) & mask);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CandidateVertexCreationThreeDAlgorithm::GetCrossingGridCell(const CartesianVector &position, int &ix, int &iy, int &iz) const
+{
+    // Cells are twice the minimum crossing distance, so any nearby crossing point lies in the same or an adjacent cell
+    const float cellSize(2.f * std::sqrt(m_minNearbyCrossingDistanceSquared));
+
+    ix = static_cast<int>(std::floor(position.GetX() / cellSize));
+    iy = static_cast<int>(std::floor(position.GetY() / cellSize));
+    iz = static_cast<int>(std::floor(position.GetZ() / cellSize));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CandidateVertexCreationThreeDAlgorithm::AddCrossingPoints(const CartesianVector &position1, const CartesianVector &position2,
+    CrossingPointGrid &crossingPointGrid, CartesianPointVector &crossingPoints) const
+{
+    if (this->IsNearbyCrossingPoint(position1, crossingPointGrid) || this->IsNearbyCrossingPoint(position2, crossingPointGrid))
+        return;
+
+    crossingPoints.push_back(position1);
+    crossingPoints.push_back(position2);
+
+    if (m_minNearbyCrossingDistanceSquared > 0.f)
+    {
+        for (const CartesianVector &position : {position1, position2})
         {
-            if (((existingPosition - bestPosition1).GetMagnitudeSquared() < m_minNearbyCrossingDistanceSquared) ||
-                ((existingPosition - bestPosition2).GetMagnitudeSquared() < m_minNearbyCrossingDistanceSquared))
-            {
-                alreadyPopulated = true;
-                break;
-            }
+            int ix(0), iy(0), iz(0);
+            this->GetCrossingGridCell(position, ix, iy, iz);
+            crossingPointGrid[this->GetCrossingGridKey(ix, iy, iz)].push_back(position);
         }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool CandidateVertexCreationThreeDAlgorithm::IsNearbyCrossingPoint(const CartesianVector &position, const CrossingPointGrid &crossingPointGrid) const
+{
+    if (m_minNearbyCrossingDistanceSquared <= 0.f)
+        return false;
+
+    int ix(0), iy(0), iz(0);
+    this->GetCrossingGridCell(position, ix, iy, iz);
 
-        if (!alreadyPopulated)
+    for (int dx = -1; dx <= 1; ++dx)
+    {
+        for (int dy = -1; dy <= 1; ++dy)
         {
-            crossingPoints.push_back(bestPosition1);
-            crossingPoints.push_back(bestPosition2);
+            for (int dz = -1; dz <= 1; ++dz)
+            {
+                const CrossingPointGrid::const_iterator iter(crossingPointGrid.find(this->GetCrossingGridKey(ix + dx, iy + dy, iz + dz)));
+
+                if (crossingPointGrid.end() == iter)
+                    continue;
+
+                for (const CartesianVector &existingPosition : iter->second)
+                {
+                    if ((existingPosition - position).GetMagnitudeSquared() < m_minNearbyCrossingDistanceSquared)
+                        return true;
+                }
+            }
         }
     }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CandidateVertexCreationThreeDAlgorithm::ClusterCrossing::ClusterCrossing() :
+    m_isCrossing(false),
+    m_position1A(0.f, 0.f, 0.f),
+    m_position2A(0.f, 0.f, 0.f),
+    m_position1B(0.f, 0.f, 0.f),
+    m_position2B(0.f, 0.f, 0.f)
+{
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -345,9 +532,10 @@ void CandidateVertexCreationThreeDAlgorithm::AddInputVertices() const
 void CandidateVertexCreationThreeDAlgorithm::AddToSlidingFitCache(const Cluster *const pCluster)
 {
     const float slidingFitPitch(LArGeometryHelper::GetWireZPitch(this->GetPandora()));
-    const ThreeDSlidingFitResult slidingFitResult(pCluster, m_slidingFitWindow, slidingFitPitch);
+    const ThreeDSlidingFitResult &slidingFitResult(
+        SlidingFitCache::GetInstance(this->GetPandora()).GetSlidingFitResult(pCluster, m_slidingFitWindow, slidingFitPitch));
 
-    if (!m_slidingFitResultMap.insert(ThreeDSlidingFitResultMap::value_type(pCluster, slidingFitResult)).second)
+    if (!m_slidingFitResultMap.insert(ClusterToSlidingFitMap::value_type(pCluster, &slidingFitResult)).second)
         throw StatusCodeException(STATUS_CODE_FAILURE);
 }
 
@@ -355,12 +543,12 @@ void CandidateVertexCreationThreeDAlgorithm::AddToSlidingFitCache(const Cluster
 
 const ThreeDSlidingFitResult &CandidateVertexCreationThreeDAlgorithm::GetCachedSlidingFitResult(const Cluster *const pCluster) const
 {
-    ThreeDSlidingFitResultMap::const_iterator iter = m_slidingFitResultMap.find(pCluster);
+    ClusterToSlidingFitMap::const_iterator iter = m_slidingFitResultMap.find(pCluster);
 
     if (m_slidingFitResultMap.end() == iter)
         throw StatusCodeException(STATUS_CODE_NOT_FOUND);
 
-    return iter->second;
+    return *iter->second;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -372,6 +560,14 @@ void CandidateVertexCreationThreeDAlgorithm::TidyUp()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode CandidateVertexCreationThreeDAlgorithm::Reset()
+{
+    SlidingFitCache::GetInstance(this->GetPandora()).Reset();
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode CandidateVertexCreationThreeDAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 {
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, XmlHelper::ReadValue(xmlHandle, "InputClusterListName", m_inputClusterListName));
@@ -12,12 +12,16 @@
 
 #include "CreateTwoDClustersFromThreeDAlgorithm.h"
 
+#include <algorithm>
+#include <chrono>
+
 using namespace pandora;
 
 namespace lar_content
 {
 
-CreateTwoDClustersFromThreeDAlgorithm::CreateTwoDClustersFromThreeDAlgorithm()
+CreateTwoDClustersFromThreeDAlgorithm::CreateTwoDClustersFromThreeDAlgorithm() :
+    m_printTimings(false)
 {
 }
 
@@ -46,48 +50,19 @@ StatusCode CreateTwoDClustersFromThreeDAlgorithm::Run()
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputCaloHitListNames2D.at(1), pCaloHitListV));
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputCaloHitListNames2D.at(2), pCaloHitListW));
 
-    HitUsedMap usedHitsU, usedHitsV, usedHitsW;
-
-    for (const CaloHit *const pCaloHit : *pCaloHitListU)
-        usedHitsU[pCaloHit] = false;
-    for (const CaloHit *const pCaloHit : *pCaloHitListV)
-        usedHitsV[pCaloHit] = false;
-    for (const CaloHit *const pCaloHit : *pCaloHitListW)
-        usedHitsW[pCaloHit] = false;
-
-    std::vector<PandoraContentApi::Cluster::Parameters> clustersU;
-    std::vector<PandoraContentApi::Cluster::Parameters> clustersV;
-    std::vector<PandoraContentApi::Cluster::Parameters> clustersW;
+    const auto startTime{std::chrono::steady_clock::now()};
 
     // Populate a spatial map of CaloHit to 2D position.
     SpatialHitMap spatialHitMapU, spatialHitMapV, spatialHitMapW;
+    this->FillSpatialHitMap(*pCaloHitListU, spatialHitMapU);
+    this->FillSpatialHitMap(*pCaloHitListV, spatialHitMapV);
+    this->FillSpatialHitMap(*pCaloHitListW, spatialHitMapW);
 
-    for (const CaloHit *const pCaloHit : *pCaloHitListU)
-    {
-        if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
-            continue;
-
-        const CartesianVector pos = pCaloHit->GetPositionVector();
-        spatialHitMapU[QuantizePosition(pos.GetX(), pos.GetZ())] = pCaloHit;
-    }
-
-    for (const CaloHit *const pCaloHit : *pCaloHitListV)
-    {
-        if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
-            continue;
-
-        const CartesianVector pos = pCaloHit->GetPositionVector();
-        spatialHitMapV[QuantizePosition(pos.GetX(), pos.GetZ())] = pCaloHit;
-    }
-
-    for (const CaloHit *const pCaloHit : *pCaloHitListW)
-    {
-        if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
-            continue;
+    const auto mapTime{std::chrono::steady_clock::now()};
 
-        const CartesianVector pos = pCaloHit->GetPositionVector();
-        spatialHitMapW[QuantizePosition(pos.GetX(), pos.GetZ())] = pCaloHit;
-    }
+    std::vector<PandoraContentApi::Cluster::Parameters> clustersU;
+    std::vector<PandoraContentApi::Cluster::Parameters> clustersV;
+    std::vector<PandoraContentApi::Cluster::Parameters> clustersW;
 
     for (const Cluster *pCluster : *pClusterList3D)
     {
@@ -100,9 +75,9 @@ StatusCode CreateTwoDClustersFromThreeDAlgorithm::Run()
 
         for (const CaloHit *pCaloHit3D : clusterHits3D)
         {
-            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapU, associatedHitsU, usedHitsU, TPC_VIEW_U);
-            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapV, associatedHitsV, usedHitsV, TPC_VIEW_V);
-            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapW, associatedHitsW, usedHitsW, TPC_VIEW_W);
+            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapU, associatedHitsU, TPC_VIEW_U);
+            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapV, associatedHitsV, TPC_VIEW_V);
+            this->GetAssociatedTwoDHit(pCaloHit3D, spatialHitMapW, associatedHitsW, TPC_VIEW_W);
         }
 
         if (!associatedHitsU.empty())
@@ -127,6 +102,14 @@ StatusCode CreateTwoDClustersFromThreeDAlgorithm::Run()
         }
     }
 
+    if (m_printTimings)
+    {
+        const auto matchTime{std::chrono::steady_clock::now()};
+        std::cout << "CreateTwoDClustersFromThreeDAlgorithm: " << (spatialHitMapU.size() + spatialHitMapV.size() + spatialHitMapW.size())
+                  << " available 2D hits, map build " << std::chrono::duration<double, std::milli>(mapTime - startTime).count()
+                  << " ms, matching " << std::chrono::duration<double, std::milli>(matchTime - mapTime).count() << " ms" << std::endl;
+    }
+
     // Create new clusters
     std::string tempClusterListName;
 
@@ -165,8 +148,32 @@ StatusCode CreateTwoDClustersFromThreeDAlgorithm::Run()
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void CreateTwoDClustersFromThreeDAlgorithm::GetAssociatedTwoDHit(const CaloHit *const pCaloHit3D, const SpatialHitMap &hitMap,
-    CaloHitList &associatedHits, HitUsedMap &usedHits2D, const HitType &hitType) const
+void CreateTwoDClustersFromThreeDAlgorithm::FillSpatialHitMap(const CaloHitList &caloHitList, SpatialHitMap &hitMap) const
+{
+    hitMap.reserve(caloHitList.size());
+
+    for (const CaloHit *const pCaloHit : caloHitList)
+    {
+        if (!PandoraContentApi::IsAvailable(*this, pCaloHit))
+            continue;
+
+        const CartesianVector &pos = pCaloHit->GetPositionVector();
+        hitMap.push_back({QuantizePosition(pos.GetX(), pos.GetZ()), pCaloHit, false});
+    }
+
+    // Stable sort and keep the last entry for each position, matching the overwrite behaviour of the previous map insertion
+    std::stable_sort(hitMap.begin(), hitMap.end(),
+        [](const SpatialHitEntry &lhs, const SpatialHitEntry &rhs) { return lhs.m_position < rhs.m_position; });
+
+    auto last{std::unique(hitMap.rbegin(), hitMap.rend(),
+        [](const SpatialHitEntry &lhs, const SpatialHitEntry &rhs) { return lhs.m_position == rhs.m_position; })};
+    hitMap.erase(hitMap.begin(), last.base());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void CreateTwoDClustersFromThreeDAlgorithm::GetAssociatedTwoDHit(
+    const CaloHit *const pCaloHit3D, SpatialHitMap &hitMap, CaloHitList &associatedHits, const HitType &hitType) const
 {
     const CartesianVector posThreeD = pCaloHit3D->GetPositionVector();
     float wirePos{0.f};
@@ -179,16 +186,18 @@ void CreateTwoDClustersFromThreeDAlgorithm::GetAssociatedTwoDHit(const CaloHit *
         wirePos = PandoraContentApi::GetPlugins(*this)->GetLArTransformationPlugin()->YZtoW(posThreeD.GetY(), posThreeD.GetZ());
 
     // Look up the match in the spatial map
-    const auto it = hitMap.find(QuantizePosition(posThreeD.GetX(), wirePos));
+    const QuantizedPosition position{QuantizePosition(posThreeD.GetX(), wirePos)};
+    const auto it = std::lower_bound(hitMap.begin(), hitMap.end(), position,
+        [](const SpatialHitEntry &entry, const QuantizedPosition &value) { return entry.m_position < value; });
 
-    if (it == hitMap.end())
+    if (it == hitMap.end() || it->m_position != position)
         return;
 
-    if (usedHits2D.at(it->second) == true)
+    if (it->m_isUsed)
         return;
 
-    associatedHits.emplace_back(it->second);
-    usedHits2D.at(it->second) = true;
+    associatedHits.emplace_back(it->m_pCaloHit);
+    it->m_isUsed = true;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -214,6 +223,8 @@ StatusCode CreateTwoDClustersFromThreeDAlgorithm::ReadSettings(const TiXmlHandle
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, XmlHelper::ReadValue(xmlHandle, "OutputClusterListNameW", tempClusterName));
     m_outputClusterListNames.push_back(tempClusterName);
 
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "PrintTimings", m_printTimings));
+
     return STATUS_CODE_SUCCESS;
 }
 
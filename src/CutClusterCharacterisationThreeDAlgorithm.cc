@@ -15,6 +15,7 @@
 #include "larpandoracontent/LArTrackShowerId/CutClusterCharacterisationAlgorithm.h"
 
 #include "CutClusterCharacterisationThreeDAlgorithm.h"
+#include "LArSlidingFitCache.h"
 
 using namespace pandora;
 
@@ -34,6 +35,13 @@ CutClusterCharacterisationThreeDAlgorithm::CutClusterCharacterisationThreeDAlgor
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+CutClusterCharacterisationThreeDAlgorithm::~CutClusterCharacterisationThreeDAlgorithm()
+{
+    SlidingFitCache::DeleteInstance(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 bool CutClusterCharacterisationThreeDAlgorithm::IsClearTrack(const Cluster *const pCluster) const
 {
     if (pCluster->GetNCaloHits() < m_minCaloHitsCut)
@@ -47,7 +55,8 @@ bool CutClusterCharacterisationThreeDAlgorithm::IsClearTrack(const Cluster *cons
     {
         // We can actually do a sliding cone fit and then extract the sliding fit result. We'll use the cones later
 
-        const ThreeDSlidingFitResult slidingFitResult(pCluster, m_slidingFitWindow, LArGeometryHelper::GetWireZPitch(this->GetPandora()));
+        const ThreeDSlidingFitResult &slidingFitResult(SlidingFitCache::GetInstance(this->GetPandora())
+                .GetSlidingFitResult(pCluster, m_slidingFitWindow, LArGeometryHelper::GetWireZPitch(this->GetPandora())));
 
         const CartesianVector globalMinLayerPosition(slidingFitResult.GetGlobalMinLayerPosition());
         straightLineLength = (slidingFitResult.GetGlobalMaxLayerPosition() - globalMinLayerPosition).GetMagnitude();
@@ -112,6 +121,14 @@ bool CutClusterCharacterisationThreeDAlgorithm::IsClearTrack(const Cluster *cons
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode CutClusterCharacterisationThreeDAlgorithm::Reset()
+{
+    SlidingFitCache::GetInstance(this->GetPandora()).Reset();
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode CutClusterCharacterisationThreeDAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 {
     PANDORA_RETURN_RESULT_IF_AND_IF(
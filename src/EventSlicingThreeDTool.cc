@@ -17,9 +17,12 @@
 #include "larpandoracontent/LArObjects/LArThreeDSlidingFitResult.h"
 
 #include "EventSlicingThreeDTool.h"
+#include "LArSlidingFitCache.h"
 
 #include "larpandoracontent/LArUtility/KDTreeLinkerAlgoT.h"
 
+#include <numeric>
+
 using namespace pandora;
 
 namespace lar_content
@@ -55,6 +58,13 @@ EventSlicingThreeDTool::EventSlicingThreeDTool() :
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+EventSlicingThreeDTool::~EventSlicingThreeDTool()
+{
+    SlidingFitCache::DeleteInstance(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void EventSlicingThreeDTool::RunSlicing(const Algorithm *const pAlgorithm, const HitTypeToNameMap &caloHitListNames,
     const HitTypeToNameMap &clusterListNames, Slice3DList &sliceList)
 {
@@ -72,6 +82,13 @@ void EventSlicingThreeDTool::RunSlicing(const Algorithm *const pAlgorithm, const
     ClusterSliceList clusterSliceList;
     this->GetClusterSliceList(trackClusters3D, showerClusters3D, clusterSliceList);
 
+    if (PandoraContentApi::GetSettings(*pAlgorithm)->ShouldDisplayAlgorithmInfo())
+    {
+        const SlidingFitCache &slidingFitCache(SlidingFitCache::GetInstance(this->GetPandora()));
+        std::cout << "EventSlicingThreeDTool: sliding fit cache " << slidingFitCache.GetNHits() << " hits, " << slidingFitCache.GetNMisses()
+                  << " misses this event" << std::endl;
+    }
+
     if (clusterSliceList.size() < 2)
     {
         return this->CopyAllHitsToSingleSlice(pAlgorithm, caloHitListNames, sliceList);
@@ -95,6 +112,14 @@ void EventSlicingThreeDTool::RunSlicing(const Algorithm *const pAlgorithm, const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode EventSlicingThreeDTool::Reset()
+{
+    SlidingFitCache::GetInstance(this->GetPandora()).Reset();
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void EventSlicingThreeDTool::CopyAllHitsToSingleSlice(const Algorithm *const pAlgorithm, const HitTypeToNameMap &caloHitListNames, Slice3DList &sliceList) const
 {
     if (!sliceList.empty())
@@ -176,14 +201,15 @@ void EventSlicingThreeDTool::GetClusterSliceList(
 {
     const float layerPitch(LArGeometryHelper::GetWireZPitch(this->GetPandora()));
 
-    ThreeDSlidingFitResultMap trackFitResults;
+    SlidingFitCache &slidingFitCache(SlidingFitCache::GetInstance(this->GetPandora()));
+    ClusterToSlidingFitMap trackFitResults;
 
     for (const Cluster *const pCluster3D : trackClusters3D)
     {
         try
         {
-            trackFitResults.insert(
-                ThreeDSlidingFitResultMap::value_type(pCluster3D, ThreeDSlidingFitResult(pCluster3D, m_halfWindowLayers, layerPitch)));
+            trackFitResults.insert(ClusterToSlidingFitMap::value_type(
+                pCluster3D, &slidingFitCache.GetSlidingFitResult(pCluster3D, m_halfWindowLayers, layerPitch)));
         }
         catch (StatusCodeException &)
         {
@@ -231,18 +257,31 @@ void EventSlicingThreeDTool::GetClusterSliceList(
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 void EventSlicingThreeDTool::CollectAssociatedClusters(const Cluster *const pClusterInSlice, const ClusterVector &candidateClusters,
-    const ThreeDSlidingFitResultMap &trackFitResults, const ThreeDSlidingConeFitResultMap &showerConeFitResults,
+    const ClusterToSlidingFitMap &trackFitResults, const ThreeDSlidingConeFitResultMap &showerConeFitResults,
     ClusterVector &clusterSlice, ClusterSet &usedClusters) const
 {
     ClusterVector addedClusters;
 
+    // Index the hits of the cluster in the slice once, for proximity checks against all candidates
+    HitKDTree2D kdTree;
+    HitKDNode2DList hitKDNode2DList;
+
+    if (m_useProximityAssociation)
+    {
+        CaloHitList clusterInSliceHits;
+        pClusterInSlice->GetOrderedCaloHitList().FillCaloHitList(clusterInSliceHits);
+
+        KDTreeBox hitsBoundingRegion2D(fill_and_bound_2d_kd_tree(clusterInSliceHits, hitKDNode2DList));
+        kdTree.build(hitKDNode2DList, hitsBoundingRegion2D);
+    }
+
     for (const Cluster *const pCandidateCluster : candidateClusters)
     {
         if (usedClusters.count(pCandidateCluster) || (pClusterInSlice == pCandidateCluster))
             continue;
 
         if ((m_usePointingAssociation && this->PassPointing(pClusterInSlice, pCandidateCluster, trackFitResults)) ||
-            (m_useProximityAssociation && this->PassProximity(pClusterInSlice, pCandidateCluster)) ||
+            (m_useProximityAssociation && this->PassProximity(kdTree, pCandidateCluster)) ||
             (m_useShowerConeAssociation && (this->PassShowerCone(pClusterInSlice, pCandidateCluster, showerConeFitResults) ||
                                                this->PassShowerCone(pCandidateCluster, pClusterInSlice, showerConeFitResults))))
         {
@@ -260,16 +299,16 @@ void EventSlicingThreeDTool::CollectAssociatedClusters(const Cluster *const pClu
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 bool EventSlicingThreeDTool::PassPointing(
-    const Cluster *const pClusterInSlice, const Cluster *const pCandidateCluster, const ThreeDSlidingFitResultMap &trackFitResults) const
+    const Cluster *const pClusterInSlice, const Cluster *const pCandidateCluster, const ClusterToSlidingFitMap &trackFitResults) const
 {
-    ThreeDSlidingFitResultMap::const_iterator inSliceIter = trackFitResults.find(pClusterInSlice);
-    ThreeDSlidingFitResultMap::const_iterator candidateIter = trackFitResults.find(pCandidateCluster);
+    ClusterToSlidingFitMap::const_iterator inSliceIter = trackFitResults.find(pClusterInSlice);
+    ClusterToSlidingFitMap::const_iterator candidateIter = trackFitResults.find(pCandidateCluster);
 
     if ((trackFitResults.end() == inSliceIter) || (trackFitResults.end() == candidateIter))
         return false;
 
-    const LArPointingCluster inSlicePointingCluster(inSliceIter->second);
-    const LArPointingCluster candidatePointingCluster(candidateIter->second);
+    const LArPointingCluster inSlicePointingCluster(*inSliceIter->second);
+    const LArPointingCluster candidatePointingCluster(*candidateIter->second);
 
     if (this->CheckClosestApproach(inSlicePointingCluster, candidatePointingCluster) ||
         this->IsEmission(inSlicePointingCluster, candidatePointingCluster) || this->IsNode(inSlicePointingCluster, candidatePointingCluster))
@@ -282,21 +321,24 @@ bool EventSlicingThreeDTool::PassPointing(
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool EventSlicingThreeDTool::PassProximity(const Cluster *const pClusterInSlice, const Cluster *const pCandidateCluster) const
+bool EventSlicingThreeDTool::PassProximity(HitKDTree2D &clusterInSliceKDTree, const Cluster *const pCandidateCluster) const
 {
-    for (const auto &orderedList1 : pClusterInSlice->GetOrderedCaloHitList())
+    const float maxHitSeparation(std::sqrt(m_maxHitSeparationSquared));
+
+    for (const auto &orderedList : pCandidateCluster->GetOrderedCaloHitList())
     {
-        for (const CaloHit *const pCaloHit1 : *(orderedList1.second))
+        for (const CaloHit *const pCandidateHit : *(orderedList.second))
         {
-            const CartesianVector &positionVector1(pCaloHit1->GetPositionVector());
+            const CartesianVector &candidatePosition(pCandidateHit->GetPositionVector());
+            KDTreeBox searchRegionHits(build_2d_kd_search_region(pCandidateHit, maxHitSeparation, maxHitSeparation));
+
+            HitKDNode2DList found;
+            clusterInSliceKDTree.search(searchRegionHits, found);
 
-            for (const auto &orderedList2 : pCandidateCluster->GetOrderedCaloHitList())
+            for (const HitKDNode2D &node : found)
             {
-                for (const CaloHit *const pCaloHit2 : *(orderedList2.second))
-                {
-                    if ((positionVector1 - pCaloHit2->GetPositionVector()).GetMagnitudeSquared() < m_maxHitSeparationSquared)
-                        return true;
-                }
+                if ((node.data->GetPositionVector() - candidatePosition).GetMagnitudeSquared() < m_maxHitSeparationSquared)
+                    return true;
             }
         }
     }
@@ -537,94 +579,59 @@ void EventSlicingThreeDTool::GetRemainingClusters(const Algorithm *const pAlgori
 void EventSlicingThreeDTool::AssignRemainingHitsToSlices(
     const ClusterList &remainingClusters, const ClusterToSliceIndexMap &clusterToSliceIndexMap, Slice3DList &sliceList) const
 {
-    PointToSliceIndexMap pointToSliceIndexMap;
-
-    try
-    {
-        PointList pointsU, pointsV, pointsW;
-        this->GetKDTreeEntries2D(sliceList, pointsU, pointsV, pointsW, pointToSliceIndexMap);
-
-        if (m_use3DProjectionsInHitPickUp)
-            this->GetKDTreeEntries3D(clusterToSliceIndexMap, pointsU, pointsV, pointsW, pointToSliceIndexMap);
-
-        pointsU.sort(EventSlicingThreeDTool::SortPoints);
-        pointsV.sort(EventSlicingThreeDTool::SortPoints);
-        pointsW.sort(EventSlicingThreeDTool::SortPoints);
+    SlicePoints pointsU, pointsV, pointsW;
+    this->GetKDTreeEntries2D(sliceList, pointsU, pointsV, pointsW);
 
-        PointKDNode2DList kDNode2DListU, kDNode2DListV, kDNode2DListW;
-        KDTreeBox boundingRegionU = fill_and_bound_2d_kd_tree(pointsU, kDNode2DListU);
-        KDTreeBox boundingRegionV = fill_and_bound_2d_kd_tree(pointsV, kDNode2DListV);
-        KDTreeBox boundingRegionW = fill_and_bound_2d_kd_tree(pointsW, kDNode2DListW);
+    if (m_use3DProjectionsInHitPickUp)
+        this->GetKDTreeEntries3D(clusterToSliceIndexMap, pointsU, pointsV, pointsW);
 
-        PointKDTree2D kdTreeU, kdTreeV, kdTreeW;
-        kdTreeU.build(kDNode2DListU, boundingRegionU);
-        kdTreeV.build(kDNode2DListV, boundingRegionV);
-        kdTreeW.build(kDNode2DListW, boundingRegionW);
+    PointKDNode2DList kDNode2DListU, kDNode2DListV, kDNode2DListW;
+    PointKDTree2D kdTreeU, kdTreeV, kdTreeW;
+    this->BuildKDTree(pointsU, kDNode2DListU, kdTreeU);
+    this->BuildKDTree(pointsV, kDNode2DListV, kdTreeV);
+    this->BuildKDTree(pointsW, kDNode2DListW, kdTreeW);
 
-        ClusterVector sortedRemainingClusters(remainingClusters.begin(), remainingClusters.end());
-        std::sort(sortedRemainingClusters.begin(), sortedRemainingClusters.end(), LArClusterHelper::SortByNHits);
+    ClusterVector sortedRemainingClusters(remainingClusters.begin(), remainingClusters.end());
+    std::sort(sortedRemainingClusters.begin(), sortedRemainingClusters.end(), LArClusterHelper::SortByNHits);
 
-        for (const Cluster *const pCluster2D : sortedRemainingClusters)
-        {
-            const HitType hitType(LArClusterHelper::GetClusterHitType(pCluster2D));
+    for (const Cluster *const pCluster2D : sortedRemainingClusters)
+    {
+        const HitType hitType(LArClusterHelper::GetClusterHitType(pCluster2D));
 
-            if ((TPC_VIEW_U != hitType) && (TPC_VIEW_V != hitType) && (TPC_VIEW_W != hitType))
-                throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
+        if ((TPC_VIEW_U != hitType) && (TPC_VIEW_V != hitType) && (TPC_VIEW_W != hitType))
+            throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
 
-            PointKDTree2D &kdTree((TPC_VIEW_U == hitType) ? kdTreeU : (TPC_VIEW_V == hitType) ? kdTreeV : kdTreeW);
-            const PointKDNode2D *pBestResultPoint(this->MatchClusterToSlice(pCluster2D, kdTree));
+        PointKDTree2D &kdTree((TPC_VIEW_U == hitType) ? kdTreeU : (TPC_VIEW_V == hitType) ? kdTreeV : kdTreeW);
+        const PointKDNode2D *pBestResultPoint(this->MatchClusterToSlice(pCluster2D, kdTree));
 
-            if (!pBestResultPoint)
-                continue;
+        if (!pBestResultPoint)
+            continue;
 
-            Slice3D &slice(sliceList.at(pointToSliceIndexMap.at(pBestResultPoint->data)));
-            CaloHitList &targetList((TPC_VIEW_U == hitType) ? slice.m_caloHitListU : (TPC_VIEW_V == hitType) ? slice.m_caloHitListV : slice.m_caloHitListW);
+        const SlicePoints &slicePoints((TPC_VIEW_U == hitType) ? pointsU : (TPC_VIEW_V == hitType) ? pointsV : pointsW);
+        Slice3D &slice(sliceList.at(slicePoints.m_sliceIndices.at(pBestResultPoint->data)));
+        CaloHitList &targetList((TPC_VIEW_U == hitType) ? slice.m_caloHitListU : (TPC_VIEW_V == hitType) ? slice.m_caloHitListV : slice.m_caloHitListW);
 
-            pCluster2D->GetOrderedCaloHitList().FillCaloHitList(targetList);
-            targetList.insert(targetList.end(), pCluster2D->GetIsolatedCaloHitList().begin(), pCluster2D->GetIsolatedCaloHitList().end());
-        }
-    }
-    catch (...)
-    {
-        std::cout << "EventSlicingThreeDTool::AssignRemainingHitsToSlices - exception " << std::endl;
-        for (const auto &pointMap : pointToSliceIndexMap)
-            delete pointMap.first;
-        throw;
+        pCluster2D->GetOrderedCaloHitList().FillCaloHitList(targetList);
+        targetList.insert(targetList.end(), pCluster2D->GetIsolatedCaloHitList().begin(), pCluster2D->GetIsolatedCaloHitList().end());
     }
-
-    for (const auto &pointMap : pointToSliceIndexMap)
-        delete pointMap.first;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void EventSlicingThreeDTool::GetKDTreeEntries2D(const Slice3DList &sliceList, PointList &pointsU, PointList &pointsV, PointList &pointsW,
-    PointToSliceIndexMap &pointToSliceIndexMap) const
+void EventSlicingThreeDTool::GetKDTreeEntries2D(const Slice3DList &sliceList, SlicePoints &pointsU, SlicePoints &pointsV, SlicePoints &pointsW) const
 {
     unsigned int sliceIndex(0);
 
     for (const Slice3D &slice : sliceList)
     {
         for (const CaloHit *const pCaloHit : slice.m_caloHitListU)
-        {
-            const CartesianVector *const pPoint(new CartesianVector(pCaloHit->GetPositionVector()));
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pPoint, sliceIndex));
-            pointsU.push_back(pPoint);
-        }
+            pointsU.AddPoint(pCaloHit->GetPositionVector(), sliceIndex);
 
         for (const CaloHit *const pCaloHit : slice.m_caloHitListV)
-        {
-            const CartesianVector *const pPoint(new CartesianVector(pCaloHit->GetPositionVector()));
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pPoint, sliceIndex));
-            pointsV.push_back(pPoint);
-        }
+            pointsV.AddPoint(pCaloHit->GetPositionVector(), sliceIndex);
 
         for (const CaloHit *const pCaloHit : slice.m_caloHitListW)
-        {
-            const CartesianVector *const pPoint(new CartesianVector(pCaloHit->GetPositionVector()));
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pPoint, sliceIndex));
-            pointsW.push_back(pPoint);
-        }
+            pointsW.AddPoint(pCaloHit->GetPositionVector(), sliceIndex);
 
         ++sliceIndex;
     }
@@ -632,8 +639,8 @@ void EventSlicingThreeDTool::GetKDTreeEntries2D(const Slice3DList &sliceList, Po
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void EventSlicingThreeDTool::GetKDTreeEntries3D(const ClusterToSliceIndexMap &clusterToSliceIndexMap, PointList &pointsU,
-    PointList &pointsV, PointList &pointsW, PointToSliceIndexMap &pointToSliceIndexMap) const
+void EventSlicingThreeDTool::GetKDTreeEntries3D(
+    const ClusterToSliceIndexMap &clusterToSliceIndexMap, SlicePoints &pointsU, SlicePoints &pointsV, SlicePoints &pointsW) const
 {
     ClusterList clusterList;
     for (const auto &mapEntry : clusterToSliceIndexMap)
@@ -654,73 +661,78 @@ void EventSlicingThreeDTool::GetKDTreeEntries3D(const ClusterToSliceIndexMap &cl
 
             const CartesianVector &position3D(pCaloHit3D->GetPositionVector());
 
-            const CartesianVector *const pProjectionU(
-                new CartesianVector(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_U)));
-            const CartesianVector *const pProjectionV(
-                new CartesianVector(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_V)));
-            const CartesianVector *const pProjectionW(
-                new CartesianVector(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_W)));
+            pointsU.AddPoint(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_U), sliceIndex);
+            pointsV.AddPoint(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_V), sliceIndex);
+            pointsW.AddPoint(LArGeometryHelper::ProjectPosition(this->GetPandora(), position3D, TPC_VIEW_W), sliceIndex);
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
 
-            pointsU.push_back(pProjectionU);
-            pointsV.push_back(pProjectionV);
-            pointsW.push_back(pProjectionW);
+void EventSlicingThreeDTool::BuildKDTree(const SlicePoints &slicePoints, PointKDNode2DList &kDNode2DList, PointKDTree2D &kdTree) const
+{
+    const CartesianPointVector &points(slicePoints.m_points);
 
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pProjectionU, sliceIndex));
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pProjectionV, sliceIndex));
-            pointToSliceIndexMap.insert(PointToSliceIndexMap::value_type(pProjectionW, sliceIndex));
-        }
+    if (points.empty())
+        return;
+
+    // Insert the nodes in sorted point order, so that the tree (and nearest-neighbour tie-breaking) does not depend on hit ordering
+    UIntVector sortedIndices(points.size());
+    std::iota(sortedIndices.begin(), sortedIndices.end(), 0);
+    std::stable_sort(sortedIndices.begin(), sortedIndices.end(),
+        [&points](const unsigned int lhs, const unsigned int rhs) { return EventSlicingThreeDTool::SortPoints(points.at(lhs), points.at(rhs)); });
+
+    float minX(std::numeric_limits<float>::max()), maxX(-std::numeric_limits<float>::max());
+    float minZ(std::numeric_limits<float>::max()), maxZ(-std::numeric_limits<float>::max());
+    kDNode2DList.reserve(points.size());
+
+    for (const unsigned int index : sortedIndices)
+    {
+        const CartesianVector &point(points.at(index));
+        kDNode2DList.emplace_back(index, point.GetX(), point.GetZ());
+        minX = std::min(minX, point.GetX());
+        maxX = std::max(maxX, point.GetX());
+        minZ = std::min(minZ, point.GetZ());
+        maxZ = std::max(maxZ, point.GetZ());
     }
+
+    kdTree.build(kDNode2DList, KDTreeBox(minX, maxX, minZ, maxZ));
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 const EventSlicingThreeDTool::PointKDNode2D *EventSlicingThreeDTool::MatchClusterToSlice(const Cluster *const pCluster2D, PointKDTree2D &kdTree) const
 {
-    PointList clusterPointList;
+    const CartesianVector innerCentroid(pCluster2D->GetCentroid(pCluster2D->GetInnerPseudoLayer()));
+    const CartesianVector outerCentroid(pCluster2D->GetCentroid(pCluster2D->GetOuterPseudoLayer()));
+    const CartesianPointVector clusterPoints{innerCentroid, outerCentroid, (innerCentroid + outerCentroid) * 0.5f};
+
     const PointKDNode2D *pBestResultPoint(nullptr);
+    float bestDistance(std::numeric_limits<float>::max());
 
-    try
+    for (const CartesianVector &clusterPoint : clusterPoints)
     {
-        clusterPointList.push_back(new CartesianVector(pCluster2D->GetCentroid(pCluster2D->GetInnerPseudoLayer())));
-        clusterPointList.push_back(new CartesianVector(pCluster2D->GetCentroid(pCluster2D->GetOuterPseudoLayer())));
-        clusterPointList.push_back(new CartesianVector(
-            (pCluster2D->GetCentroid(pCluster2D->GetInnerPseudoLayer()) + pCluster2D->GetCentroid(pCluster2D->GetOuterPseudoLayer())) * 0.5f));
-
-        float bestDistance(std::numeric_limits<float>::max());
+        const PointKDNode2D *pResultPoint(nullptr);
+        float resultDistance(std::numeric_limits<float>::max());
+        const PointKDNode2D targetPoint(std::numeric_limits<unsigned int>::max(), clusterPoint.GetX(), clusterPoint.GetZ());
+        kdTree.findNearestNeighbour(targetPoint, pResultPoint, resultDistance);
 
-        for (const CartesianVector *const pClusterPoint : clusterPointList)
+        if (pResultPoint && (resultDistance < bestDistance))
         {
-            const PointKDNode2D *pResultPoint(nullptr);
-            float resultDistance(std::numeric_limits<float>::max());
-            const PointKDNode2D targetPoint(pClusterPoint, pClusterPoint->GetX(), pClusterPoint->GetZ());
-            kdTree.findNearestNeighbour(targetPoint, pResultPoint, resultDistance);
-
-            if (pResultPoint && (resultDistance < bestDistance))
-            {
-                pBestResultPoint = pResultPoint;
-                bestDistance = resultDistance;
-            }
+            pBestResultPoint = pResultPoint;
+            bestDistance = resultDistance;
         }
     }
-    catch (...)
-    {
-        std::cout << "EventSlicingThreeDTool::MatchClusterToSlice - exception " << std::endl;
-        for (const CartesianVector *const pPoint : clusterPointList)
-            delete pPoint;
-        throw;
-    }
-
-    for (const CartesianVector *const pPoint : clusterPointList)
-        delete pPoint;
 
     return pBestResultPoint;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool EventSlicingThreeDTool::SortPoints(const CartesianVector *const pLhs, const CartesianVector *const pRhs)
+bool EventSlicingThreeDTool::SortPoints(const CartesianVector &lhs, const CartesianVector &rhs)
 {
-    const CartesianVector deltaPosition(*pRhs - *pLhs);
+    const CartesianVector deltaPosition(rhs - lhs);
 
     if (std::fabs(deltaPosition.GetZ()) > std::numeric_limits<float>::epsilon())
         return (deltaPosition.GetZ() > std::numeric_limits<float>::epsilon());
@@ -733,6 +745,14 @@ bool EventSlicingThreeDTool::SortPoints(const CartesianVector *const pLhs, const
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void EventSlicingThreeDTool::SlicePoints::AddPoint(const CartesianVector &point, const unsigned int sliceIndex)
+{
+    m_points.push_back(point);
+    m_sliceIndices.push_back(sliceIndex);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode EventSlicingThreeDTool::ReadSettings(const TiXmlHandle xmlHandle)
 {
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, XmlHelper::ReadValue(xmlHandle, "TrackPfoListName", m_trackPfoListName));
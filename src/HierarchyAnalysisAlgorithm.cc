@@ -9,12 +9,18 @@
 #include "Pandora/AlgorithmHeaders.h"
 
 #include "HierarchyAnalysisAlgorithm.h"
+#include "LArAnalysisTreeWriter.h"
+#include "LArEventTimeBudget.h"
 
 #include "larpandoracontent/LArHelpers/LArClusterHelper.h"
 #include "larpandoracontent/LArHelpers/LArPfoHelper.h"
 
+#include "TBranch.h"
+#include "TChain.h"
 #include "TFile.h"
-#include "TTree.h"
+
+#include <algorithm>
+#include <unordered_map>
 
 using namespace pandora;
 
@@ -32,6 +38,10 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
     m_endTime{0},
     m_triggers{0},
     m_nhits{0},
+    m_voxelWidth{0.f},
+    m_timeBudgetExceeded{0},
+    m_inputFileName{""},
+    m_inputFileEntry{-1},
     m_mcIDs{nullptr},
     m_mcLocalIDs{nullptr},
     m_eventFileName{""},
@@ -49,13 +59,15 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
     m_mcLocalIdLeafName{"mcp_idLocal"},
     m_eventsToSkip{0},
     m_minHitsToSkip{2},
-    m_eventFile{nullptr},
-    m_eventTree{nullptr},
+    m_eventChain{nullptr},
+    m_eventEntries{},
     m_caloHitListName{"CaloHitList2D"},
     m_pfoListName{"RecreatedPfos"},
     m_minTrackScore{0.5f},
     m_analysisFileName{"LArRecoND.root"},
     m_analysisTreeName{"LArRecoND"},
+    m_analysisCompression{-1},
+    m_analysisBasketSize{32000},
     m_foldToPrimaries{false},
     m_foldToLeadingShowers{false},
     m_foldDynamic{true},
@@ -68,7 +80,10 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
     m_selectRecoHits{true},
     m_storeClusterRecoHits{true},
     m_gotMCEventInput{false},
-    m_mcIdMap{}
+    m_mcIdMap{},
+    m_pInputEvents{nullptr},
+    m_pAnalysisTreeWriter{nullptr},
+    m_analysisOutput{}
 {
 }
 
@@ -76,17 +91,14 @@ HierarchyAnalysisAlgorithm::HierarchyAnalysisAlgorithm() :
 
 HierarchyAnalysisAlgorithm::~HierarchyAnalysisAlgorithm()
 {
-    // Save the analysis output ROOT file. Always recreate this
-    PANDORA_MONITORING_API(SaveTree(this->GetPandora(), m_analysisTreeName.c_str(), m_analysisFileName.c_str(), "RECREATE"));
+    // Write the analysis tree and close its ROOT file. Each primary instance owns its own output file and tree
+    m_pAnalysisTreeWriter.reset();
 
-    // Cleanup ROOT file used for the event numbers
-    if (m_eventFile && m_eventFile->IsOpen())
-    {
-        delete m_eventTree;
-        m_eventTree = nullptr;
-    }
-    delete m_eventFile;
-    m_eventFile = nullptr;
+    // Cleanup the ROOT chain used for the event numbers, which closes its files
+    delete m_eventChain;
+    m_eventChain = nullptr;
+
+    EventTimeBudget::DeleteInstance(this->GetPandora());
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -108,6 +120,11 @@ StatusCode HierarchyAnalysisAlgorithm::Run()
     const PfoList *pPfoList(nullptr);
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_pfoListName, pPfoList));
 
+    // The hit cell size is the width of the voxels used to make the hits, which PandoraInterface may coarsen for oversized events
+    m_voxelWidth = 0.f;
+    for (const CaloHit *const pCaloHit : *pCaloHitList)
+        m_voxelWidth = std::max(m_voxelWidth, pCaloHit->GetCellThickness());
+
     LArHierarchyHelper::FoldingParameters foldParameters;
     if (m_foldToPrimaries)
         foldParameters.m_foldToTier = true;
@@ -126,8 +143,16 @@ StatusCode HierarchyAnalysisAlgorithm::Run()
 
     const LArHierarchyHelper::QualityCuts quality(m_minPurity, m_minCompleteness, m_selectRecoHits);
     LArHierarchyHelper::MatchInfo matchInfo(mcHierarchy, recoHierarchy, quality);
-    LArHierarchyHelper::MatchHierarchies(matchInfo);
-    matchInfo.Print(mcHierarchy);
+    EventTimeBudget &eventTimeBudget(EventTimeBudget::GetInstance(this->GetPandora()));
+
+    // Over the time budget, the pfos are still written, but without their matches to the mc hierarchy
+    if (!eventTimeBudget.ShouldSkipStage("HierarchyAnalysis reco-mc hierarchy matching"))
+    {
+        LArHierarchyHelper::MatchHierarchies(matchInfo);
+        matchInfo.Print(mcHierarchy);
+    }
+
+    m_timeBudgetExceeded = eventTimeBudget.IsExceeded() ? 1 : 0;
 
     // Analysis PFO & matched reco-MC output
     this->EventAnalysisOutput(matchInfo);
@@ -144,81 +169,152 @@ void HierarchyAnalysisAlgorithm::SetEventRunMCIdInfo()
     // MCParticles use unique MC Ids, but CAFs need the local ones as well
     m_mcIdMap.clear();
 
-    if (m_eventTree)
+    if (m_eventChain)
     {
-        // Sets m_event, m_run, m_subRun, m_unixTime, m_unixTimeUsec, m_startTime, m_endTime & m_triggers
-        const int iEntry = m_count + m_eventsToSkip;
-        m_eventTree->GetEntry(iEntry);
-
-        // Check if we should actually be pointing to a higher event number due to skipping some events in Pandora
-        if (m_nhits < m_minHitsToSkip)
+        // Sets m_event, m_run, m_subRun, m_unixTime, m_unixTimeUsec, m_startTime, m_endTime & m_triggers.
+        // The entry index and the shared input events both account for the events skipped by Pandora, so only the needed entry is read
+        if (m_pInputEvents ? m_pInputEvents->empty() : (m_count >= static_cast<int>(m_eventEntries.size())))
         {
-            // Skip ahead as many events as we need to
-            int thisHits = m_nhits;
-            while (thisHits < m_minHitsToSkip)
-            {
-                m_count += 1;
-                const int newEntry = m_count + m_eventsToSkip;
-                m_eventTree->GetEntry(newEntry);
-                thisHits = m_nhits;
-            }
+            std::cout << "HierarchyAnalysisAlgorithm: no event tree entry for run " << m_count << ", keeping previous event info"
+                      << std::endl;
+            return;
         }
 
+        m_eventChain->GetEntry(m_pInputEvents ? m_pInputEvents->back() : m_eventEntries[m_count]);
+
+        // Tag the event with the file it was read from, and its entry there, as each chain entry is numbered across all files
+        m_inputFileName = m_eventChain->GetCurrentFile()->GetName();
+        m_inputFileEntry = static_cast<int>(m_eventChain->GetTree()->GetReadEntry());
+
         // Fill the Id map
         if (m_gotMCEventInput)
         {
+            m_mcIdMap.reserve(m_mcIDs->size());
             for (size_t i = 0; i < m_mcIDs->size(); i++)
                 m_mcIdMap[(*m_mcIDs)[i]] = (*m_mcLocalIDs)[i];
         }
     }
+    else if (m_pInputEvents && !m_pInputEvents->empty())
+        // Use the input event index, as claimed by this instance from those shared with the others
+        m_event = m_pInputEvents->back();
     else
-        // Use the algorithm run count number
+        // Use the algorithm run count number, as an input event index
         m_event = m_count;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::MatchInfo &matchInfo) const
+void HierarchyAnalysisAlgorithm::FillEventEntryIndex()
+{
+    m_eventEntries.clear();
+
+    // Read just the nhits branch, which is bound to m_nhits, rather than whole entries. The branch belongs to the tree of the
+    // current file, so is found again whenever the chain moves on to the next file
+    TBranch *pNHitsBranch{nullptr};
+    int treeNumber{-1};
+    const long long nEntries{m_eventChain->GetEntries()};
+
+    for (long long iEntry = m_eventsToSkip; iEntry < nEntries; ++iEntry)
+    {
+        const long long localEntry{m_eventChain->LoadTree(iEntry)};
+        if (localEntry < 0)
+            break;
+
+        if (m_eventChain->GetTreeNumber() != treeNumber)
+        {
+            treeNumber = m_eventChain->GetTreeNumber();
+            pNHitsBranch = m_eventChain->GetTree()->GetBranch(m_nhitsLeafName.c_str());
+        }
+
+        if (pNHitsBranch)
+        {
+            pNHitsBranch->GetEntry(localEntry);
+
+            // Check if this event is skipped in Pandora due to having too few hits
+            if (m_nhits < m_minHitsToSkip)
+                continue;
+        }
+
+        m_eventEntries.emplace_back(iEntry);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HierarchyAnalysisAlgorithm::OpenEventChain(const StringVector &eventFileNames)
+{
+    if (eventFileNames.empty() && m_eventFileName.empty())
+        return;
+
+    // A chain of a single file behaves as its tree, while the settings file name may also be a glob matching several files
+    m_eventChain = new TChain(m_eventTreeName.c_str());
+
+    if (eventFileNames.empty())
+        m_eventChain->Add(m_eventFileName.c_str());
+
+    for (const std::string &eventFileName : eventFileNames)
+        m_eventChain->Add(eventFileName.c_str());
+
+    if (m_eventChain->GetEntries() <= 0)
+    {
+        std::cout << "HierarchyAnalysisAlgorithm: no " << m_eventTreeName << " entries in the event files, using the run count instead"
+                  << std::endl;
+        delete m_eventChain;
+        m_eventChain = nullptr;
+        return;
+    }
+
+    // Only enable the event and run number leaves as well as the trigger timing.
+    // Also enable the vertex_id leaf
+    m_eventChain->SetBranchStatus("*", 0);
+    m_eventChain->SetBranchStatus(m_eventLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_runLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_subRunLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_unixTimeLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_unixTimeUsecLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_startTimeLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_endTimeLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_triggersLeafName.c_str(), 1);
+    m_eventChain->SetBranchStatus(m_nhitsLeafName.c_str(), 1);
+    m_eventChain->SetBranchAddress(m_eventLeafName.c_str(), &m_event);
+    m_eventChain->SetBranchAddress(m_runLeafName.c_str(), &m_run);
+    m_eventChain->SetBranchAddress(m_subRunLeafName.c_str(), &m_subRun);
+    m_eventChain->SetBranchAddress(m_unixTimeLeafName.c_str(), &m_unixTime);
+    m_eventChain->SetBranchAddress(m_unixTimeUsecLeafName.c_str(), &m_unixTimeUsec);
+    m_eventChain->SetBranchAddress(m_startTimeLeafName.c_str(), &m_startTime);
+    m_eventChain->SetBranchAddress(m_endTimeLeafName.c_str(), &m_endTime);
+    m_eventChain->SetBranchAddress(m_triggersLeafName.c_str(), &m_triggers);
+    m_eventChain->SetBranchAddress(m_nhitsLeafName.c_str(), &m_nhits);
+
+    // Check if we have MC branches
+    if (m_eventChain->GetBranch(m_mcIdLeafName.c_str()) && m_eventChain->GetBranch(m_mcLocalIdLeafName.c_str()))
+    {
+        m_gotMCEventInput = true;
+        m_eventChain->SetBranchStatus(m_mcIdLeafName.c_str(), 1);
+        m_eventChain->SetBranchStatus(m_mcLocalIdLeafName.c_str(), 1);
+        m_eventChain->SetBranchAddress(m_mcIdLeafName.c_str(), &m_mcIDs);
+        m_eventChain->SetBranchAddress(m_mcLocalIdLeafName.c_str(), &m_mcLocalIDs);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::MatchInfo &matchInfo)
 {
     // For storing various reconstructed PFO quantities in the given event
     int sliceId{-1};
-    // Slice & cluster IDs, and number of hits
-    IntVector sliceIdVect, clusterIdVect, n3DHitsVect, nUHitsVect, nVHitsVect, nWHitsVect;
-    // Cluster isShower, isRecoPrimary & reco PDG hypothesis, as well as the track score
-    IntVector isShowerVect, isRecoPrimaryVect, recoPDGVect;
-    FloatVector trackScoreVect;
-    // Reco neutrino vertex
-    FloatVector nuVtxXVect, nuVtxYVect, nuVtxZVect;
-    // Cluster start, end, direction, PCA axis lengths and total hit energy
-    FloatVector startXVect, startYVect, startZVect, endXVect, endYVect, endZVect;
-    FloatVector dirXVect, dirYVect, dirZVect, centroidXVect, centroidYVect, centroidZVect;
-    FloatVector primaryLVect, secondaryLVect, tertiaryLVect, energyVect;
-    // Best matched MC info
-    IntVector matchVect, mcPDGVect, nSharedHitsVect, isPrimaryVect;
-    FloatVector completenessVect, purityVect;
-    // MC matched energy, momentum, vertex and end position
-    FloatVector mcEVect, mcPxVect, mcPyVect, mcPzVect;
-    FloatVector mcVtxXVect, mcVtxYVect, mcVtxZVect, mcEndXVect, mcEndYVect, mcEndZVect;
-    // MC neutrino parent info
-    IntVector mcNuPDGVect, mcNuCodeVect;
-    FloatVector mcNuVtxXVect, mcNuVtxYVect, mcNuVtxZVect;
-    FloatVector mcNuEVect, mcNuPxVect, mcNuPyVect, mcNuPzVect;
-    // Long integers for the MC IDs: vertex, unique and local trajectories
-    std::vector<long> mcNuIdVect, mcIdVect, mcLocalIdVect, mcParentIdVect;
-    //MC pfo parent info
-    IntVector mcParentPDGVect;
-
-    // Hit info for each reconstructed PFO. Since we can't store vectors of vectors, the size of
-    // these vectors = n3DHits*nPFOs, whereas all of the above vectors have size = nPFOs.
-    // The hit vector entries follow the order PFO1[n3DHits1], PFO2[n3DHits2], PFO3[n3DHits3] etc.
-    // The sliceId & clusterId vectors keep track of where a given hit comes from
-    IntVector recoHitIdVect, recoHitSliceIdVect, recoHitClusterIdVect;
-    FloatVector recoHitXVect, recoHitYVect, recoHitZVect, recoHitEVect;
+
+    // The branch buffers are bound to the analysis tree, and keep their capacity from one event to the next
+    AnalysisOutput &output(m_analysisOutput);
+    output.Clear();
 
     // Get the list of root MCParticles for the MC truth matching
     MCParticleList rootMCParticles;
     matchInfo.GetRootMCParticles(rootMCParticles);
 
+    // Map the hits to their MC and reco nodes once, rather than intersecting hit lists for every PFO and match
+    const HitMatchIndex hitMatchIndex(matchInfo, rootMCParticles);
+
     // Get reconstructed root PFOs (neutrinos)
     PfoList rootPfos;
     const LArHierarchyHelper::RecoHierarchy &recoHierarchy{matchInfo.GetRecoHierarchy()};
@@ -311,20 +407,20 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                 const int nWHits = (pClusterW != nullptr) ? pClusterW->GetNCaloHits() : 0;
 
                 // Store quantities in the vectors
-                sliceIdVect.emplace_back(sliceId);
+                output.m_sliceId.emplace_back(sliceId);
                 // Neutrino reco vertex
-                nuVtxXVect.emplace_back(rootRecoVtx.GetX());
-                nuVtxYVect.emplace_back(rootRecoVtx.GetY());
-                nuVtxZVect.emplace_back(rootRecoVtx.GetZ());
+                output.m_nuVtxX.emplace_back(rootRecoVtx.GetX());
+                output.m_nuVtxY.emplace_back(rootRecoVtx.GetY());
+                output.m_nuVtxZ.emplace_back(rootRecoVtx.GetZ());
 
                 // Cluster Id
-                clusterIdVect.emplace_back(clusterId);
+                output.m_clusterId.emplace_back(clusterId);
 
                 // Number of hits in the cluster (by views)
-                n3DHitsVect.emplace_back(n3DHits);
-                nUHitsVect.emplace_back(nUHits);
-                nVHitsVect.emplace_back(nVHits);
-                nWHitsVect.emplace_back(nWHits);
+                output.m_n3DHits.emplace_back(n3DHits);
+                output.m_nUHits.emplace_back(nUHits);
+                output.m_nVHits.emplace_back(nVHits);
+                output.m_nWHits.emplace_back(nWHits);
 
                 // Save the track score, getting the appropriate metadata
                 // see e.g. https://github.com/PandoraPFA/larpandora/blob/develop/larpandora/LArPandoraInterface/LArPandoraOutput.cxx#L325 for similar
@@ -335,40 +431,40 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                 {
                     trackScore = iterTrackScore->second;
                 }
-                trackScoreVect.emplace_back(trackScore);
+                output.m_trackScore.emplace_back(trackScore);
 
                 // Define isShower based on track score
                 const int isShower = (trackScore >= m_minTrackScore) ? 0 : 1;
-                isShowerVect.emplace_back(isShower);
+                output.m_isShower.emplace_back(isShower);
 
                 // Set reco PDG hypothesis, e.g track = muon, shower = electron.
                 // Since all PFOs are tracks for now, this will always be muon
                 const int recoPDG = (isShower == 0) ? MU_MINUS : E_MINUS;
-                recoPDGVect.emplace_back(recoPDG);
+                output.m_recoPDG.emplace_back(recoPDG);
 
                 // Is this a reconstructed primary PFO?
-                isRecoPrimaryVect.emplace_back(isRecoPrimary);
+                output.m_isRecoPrimary.emplace_back(isRecoPrimary);
 
                 // Cluster vertex, end and direction (from PCA)
-                startXVect.emplace_back(vertex.GetX());
-                startYVect.emplace_back(vertex.GetY());
-                startZVect.emplace_back(vertex.GetZ());
-                endXVect.emplace_back(endPoint.GetX());
-                endYVect.emplace_back(endPoint.GetY());
-                endZVect.emplace_back(endPoint.GetZ());
-                dirXVect.emplace_back(direction.GetX());
-                dirYVect.emplace_back(direction.GetY());
-                dirZVect.emplace_back(direction.GetZ());
+                output.m_startX.emplace_back(vertex.GetX());
+                output.m_startY.emplace_back(vertex.GetY());
+                output.m_startZ.emplace_back(vertex.GetZ());
+                output.m_endX.emplace_back(endPoint.GetX());
+                output.m_endY.emplace_back(endPoint.GetY());
+                output.m_endZ.emplace_back(endPoint.GetZ());
+                output.m_dirX.emplace_back(direction.GetX());
+                output.m_dirY.emplace_back(direction.GetY());
+                output.m_dirZ.emplace_back(direction.GetZ());
                 // Cluster centroid and axis lengths (from PCA)
-                centroidXVect.emplace_back(centroid.GetX());
-                centroidYVect.emplace_back(centroid.GetY());
-                centroidZVect.emplace_back(centroid.GetZ());
-                primaryLVect.emplace_back(primaryLength);
-                secondaryLVect.emplace_back(secondaryLength);
-                tertiaryLVect.emplace_back(tertiaryLength);
+                output.m_centroidX.emplace_back(centroid.GetX());
+                output.m_centroidY.emplace_back(centroid.GetY());
+                output.m_centroidZ.emplace_back(centroid.GetZ());
+                output.m_length1.emplace_back(primaryLength);
+                output.m_length2.emplace_back(secondaryLength);
+                output.m_length3.emplace_back(tertiaryLength);
 
                 // Cluster energy (sum over all hits)
-                energyVect.emplace_back(clusterEnergy);
+                output.m_energy.emplace_back(clusterEnergy);
 
                 if (m_storeClusterRecoHits)
                 {
@@ -384,18 +480,18 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                         const int hitId = reinterpret_cast<intptr_t>(pCalo3DHit->GetParentAddress());
                         const CartesianVector hitPos = pCalo3DHit->GetPositionVector();
                         const float hitE = pCalo3DHit->GetInputEnergy();
-                        recoHitIdVect.emplace_back(hitId);
-                        recoHitSliceIdVect.emplace_back(sliceId);
-                        recoHitClusterIdVect.emplace_back(clusterId);
-                        recoHitXVect.emplace_back(hitPos.GetX());
-                        recoHitYVect.emplace_back(hitPos.GetY());
-                        recoHitZVect.emplace_back(hitPos.GetZ());
-                        recoHitEVect.emplace_back(hitE);
+                        output.m_recoHitId.emplace_back(hitId);
+                        output.m_recoHitSliceId.emplace_back(sliceId);
+                        output.m_recoHitClusterId.emplace_back(clusterId);
+                        output.m_recoHitX.emplace_back(hitPos.GetX());
+                        output.m_recoHitY.emplace_back(hitPos.GetY());
+                        output.m_recoHitZ.emplace_back(hitPos.GetZ());
+                        output.m_recoHitE.emplace_back(hitE);
                     }
                 }
 
                 // Find best-matched MC particle for this reconstructed PFO cluster
-                const HierarchyAnalysisAlgorithm::RecoMCMatch bestMatch = GetRecoMCMatch(pPfo, pRecoNode, matchInfo, rootMCParticles);
+                const HierarchyAnalysisAlgorithm::RecoMCMatch bestMatch = this->GetRecoMCMatch(pPfo, pRecoNode, hitMatchIndex);
 
                 // Best matched MC particle
                 const MCParticle *pLeadingMC = bestMatch.m_pLeadingMC;
@@ -403,7 +499,8 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                 const int mcPDG = (pLeadingMC != nullptr) ? pLeadingMC->GetParticleId() : 0;
                 // Unique and local MC Ids
                 const long mcId = (pLeadingMC != nullptr) ? reinterpret_cast<intptr_t>(pLeadingMC->GetUid()) : 0;
-                const long mcLocalId = (m_mcIdMap.find(mcId) != m_mcIdMap.end()) ? m_mcIdMap.at(mcId) : mcId;
+                const MCIdUniqueLocalMap::const_iterator mcIdIter(m_mcIdMap.find(mcId));
+                const long mcLocalId = (mcIdIter != m_mcIdMap.end()) ? mcIdIter->second : mcId;
                 const int isPrimary = (pLeadingMC != nullptr && LArMCParticleHelper::IsPrimary(pLeadingMC)) ? 1 : 0;
                 const float mcEnergy = (pLeadingMC != nullptr) ? pLeadingMC->GetEnergy() : 0.f;
                 const CartesianVector mcMomentum = (pLeadingMC != nullptr) ? pLeadingMC->GetMomentum() : CartesianVector(0.f, 0.f, 0.f);
@@ -423,8 +520,8 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                     }
                 }
 
-                mcParentPDGVect.emplace_back(mcParentPDG);
-                mcParentIdVect.emplace_back(mcParentId);
+                output.m_mcParentPDG.emplace_back(mcParentPDG);
+                output.m_mcParentId.emplace_back(mcParentId);
 
                 // MC neutrino parent info, including Nuance interaction code
                 const MCParticle *pNuRoot = bestMatch.m_pNuRoot;
@@ -436,119 +533,141 @@ void HierarchyAnalysisAlgorithm::EventAnalysisOutput(const LArHierarchyHelper::M
                 const float mcNuEnergy = (pNuRoot != nullptr) ? pNuRoot->GetEnergy() : 0.f;
                 const CartesianVector mcNuMomentum = (pNuRoot != nullptr) ? pNuRoot->GetMomentum() : CartesianVector(0.f, 0.f, 0.f);
 
-                matchVect.emplace_back(gotMatch);
-                mcPDGVect.emplace_back(mcPDG);
-                mcIdVect.emplace_back(mcId);
-                mcLocalIdVect.emplace_back(mcLocalId);
-                isPrimaryVect.emplace_back(isPrimary);
-                nSharedHitsVect.emplace_back(bestMatch.m_nSharedHits);
-                completenessVect.emplace_back(bestMatch.m_completeness);
-                purityVect.emplace_back(bestMatch.m_purity);
-                mcEVect.emplace_back(mcEnergy);
-                mcPxVect.emplace_back(mcMomentum.GetX());
-                mcPyVect.emplace_back(mcMomentum.GetY());
-                mcPzVect.emplace_back(mcMomentum.GetZ());
-                mcVtxXVect.emplace_back(mcVertex.GetX());
-                mcVtxYVect.emplace_back(mcVertex.GetY());
-                mcVtxZVect.emplace_back(mcVertex.GetZ());
-                mcEndXVect.emplace_back(mcEndPoint.GetX());
-                mcEndYVect.emplace_back(mcEndPoint.GetY());
-                mcEndZVect.emplace_back(mcEndPoint.GetZ());
-                mcNuPDGVect.emplace_back(mcNuPDG);
-                mcNuIdVect.emplace_back(mcNuId);
-                mcNuCodeVect.emplace_back(mcNuCode);
-                mcNuVtxXVect.emplace_back(mcNuVertex.GetX());
-                mcNuVtxYVect.emplace_back(mcNuVertex.GetY());
-                mcNuVtxZVect.emplace_back(mcNuVertex.GetZ());
-                mcNuEVect.emplace_back(mcNuEnergy);
-                mcNuPxVect.emplace_back(mcNuMomentum.GetX());
-                mcNuPyVect.emplace_back(mcNuMomentum.GetY());
-                mcNuPzVect.emplace_back(mcNuMomentum.GetZ());
+                output.m_gotMatch.emplace_back(gotMatch);
+                output.m_mcPDG.emplace_back(mcPDG);
+                output.m_mcId.emplace_back(mcId);
+                output.m_mcLocalId.emplace_back(mcLocalId);
+                output.m_isPrimary.emplace_back(isPrimary);
+                output.m_nSharedHits.emplace_back(bestMatch.m_nSharedHits);
+                output.m_completeness.emplace_back(bestMatch.m_completeness);
+                output.m_purity.emplace_back(bestMatch.m_purity);
+                output.m_mcEnergy.emplace_back(mcEnergy);
+                output.m_mcPx.emplace_back(mcMomentum.GetX());
+                output.m_mcPy.emplace_back(mcMomentum.GetY());
+                output.m_mcPz.emplace_back(mcMomentum.GetZ());
+                output.m_mcVtxX.emplace_back(mcVertex.GetX());
+                output.m_mcVtxY.emplace_back(mcVertex.GetY());
+                output.m_mcVtxZ.emplace_back(mcVertex.GetZ());
+                output.m_mcEndX.emplace_back(mcEndPoint.GetX());
+                output.m_mcEndY.emplace_back(mcEndPoint.GetY());
+                output.m_mcEndZ.emplace_back(mcEndPoint.GetZ());
+                output.m_mcNuPDG.emplace_back(mcNuPDG);
+                output.m_mcNuId.emplace_back(mcNuId);
+                output.m_mcNuCode.emplace_back(mcNuCode);
+                output.m_mcNuVtxX.emplace_back(mcNuVertex.GetX());
+                output.m_mcNuVtxY.emplace_back(mcNuVertex.GetY());
+                output.m_mcNuVtxZ.emplace_back(mcNuVertex.GetZ());
+                output.m_mcNuE.emplace_back(mcNuEnergy);
+                output.m_mcNuPx.emplace_back(mcNuMomentum.GetX());
+                output.m_mcNuPy.emplace_back(mcNuMomentum.GetY());
+                output.m_mcNuPz.emplace_back(mcNuMomentum.GetZ());
 
             } // Reco PFOs
         } // Reco nodes
     } // Root PFOs
 
-    // Fill ROOT ntuple
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "event", m_event));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "run", m_run));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "subRun", m_subRun));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "unixTime", m_unixTime));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "unixTimeUsec", m_unixTimeUsec));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "startTime", m_startTime));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "endTime", m_endTime));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "triggers", m_triggers));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "sliceId", &sliceIdVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nuVtxX", &nuVtxXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nuVtxY", &nuVtxYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nuVtxZ", &nuVtxZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "clusterId", &clusterIdVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "n3DHits", &n3DHitsVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nUHits", &nUHitsVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nVHits", &nVHitsVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nWHits", &nWHitsVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "isShower", &isShowerVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "trackScore", &trackScoreVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoPDG", &recoPDGVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "isRecoPrimary", &isRecoPrimaryVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "startX", &startXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "startY", &startYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "startZ", &startZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "endX", &endXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "endY", &endYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "endZ", &endZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "dirX", &dirXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "dirY", &dirYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "dirZ", &dirZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "centroidX", &centroidXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "centroidY", &centroidYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "centroidZ", &centroidZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "length1", &primaryLVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "length2", &secondaryLVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "length3", &tertiaryLVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "energy", &energyVect));
+    // Fill ROOT ntuple, from the bound event info and branch buffers
+    if (m_pAnalysisTreeWriter && (STATUS_CODE_SUCCESS != m_pAnalysisTreeWriter->Fill()))
+        std::cout << "HierarchyAnalysisAlgorithm: failed to fill analysis tree " << m_analysisTreeName << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode HierarchyAnalysisAlgorithm::CreateAnalysisTreeWriter()
+{
+    try
+    {
+        m_pAnalysisTreeWriter =
+            std::make_unique<AnalysisTreeWriter>(m_analysisFileName, m_analysisTreeName, m_analysisCompression, m_analysisBasketSize);
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        return statusCodeException.GetStatusCode();
+    }
+
+    m_pAnalysisTreeWriter->AddBranch("event", m_event);
+    m_pAnalysisTreeWriter->AddBranch("run", m_run);
+    m_pAnalysisTreeWriter->AddBranch("subRun", m_subRun);
+    m_pAnalysisTreeWriter->AddBranch("unixTime", m_unixTime);
+    m_pAnalysisTreeWriter->AddBranch("unixTimeUsec", m_unixTimeUsec);
+    m_pAnalysisTreeWriter->AddBranch("startTime", m_startTime);
+    m_pAnalysisTreeWriter->AddBranch("endTime", m_endTime);
+    m_pAnalysisTreeWriter->AddBranch("triggers", m_triggers);
+    m_pAnalysisTreeWriter->AddBranch("voxelWidth", m_voxelWidth);
+    m_pAnalysisTreeWriter->AddBranch("timeBudgetExceeded", m_timeBudgetExceeded);
+    m_pAnalysisTreeWriter->AddBranch("inputFileName", m_inputFileName);
+    m_pAnalysisTreeWriter->AddBranch("inputFileEntry", m_inputFileEntry);
+    m_pAnalysisTreeWriter->AddBranch("sliceId", m_analysisOutput.m_sliceId);
+    m_pAnalysisTreeWriter->AddBranch("nuVtxX", m_analysisOutput.m_nuVtxX);
+    m_pAnalysisTreeWriter->AddBranch("nuVtxY", m_analysisOutput.m_nuVtxY);
+    m_pAnalysisTreeWriter->AddBranch("nuVtxZ", m_analysisOutput.m_nuVtxZ);
+    m_pAnalysisTreeWriter->AddBranch("clusterId", m_analysisOutput.m_clusterId);
+    m_pAnalysisTreeWriter->AddBranch("n3DHits", m_analysisOutput.m_n3DHits);
+    m_pAnalysisTreeWriter->AddBranch("nUHits", m_analysisOutput.m_nUHits);
+    m_pAnalysisTreeWriter->AddBranch("nVHits", m_analysisOutput.m_nVHits);
+    m_pAnalysisTreeWriter->AddBranch("nWHits", m_analysisOutput.m_nWHits);
+    m_pAnalysisTreeWriter->AddBranch("isShower", m_analysisOutput.m_isShower);
+    m_pAnalysisTreeWriter->AddBranch("trackScore", m_analysisOutput.m_trackScore);
+    m_pAnalysisTreeWriter->AddBranch("recoPDG", m_analysisOutput.m_recoPDG);
+    m_pAnalysisTreeWriter->AddBranch("isRecoPrimary", m_analysisOutput.m_isRecoPrimary);
+    m_pAnalysisTreeWriter->AddBranch("startX", m_analysisOutput.m_startX);
+    m_pAnalysisTreeWriter->AddBranch("startY", m_analysisOutput.m_startY);
+    m_pAnalysisTreeWriter->AddBranch("startZ", m_analysisOutput.m_startZ);
+    m_pAnalysisTreeWriter->AddBranch("endX", m_analysisOutput.m_endX);
+    m_pAnalysisTreeWriter->AddBranch("endY", m_analysisOutput.m_endY);
+    m_pAnalysisTreeWriter->AddBranch("endZ", m_analysisOutput.m_endZ);
+    m_pAnalysisTreeWriter->AddBranch("dirX", m_analysisOutput.m_dirX);
+    m_pAnalysisTreeWriter->AddBranch("dirY", m_analysisOutput.m_dirY);
+    m_pAnalysisTreeWriter->AddBranch("dirZ", m_analysisOutput.m_dirZ);
+    m_pAnalysisTreeWriter->AddBranch("centroidX", m_analysisOutput.m_centroidX);
+    m_pAnalysisTreeWriter->AddBranch("centroidY", m_analysisOutput.m_centroidY);
+    m_pAnalysisTreeWriter->AddBranch("centroidZ", m_analysisOutput.m_centroidZ);
+    m_pAnalysisTreeWriter->AddBranch("length1", m_analysisOutput.m_length1);
+    m_pAnalysisTreeWriter->AddBranch("length2", m_analysisOutput.m_length2);
+    m_pAnalysisTreeWriter->AddBranch("length3", m_analysisOutput.m_length3);
+    m_pAnalysisTreeWriter->AddBranch("energy", m_analysisOutput.m_energy);
     if (m_storeClusterRecoHits)
     {
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitId", &recoHitIdVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitSliceId", &recoHitSliceIdVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitClusterId", &recoHitClusterIdVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitX", &recoHitXVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitY", &recoHitYVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitZ", &recoHitZVect));
-        PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "recoHitE", &recoHitEVect));
+        m_pAnalysisTreeWriter->AddBranch("recoHitId", m_analysisOutput.m_recoHitId);
+        m_pAnalysisTreeWriter->AddBranch("recoHitSliceId", m_analysisOutput.m_recoHitSliceId);
+        m_pAnalysisTreeWriter->AddBranch("recoHitClusterId", m_analysisOutput.m_recoHitClusterId);
+        m_pAnalysisTreeWriter->AddBranch("recoHitX", m_analysisOutput.m_recoHitX);
+        m_pAnalysisTreeWriter->AddBranch("recoHitY", m_analysisOutput.m_recoHitY);
+        m_pAnalysisTreeWriter->AddBranch("recoHitZ", m_analysisOutput.m_recoHitZ);
+        m_pAnalysisTreeWriter->AddBranch("recoHitE", m_analysisOutput.m_recoHitE);
     }
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "gotMatch", &matchVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcPDG", &mcPDGVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcId", &mcIdVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcLocalId", &mcLocalIdVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "isPrimary", &isPrimaryVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "nSharedHits", &nSharedHitsVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "completeness", &completenessVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "purity", &purityVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcEnergy", &mcEVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcPx", &mcPxVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcPy", &mcPyVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcPz", &mcPzVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcVtxX", &mcVtxXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcVtxY", &mcVtxYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcVtxZ", &mcVtxZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcEndX", &mcEndXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcEndY", &mcEndYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcEndZ", &mcEndZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuPDG", &mcNuPDGVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuId", &mcNuIdVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuCode", &mcNuCodeVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuVtxX", &mcNuVtxXVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuVtxY", &mcNuVtxYVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuVtxZ", &mcNuVtxZVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuE", &mcNuEVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuPx", &mcNuPxVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuPy", &mcNuPyVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcNuPz", &mcNuPzVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcParentPDG", &mcParentPDGVect));
-    PANDORA_MONITORING_API(SetTreeVariable(this->GetPandora(), m_analysisTreeName.c_str(), "mcParentId", &mcParentIdVect));
-
-    PANDORA_MONITORING_API(FillTree(this->GetPandora(), m_analysisTreeName.c_str()));
+    m_pAnalysisTreeWriter->AddBranch("gotMatch", m_analysisOutput.m_gotMatch);
+    m_pAnalysisTreeWriter->AddBranch("mcPDG", m_analysisOutput.m_mcPDG);
+    m_pAnalysisTreeWriter->AddBranch("mcId", m_analysisOutput.m_mcId);
+    m_pAnalysisTreeWriter->AddBranch("mcLocalId", m_analysisOutput.m_mcLocalId);
+    m_pAnalysisTreeWriter->AddBranch("isPrimary", m_analysisOutput.m_isPrimary);
+    m_pAnalysisTreeWriter->AddBranch("nSharedHits", m_analysisOutput.m_nSharedHits);
+    m_pAnalysisTreeWriter->AddBranch("completeness", m_analysisOutput.m_completeness);
+    m_pAnalysisTreeWriter->AddBranch("purity", m_analysisOutput.m_purity);
+    m_pAnalysisTreeWriter->AddBranch("mcEnergy", m_analysisOutput.m_mcEnergy);
+    m_pAnalysisTreeWriter->AddBranch("mcPx", m_analysisOutput.m_mcPx);
+    m_pAnalysisTreeWriter->AddBranch("mcPy", m_analysisOutput.m_mcPy);
+    m_pAnalysisTreeWriter->AddBranch("mcPz", m_analysisOutput.m_mcPz);
+    m_pAnalysisTreeWriter->AddBranch("mcVtxX", m_analysisOutput.m_mcVtxX);
+    m_pAnalysisTreeWriter->AddBranch("mcVtxY", m_analysisOutput.m_mcVtxY);
+    m_pAnalysisTreeWriter->AddBranch("mcVtxZ", m_analysisOutput.m_mcVtxZ);
+    m_pAnalysisTreeWriter->AddBranch("mcEndX", m_analysisOutput.m_mcEndX);
+    m_pAnalysisTreeWriter->AddBranch("mcEndY", m_analysisOutput.m_mcEndY);
+    m_pAnalysisTreeWriter->AddBranch("mcEndZ", m_analysisOutput.m_mcEndZ);
+    m_pAnalysisTreeWriter->AddBranch("mcNuPDG", m_analysisOutput.m_mcNuPDG);
+    m_pAnalysisTreeWriter->AddBranch("mcNuId", m_analysisOutput.m_mcNuId);
+    m_pAnalysisTreeWriter->AddBranch("mcNuCode", m_analysisOutput.m_mcNuCode);
+    m_pAnalysisTreeWriter->AddBranch("mcNuVtxX", m_analysisOutput.m_mcNuVtxX);
+    m_pAnalysisTreeWriter->AddBranch("mcNuVtxY", m_analysisOutput.m_mcNuVtxY);
+    m_pAnalysisTreeWriter->AddBranch("mcNuVtxZ", m_analysisOutput.m_mcNuVtxZ);
+    m_pAnalysisTreeWriter->AddBranch("mcNuE", m_analysisOutput.m_mcNuE);
+    m_pAnalysisTreeWriter->AddBranch("mcNuPx", m_analysisOutput.m_mcNuPx);
+    m_pAnalysisTreeWriter->AddBranch("mcNuPy", m_analysisOutput.m_mcNuPy);
+    m_pAnalysisTreeWriter->AddBranch("mcNuPz", m_analysisOutput.m_mcNuPz);
+    m_pAnalysisTreeWriter->AddBranch("mcParentPDG", m_analysisOutput.m_mcParentPDG);
+    m_pAnalysisTreeWriter->AddBranch("mcParentId", m_analysisOutput.m_mcParentId);
+
+    return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -569,77 +688,60 @@ const Cluster *HierarchyAnalysisAlgorithm::GetCluster(const ParticleFlowObject *
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 const HierarchyAnalysisAlgorithm::RecoMCMatch HierarchyAnalysisAlgorithm::GetRecoMCMatch(const pandora::ParticleFlowObject *pPfo,
-    const LArHierarchyHelper::RecoHierarchy::Node *pRecoNode, const LArHierarchyHelper::MatchInfo &matchInfo, MCParticleList &rootMCParticles) const
+    const LArHierarchyHelper::RecoHierarchy::Node *pRecoNode, const HitMatchIndex &hitMatchIndex) const
 {
     int nSharedHits{0};
     float completeness{0.f}, purity{0.f};
 
     const MCParticle *pRootNu{nullptr}, *pLeadingMC{nullptr};
 
-    // Loop over the root (neutrino) MC particles
-    for (const MCParticle *const pMCRoot : rootMCParticles)
+    // The (root MC particle, match) pairs in which the current recoNode is one of the reco matches
+    const HitMatchIndex::RecoNodeToMatchesMap::const_iterator matchesIter{hitMatchIndex.m_recoNodeToMatchesMap.find(pRecoNode)};
+    if (matchesIter == hitMatchIndex.m_recoNodeToMatchesMap.end())
+        return RecoMCMatch(pRootNu, pLeadingMC, nSharedHits, completeness, purity);
+
+    // The MC matching uses nodes which can have more than 1 folded particle/PFO.
+    // For completeness & purity, only use the required PFO hits and not all hits from
+    // the reco node (which will include other PFOs if they are present). Only the PFO
+    // hits that are selected reco hits of the node (such that each reco hit has a
+    // corresponding MC hit) are used, and the shared hits for every MC node are
+    // accumulated in a single pass over these hits
+    CaloHitList pfoHits;
+    LArPfoHelper::GetAllCaloHits2D(pPfo, pfoHits);
+
+    int nSelectedPfoHits{0};
+    std::unordered_map<const LArHierarchyHelper::MCHierarchy::Node *, int> mcNodeSharedHits;
+
+    for (const CaloHit *const pCaloHit : pfoHits)
     {
-        // Loop over the possible matches
-        const LArHierarchyHelper::MCMatchesVector &matches{matchInfo.GetMatches(pMCRoot)};
+        const HitMatchIndex::HitToRecoNodeMap::const_iterator recoIter{hitMatchIndex.m_hitToRecoNodeMap.find(pCaloHit)};
+        if ((recoIter == hitMatchIndex.m_hitToRecoNodeMap.end()) || (recoIter->second != pRecoNode))
+            continue;
 
-        for (const LArHierarchyHelper::MCMatches &match : matches)
-        {
-            // MC node
-            const LArHierarchyHelper::MCHierarchy::Node *pMCNode{match.GetMC()};
+        ++nSelectedPfoHits;
 
-            // Reco matches
-            const LArHierarchyHelper::RecoHierarchy::NodeVector &nodeVector{match.GetRecoMatches()};
+        const HitMatchIndex::HitToMCNodeMap::const_iterator mcIter{hitMatchIndex.m_hitToMCNodeMap.find(pCaloHit)};
+        if (mcIter != hitMatchIndex.m_hitToMCNodeMap.end())
+            ++mcNodeSharedHits[mcIter->second];
+    }
 
-            // See if the current recoNode is in the reco matches vector
-            if (std::find(nodeVector.begin(), nodeVector.end(), pRecoNode) != nodeVector.end())
-            {
-                // The MC matching uses nodes which can have more than 1 folded particle/PFO.
-                // The PFO passed to this function will be part of the matched reco node
-                // once the code reaches here, but this reco node can have more than 1 PFO via folding.
-                // For completeness & purity, only use the required PFO hits and not all hits from
-                // the reco node (which will include other PFOs if they are present).
-                // Copies and adapts code from GetSharedHits(), GetCompleteness() & GetPurity() from
-                // LArHierarchyHelper::MCMatches to avoid duplicate shared hits, completeness & purities
-                // for the case when reco nodes have more than 1 PFO. Otherwise each PFO from
-                // the same reco node will always return the same match quantities
-
-                // Get hits for this best matched MC node
-                CaloHitList mcHits = pMCNode->GetCaloHits();
-
-                // Get all the reco hits for the passed PFO only, not the whole reco node
-                CaloHitList pfoHits;
-                LArPfoHelper::GetAllCaloHits2D(pPfo, pfoHits);
-
-                // Get the selected hits of the reco node, such that each reco hit has a corresponding MC hit
-                CaloHitList selectedRecoHits = match.GetSelectedRecoHits(pRecoNode);
-
-                // Sort the hit lists
-                mcHits.sort();
-                pfoHits.sort();
-                selectedRecoHits.sort();
-
-                // Get the PFO reco hits that are also part of the selected reco list (such that each reco hit has a corresponding MC hit)
-                CaloHitVector selectedPfoHits;
-                std::set_intersection(
-                    pfoHits.begin(), pfoHits.end(), selectedRecoHits.begin(), selectedRecoHits.end(), std::back_inserter(selectedPfoHits));
-
-                // Find the overlap of these MC & selected PFO reco hit lists
-                CaloHitVector intersection;
-                std::set_intersection(mcHits.begin(), mcHits.end(), selectedPfoHits.begin(), selectedPfoHits.end(), std::back_inserter(intersection));
-
-                const int currentSharedHits = intersection.size();
-
-                if (currentSharedHits > nSharedHits)
-                {
-                    nSharedHits = currentSharedHits;
-                    completeness = (mcHits.size() > 0) ? nSharedHits / static_cast<float>(mcHits.size()) : 0.0;
-                    purity = (selectedPfoHits.size() > 0) ? nSharedHits / static_cast<float>(selectedPfoHits.size()) : 0.0;
-                    pRootNu = pMCRoot;
-                    pLeadingMC = pMCNode->GetLeadingMCParticle();
-                }
-            } // Find recoNode
-        } // Match loop
-    } // Root MC particles
+    // Choose the first match with the largest number of shared hits
+    for (const HitMatchIndex::RootMatch &rootMatch : matchesIter->second)
+    {
+        const LArHierarchyHelper::MCHierarchy::Node *pMCNode{rootMatch.second->GetMC()};
+        const auto sharedIter(mcNodeSharedHits.find(pMCNode));
+        const int currentSharedHits{(sharedIter != mcNodeSharedHits.end()) ? sharedIter->second : 0};
+
+        if (currentSharedHits > nSharedHits)
+        {
+            const size_t nMCHits{pMCNode->GetCaloHits().size()};
+            nSharedHits = currentSharedHits;
+            completeness = (nMCHits > 0) ? nSharedHits / static_cast<float>(nMCHits) : 0.0;
+            purity = (nSelectedPfoHits > 0) ? nSharedHits / static_cast<float>(nSelectedPfoHits) : 0.0;
+            pRootNu = rootMatch.first;
+            pLeadingMC = pMCNode->GetLeadingMCParticle();
+        }
+    }
 
     const HierarchyAnalysisAlgorithm::RecoMCMatch info(pRootNu, pLeadingMC, nSharedHits, completeness, purity);
     return info;
@@ -659,6 +761,111 @@ HierarchyAnalysisAlgorithm::RecoMCMatch::RecoMCMatch(const pandora::MCParticle *
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+void HierarchyAnalysisAlgorithm::AnalysisOutput::Clear()
+{
+    m_sliceId.clear();
+    m_nuVtxX.clear();
+    m_nuVtxY.clear();
+    m_nuVtxZ.clear();
+    m_clusterId.clear();
+    m_n3DHits.clear();
+    m_nUHits.clear();
+    m_nVHits.clear();
+    m_nWHits.clear();
+    m_isShower.clear();
+    m_trackScore.clear();
+    m_recoPDG.clear();
+    m_isRecoPrimary.clear();
+    m_startX.clear();
+    m_startY.clear();
+    m_startZ.clear();
+    m_endX.clear();
+    m_endY.clear();
+    m_endZ.clear();
+    m_dirX.clear();
+    m_dirY.clear();
+    m_dirZ.clear();
+    m_centroidX.clear();
+    m_centroidY.clear();
+    m_centroidZ.clear();
+    m_length1.clear();
+    m_length2.clear();
+    m_length3.clear();
+    m_energy.clear();
+    m_recoHitId.clear();
+    m_recoHitSliceId.clear();
+    m_recoHitClusterId.clear();
+    m_recoHitX.clear();
+    m_recoHitY.clear();
+    m_recoHitZ.clear();
+    m_recoHitE.clear();
+    m_gotMatch.clear();
+    m_mcPDG.clear();
+    m_mcId.clear();
+    m_mcLocalId.clear();
+    m_isPrimary.clear();
+    m_nSharedHits.clear();
+    m_completeness.clear();
+    m_purity.clear();
+    m_mcEnergy.clear();
+    m_mcPx.clear();
+    m_mcPy.clear();
+    m_mcPz.clear();
+    m_mcVtxX.clear();
+    m_mcVtxY.clear();
+    m_mcVtxZ.clear();
+    m_mcEndX.clear();
+    m_mcEndY.clear();
+    m_mcEndZ.clear();
+    m_mcNuPDG.clear();
+    m_mcNuId.clear();
+    m_mcNuCode.clear();
+    m_mcNuVtxX.clear();
+    m_mcNuVtxY.clear();
+    m_mcNuVtxZ.clear();
+    m_mcNuE.clear();
+    m_mcNuPx.clear();
+    m_mcNuPy.clear();
+    m_mcNuPz.clear();
+    m_mcParentPDG.clear();
+    m_mcParentId.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+HierarchyAnalysisAlgorithm::ExternalInstanceParameters::ExternalInstanceParameters() :
+    m_pInputEvents{nullptr},
+    m_analysisFileName{""},
+    m_eventFileNames{}
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+HierarchyAnalysisAlgorithm::HitMatchIndex::HitMatchIndex(
+    const LArHierarchyHelper::MatchInfo &matchInfo, const MCParticleList &rootMCParticles)
+{
+    for (const MCParticle *const pMCRoot : rootMCParticles)
+    {
+        for (const LArHierarchyHelper::MCMatches &match : matchInfo.GetMatches(pMCRoot))
+        {
+            const LArHierarchyHelper::MCHierarchy::Node *pMCNode{match.GetMC()};
+
+            for (const CaloHit *const pCaloHit : pMCNode->GetCaloHits())
+                m_hitToMCNodeMap.emplace(pCaloHit, pMCNode);
+
+            for (const LArHierarchyHelper::RecoHierarchy::Node *pRecoNode : match.GetRecoMatches())
+            {
+                m_recoNodeToMatchesMap[pRecoNode].emplace_back(pMCRoot, &match);
+
+                // The selected reco hits of a node are its hits with a corresponding MC hit, whichever MC node it is matched to
+                for (const CaloHit *const pCaloHit : match.GetSelectedRecoHits(pRecoNode))
+                    m_hitToRecoNodeMap.emplace(pCaloHit, pRecoNode);
+            }
+        }
+    }
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode HierarchyAnalysisAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
@@ -687,50 +894,6 @@ StatusCode HierarchyAnalysisAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
 
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "MinHitsToSkip", m_minHitsToSkip));
 
-    // Setup the event ROOT file
-    if (m_eventFileName.size() > 0)
-    {
-        m_eventFile = TFile::Open(m_eventFileName.c_str(), "READ");
-        if (m_eventFile && m_eventFile->IsOpen())
-        {
-            m_eventTree = dynamic_cast<TTree *>(m_eventFile->Get(m_eventTreeName.c_str()));
-            if (m_eventTree)
-            {
-                // Only enable the event and run number leaves as well as the trigger timing.
-                // Also enable the vertex_id leaf
-                m_eventTree->SetBranchStatus("*", 0);
-                m_eventTree->SetBranchStatus(m_eventLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_runLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_subRunLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_unixTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_unixTimeUsecLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_startTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_endTimeLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_triggersLeafName.c_str(), 1);
-                m_eventTree->SetBranchStatus(m_nhitsLeafName.c_str(), 1);
-                m_eventTree->SetBranchAddress(m_eventLeafName.c_str(), &m_event);
-                m_eventTree->SetBranchAddress(m_runLeafName.c_str(), &m_run);
-                m_eventTree->SetBranchAddress(m_subRunLeafName.c_str(), &m_subRun);
-                m_eventTree->SetBranchAddress(m_unixTimeLeafName.c_str(), &m_unixTime);
-                m_eventTree->SetBranchAddress(m_unixTimeUsecLeafName.c_str(), &m_unixTimeUsec);
-                m_eventTree->SetBranchAddress(m_startTimeLeafName.c_str(), &m_startTime);
-                m_eventTree->SetBranchAddress(m_endTimeLeafName.c_str(), &m_endTime);
-                m_eventTree->SetBranchAddress(m_triggersLeafName.c_str(), &m_triggers);
-                m_eventTree->SetBranchAddress(m_nhitsLeafName.c_str(), &m_nhits);
-
-                // Check if we have MC branches
-                if (m_eventTree->GetBranch(m_mcIdLeafName.c_str()) && m_eventTree->GetBranch(m_mcLocalIdLeafName.c_str()))
-                {
-                    m_gotMCEventInput = true;
-                    m_eventTree->SetBranchStatus(m_mcIdLeafName.c_str(), 1);
-                    m_eventTree->SetBranchStatus(m_mcLocalIdLeafName.c_str(), 1);
-                    m_eventTree->SetBranchAddress(m_mcIdLeafName.c_str(), &m_mcIDs);
-                    m_eventTree->SetBranchAddress(m_mcLocalIdLeafName.c_str(), &m_mcLocalIDs);
-                }
-            }
-        }
-    }
-
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "CaloHitListName", m_caloHitListName));
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "PfoListName", m_pfoListName));
 
@@ -741,6 +904,43 @@ StatusCode HierarchyAnalysisAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
     PANDORA_RETURN_RESULT_IF_AND_IF(
         STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "AnalysisTreeName", m_analysisTreeName));
 
+    // Several primary instances share the input events: each writes its own analysis file, merged by the caller in input order.
+    // Several input files are read by PandoraInterface as one chain of events, so the event info is read from the same files
+    pandora::StringVector eventFileNames;
+
+    if (this->ExternalParametersPresent())
+    {
+        const ExternalInstanceParameters *const pExternalParameters(
+            dynamic_cast<const ExternalInstanceParameters *>(this->GetExternalParameters()));
+
+        if (!pExternalParameters)
+            return STATUS_CODE_INVALID_PARAMETER;
+
+        m_pInputEvents = pExternalParameters->m_pInputEvents;
+
+        if (!pExternalParameters->m_analysisFileName.empty())
+            m_analysisFileName = pExternalParameters->m_analysisFileName;
+
+        eventFileNames = pExternalParameters->m_eventFileNames;
+    }
+
+    this->OpenEventChain(eventFileNames);
+
+    // Events shared between instances are only known as each is claimed, so the entries are indexed up front for a sole instance
+    if (m_eventChain && !m_pInputEvents)
+        this->FillEventEntryIndex();
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "AnalysisCompression", m_analysisCompression));
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "AnalysisBasketSize", m_analysisBasketSize));
+
+    if (m_analysisBasketSize <= 0)
+    {
+        std::cout << "HierarchyAnalysisAlgorithm: AnalysisBasketSize must be positive" << std::endl;
+        return STATUS_CODE_INVALID_PARAMETER;
+    }
+
     PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "FoldToPrimaries", m_foldToPrimaries));
     PANDORA_RETURN_RESULT_IF_AND_IF(
         STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "FoldToLeadingShowers", m_foldToLeadingShowers));
@@ -759,6 +959,9 @@ StatusCode HierarchyAnalysisAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
     PANDORA_RETURN_RESULT_IF_AND_IF(
         STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "StoreClusterRecoHits", m_storeClusterRecoHits));
 
+    // The output file name and the branches to write are now known
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CreateAnalysisTreeWriter());
+
     return STATUS_CODE_SUCCESS;
 }
 
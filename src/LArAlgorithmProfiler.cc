@@ -0,0 +1,408 @@
+/**
+ *  @file   src/LArAlgorithmProfiler.cc
+ *
+ *  @brief  Implementation of the algorithm profiler class.
+ *
+ *  $Log: $
+ */
+
+#include "Api/PandoraApi.h"
+
+#include "Pandora/Pandora.h"
+#include "Pandora/StatusCodes.h"
+
+#include "Xml/tinyxml.h"
+
+#include "LArAlgorithmProfiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#include <sys/resource.h>
+
+using namespace pandora;
+
+namespace
+{
+
+/**
+ *  @brief  Get the wall time, from a monotonic clock
+ *
+ *  @return the wall time, in ms
+ */
+double GetWallTime()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the cpu time used by the calling thread, so that concurrently running instances are not charged for each other
+ *
+ *  @return the cpu time, in ms
+ */
+double GetThreadCpuTime()
+{
+    struct timespec cpuTime;
+
+    if (0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuTime))
+        return 0.;
+
+    return 1000. * static_cast<double>(cpuTime.tv_sec) + 1.e-6 * static_cast<double>(cpuTime.tv_nsec);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the peak resident set size of the process
+ *
+ *  @return the peak resident set size, in kB
+ */
+long GetPeakRss()
+{
+    struct rusage resourceUsage;
+
+    if (0 != getrusage(RUSAGE_SELF, &resourceUsage))
+        return 0;
+
+    return resourceUsage.ru_maxrss;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the type of an instance, i.e. its name without any trailing index, so that equivalent workers are summarised together
+ *
+ *  @param  instanceName the instance name
+ *
+ *  @return the instance type
+ */
+std::string GetInstanceType(const std::string &instanceName)
+{
+    const std::size_t typeEnd(instanceName.find_last_not_of("0123456789_"));
+    return (std::string::npos == typeEnd) ? instanceName : instanceName.substr(0, typeEnd + 1);
+}
+
+} // namespace
+
+namespace lar_content
+{
+
+AlgorithmProfiler::ListSizes::ListSizes() :
+    m_nCaloHits(0),
+    m_nClusters(0),
+    m_nPfos(0),
+    m_nVertices(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+AlgorithmProfiler &AlgorithmProfiler::GetInstance()
+{
+    static AlgorithmProfiler algorithmProfiler;
+    return algorithmProfiler;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode AlgorithmProfiler::Enable(const std::string &profileFileName)
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (m_isEnabled)
+        return STATUS_CODE_ALREADY_INITIALIZED;
+
+    m_profileFile.open(profileFileName, std::ios::out | std::ios::trunc);
+
+    if (!m_profileFile.is_open())
+    {
+        std::cout << "AlgorithmProfiler::Enable - unable to create profile file " << profileFileName << std::endl;
+        return STATUS_CODE_FAILURE;
+    }
+
+    m_profileFile << "instance,event,algorithm,wall_ms,cpu_ms,peak_rss_delta_kb,hits_in,hits_out,clusters_in,clusters_out,"
+                  << "pfos_in,pfos_out,vertices_in,vertices_out" << std::endl;
+    m_isEnabled = true;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool AlgorithmProfiler::IsEnabled() const
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    return m_isEnabled;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode AlgorithmProfiler::ReadSettings(const Pandora &pandora, const std::string &settingsFile)
+{
+    if (!this->IsEnabled())
+        return PandoraApi::ReadSettings(pandora, settingsFile);
+
+    std::unique_ptr<TiXmlDocument> pXmlDocument(new TiXmlDocument(settingsFile));
+
+    if (!pXmlDocument->LoadFile())
+    {
+        std::cout << "AlgorithmProfiler::ReadSettings - Invalid xml file " << settingsFile << std::endl;
+        return STATUS_CODE_FAILURE;
+    }
+
+    AlgorithmProfiler::InsertCheckpoints(pXmlDocument->RootElement());
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(pandora, pXmlDocument->RootElement()));
+
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    m_settingsDocuments.push_back(std::move(pXmlDocument));
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AlgorithmProfiler::InsertCheckpoints(TiXmlElement *const pXmlElement)
+{
+    if (!pXmlElement)
+        return;
+
+    TiXmlElement *pAlgorithmElement(pXmlElement->FirstChildElement("algorithm"));
+
+    if (!pAlgorithmElement)
+        return;
+
+    // The checkpoint at the start of each event profiles nothing, but sets the reference point for the first algorithm
+    TiXmlElement startCheckpoint("algorithm");
+    startCheckpoint.SetAttribute("type", "LArProfilingCheckpoint");
+    pXmlElement->InsertBeforeChild(pAlgorithmElement, startCheckpoint);
+
+    while (pAlgorithmElement)
+    {
+        TiXmlElement *const pNextAlgorithmElement(pAlgorithmElement->NextSiblingElement("algorithm"));
+        const char *const pType(pAlgorithmElement->Attribute("type"));
+        const char *const pDescription(pAlgorithmElement->Attribute("description"));
+
+        std::string algorithmName(pType ? pType : "Unknown");
+
+        if (pDescription)
+            algorithmName += "/" + std::string(pDescription);
+
+        TiXmlElement profiledAlgorithm("ProfiledAlgorithm");
+        profiledAlgorithm.InsertEndChild(TiXmlText(algorithmName.c_str()));
+
+        TiXmlElement checkpoint("algorithm");
+        checkpoint.SetAttribute("type", "LArProfilingCheckpoint");
+        checkpoint.InsertEndChild(profiledAlgorithm);
+        pXmlElement->InsertAfterChild(pAlgorithmElement, checkpoint);
+
+        pAlgorithmElement = pNextAlgorithmElement;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::shared_ptr<AlgorithmProfiler::InstanceProfile> AlgorithmProfiler::GetInstanceProfile(const Pandora &pandora)
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    std::shared_ptr<InstanceProfile> &pInstanceProfile(m_instanceProfileMap[&pandora]);
+
+    if (!pInstanceProfile)
+        pInstanceProfile = std::make_shared<InstanceProfile>(pandora.GetName().empty() ? "Primary" : pandora.GetName());
+
+    return pInstanceProfile;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AlgorithmProfiler::RecordCheckpoint(InstanceProfile &instanceProfile, const std::string &algorithmName, const ListSizes &listSizes)
+{
+    const double wallTime(GetWallTime());
+    const double cpuTime(GetThreadCpuTime());
+    const long peakRss(GetPeakRss());
+
+    if (algorithmName.empty())
+    {
+        ++instanceProfile.m_event;
+    }
+    else if (instanceProfile.m_hasCheckpoint)
+    {
+        InstanceProfile::Record record;
+        record.m_algorithmName = algorithmName;
+        record.m_event = instanceProfile.m_event;
+        record.m_wallTime = wallTime - instanceProfile.m_wallTime;
+        record.m_cpuTime = cpuTime - instanceProfile.m_cpuTime;
+        record.m_peakRssDelta = peakRss - instanceProfile.m_peakRss;
+        record.m_listSizesIn = instanceProfile.m_listSizes;
+        record.m_listSizesOut = listSizes;
+        instanceProfile.m_records.push_back(std::move(record));
+    }
+
+    // ATTN The records are written in batches, to bound the memory used without locking at every checkpoint
+    const std::size_t maxBufferedRecords(10000);
+
+    if (instanceProfile.m_records.size() >= maxBufferedRecords)
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        this->WriteRecords(instanceProfile);
+    }
+
+    // Read the clock again, so that the time spent recording is not attributed to the next algorithm
+    instanceProfile.m_hasCheckpoint = true;
+    instanceProfile.m_wallTime = GetWallTime();
+    instanceProfile.m_cpuTime = GetThreadCpuTime();
+    instanceProfile.m_peakRss = peakRss;
+    instanceProfile.m_listSizes = listSizes;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AlgorithmProfiler::DeleteInstanceProfile(const Pandora &pandora)
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    InstanceProfileMap::iterator iter(m_instanceProfileMap.find(&pandora));
+
+    if (m_instanceProfileMap.end() == iter)
+        return;
+
+    this->WriteRecords(*iter->second);
+    m_instanceProfileMap.erase(iter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AlgorithmProfiler::Finish()
+{
+    const std::lock_guard<std::mutex> lock(m_mutex);
+
+    if (!m_isEnabled)
+        return;
+
+    for (InstanceProfileMap::value_type &mapEntry : m_instanceProfileMap)
+        this->WriteRecords(*mapEntry.second);
+
+    m_instanceProfileMap.clear();
+
+    std::vector<std::string> instanceTypes;
+    std::unordered_map<std::string, double> instanceTypeWallTimeMap;
+
+    for (const Summary &summary : m_summaries)
+    {
+        if (!instanceTypeWallTimeMap.count(summary.m_instanceType))
+            instanceTypes.push_back(summary.m_instanceType);
+
+        instanceTypeWallTimeMap[summary.m_instanceType] += summary.m_totalWallTime;
+    }
+
+    std::ostringstream table;
+    table << std::fixed << std::setprecision(2) << std::left << std::setw(20) << "Instance" << std::setw(48) << "Algorithm" << std::right
+          << std::setw(8) << "Calls" << std::setw(14) << "Wall [s]" << std::setw(14) << "Mean [ms]" << std::setw(14) << "Max [ms]"
+          << std::setw(14) << "Cpu [s]" << std::setw(16) << "MaxRss+ [kB]" << std::setw(10) << "Wall [%]" << "\n";
+
+    for (const std::string &instanceType : instanceTypes)
+    {
+        const double instanceWallTime(instanceTypeWallTimeMap.at(instanceType));
+
+        for (const Summary &summary : m_summaries)
+        {
+            if (summary.m_instanceType != instanceType)
+                continue;
+
+            table << std::left << std::setw(20) << summary.m_instanceType << std::setw(48) << summary.m_algorithmName << std::right
+                  << std::setw(8) << summary.m_nCalls << std::setw(14) << 1.e-3 * summary.m_totalWallTime << std::setw(14)
+                  << summary.m_totalWallTime / summary.m_nCalls << std::setw(14) << summary.m_maxWallTime << std::setw(14)
+                  << 1.e-3 * summary.m_totalCpuTime << std::setw(16) << summary.m_maxPeakRssDelta << std::setw(10)
+                  << ((instanceWallTime > 0.) ? 100. * summary.m_totalWallTime / instanceWallTime : 0.) << "\n";
+        }
+    }
+
+    std::cout << "AlgorithmProfiler summary (peak RSS is process-wide, so it is shared between concurrently running instances)\n"
+              << table.str() << std::flush;
+
+    std::istringstream tableLines(table.str());
+    std::string line;
+
+    while (std::getline(tableLines, line))
+        m_profileFile << "# " << line << "\n";
+
+    m_profileFile.close();
+    m_isEnabled = false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AlgorithmProfiler::WriteRecords(InstanceProfile &instanceProfile)
+{
+    if (m_isEnabled)
+    {
+        const std::string instanceType(GetInstanceType(instanceProfile.m_instanceName));
+
+        for (const InstanceProfile::Record &record : instanceProfile.m_records)
+        {
+            const ListSizes &in(record.m_listSizesIn), &out(record.m_listSizesOut);
+
+            m_profileFile << instanceProfile.m_instanceName << "," << record.m_event << "," << record.m_algorithmName << ","
+                          << record.m_wallTime << "," << record.m_cpuTime << "," << record.m_peakRssDelta << "," << in.m_nCaloHits << ","
+                          << out.m_nCaloHits << "," << in.m_nClusters << "," << out.m_nClusters << "," << in.m_nPfos << "," << out.m_nPfos
+                          << "," << in.m_nVertices << "," << out.m_nVertices << "\n";
+
+            const std::string summaryKey(instanceType + "," + record.m_algorithmName);
+            SummaryIndexMap::const_iterator indexIter(m_summaryIndexMap.find(summaryKey));
+
+            if (m_summaryIndexMap.end() == indexIter)
+            {
+                indexIter = m_summaryIndexMap.emplace(summaryKey, m_summaries.size()).first;
+                m_summaries.emplace_back(instanceType, record.m_algorithmName);
+            }
+
+            Summary &summary(m_summaries.at(indexIter->second));
+            ++summary.m_nCalls;
+            summary.m_totalWallTime += record.m_wallTime;
+            summary.m_maxWallTime = std::max(summary.m_maxWallTime, record.m_wallTime);
+            summary.m_totalCpuTime += record.m_cpuTime;
+            summary.m_maxPeakRssDelta = std::max(summary.m_maxPeakRssDelta, record.m_peakRssDelta);
+        }
+    }
+
+    instanceProfile.m_records.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+AlgorithmProfiler::AlgorithmProfiler() :
+    m_isEnabled(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+AlgorithmProfiler::InstanceProfile::InstanceProfile(const std::string &instanceName) :
+    m_instanceName(instanceName),
+    m_hasCheckpoint(false),
+    m_event(-1),
+    m_wallTime(0.),
+    m_cpuTime(0.),
+    m_peakRss(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+AlgorithmProfiler::Summary::Summary(const std::string &instanceType, const std::string &algorithmName) :
+    m_instanceType(instanceType),
+    m_algorithmName(algorithmName),
+    m_nCalls(0),
+    m_totalWallTime(0.),
+    m_maxWallTime(0.),
+    m_totalCpuTime(0.),
+    m_maxPeakRssDelta(0)
+{
+}
+
+} // namespace lar_content
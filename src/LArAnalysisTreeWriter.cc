@@ -0,0 +1,107 @@
+/**
+ *  @file   src/LArAnalysisTreeWriter.cc
+ *
+ *  @brief  Implementation of the analysis tree writer class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/StatusCodes.h"
+
+#include "LArAnalysisTreeWriter.h"
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include <iostream>
+
+using namespace pandora;
+
+namespace lar_content
+{
+
+AnalysisTreeWriter::AnalysisTreeWriter(
+    const std::string &fileName, const std::string &treeName, const int compressionSettings, const int basketSize) :
+    m_pFile{nullptr},
+    m_pTree{nullptr},
+    m_basketSize{basketSize}
+{
+    m_pFile = TFile::Open(fileName.c_str(), "RECREATE");
+
+    if (!m_pFile || !m_pFile->IsOpen())
+    {
+        std::cout << "AnalysisTreeWriter: unable to create output file " << fileName << std::endl;
+        delete m_pFile;
+        throw StatusCodeException(STATUS_CODE_FAILURE);
+    }
+
+    if (compressionSettings >= 0)
+        m_pFile->SetCompressionSettings(compressionSettings);
+
+    // The tree is attached to the file, so full baskets are written out as the events are filled
+    m_pTree = new TTree(treeName.c_str(), treeName.c_str());
+    m_pTree->SetDirectory(m_pFile);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+AnalysisTreeWriter::~AnalysisTreeWriter()
+{
+    m_pFile->cd();
+    m_pTree->Write(nullptr, TObject::kOverwrite);
+
+    // Closing the file also deletes the tree
+    m_pFile->Close();
+    delete m_pFile;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, int &value)
+{
+    m_pTree->Branch(branchName.c_str(), &value, (branchName + "/I").c_str(), m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, float &value)
+{
+    m_pTree->Branch(branchName.c_str(), &value, (branchName + "/F").c_str(), m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, std::string &value)
+{
+    m_pTree->Branch(branchName.c_str(), &value, m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, std::vector<int> &values)
+{
+    m_pTree->Branch(branchName.c_str(), &values, m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, std::vector<long> &values)
+{
+    m_pTree->Branch(branchName.c_str(), &values, m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AnalysisTreeWriter::AddBranch(const std::string &branchName, std::vector<float> &values)
+{
+    m_pTree->Branch(branchName.c_str(), &values, m_basketSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode AnalysisTreeWriter::Fill()
+{
+    return (m_pTree->Fill() < 0) ? STATUS_CODE_FAILURE : STATUS_CODE_SUCCESS;
+}
+
+} // namespace lar_content
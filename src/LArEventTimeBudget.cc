@@ -0,0 +1,131 @@
+/**
+ *  @file   src/LArEventTimeBudget.cc
+ *
+ *  @brief  Implementation of the per-event time budget class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/Pandora.h"
+
+#include "LArEventTimeBudget.h"
+
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+using namespace pandora;
+
+namespace
+{
+
+typedef std::unordered_map<const Pandora *, std::shared_ptr<lar_content::EventTimeBudget>> EventTimeBudgetMap;
+
+// Worker instances may be created and run concurrently, so access to the per-instance budgets is serialised
+std::mutex instanceMapMutex;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the map from pandora instance to time budget, in which worker instances share the entry of their primary instance
+ *
+ *  @return the map from pandora instance to time budget
+ */
+EventTimeBudgetMap &GetEventTimeBudgetMap()
+{
+    static EventTimeBudgetMap instanceMap;
+    return instanceMap;
+}
+
+} // namespace
+
+namespace lar_content
+{
+
+EventTimeBudget &EventTimeBudget::GetInstance(const Pandora &pandora)
+{
+    const std::lock_guard<std::mutex> lock(instanceMapMutex);
+    std::shared_ptr<EventTimeBudget> &pEventTimeBudget(GetEventTimeBudgetMap()[&pandora]);
+
+    if (!pEventTimeBudget)
+        pEventTimeBudget.reset(new EventTimeBudget);
+
+    return *pEventTimeBudget;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void EventTimeBudget::AddWorkerInstance(const Pandora &primaryPandora, const Pandora &workerPandora)
+{
+    const std::lock_guard<std::mutex> lock(instanceMapMutex);
+    EventTimeBudgetMap &instanceMap(GetEventTimeBudgetMap());
+    std::shared_ptr<EventTimeBudget> &pEventTimeBudget(instanceMap[&primaryPandora]);
+
+    if (!pEventTimeBudget)
+        pEventTimeBudget.reset(new EventTimeBudget);
+
+    instanceMap[&workerPandora] = pEventTimeBudget;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void EventTimeBudget::DeleteInstance(const Pandora &primaryPandora)
+{
+    const std::lock_guard<std::mutex> lock(instanceMapMutex);
+    EventTimeBudgetMap &instanceMap(GetEventTimeBudgetMap());
+    const auto primaryIter(instanceMap.find(&primaryPandora));
+
+    if (instanceMap.end() == primaryIter)
+        return;
+
+    // ATTN Copy the pointer, so the budget outlives the erasure of its own map entry while the worker entries are found
+    const std::shared_ptr<EventTimeBudget> pEventTimeBudget(primaryIter->second);
+
+    for (auto iter = instanceMap.begin(); iter != instanceMap.end();)
+        iter = (iter->second == pEventTimeBudget) ? instanceMap.erase(iter) : std::next(iter);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void EventTimeBudget::StartEvent(const double timeBudget)
+{
+    // ATTN Called before the primary instance processes the event, so before any worker thread can read the deadline
+    m_hasDeadline = (timeBudget > 0.);
+    m_timeBudget = timeBudget;
+    m_nSkippedStages = 0;
+
+    if (m_hasDeadline)
+    {
+        const std::chrono::duration<double, std::milli> budgetDuration(timeBudget);
+        m_deadline = std::chrono::steady_clock::now() + std::chrono::duration_cast<std::chrono::steady_clock::duration>(budgetDuration);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool EventTimeBudget::ShouldSkipStage(const std::string &stageName)
+{
+    if (!m_hasDeadline || (std::chrono::steady_clock::now() < m_deadline))
+        return false;
+
+    if (0 == m_nSkippedStages++)
+        std::cout << "EventTimeBudget: event time budget of " << m_timeBudget << " ms exceeded, skipping optional stages" << std::endl;
+
+    std::cout << "EventTimeBudget: skipping " << stageName << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+EventTimeBudget::EventTimeBudget() :
+    m_hasDeadline(false),
+    m_timeBudget(0.),
+    m_deadline(),
+    m_nSkippedStages(0)
+{
+}
+
+} // namespace lar_content
@@ -27,6 +27,7 @@
 #include "MergeClearTracksThreeDAlgorithm.h"
 #include "PfoThreeDHitAssignmentAlgorithm.h"
 #include "PreProcessingThreeDAlgorithm.h"
+#include "ProfilingCheckpointAlgorithm.h"
 #include "ReplaceHitAndClusterListsAlgorithm.h"
 #include "SimpleClusterCreationThreeDAlgorithm.h"
 #include "SlicingThreeDAlgorithm.h"
@@ -44,7 +45,8 @@
     d("LArCutClusterCharacterisationThreeD",    CutClusterCharacterisationThreeDAlgorithm)                                         \
     d("LArCandidateVertexCreationThreeD",       CandidateVertexCreationThreeDAlgorithm)                                            \
     d("LArHierarchyAnalysis",                   HierarchyAnalysisAlgorithm)                                                        \
-    d("LArCheatingRockMuonRemoval",             CheatingRockMuonRemovalAlgorithm)
+    d("LArCheatingRockMuonRemoval",             CheatingRockMuonRemovalAlgorithm)                                                  \
+    d("LArProfilingCheckpoint",                 ProfilingCheckpointAlgorithm)
 
 #define LAR_ND_ALGORITHM_TOOL_LIST(d)                                                                                              \
     d("LArEventSlicingThreeD",                  EventSlicingThreeDTool)                                                            \
@@ -0,0 +1,309 @@
+/**
+ *  @file   src/LArNDGeometryCache.cc
+ *
+ *  @brief  Implementation of the cache of the ND LAr TPC volumes found in the ROOT geometry
+ *
+ *  $Log: $
+ */
+
+#include "TFile.h"
+#include "TGeoBBox.h"
+#include "TGeoManager.h"
+#include "TGeoMatrix.h"
+#include "TGeoNode.h"
+#include "TGeoShape.h"
+#include "TGeoVolume.h"
+#include "TMD5.h"
+
+#include "LArNDGeometryCache.h"
+
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <set>
+
+#include <unistd.h>
+
+namespace lar_nd_reco
+{
+
+LArNDGeometryCache::LArNDGeometryCache(
+    const std::string &geomFileName, const std::string &geomManagerName, const std::string &volumeName) :
+    m_geomFileName(geomFileName),
+    m_geomManagerName(geomManagerName),
+    m_volumeName(volumeName),
+    m_checksum("")
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDGeometryCache::Load(const std::string &cacheFileName)
+{
+    if (!cacheFileName.empty())
+    {
+        // The checksum only needs a sequential read of the geometry file, without building the TGeoManager
+        const std::unique_ptr<TMD5> pMD5(TMD5::FileChecksum(m_geomFileName.c_str()));
+
+        if (pMD5)
+            m_checksum = pMD5->AsString();
+        else
+            std::cout << "LArNDGeometryCache: unable to find the checksum of " << m_geomFileName << ", not using the cache" << std::endl;
+
+        if (!m_checksum.empty() && this->ReadCacheFile(cacheFileName))
+        {
+            std::cout << "Read " << m_tpcBoxes.size() << " TPCs from the geometry cache " << cacheFileName << std::endl;
+            return true;
+        }
+    }
+
+    if (!this->ReadROOTGeometry())
+        return false;
+
+    this->FillAnodePositions();
+
+    if (!cacheFileName.empty() && !m_checksum.empty())
+        this->WriteCacheFile(cacheFileName);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const LArNDTPCBoxList &LArNDGeometryCache::GetTPCBoxes() const
+{
+    return m_tpcBoxes;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const std::vector<float> &LArNDGeometryCache::GetAnodePositions() const
+{
+    return m_anodePositions;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDGeometryCache::ReadCacheFile(const std::string &cacheFileName)
+{
+    std::ifstream cacheFile(cacheFileName);
+
+    if (!cacheFile.is_open())
+        return false;
+
+    // The names are read up to the end of their lines, since they can contain spaces
+    std::string key, checksum, geomManagerName, volumeName;
+    int version(0);
+    cacheFile >> key >> version >> key >> checksum >> key >> std::ws;
+    std::getline(cacheFile, geomManagerName);
+    cacheFile >> key >> std::ws;
+    std::getline(cacheFile, volumeName);
+
+    if (!cacheFile || (m_cacheVersion != version) || (m_checksum != checksum) || (m_geomManagerName != geomManagerName) ||
+        (m_volumeName != volumeName))
+    {
+        std::cout << "LArNDGeometryCache: " << cacheFileName << " does not match the geometry " << m_geomFileName << " (" << m_checksum
+                  << ", " << m_geomManagerName << ", " << m_volumeName << "), it will be rewritten" << std::endl;
+        return false;
+    }
+
+    std::size_t nTPCs(0), nAnodes(0);
+    LArNDTPCBoxList tpcBoxes;
+    std::vector<float> anodePositions;
+    cacheFile >> key >> nTPCs;
+
+    for (std::size_t i = 0; (i < nTPCs) && cacheFile; ++i)
+    {
+        LArNDTPCBox tpcBox;
+        cacheFile >> tpcBox.m_tpcID >> tpcBox.m_centreX >> tpcBox.m_centreY >> tpcBox.m_centreZ >> tpcBox.m_halfWidthX >>
+            tpcBox.m_halfWidthY >> tpcBox.m_halfWidthZ;
+        tpcBoxes.emplace_back(tpcBox);
+    }
+
+    cacheFile >> key >> nAnodes;
+
+    for (std::size_t i = 0; (i < nAnodes) && cacheFile; ++i)
+    {
+        float anodePosition(0.f);
+        cacheFile >> anodePosition;
+        anodePositions.emplace_back(anodePosition);
+    }
+
+    // A cache file cut short, e.g. by a full disk, is missing the end of file marker
+    std::string endMarker;
+    cacheFile >> endMarker;
+
+    if (!cacheFile || ("end" != endMarker))
+    {
+        std::cout << "LArNDGeometryCache: unable to read " << cacheFileName << ", it will be rewritten" << std::endl;
+        return false;
+    }
+
+    m_tpcBoxes = tpcBoxes;
+    m_anodePositions = anodePositions;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDGeometryCache::WriteCacheFile(const std::string &cacheFileName) const
+{
+    // Jobs sharing a cache file may write it at the same time, so each writes its own temporary file and renames it into place
+    const std::string tempFileName(cacheFileName + ".tmp" + std::to_string(getpid()));
+    std::ofstream cacheFile(tempFileName);
+
+    if (!cacheFile.is_open())
+    {
+        std::cout << "LArNDGeometryCache: unable to write the geometry cache " << cacheFileName << std::endl;
+        return;
+    }
+
+    cacheFile << "version " << m_cacheVersion << std::endl
+              << "checksum " << m_checksum << std::endl
+              << "manager " << m_geomManagerName << std::endl
+              << "volume " << m_volumeName << std::endl
+              << "tpcs " << m_tpcBoxes.size() << std::endl
+              << std::setprecision(std::numeric_limits<double>::max_digits10);
+
+    for (const LArNDTPCBox &tpcBox : m_tpcBoxes)
+    {
+        cacheFile << tpcBox.m_tpcID << " " << tpcBox.m_centreX << " " << tpcBox.m_centreY << " " << tpcBox.m_centreZ << " "
+                  << tpcBox.m_halfWidthX << " " << tpcBox.m_halfWidthY << " " << tpcBox.m_halfWidthZ << std::endl;
+    }
+
+    cacheFile << "anodes " << m_anodePositions.size() << std::endl << std::setprecision(std::numeric_limits<float>::max_digits10);
+
+    for (const float anodePosition : m_anodePositions)
+        cacheFile << anodePosition << std::endl;
+
+    cacheFile << "end" << std::endl;
+    cacheFile.close();
+
+    if (!cacheFile.good() || (0 != std::rename(tempFileName.c_str(), cacheFileName.c_str())))
+    {
+        std::cout << "LArNDGeometryCache: unable to write the geometry cache " << cacheFileName << std::endl;
+        std::remove(tempFileName.c_str());
+        return;
+    }
+
+    std::cout << "Wrote " << m_tpcBoxes.size() << " TPCs to the geometry cache " << cacheFileName << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDGeometryCache::ReadROOTGeometry()
+{
+    // Get the geometry info from the appropriate ROOT file
+    TFile *fileSource = TFile::Open(m_geomFileName.c_str(), "READ");
+    if (!fileSource)
+    {
+        std::cout << "Error in CreateGeometry(): can't open file " << m_geomFileName << std::endl;
+        return false;
+    }
+
+    TGeoManager *pSimGeom = dynamic_cast<TGeoManager *>(fileSource->Get(m_geomManagerName.c_str()));
+    if (!pSimGeom)
+    {
+        std::cout << "Could not find the geometry manager named " << m_geomManagerName << std::endl;
+        fileSource->Close();
+        return false;
+    }
+
+    // Go through the geometry and find the paths to the nodes we are interested in
+    std::vector<std::vector<unsigned int>> nodePaths; // Store the daughter indices in the path to the node
+    std::vector<unsigned int> currentPath;
+    this->RecursiveGeometrySearch(pSimGeom, nodePaths, currentPath);
+    std::cout << "Found " << nodePaths.size() << " matches for volumes containing the name " << m_volumeName << std::endl;
+
+    // Navigate to each node and find its box in the world volume
+    for (unsigned int n = 0; n < nodePaths.size(); ++n)
+    {
+        const TGeoNode *pTopNode = pSimGeom->GetCurrentNode();
+        // We have to multiply together matrices at each depth to convert local coordinates to the world volume
+        std::unique_ptr<TGeoHMatrix> pVolMatrix = std::make_unique<TGeoHMatrix>(*pTopNode->GetMatrix());
+        for (unsigned int d = 0; d < nodePaths.at(n).size(); ++d)
+        {
+            pSimGeom->CdDown(nodePaths.at(n).at(d));
+            const TGeoNode *pNode = pSimGeom->GetCurrentNode();
+            std::unique_ptr<TGeoHMatrix> pMatrix = std::make_unique<TGeoHMatrix>(*pNode->GetMatrix());
+            pVolMatrix->Multiply(pMatrix.get());
+        }
+        const TGeoNode *pTargetNode = pSimGeom->GetCurrentNode();
+
+        // Get the BBox dimensions from the placement volume, which is assumed to be a cube
+        TGeoVolume *pCurrentVol = pTargetNode->GetVolume();
+        TGeoShape *pCurrentShape = pCurrentVol->GetShape();
+        TGeoBBox *pBox = dynamic_cast<TGeoBBox *>(pCurrentShape);
+
+        // Translate local origin to global coordinates
+        const double *pOrigin = pBox->GetOrigin();
+        double level1[3] = {0.0, 0.0, 0.0};
+        pTargetNode->LocalToMasterVect(pOrigin, level1);
+
+        const double *pVolTrans = pVolMatrix->GetTranslation();
+        m_tpcBoxes.push_back(LArNDTPCBox{n, level1[0] + pVolTrans[0], level1[1] + pVolTrans[1], level1[2] + pVolTrans[2], pBox->GetDX(),
+            pBox->GetDY(), pBox->GetDZ()});
+
+        for (const unsigned int &daughter : nodePaths.at(n))
+        {
+            (void)daughter;
+            pSimGeom->CdUp();
+        }
+    }
+
+    fileSource->Close();
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDGeometryCache::RecursiveGeometrySearch(
+    TGeoManager *pSimGeom, std::vector<std::vector<unsigned int>> &nodePaths, std::vector<unsigned int> &currentPath) const
+{
+    const std::string nodeName{pSimGeom->GetCurrentNode()->GetName()};
+    if (nodeName.find(m_volumeName) != std::string::npos)
+    {
+        nodePaths.emplace_back(currentPath);
+    }
+    else
+    {
+        for (unsigned int i = 0; i < pSimGeom->GetCurrentNode()->GetNdaughters(); ++i)
+        {
+            pSimGeom->CdDown(i);
+            currentPath.emplace_back(i);
+            this->RecursiveGeometrySearch(pSimGeom, nodePaths, currentPath);
+            pSimGeom->CdUp();
+            currentPath.pop_back();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDGeometryCache::FillAnodePositions()
+{
+    std::set<float> uniqueBoundariesX;
+
+    for (const LArNDTPCBox &tpcBox : m_tpcBoxes)
+    {
+        uniqueBoundariesX.insert(tpcBox.m_centreX - tpcBox.m_halfWidthX);
+        uniqueBoundariesX.insert(tpcBox.m_centreX + tpcBox.m_halfWidthX);
+    }
+
+    // Outer x boundaries are always anodes -- start there and step inward by the appropriate amount to enumerate the anodes
+    // Structure is Anode - Cathode - Cathode - Anode
+    const std::vector<float> boundariesX(uniqueBoundariesX.begin(), uniqueBoundariesX.end());
+
+    for (std::size_t i = 0; i + 3 < boundariesX.size(); i += 4)
+    {
+        m_anodePositions.push_back(boundariesX.at(i));
+        m_anodePositions.push_back(boundariesX.at(i + 3));
+    }
+}
+
+} // namespace lar_nd_reco
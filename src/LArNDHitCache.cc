@@ -0,0 +1,402 @@
+/**
+ *  @file   src/LArNDHitCache.cc
+ *
+ *  @brief  Implementation of the memory-mapped cache of the pre-decoded input event hits
+ *
+ *  $Log: $
+ */
+
+#include "LArNDHitCache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <numeric>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace lar_nd_reco
+{
+
+void LArNDHitCacheHeader::SetLayout(const std::uint64_t nEvents, const std::uint64_t nHits, const bool hasMCTruth,
+    const std::uint64_t nSourceFiles, const std::uint64_t sourceFileNamesSize)
+{
+    std::memcpy(m_magic, m_cacheMagic, sizeof(m_magic));
+    m_version = m_cacheVersion;
+    m_hasMCTruth = hasMCTruth ? 1 : 0;
+    m_nEvents = nEvents;
+    m_nHits = nHits;
+    m_nSourceFiles = nSourceFiles;
+    m_sourceFileNamesSize = sourceFileNamesSize;
+
+    // Each section starts on the first aligned offset after the end of the previous one
+    std::uint64_t offset(sizeof(LArNDHitCacheHeader));
+
+    for (int iSection = 0; iSection < NSections; ++iSection)
+    {
+        const Section section(static_cast<Section>(iSection));
+        offset = ((offset + m_alignment - 1) / m_alignment) * m_alignment;
+        m_sectionOffsets[iSection] = offset;
+        offset += this->GetNElements(section) * GetElementSize(section);
+    }
+
+    m_fileSize = offset;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::uint64_t LArNDHitCacheHeader::GetElementSize(const Section section)
+{
+    switch (section)
+    {
+        case HitOffsets:
+        case SourceFileEntries:
+            return sizeof(std::uint64_t);
+        case SourceFileNames:
+            return sizeof(char);
+        case EventNumbers:
+            return sizeof(std::int32_t);
+        case TrackID:
+            return sizeof(std::int64_t);
+        case HasMCContribution:
+            return sizeof(std::uint8_t);
+        default:
+            return sizeof(float);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::uint64_t LArNDHitCacheHeader::GetNElements(const Section section) const
+{
+    switch (section)
+    {
+        case HitOffsets:
+            return m_nEvents + 1;
+        case EventNumbers:
+            return m_nEvents;
+        case SourceFileEntries:
+            return m_nSourceFiles;
+        case SourceFileNames:
+            return m_sourceFileNamesSize;
+        default:
+            return m_nHits;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDCachedHits::Clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_charge.clear();
+    m_trackID.clear();
+    m_energyFrac.clear();
+    m_hasMCContribution.clear();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArNDHitCacheWriter::LArNDHitCacheWriter(const std::string &fileName, const std::vector<std::uint64_t> &nEventHits, const bool hasMCTruth,
+    const std::vector<std::string> &sourceFileNames, const std::vector<std::uint64_t> &nSourceFileEntries) :
+    m_fileName(fileName),
+    m_file(),
+    m_header(),
+    m_nEventHits(nEventHits),
+    m_nWrittenEvents(0),
+    m_nWrittenElements()
+{
+    if ((sourceFileNames.size() != nSourceFileEntries.size()) ||
+        (std::accumulate(nSourceFileEntries.begin(), nSourceFileEntries.end(), std::uint64_t(0)) != nEventHits.size()))
+    {
+        std::cout << "LArNDHitCacheWriter: the events of the source files don't match the " << nEventHits.size() << " events to write"
+                  << std::endl;
+        return;
+    }
+
+    std::string sourceFileNameBuffer;
+
+    for (const std::string &sourceFileName : sourceFileNames)
+        sourceFileNameBuffer.append(sourceFileName).push_back('\0');
+
+    m_header.SetLayout(nEventHits.size(), std::accumulate(nEventHits.begin(), nEventHits.end(), std::uint64_t(0)), hasMCTruth,
+        sourceFileNames.size(), sourceFileNameBuffer.size());
+
+    m_file.open(fileName, std::ios::binary | std::ios::trunc);
+
+    if (!m_file.is_open())
+    {
+        std::cout << "LArNDHitCacheWriter: unable to create the hit cache " << fileName << std::endl;
+        return;
+    }
+
+    // The padding between sections, and the header until the file is complete, are left as zeros by extending the file first
+    m_file.seekp(m_header.m_fileSize - 1);
+    m_file.put('\0');
+
+    this->WriteElements(LArNDHitCacheHeader::SourceFileEntries, nSourceFileEntries.data(), nSourceFileEntries.size());
+    this->WriteElements(LArNDHitCacheHeader::SourceFileNames, sourceFileNameBuffer.data(), sourceFileNameBuffer.size());
+
+    // The event table is complete from the start, since it only needs the number of hits in each event
+    std::vector<std::uint64_t> hitOffsets(1, 0);
+    hitOffsets.reserve(nEventHits.size() + 1);
+
+    for (const std::uint64_t nHits : nEventHits)
+        hitOffsets.emplace_back(hitOffsets.back() + nHits);
+
+    this->WriteElements(LArNDHitCacheHeader::HitOffsets, hitOffsets.data(), hitOffsets.size());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDHitCacheWriter::IsOpen() const
+{
+    return m_file.is_open() && m_file.good();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDHitCacheWriter::WriteEvent(const int eventNumber, const LArNDCachedHits &hits)
+{
+    if (!this->IsOpen() || (m_nWrittenEvents >= m_nEventHits.size()))
+        return false;
+
+    const std::uint64_t nHits(hits.m_x.size());
+
+    if ((m_nEventHits[m_nWrittenEvents] != nHits) || (hits.m_y.size() != nHits) || (hits.m_z.size() != nHits) ||
+        (hits.m_charge.size() != nHits) || (hits.m_trackID.size() != nHits) || (hits.m_energyFrac.size() != nHits) ||
+        (hits.m_hasMCContribution.size() != nHits))
+    {
+        std::cout << "LArNDHitCacheWriter: event " << m_nWrittenEvents << " has " << nHits << " hits, but "
+                  << m_nEventHits[m_nWrittenEvents] << " were expected" << std::endl;
+        return false;
+    }
+
+    const std::int32_t eventNumber32(eventNumber);
+    this->WriteElements(LArNDHitCacheHeader::EventNumbers, &eventNumber32, 1);
+    this->WriteElements(LArNDHitCacheHeader::X, hits.m_x.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::Y, hits.m_y.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::Z, hits.m_z.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::Charge, hits.m_charge.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::TrackID, hits.m_trackID.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::EnergyFrac, hits.m_energyFrac.data(), nHits);
+    this->WriteElements(LArNDHitCacheHeader::HasMCContribution, hits.m_hasMCContribution.data(), nHits);
+    ++m_nWrittenEvents;
+
+    return this->IsOpen();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDHitCacheWriter::Close()
+{
+    if (!m_file.is_open())
+        return false;
+
+    const bool isComplete(m_nWrittenEvents == m_nEventHits.size());
+
+    if (isComplete)
+    {
+        m_file.seekp(0);
+        m_file.write(reinterpret_cast<const char *>(&m_header), sizeof(LArNDHitCacheHeader));
+    }
+
+    m_file.close();
+
+    if (!isComplete || m_file.fail())
+    {
+        std::cout << "LArNDHitCacheWriter: unable to write all " << m_nEventHits.size() << " events to the hit cache " << m_fileName
+                  << ", removing it" << std::endl;
+        std::remove(m_fileName.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDHitCacheWriter::WriteElements(
+    const LArNDHitCacheHeader::Section section, const void *const pElements, const std::uint64_t nElements)
+{
+    if (0 == nElements)
+        return;
+
+    const std::uint64_t elementSize(LArNDHitCacheHeader::GetElementSize(section));
+    m_file.seekp(m_header.m_sectionOffsets[section] + m_nWrittenElements[section] * elementSize);
+    m_file.write(static_cast<const char *>(pElements), nElements * elementSize);
+    m_nWrittenElements[section] += nElements;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArNDHitCache::LArNDHitCache() :
+    m_pData(nullptr),
+    m_dataSize(0),
+    m_header(),
+    m_sourceFileNames(),
+    m_nSourceFileEntries()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArNDHitCache::~LArNDHitCache()
+{
+    this->Close();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDHitCache::Open(const std::string &fileName)
+{
+    this->Close();
+
+    const int fileDescriptor(open(fileName.c_str(), O_RDONLY));
+    struct stat fileStatus;
+
+    if ((fileDescriptor < 0) || (0 != fstat(fileDescriptor, &fileStatus)) ||
+        (static_cast<std::size_t>(fileStatus.st_size) < sizeof(LArNDHitCacheHeader)))
+    {
+        std::cout << "LArNDHitCache: unable to open the hit cache " << fileName << std::endl;
+
+        if (fileDescriptor >= 0)
+            close(fileDescriptor);
+
+        return false;
+    }
+
+    // The mapping keeps the file open, so its descriptor is no longer needed
+    void *const pMapped(mmap(nullptr, fileStatus.st_size, PROT_READ, MAP_SHARED, fileDescriptor, 0));
+    close(fileDescriptor);
+
+    if (MAP_FAILED == pMapped)
+    {
+        std::cout << "LArNDHitCache: unable to map the hit cache " << fileName << std::endl;
+        return false;
+    }
+
+    m_pData = static_cast<const unsigned char *>(pMapped);
+    m_dataSize = fileStatus.st_size;
+    std::memcpy(&m_header, m_pData, sizeof(LArNDHitCacheHeader));
+
+    // The events are read in order, so the kernel can read ahead of them
+    madvise(pMapped, m_dataSize, MADV_SEQUENTIAL);
+
+    // The layout is recomputed from the numbers of events, hits and source files, so any mismatch with the stored offsets or size is
+    // detected before any section is read
+    LArNDHitCacheHeader expectedHeader;
+    expectedHeader.SetLayout(
+        m_header.m_nEvents, m_header.m_nHits, m_header.m_hasMCTruth, m_header.m_nSourceFiles, m_header.m_sourceFileNamesSize);
+
+    const std::uint64_t *const pHitOffsets(this->GetSection<std::uint64_t>(LArNDHitCacheHeader::HitOffsets));
+    const std::uint64_t *const pSourceFileEntries(this->GetSection<std::uint64_t>(LArNDHitCacheHeader::SourceFileEntries));
+    const char *const pSourceFileNames(this->GetSection<char>(LArNDHitCacheHeader::SourceFileNames));
+    const char *const pSourceFileNamesEnd(pSourceFileNames + m_header.m_sourceFileNamesSize);
+
+    const bool isValid((0 == std::memcmp(&expectedHeader, &m_header, sizeof(LArNDHitCacheHeader))) && (m_header.m_fileSize == m_dataSize) &&
+        std::is_sorted(pHitOffsets, pHitOffsets + m_header.m_nEvents + 1) && (0 == pHitOffsets[0]) &&
+        (m_header.m_nHits == pHitOffsets[m_header.m_nEvents]) &&
+        (m_header.m_nEvents == std::accumulate(pSourceFileEntries, pSourceFileEntries + m_header.m_nSourceFiles, std::uint64_t(0))) &&
+        (m_header.m_nSourceFiles == static_cast<std::uint64_t>(std::count(pSourceFileNames, pSourceFileNamesEnd, '\0'))) &&
+        ((0 == m_header.m_sourceFileNamesSize) || ('\0' == *(pSourceFileNamesEnd - 1))));
+
+    if (!isValid)
+    {
+        std::cout << "LArNDHitCache: " << fileName << " is not a version " << LArNDHitCacheHeader::m_cacheVersion
+                  << " hit cache, or is incomplete" << std::endl;
+        this->Close();
+        return false;
+    }
+
+    m_nSourceFileEntries.assign(pSourceFileEntries, pSourceFileEntries + m_header.m_nSourceFiles);
+
+    // Each name is terminated by a null character, which the checks above guarantee for the last one
+    for (const char *pSourceFileName = pSourceFileNames; pSourceFileName != pSourceFileNamesEnd;
+         pSourceFileName += std::strlen(pSourceFileName) + 1)
+        m_sourceFileNames.emplace_back(pSourceFileName);
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::size_t LArNDHitCache::GetNEvents() const
+{
+    return m_pData ? m_header.m_nEvents : 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool LArNDHitCache::HasMCTruth() const
+{
+    return m_pData && (0 != m_header.m_hasMCTruth);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArNDHitCacheEvent LArNDHitCache::GetEvent(const std::size_t iEvent) const
+{
+    const std::uint64_t *const pHitOffsets(this->GetSection<std::uint64_t>(LArNDHitCacheHeader::HitOffsets));
+    const std::uint64_t firstHit(pHitOffsets[iEvent]);
+
+    LArNDHitCacheEvent event;
+    event.m_nHits = pHitOffsets[iEvent + 1] - firstHit;
+    event.m_eventNumber = this->GetSection<std::int32_t>(LArNDHitCacheHeader::EventNumbers)[iEvent];
+    event.m_x = this->GetSection<float>(LArNDHitCacheHeader::X) + firstHit;
+    event.m_y = this->GetSection<float>(LArNDHitCacheHeader::Y) + firstHit;
+    event.m_z = this->GetSection<float>(LArNDHitCacheHeader::Z) + firstHit;
+    event.m_charge = this->GetSection<float>(LArNDHitCacheHeader::Charge) + firstHit;
+    event.m_trackID = this->GetSection<std::int64_t>(LArNDHitCacheHeader::TrackID) + firstHit;
+    event.m_energyFrac = this->GetSection<float>(LArNDHitCacheHeader::EnergyFrac) + firstHit;
+    event.m_hasMCContribution = this->GetSection<std::uint8_t>(LArNDHitCacheHeader::HasMCContribution) + firstHit;
+
+    return event;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const std::vector<std::string> &LArNDHitCache::GetSourceFileNames() const
+{
+    return m_sourceFileNames;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const std::vector<std::uint64_t> &LArNDHitCache::GetNSourceFileEntries() const
+{
+    return m_nSourceFileEntries;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+template <typename T>
+const T *LArNDHitCache::GetSection(const LArNDHitCacheHeader::Section section) const
+{
+    // Each section is aligned well beyond the alignment of its elements, so it can be used in place
+    return reinterpret_cast<const T *>(m_pData + m_header.m_sectionOffsets[section]);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void LArNDHitCache::Close()
+{
+    if (m_pData)
+        munmap(const_cast<unsigned char *>(m_pData), m_dataSize);
+
+    m_pData = nullptr;
+    m_dataSize = 0;
+    m_sourceFileNames.clear();
+    m_nSourceFileEntries.clear();
+}
+
+} // namespace lar_nd_reco
@@ -0,0 +1,142 @@
+/**
+ *  @file   src/LArNDInputFiles.cc
+ *
+ *  @brief  Implementation of the functions finding the input event files and chaining their event trees
+ *
+ *  $Log: $
+ */
+
+#include "TChain.h"
+#include "TChainElement.h"
+#include "TObjArray.h"
+
+#include "LArNDInputFiles.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include <glob.h>
+
+namespace lar_nd_reco
+{
+
+bool ExpandInputFileNames(const std::string &inputFilesOption, std::vector<std::string> &inputFileNames)
+{
+    inputFileNames.clear();
+
+    std::vector<std::string> inputPatterns;
+    std::stringstream optionStream(inputFilesOption);
+    std::string item;
+
+    while (std::getline(optionStream, item, ','))
+    {
+        if (item.empty())
+            continue;
+
+        const size_t extensionPosition(item.find_last_of('.'));
+        const std::string extension((std::string::npos == extensionPosition) ? "" : item.substr(extensionPosition));
+
+        if ((".txt" != extension) && (".list" != extension))
+        {
+            inputPatterns.emplace_back(item);
+            continue;
+        }
+
+        std::ifstream listFile(item);
+        if (!listFile)
+        {
+            std::cout << "Could not open the input file list " << item << std::endl;
+            return false;
+        }
+
+        std::string line;
+        while (std::getline(listFile, line))
+        {
+            // Skip blank lines and comments, and trim any surrounding whitespace
+            const size_t first(line.find_first_not_of(" \t\r"));
+            if ((std::string::npos == first) || ('#' == line[first]))
+                continue;
+
+            inputPatterns.emplace_back(line.substr(first, line.find_last_not_of(" \t\r") + 1 - first));
+        }
+    }
+
+    for (const std::string &inputPattern : inputPatterns)
+    {
+        glob_t globResult;
+        const int globStatus(glob(inputPattern.c_str(), 0, nullptr, &globResult));
+
+        if (0 == globStatus)
+        {
+            // Matches are sorted, so the files of a glob are read in a reproducible order
+            for (size_t iPath = 0; iPath < globResult.gl_pathc; ++iPath)
+                inputFileNames.emplace_back(globResult.gl_pathv[iPath]);
+        }
+        else if (std::string::npos == inputPattern.find_first_of("*?["))
+        {
+            // Not a glob, and perhaps a remote file that can't be matched locally, so leave it for ROOT to open
+            inputFileNames.emplace_back(inputPattern);
+        }
+        else
+        {
+            std::cout << "No input files match " << inputPattern << std::endl;
+        }
+
+        globfree(&globResult);
+    }
+
+    if (inputFileNames.empty())
+    {
+        std::cout << "No input event files given by " << inputFilesOption << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TChain> MakeInputChain(
+    const std::string &inputTreeName, const std::vector<std::string> &inputFileNames, const long long cacheSize)
+{
+    std::unique_ptr<TChain> pInputChain(std::make_unique<TChain>(inputTreeName.c_str()));
+
+    // A zero entry count makes the chain open each file and check for the event tree, so unusable files are reported up front
+    for (const std::string &inputFileName : inputFileNames)
+    {
+        if (!pInputChain->Add(inputFileName.c_str(), 0))
+            std::cout << "Error in MakeInputChain(): can't add file " << inputFileName << std::endl;
+    }
+
+    if (pInputChain->GetEntries() <= 0)
+    {
+        std::cout << "Could not find the event tree " << inputTreeName << " in the input files" << std::endl;
+        return nullptr;
+    }
+
+    // The chain keeps its read cache when it moves on to the next file, so the cache is only allocated once
+    pInputChain->SetCacheSize(cacheSize);
+
+    return pInputChain;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void GetInputFileEntries(const TChain &inputChain, std::vector<std::string> &fileNames, std::vector<std::uint64_t> &nFileEntries)
+{
+    fileNames.clear();
+    nFileEntries.clear();
+
+    // Each file was opened when it was added to the chain, so its number of entries is already known
+    const TObjArray *const pChainElements(inputChain.GetListOfFiles());
+
+    for (int iElement = 0; iElement < pChainElements->GetEntries(); ++iElement)
+    {
+        const TChainElement *const pChainElement(static_cast<const TChainElement *>(pChainElements->At(iElement)));
+        fileNames.emplace_back(pChainElement->GetTitle());
+        nFileEntries.emplace_back(pChainElement->GetEntries());
+    }
+}
+
+} // namespace lar_nd_reco
@@ -0,0 +1,130 @@
+/**
+ *  @file   src/LArNDParticleId.cc
+ *
+ *  @brief  Implementation of the dE/dx template particle identification, shared by PandoraOuterface and the micro-benchmarks
+ *
+ *  $Log: $
+ */
+
+#include "TProfile.h"
+
+#include "PandoraOuterface.h"
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+namespace lar_nd_postreco
+{
+
+bool Chi2PID(const ParameterStruct &parameters, const std::vector<float> &trackVecDX, const std::vector<float> &trackVecDEDX,
+    const std::vector<float> &trackVecRR, int &pdg, int &ndf, float &muScore, float &piScore, float &kScore, float &proScore)
+{
+    // as in https://github.com/LArSoft/larana/blob/develop/larana/ParticleIdentification/Chi2PIDAlg.cxx#L90
+    const TProfile *const pProtonTemplate(parameters.templatesdEdxRR.at("proton"));
+    const TProfile *const pKaonTemplate(parameters.templatesdEdxRR.at("kaon"));
+    const TProfile *const pPionTemplate(parameters.templatesdEdxRR.at("pion"));
+    const TProfile *const pMuonTemplate(parameters.templatesdEdxRR.at("muon"));
+
+    float chi2pro = 0.;
+    float chi2ka = 0.;
+    float chi2pi = 0.;
+    float chi2mu = 0.;
+    int nbins_dedx_range = pProtonTemplate->GetNbinsX();
+    int npts = 0;
+    for (unsigned int idxCaloPt = 0; idxCaloPt < trackVecDEDX.size(); ++idxCaloPt)
+    {
+        if (idxCaloPt == 0 || idxCaloPt == trackVecDEDX.size() - 1)
+            continue; // ignore 1st and last point
+        if (trackVecDEDX[idxCaloPt] > 1000.)
+            continue; // ignore if too high dEdx
+        if (trackVecDEDX[idxCaloPt] < parameters.fChi2RestrictDEDXLo)
+            continue; // also, optionally restrict unexpected low dE/dx. By default just requires it to be positive.
+        if (parameters.fChi2RestrictDX &&
+            (trackVecDX[idxCaloPt] < parameters.fChi2RestrictDXLo ||
+                (parameters.fChi2RestrictDXHi > 0. && trackVecDX[idxCaloPt] > parameters.fChi2RestrictDXHi)))
+        {
+            continue; // optionally skip this point if dx too small/large
+        }
+        int bin = pProtonTemplate->FindBin(trackVecRR[idxCaloPt]);
+        if (bin >= 1 && bin <= nbins_dedx_range)
+        {
+            // Content
+            float bincpro = pProtonTemplate->GetBinContent(bin);
+            if (bincpro < 1e-6)
+                bincpro = (pProtonTemplate->GetBinContent(bin - 1) + pProtonTemplate->GetBinContent(bin + 1)) / 2.;
+            float bincka = pKaonTemplate->GetBinContent(bin);
+            if (bincka < 1e-6)
+                bincka = (pKaonTemplate->GetBinContent(bin - 1) + pKaonTemplate->GetBinContent(bin + 1)) / 2.;
+            float bincpi = pPionTemplate->GetBinContent(bin);
+            if (bincpi < 1e-6)
+                bincpi = (pPionTemplate->GetBinContent(bin - 1) + pPionTemplate->GetBinContent(bin + 1)) / 2.;
+            float bincmu = pMuonTemplate->GetBinContent(bin);
+            if (bincmu < 1e-6)
+                bincmu = (pMuonTemplate->GetBinContent(bin - 1) + pMuonTemplate->GetBinContent(bin + 1)) / 2.;
+            // Error
+            float binepro = pProtonTemplate->GetBinError(bin);
+            if (binepro < 1e-6)
+                binepro = (pProtonTemplate->GetBinError(bin - 1) + pProtonTemplate->GetBinError(bin + 1)) / 2.;
+            float bineka = pKaonTemplate->GetBinError(bin);
+            if (bineka < 1e-6)
+                bineka = (pKaonTemplate->GetBinError(bin - 1) + pKaonTemplate->GetBinError(bin + 1)) / 2.;
+            float binepi = pPionTemplate->GetBinError(bin);
+            if (binepi < 1e-6)
+                binepi = (pPionTemplate->GetBinError(bin - 1) + pPionTemplate->GetBinError(bin + 1)) / 2.;
+            float binemu = pMuonTemplate->GetBinError(bin);
+            if (binemu < 1e-6)
+                binemu = (pMuonTemplate->GetBinError(bin - 1) + pMuonTemplate->GetBinError(bin + 1)) / 2.;
+            float errdedx = 0.04231 + 0.0001783 * trackVecDEDX[idxCaloPt] * trackVecDEDX[idxCaloPt];
+            errdedx *= trackVecDEDX[idxCaloPt];
+            float errdedx_square = errdedx * errdedx;
+            // chi2 values
+            float thisPointDEDX = trackVecDEDX[idxCaloPt];
+            if (!parameters.fApplyCalibrationFudgeFactor && parameters.fApplyCalibrationFudgeFactor_PID)
+                thisPointDEDX *= parameters.fCalibrationFudgeFactor;
+            chi2pro += std::pow(thisPointDEDX - bincpro, 2) / (binepro * binepro + errdedx_square);
+            chi2ka += std::pow(thisPointDEDX - bincka, 2) / (bineka * bineka + errdedx_square);
+            chi2pi += std::pow(thisPointDEDX - bincpi, 2) / (binepi * binepi + errdedx_square);
+            chi2mu += std::pow(thisPointDEDX - bincmu, 2) / (binemu * binemu + errdedx_square);
+            npts += 1;
+        } // within bins
+    } // loop calo points
+
+    if (npts == 0)
+        return false;
+
+    int thisPDG = 0;
+    float thisChi2 = std::numeric_limits<float>::max();
+    if (chi2pro / npts < thisChi2)
+    {
+        thisPDG = 2212;
+        thisChi2 = chi2pro / npts;
+    }
+    if (chi2ka / npts < thisChi2)
+    {
+        thisPDG = 321;
+        thisChi2 = chi2ka / npts;
+    }
+    if (chi2pi / npts < thisChi2)
+    {
+        thisPDG = 211;
+        thisChi2 = chi2pi / npts;
+    }
+    if (chi2mu / npts < thisChi2)
+    {
+        thisPDG = 13;
+        thisChi2 = chi2mu / npts;
+    }
+
+    // prediction is minimum chi2/npts
+    pdg = thisPDG;
+    ndf = npts;
+    muScore = chi2mu / npts;
+    piScore = chi2pi / npts;
+    kScore = chi2ka / npts;
+    proScore = chi2pro / npts;
+
+    return true;
+}
+
+} // namespace lar_nd_postreco
@@ -0,0 +1,494 @@
+/**
+ *  @file   src/LArNDVoxelisation.cc
+ *
+ *  @brief  Implementation of the voxelisation and calo hit creation functions, shared by PandoraInterface and the micro-benchmarks
+ *
+ *  $Log: $
+ */
+
+#include "Api/PandoraApi.h"
+#include "Geometry/LArTPC.h"
+#include "Managers/GeometryManager.h"
+#include "Managers/PluginManager.h"
+#include "Plugins/LArTransformationPlugin.h"
+
+#include "larpandoracontent/LArObjects/LArCaloHit.h"
+
+#include "LArBox.h"
+#include "LArRay.h"
+#include "PandoraInterface.h"
+
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <vector>
+
+using namespace pandora;
+
+namespace lar_nd_reco
+{
+
+LArGrid MakeVoxelisationGrid(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters)
+{
+    // Detector volume for voxelising the hits
+    const GeometryManager *geom = pPrimaryPandora->GetGeometry();
+    const LArTPC &tpc = geom->GetLArTPC();
+
+    const float botX = tpc.GetCenterX() - 0.5 * tpc.GetWidthX();
+    const float botY = tpc.GetCenterY() - 0.5 * tpc.GetWidthY();
+    const float botZ = tpc.GetCenterZ() - 0.5 * tpc.GetWidthZ();
+    const float topX = botX + tpc.GetWidthX();
+    const float topY = botY + tpc.GetWidthY();
+    const float topZ = botZ + tpc.GetWidthZ();
+    const float voxelWidth(parameters.m_voxelWidth);
+
+    return LArGrid(pandora::CartesianVector(botX, botY, botZ), pandora::CartesianVector(topX, topY, topZ),
+        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArGrid MakeVoxelisationGrid(const LArNDGeomSimple &geom, const Parameters &parameters)
+{
+    double minX{0.f};
+    double maxX{0.f};
+    double minY{0.f};
+    double maxY{0.f};
+    double minZ{0.f};
+    double maxZ{0.f};
+    const float voxelWidth(parameters.m_voxelWidth);
+    geom.GetSurroundingBox(minX, maxX, minY, maxY, minZ, maxZ);
+
+    return LArGrid(pandora::CartesianVector(minX, minY, minZ), pandora::CartesianVector(maxX, maxY, maxZ),
+        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom,
+    LArVoxelAccumulator &voxelAccumulator)
+{
+    // Code based on
+    // https://github.com/chenel/larcv2/tree/edepsim-formattruth/larcv/app/Supera/Voxelize.cxx
+    // which is made available under the MIT license (which is fully compatible with Pandora's GPLv3 license)
+
+    // Start and end positions
+    const pandora::CartesianVector start(hitInfo.m_start);
+    const pandora::CartesianVector stop(hitInfo.m_stop);
+
+    // Direction vector and hit segment length
+    const pandora::CartesianVector dir = stop - start;
+    const float hitLength(dir.GetMagnitude());
+
+    // Check hit length is greater than epsilon limit
+    if (hitLength < std::numeric_limits<float>::epsilon())
+        return;
+
+    // Hit segment total energy in GeV (Geant4 uses MeV)
+    const float g4HitEnergy(hitInfo.m_energy);
+
+    // Check hit energy is greater than epsilon limit
+    if (g4HitEnergy < std::numeric_limits<float>::epsilon())
+        return;
+
+    // Get the trackID of the (main) contributing particle.
+    // ATTN: this can very rarely be more than one track
+    const int trackID = hitInfo.m_trackID;
+
+    // Define ray trajectory, which checks dirMag (hitLength) >= epsilon limit
+    const pandora::CartesianVector dirNorm = dir.GetUnitVector();
+    LArRay ray(start, dirNorm);
+
+    // We need to shuffle along the hit segment path and create voxels as we go.
+    // There are 4 cases for the start and end points inside the voxelisation region.
+    // Case 1: start & stop are both inside the voxelisation boundary
+    // Case 2: start & stop are both outside, but path direction intersects boundary
+    // Case 3: start is inside boundary, stop = intersection at region boundary
+    // Case 4: end is inside boundary, start = intersection at region boundary
+
+    double t0(0.0), t1(0.0);
+    pandora::CartesianVector point1(0.f, 0.f, 0.f), point2(0.f, 0.f, 0.f);
+
+    // Check if the start and end points are inside the voxelisation region
+    const bool inStart = grid.Inside(start);
+    const bool inStop = grid.Inside(stop);
+
+    if (inStart && inStop)
+    {
+        // Case 1: Start and end points are inside boundary
+        point1 = start;
+        point2 = stop;
+    }
+    else if (!inStart && !inStop)
+    {
+        // Case 2: Start and end points are outside boundary
+        if (grid.Intersect(ray, t0, t1))
+        {
+            point1 = ray.GetPoint(t0);
+            point2 = ray.GetPoint(t1);
+        }
+        else
+            return;
+    }
+    else if (inStart && !inStop)
+    {
+        // Case 3: Start inside boundary
+        point1 = start;
+        if (grid.Intersect(ray, t0, t1))
+            point2 = ray.GetPoint(t1);
+        else
+            return;
+    }
+    else if (!inStart && inStop)
+    {
+        // Case 4: End inside boundary
+        point2 = stop;
+        if (grid.Intersect(ray, t0, t1))
+            point1 = ray.GetPoint(t0);
+        else
+            return;
+    }
+
+    // Now create voxels between point1 and point2.
+    // Ray direction will be the same, but update starting point
+    ray.UpdateOrigin(point1);
+
+    bool shuffle(true);
+
+    // Keep track of total voxel path length so far
+    float totalPath(0.0);
+    int loop(0);
+
+    while (shuffle)
+    {
+        // Get point along path to define voxel bin (bottom corner)
+        const pandora::CartesianVector voxelPoint = ray.GetPoint(parameters.m_voxelPathShift);
+
+        // Grid 3d bin containing this point; 4th element is the total bin number
+        const LongBin4Array gridBins = grid.GetBinIndices(voxelPoint);
+        const long voxelID = gridBins[3];
+        const long xBin = gridBins[0];
+        const long yBin = gridBins[1];
+        const long zBin = gridBins[2];
+
+        // Voxel bottom and top corners
+        const pandora::CartesianVector voxBot = grid.GetPoint(xBin, yBin, zBin);
+        const pandora::CartesianVector voxTop = grid.GetPoint(xBin + 1, yBin + 1, zBin + 1);
+
+        // Voxel box
+        const LArBox vBox(voxBot, voxTop);
+
+        // Get ray intersections with this box: t0 and t1 are set as the start
+        // and end intersection pathlengths relative to the current ray point.
+        // If we can't find t0 and t1, then stop shuffling along the path
+        if (!vBox.Intersect(ray, t0, t1))
+            shuffle = false;
+
+        // Voxel extent = intersection path difference
+        double dL(t1 - t0);
+        // For the first path length, use the distance from the
+        // starting ray point to the 2nd intersection t1
+        if (loop == 0)
+            dL = t1;
+
+        // Stop processing if we are not moving along the path
+        if (dL < parameters.m_voxelPathShift)
+            shuffle = false;
+
+        totalPath += dL;
+
+        // Stop adding voxels if we have enough
+        if (totalPath > hitLength)
+        {
+            shuffle = false;
+            // Adjust final path according to hit segment total length
+            dL = hitLength - totalPath + dL;
+        }
+
+        // Voxel energy (GeV) using path length fraction w.r.t hit length.
+        // Here, hitLength is guaranteed to be greater than zero
+        const float voxelEnergy(g4HitEnergy * dL / hitLength);
+
+        if (parameters.m_useModularGeometry)
+        {
+            // If using modular geometry we need to assign the tpc number
+            const int tpcID(geom.GetTPCNumber(voxelPoint));
+            if (tpcID != -1)
+            {
+                voxelAccumulator.AddVoxel(voxelID, voxelEnergy, trackID, tpcID);
+            }
+            else
+                std::cout << "Hit not in TPC: " << voxelPoint << std::endl;
+        }
+        else
+        {
+            voxelAccumulator.AddVoxel(voxelID, voxelEnergy, trackID, 0);
+        }
+
+        // Update ray starting position using intersection path difference
+        const pandora::CartesianVector newStart = ray.GetPoint(dL);
+        ray.UpdateOrigin(newStart);
+        loop++;
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArGrid VoxeliseHits(const LArHitInfoList &hitInfos, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom,
+    LArVoxelAccumulator &voxelAccumulator)
+{
+    voxelAccumulator.Clear();
+
+    for (const LArHitInfo &hitInfo : hitInfos)
+        MakeVoxels(hitInfo, grid, parameters, geom, voxelAccumulator);
+
+    // Revoxelise oversized events from their hit segments, so that the energy and the main true particle of each coarse voxel are
+    // found exactly as for the nominal grid
+    int coarsening(1);
+
+    while ((parameters.m_maxMergedVoxels > 0) && (voxelAccumulator.GetMergedVoxels().GetNVoxels() > parameters.m_maxMergedVoxels) &&
+        (2 * coarsening <= parameters.m_maxVoxelCoarsening))
+    {
+        coarsening *= 2;
+        std::cout << "Revoxelising " << voxelAccumulator.GetMergedVoxels().GetNVoxels() << " merged voxels with width "
+                  << coarsening * grid.m_binWidths.GetX() << " cm" << std::endl;
+
+        const LArGrid coarseGrid(grid.GetCoarseGrid(coarsening));
+        voxelAccumulator.Clear();
+
+        for (const LArHitInfo &hitInfo : hitInfos)
+            MakeVoxels(hitInfo, coarseGrid, parameters, geom, voxelAccumulator);
+    }
+
+    return (1 == coarsening) ? grid : grid.GetCoarseGrid(coarsening);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArVoxelArray MergeSameVoxels(const LArVoxelArray &voxels)
+{
+    std::cout << "Merging voxels with the same IDs" << std::endl;
+    LArVoxelAccumulator voxelAccumulator;
+
+    for (std::size_t v = 0; v < voxels.GetNVoxels(); ++v)
+        voxelAccumulator.AddVoxel(voxels.m_voxelIDs[v], voxels.m_energiesInVoxel[v], voxels.m_trackIDs[v], voxels.m_tpcIDs[v]);
+
+    return voxelAccumulator.GetMergedVoxels();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits)
+{
+    LArVoxelProjectionList outputHits;
+    std::vector<bool> areUsed(hits.size(), false);
+
+    for (unsigned int vp1 = 0; vp1 < hits.size(); ++vp1)
+    {
+        if (areUsed.at(vp1))
+            continue;
+
+        LArVoxelProjection voxProj1{hits.at(vp1)};
+        std::map<int, float> trackIDToEnergy;
+        trackIDToEnergy[voxProj1.m_trackID] = voxProj1.m_energy;
+        for (unsigned int vp2 = vp1 + 1; vp2 < hits.size(); ++vp2)
+        {
+            if (areUsed.at(vp2))
+                continue;
+
+            const LArVoxelProjection &voxProj2 = hits.at(vp2);
+            if ((voxProj1.m_wire != voxProj2.m_wire) || (voxProj1.m_drift != voxProj2.m_drift))
+                continue;
+
+            // Add the energy, but keep track of the highest energy contributor
+            voxProj1.m_energy += voxProj2.m_energy;
+            if (trackIDToEnergy.count(voxProj2.m_trackID) != 0)
+                trackIDToEnergy[voxProj2.m_trackID] += voxProj2.m_energy;
+            else
+                trackIDToEnergy[voxProj2.m_trackID] = voxProj2.m_energy;
+
+            areUsed.at(vp2) = true;
+        }
+        // Add the hit to the output
+        areUsed.at(vp1) = true;
+
+        // Update the track ID if necessary
+        if (trackIDToEnergy.size() > 1)
+        {
+            float highestEnergy{0.f};
+            int bestTrackID{-1};
+            for (auto const &pair : trackIDToEnergy)
+            {
+                if (pair.second > highestEnergy)
+                {
+                    highestEnergy = pair.second;
+                    bestTrackID = pair.first;
+                }
+            }
+            voxProj1.m_trackID = bestTrackID;
+            voxProj1.m_parentVoxelID = hits.at(bestTrackID).m_parentVoxelID;
+        }
+        outputHits.emplace_back(voxProj1);
+    }
+
+    std::cout << outputHits.size() << " projected hits remain after merging" << std::endl;
+    return outputHits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MakeCaloHitsFromVoxels(const LArVoxelArray &voxels, const LArGrid &grid, const MCParticleEnergyMap &mcEnergyMap,
+    const pandora::Pandora *const pPrimaryPandora, const LArNDCaloHitFactory &caloHitFactory, const Parameters &parameters,
+    int &hitCounter)
+{
+    // The grid of oversized events may be coarser than the nominal voxel width
+    const float voxelWidth(grid.m_binWidths.GetX());
+    const float MipE = 0.00075;
+    lar_content::LArCaloHitParameters caloHitParameters = MakeDefaultCaloHitParams(voxelWidth);
+
+    if (parameters.m_use3D)
+    {
+        for (unsigned int v = 0; v < voxels.GetNVoxels(); ++v)
+        {
+            const pandora::CartesianVector voxelPos(grid.GetPoint(grid.GetBinIndices(voxels.m_voxelIDs[v])));
+            const float voxelE = voxels.m_energiesInVoxel[v];
+            const float voxelMipEquivalentE = voxelE / MipE;
+
+            if (voxelMipEquivalentE < parameters.m_minVoxelMipEquivE)
+                continue;
+
+            // Modify the important fields
+            caloHitParameters.m_positionVector = voxelPos;
+            caloHitParameters.m_inputEnergy = voxelE;
+            caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
+            caloHitParameters.m_electromagneticEnergy = voxelE;
+            caloHitParameters.m_hadronicEnergy = voxelE;
+            caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
+            caloHitParameters.m_larTPCVolumeId = voxels.m_tpcIDs[v];
+
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, caloHitFactory));
+
+            // Set calo hit voxel to MCParticle relation using trackID
+            const int trackID = voxels.m_trackIDs[v];
+            const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
+            PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+        }
+    }
+
+    // Treat the 3 x 2D view case separately as we need to merge hits
+    // on some of the views depending on the geometry
+    if (parameters.m_useLArTPC)
+    {
+        LArVoxelProjectionList voxelProjectionsU;
+        LArVoxelProjectionList voxelProjectionsV;
+        LArVoxelProjectionList voxelProjectionsW;
+
+        for (unsigned int v = 0; v < voxels.GetNVoxels(); ++v)
+        {
+            const long voxelID = voxels.m_voxelIDs[v];
+            const float voxelE = voxels.m_energiesInVoxel[v];
+            const int trackID = voxels.m_trackIDs[v];
+            const int tpcID = voxels.m_tpcIDs[v];
+
+            const pandora::CartesianVector voxelPos(grid.GetPoint(grid.GetBinIndices(voxelID)));
+            const float uPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(voxelPos.GetY(), voxelPos.GetZ()));
+            voxelProjectionsU.emplace_back(LArVoxelProjection(voxelE, uPos, voxelPos.GetX(), pandora::TPC_VIEW_U, voxelID, trackID, tpcID));
+
+            const float vPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(voxelPos.GetY(), voxelPos.GetZ()));
+            voxelProjectionsV.emplace_back(LArVoxelProjection(voxelE, vPos, voxelPos.GetX(), pandora::TPC_VIEW_V, voxelID, trackID, tpcID));
+
+            const float wPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(voxelPos.GetY(), voxelPos.GetZ()));
+            voxelProjectionsW.emplace_back(LArVoxelProjection(voxelE, wPos, voxelPos.GetX(), pandora::TPC_VIEW_W, voxelID, trackID, tpcID));
+        }
+
+        std::vector<LArVoxelProjectionList> viewProjections;
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsU));
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsV));
+        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsW));
+
+        voxelProjectionsU.clear();
+        voxelProjectionsV.clear();
+        voxelProjectionsW.clear();
+
+        for (const LArVoxelProjectionList &view : viewProjections)
+        {
+            for (const LArVoxelProjection &hit : view)
+            {
+                const float voxelE = hit.m_energy;
+                const float voxelMipEquivalentE = voxelE / MipE;
+
+                if (voxelMipEquivalentE < parameters.m_minVoxelMipEquivE)
+                    continue;
+
+                // Modify the important fields
+                caloHitParameters.m_positionVector = pandora::CartesianVector(hit.m_drift, 0.f, hit.m_wire);
+                caloHitParameters.m_inputEnergy = voxelE;
+                caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
+                caloHitParameters.m_electromagneticEnergy = voxelE;
+                caloHitParameters.m_hadronicEnergy = voxelE;
+                caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
+                caloHitParameters.m_hitType = hit.m_view;
+                caloHitParameters.m_larTPCVolumeId = hit.m_tpcID;
+
+                // Create LArCaloHits for U, V and W views
+                PANDORA_THROW_RESULT_IF(
+                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, caloHitFactory));
+
+                // Set calo hit voxel to MCParticle relation using trackID
+                const int trackID = hit.m_trackID;
+                const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
+                PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+            } // end voxel projection loop
+        } // end view loop
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const int trackID)
+{
+    // Find the energy fraction: voxelHitE/MCParticleE
+    float energyFrac(0.f), MCEnergy(0.f);
+    MCParticleEnergyMap::const_iterator mapIter = mcEnergyMap.find(trackID);
+    if (mapIter != mcEnergyMap.end())
+        MCEnergy = mapIter->second;
+
+    if (MCEnergy > 0.0)
+        energyFrac = voxelE / MCEnergy;
+
+    return energyFrac;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+lar_content::LArCaloHitParameters MakeDefaultCaloHitParams(float voxelWidth)
+{
+    lar_content::LArCaloHitParameters caloHitParameters;
+    caloHitParameters.m_positionVector = pandora::CartesianVector(0.f, 0.f, 1.f);
+    caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
+    caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
+    caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
+    caloHitParameters.m_cellSize0 = voxelWidth;
+    caloHitParameters.m_cellSize1 = voxelWidth;
+    caloHitParameters.m_cellThickness = voxelWidth;
+    caloHitParameters.m_nCellRadiationLengths = 1.f;
+    caloHitParameters.m_nCellInteractionLengths = 1.f;
+    caloHitParameters.m_time = 0.f;
+    caloHitParameters.m_inputEnergy = 0.f;
+    caloHitParameters.m_mipEquivalentEnergy = 0.f;
+    caloHitParameters.m_electromagneticEnergy = 0.f;
+    caloHitParameters.m_hadronicEnergy = 0.f;
+    caloHitParameters.m_isDigital = false;
+    caloHitParameters.m_hitType = pandora::TPC_3D;
+    caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
+    caloHitParameters.m_layer = 0;
+    caloHitParameters.m_isInOuterSamplingLayer = false;
+    caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(0));
+    caloHitParameters.m_larTPCVolumeId = 0;
+    caloHitParameters.m_daughterVolumeId = 0;
+    return caloHitParameters;
+}
+
+} // namespace lar_nd_reco
@@ -0,0 +1,185 @@
+/**
+ *  @file   src/LArSlidingFitCache.cc
+ *
+ *  @brief  Implementation of the event-scoped sliding fit cache class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LArSlidingFitCache.h"
+
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+
+using namespace pandora;
+
+namespace
+{
+
+/**
+ *  @brief  Mix the bits of a 64-bit value (splitmix64 finaliser), so that summed hashes of different hits rarely collide
+ *
+ *  @param  value the input value
+ *
+ *  @return the mixed value
+ */
+std::uint64_t MixBits(std::uint64_t value)
+{
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the bit pattern of a float
+ *
+ *  @param  value the float
+ *
+ *  @return the bit pattern
+ */
+std::uint64_t GetBits(const float value)
+{
+    std::uint32_t bits(0);
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+typedef std::unordered_map<const Pandora *, std::unique_ptr<lar_content::SlidingFitCache>> SlidingFitCacheMap;
+
+// Worker instances may be created and run concurrently, so access to the per-instance caches is serialised
+std::mutex instanceMapMutex;
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+/**
+ *  @brief  Get the map from pandora instance to sliding fit cache
+ *
+ *  @return the map from pandora instance to sliding fit cache
+ */
+SlidingFitCacheMap &GetSlidingFitCacheMap()
+{
+    static SlidingFitCacheMap instanceMap;
+    return instanceMap;
+}
+
+} // namespace
+
+namespace lar_content
+{
+
+SlidingFitCache &SlidingFitCache::GetInstance(const Pandora &pandora)
+{
+    const std::lock_guard<std::mutex> lock(instanceMapMutex);
+    std::unique_ptr<SlidingFitCache> &pSlidingFitCache(GetSlidingFitCacheMap()[&pandora]);
+
+    if (!pSlidingFitCache)
+        pSlidingFitCache.reset(new SlidingFitCache);
+
+    return *pSlidingFitCache;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SlidingFitCache::DeleteInstance(const Pandora &pandora)
+{
+    const std::lock_guard<std::mutex> lock(instanceMapMutex);
+    GetSlidingFitCacheMap().erase(&pandora);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+const ThreeDSlidingFitResult &SlidingFitCache::GetSlidingFitResult(
+    const Cluster *const pCluster, const unsigned int slidingFitWindow, const float slidingFitPitch)
+{
+    const std::size_t hitFingerprint(SlidingFitCache::GetHitFingerprint(pCluster));
+    FitEntry &fitEntry(m_fitEntryMap[FitKey(pCluster, slidingFitWindow, slidingFitPitch)]);
+
+    if ((STATUS_CODE_NOT_INITIALIZED != fitEntry.m_statusCode) && (fitEntry.m_hitFingerprint == hitFingerprint))
+    {
+        ++m_nHits;
+    }
+    else
+    {
+        ++m_nMisses;
+        fitEntry.m_hitFingerprint = hitFingerprint;
+        fitEntry.m_statusCode = STATUS_CODE_NOT_INITIALIZED;
+        fitEntry.m_pFitResult.reset();
+
+        try
+        {
+            fitEntry.m_pFitResult = std::make_unique<ThreeDSlidingFitResult>(pCluster, slidingFitWindow, slidingFitPitch);
+            fitEntry.m_statusCode = STATUS_CODE_SUCCESS;
+        }
+        catch (const StatusCodeException &statusCodeException)
+        {
+            fitEntry.m_statusCode = statusCodeException.GetStatusCode();
+        }
+    }
+
+    if (!fitEntry.m_pFitResult)
+        throw StatusCodeException(fitEntry.m_statusCode);
+
+    return *fitEntry.m_pFitResult;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SlidingFitCache::Reset()
+{
+    m_fitEntryMap.clear();
+    m_nHits = 0;
+    m_nMisses = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SlidingFitCache::SlidingFitCache() :
+    m_nHits(0),
+    m_nMisses(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+SlidingFitCache::FitEntry::FitEntry() :
+    m_hitFingerprint(0),
+    m_statusCode(STATUS_CODE_NOT_INITIALIZED),
+    m_pFitResult(nullptr)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::size_t SlidingFitCache::GetHitFingerprint(const Cluster *const pCluster)
+{
+    // Sums of mixed per-hit hashes do not depend on the order of the hits, only on which hits are present and where they are
+    std::uint64_t hashSum(pCluster->GetNCaloHits());
+
+    for (const OrderedCaloHitList::value_type &layerEntry : pCluster->GetOrderedCaloHitList())
+    {
+        for (const CaloHit *const pCaloHit : *layerEntry.second)
+        {
+            const CartesianVector &position(pCaloHit->GetPositionVector());
+            std::uint64_t hitHash(MixBits(reinterpret_cast<std::uintptr_t>(pCaloHit)));
+            hitHash = MixBits(hitHash ^ GetBits(position.GetX()));
+            hitHash = MixBits(hitHash ^ GetBits(position.GetY()));
+            hitHash = MixBits(hitHash ^ GetBits(position.GetZ()));
+            hashSum += hitHash;
+        }
+    }
+
+    return static_cast<std::size_t>(MixBits(hashSum));
+}
+
+} // namespace lar_content
@@ -10,6 +10,8 @@
 
 #include "Pandora/AlgorithmHeaders.h"
 
+#include "LArAlgorithmProfiler.h"
+#include "LArEventTimeBudget.h"
 #include "LArNDContent.h"
 #include "MasterThreeDAlgorithm.h"
 
@@ -28,39 +30,89 @@
 
 #include "larpandoracontent/LArUtility/PfoMopUpBaseAlgorithm.h"
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <mutex>
+#include <system_error>
+#include <thread>
+
 #ifdef LIBTORCH_DL
 #include "larpandoradlcontent/LArDLContent.h"
 #endif
 
 using namespace pandora;
 
+namespace
+{
+
+// The multi-pandora registry is process-wide, so worker registration must be serialised when several primary instances run concurrently
+std::mutex workerRegistrationMutex;
+
+} // namespace
+
 namespace lar_content
 {
 
+MasterThreeDAlgorithm::MasterThreeDAlgorithm() :
+    m_createCRWorkersOnDemand(true),
+    m_nWorkerHitsCreated(0),
+    m_nCosmicRayThreads(1),
+    m_nSliceWorkerPairs(1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+MasterThreeDAlgorithm::~MasterThreeDAlgorithm()
+{
+    // The time budget registry is process-wide, so the entries for this instance and its workers are removed before they are deleted
+    EventTimeBudget::DeleteInstance(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+MasterThreeDAlgorithm::ExternalThreeDSteeringParameters::ExternalThreeDSteeringParameters() :
+    m_nPrimaryInstances(1)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::Run()
 {
     std::cout << "Should run slicing? " << m_shouldRunSlicing << std::endl;
 
-    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Reset());
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->ResetWorkerInstances());
+
+    m_nWorkerHitsCreated = 0;
 
     if (!m_workerInstancesInitialized)
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->InitializeWorkerInstances());
 
-    if (m_passMCParticlesToWorkerInstances)
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyMCParticles());
-
     PfoToFloatMap stitchedPfosToX0Map;
     VolumeIdToHitListMap volumeIdToHitListMap;
     PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->GetVolumeIdToHitListMap(volumeIdToHitListMap));
 
-    if (m_shouldRunAllHitsCosmicReco)
+    // ATTN Any new cosmic-ray worker instances must exist before the mc particles are copied to the worker instances
+    if (m_shouldRunAllHitsCosmicReco && m_createCRWorkersOnDemand)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CreateCosmicRayWorkerInstances(volumeIdToHitListMap));
+
+    if (m_passMCParticlesToWorkerInstances)
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->CopyMCParticles());
+
+    // Over the time budget, the optional stages are skipped, with the neutrino slice reconstruction always run
+    EventTimeBudget &eventTimeBudget(EventTimeBudget::GetInstance(this->GetPandora()));
+
+    if (m_shouldRunAllHitsCosmicReco && !eventTimeBudget.ShouldSkipStage("MasterThreeD all hits cosmic-ray reconstruction"))
     {
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunCosmicRayReconstruction(volumeIdToHitListMap));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunCosmicRayWorkerInstances(volumeIdToHitListMap));
 
         PfoToLArTPCMap pfoToLArTPCMap;
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RecreateCosmicRayPfos(pfoToLArTPCMap));
 
-        if (m_shouldRunStitching)
+        if (m_shouldRunStitching && !eventTimeBudget.ShouldSkipStage("MasterThreeD cosmic-ray stitching"))
             PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->StitchCosmicRayPfos(pfoToLArTPCMap, stitchedPfosToX0Map));
     }
 
@@ -76,13 +128,327 @@ StatusCode MasterThreeDAlgorithm::Run()
 
     if (m_shouldRunNeutrinoRecoOption || m_shouldRunCosmicRecoOption)
     {
-        SliceHypotheses nuSliceHypotheses, crSliceHypotheses;
-        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RunSliceReconstruction(sliceVector, nuSliceHypotheses, crSliceHypotheses));
+        SliceHypotheses nuSliceHypotheses, crSliceHypotheses, nuOnlySliceHypotheses;
+
+        PANDORA_RETURN_RESULT_IF(
+            STATUS_CODE_SUCCESS, !=, this->RunSliceWorkerPairs(sliceVector, nuSliceHypotheses, crSliceHypotheses, nuOnlySliceHypotheses));
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->SelectBestSliceHypotheses(nuSliceHypotheses, crSliceHypotheses));
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RecreateNuOnlySlicePfos(nuOnlySliceHypotheses));
     }
 
+    if (m_printOverallRecoStatus)
+        this->PrintHandOffSummary();
+
     return STATUS_CODE_SUCCESS;
 }
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap) const
+{
+    const unsigned int nWorkers(m_crWorkerInstances.size());
+    const unsigned int nThreads(this->IsWorkerMonitoringEnabled() ? std::min(1u, nWorkers) : std::min(m_nCosmicRayThreads, nWorkers));
+
+    // ATTN Each worker instance is claimed by exactly one thread, so the instances are independent and may complete in any order
+    std::vector<StatusCode> statusCodes(nWorkers, STATUS_CODE_SUCCESS);
+    std::vector<double> workerTimes(nWorkers, 0.);
+    std::atomic<unsigned int> nextWorkerIndex(0);
+
+    const auto runWorkers = [this, nWorkers, &volumeIdToHitListMap, &statusCodes, &workerTimes, &nextWorkerIndex]() {
+        for (unsigned int workerIndex = nextWorkerIndex++; workerIndex < nWorkers; workerIndex = nextWorkerIndex++)
+        {
+            const auto startTime{std::chrono::steady_clock::now()};
+            statusCodes.at(workerIndex) = this->RunCosmicRayWorker(m_crWorkerInstances.at(workerIndex), volumeIdToHitListMap);
+            workerTimes.at(workerIndex) = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+        }
+    };
+
+    const auto startTime{std::chrono::steady_clock::now()};
+    std::vector<std::thread> threads;
+
+    if (nThreads > 1)
+    {
+        threads.reserve(nThreads);
+
+        try
+        {
+            for (unsigned int threadIndex = 0; threadIndex < nThreads; ++threadIndex)
+                threads.emplace_back(runWorkers);
+        }
+        catch (const std::system_error &)
+        {
+            // ATTN The threads already launched keep claiming workers, so this thread joins in until every worker has been claimed
+            std::cout << "MasterThreeDAlgorithm: Unable to launch all cosmic-ray worker threads, running the remaining workers on "
+                      << threads.size() + 1 << " thread(s)" << std::endl;
+            runWorkers();
+        }
+    }
+    else
+    {
+        runWorkers();
+    }
+
+    // Barrier: all volumes must be reconstructed before the cosmic-ray pfos are recreated and stitched
+    for (std::thread &thread : threads)
+        thread.join();
+
+    const double totalTime(std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count());
+
+    for (const StatusCode statusCode : statusCodes)
+    {
+        if (STATUS_CODE_SUCCESS != statusCode)
+            return statusCode;
+    }
+
+    if (m_printOverallRecoStatus)
+    {
+        for (unsigned int workerIndex = 0; workerIndex < nWorkers; ++workerIndex)
+        {
+            std::cout << "Cosmic-ray worker instance " << m_crWorkerInstances.at(workerIndex)->GetName() << ": "
+                      << workerTimes.at(workerIndex) << " ms" << std::endl;
+        }
+
+        std::cout << "Ran " << nWorkers << " cosmic-ray worker instance(s) on " << nThreads << " thread(s) in " << totalTime << " ms"
+                  << std::endl;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunCosmicRayWorker(const Pandora *const pCRWorker, const VolumeIdToHitListMap &volumeIdToHitListMap) const
+{
+    // ATTN Exceptions must not escape a worker thread, so convert them to status codes here
+    try
+    {
+        const LArTPC &larTPC(pCRWorker->GetGeometry()->GetLArTPC());
+        VolumeIdToHitListMap::const_iterator iter(volumeIdToHitListMap.find(larTPC.GetLArTPCVolumeId()));
+
+        if (volumeIdToHitListMap.end() == iter)
+            return STATUS_CODE_SUCCESS;
+
+        for (const CaloHit *const pCaloHit : iter->second.m_allHitList)
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->HandOffCaloHit(pCRWorker, pCaloHit));
+
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pCRWorker));
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        return statusCodeException.GetStatusCode();
+    }
+    catch (...)
+    {
+        return STATUS_CODE_FAILURE;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunSliceWorkerPairs(const SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses,
+    SliceHypotheses &crSliceHypotheses, SliceHypotheses &nuOnlySliceHypotheses) const
+{
+    const unsigned int nSlices(sliceVector.size());
+    const unsigned int nWorkerPairs(this->IsWorkerMonitoringEnabled() ? std::min(1u, nSlices) : std::min(m_nSliceWorkerPairs, nSlices));
+
+    if (m_printOverallRecoStatus)
+        std::cout << "Running " << nWorkerPairs << " slice worker pair(s) for " << nSlices << " slice(s)" << std::endl;
+
+    // ATTN Each worker pair processes its slices in order and writes only to its own entries in the pre-sized hypothesis vectors
+    SliceHypotheses nuHypotheses(m_shouldRunNeutrinoRecoOption ? nSlices : 0), crHypotheses(m_shouldRunCosmicRecoOption ? nSlices : 0);
+    IntVector nuOnlySliceFlags(nSlices, 0);
+    std::vector<StatusCode> statusCodes(nWorkerPairs, STATUS_CODE_SUCCESS);
+    std::vector<std::thread> threads;
+
+    if (nWorkerPairs > 1)
+    {
+        threads.reserve(nWorkerPairs);
+
+        try
+        {
+            for (unsigned int workerPairIndex = 0; workerPairIndex < nWorkerPairs; ++workerPairIndex)
+            {
+                threads.emplace_back(
+                    [this, workerPairIndex, nWorkerPairs, &sliceVector, &nuHypotheses, &crHypotheses, &nuOnlySliceFlags, &statusCodes]() {
+                        statusCodes.at(workerPairIndex) = this->RunSliceWorkerPair(
+                            workerPairIndex, nWorkerPairs, sliceVector, nuHypotheses, crHypotheses, nuOnlySliceFlags);
+                    });
+            }
+        }
+        catch (const std::system_error &)
+        {
+            // ATTN The worker pairs already launched keep running, so the pairs that could not be launched run on this thread instead
+            std::cout << "MasterThreeDAlgorithm: Unable to launch all slice worker threads, running "
+                      << nWorkerPairs - threads.size() << " worker pair(s) on this thread" << std::endl;
+
+            for (unsigned int workerPairIndex = threads.size(); workerPairIndex < nWorkerPairs; ++workerPairIndex)
+            {
+                statusCodes.at(workerPairIndex) =
+                    this->RunSliceWorkerPair(workerPairIndex, nWorkerPairs, sliceVector, nuHypotheses, crHypotheses, nuOnlySliceFlags);
+            }
+        }
+    }
+    else if (1 == nWorkerPairs)
+    {
+        statusCodes.front() = this->RunSliceWorkerPair(0, 1, sliceVector, nuHypotheses, crHypotheses, nuOnlySliceFlags);
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const StatusCode statusCode : statusCodes)
+    {
+        if (STATUS_CODE_SUCCESS != statusCode)
+            return statusCode;
+    }
+
+    // ATTN Slice labels are applied via the master instance, so only once all worker threads have finished
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->SetSliceIndices(nuHypotheses));
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->SetSliceIndices(crHypotheses));
+
+    // ATTN Slices without a cosmic-ray hypothesis are kept away from slice id, whose tools expect a hypothesis of each type per slice
+    for (unsigned int sliceIndex = 0; sliceIndex < nSlices; ++sliceIndex)
+    {
+        if (nuOnlySliceFlags.at(sliceIndex))
+        {
+            nuOnlySliceHypotheses.push_back(std::move(nuHypotheses.at(sliceIndex)));
+            continue;
+        }
+
+        if (m_shouldRunNeutrinoRecoOption)
+            nuSliceHypotheses.push_back(std::move(nuHypotheses.at(sliceIndex)));
+
+        if (m_shouldRunCosmicRecoOption)
+            crSliceHypotheses.push_back(std::move(crHypotheses.at(sliceIndex)));
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RunSliceWorkerPair(const unsigned int workerPairIndex, const unsigned int nWorkerPairs,
+    const SliceVector &sliceVector, SliceHypotheses &nuSliceHypotheses, SliceHypotheses &crSliceHypotheses,
+    IntVector &nuOnlySliceFlags) const
+{
+    // ATTN Exceptions must not escape a worker thread, so convert them to status codes here
+    try
+    {
+        for (unsigned int sliceIndex = workerPairIndex; sliceIndex < sliceVector.size(); sliceIndex += nWorkerPairs)
+        {
+            const CaloHitList &sliceHits(sliceVector.at(sliceIndex));
+
+            if (m_shouldRunNeutrinoRecoOption)
+            {
+                PfoList &slicePfos(nuSliceHypotheses.at(sliceIndex));
+                PANDORA_RETURN_RESULT_IF(
+                    STATUS_CODE_SUCCESS, !=, this->ProcessSlice(m_sliceNuWorkerPool.at(workerPairIndex), sliceHits, slicePfos));
+            }
+
+            if (m_shouldRunCosmicRecoOption)
+            {
+                if (m_shouldRunNeutrinoRecoOption &&
+                    EventTimeBudget::GetInstance(this->GetPandora()).ShouldSkipStage("MasterThreeD slice cosmic-ray hypothesis"))
+                {
+                    // ATTN The cosmic-ray hypothesis is left empty and the slice is marked to keep its neutrino hypothesis
+                    nuOnlySliceFlags.at(sliceIndex) = 1;
+                    continue;
+                }
+
+                PfoList &slicePfos(crSliceHypotheses.at(sliceIndex));
+                PANDORA_RETURN_RESULT_IF(
+                    STATUS_CODE_SUCCESS, !=, this->ProcessSlice(m_sliceCRWorkerPool.at(workerPairIndex), sliceHits, slicePfos));
+            }
+        }
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        return statusCodeException.GetStatusCode();
+    }
+    catch (...)
+    {
+        return STATUS_CODE_FAILURE;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::ProcessSlice(const Pandora *const pPandora, const CaloHitList &sliceHits, PfoList &slicePfos) const
+{
+    for (const CaloHit *const pSliceCaloHit : sliceHits)
+    {
+        // ATTN Must ensure we copy the hit actually owned by master instance; access differs with/without slicing enabled
+        const CaloHit *const pCaloHitInMaster(
+            m_shouldRunSlicing ? static_cast<const CaloHit *>(pSliceCaloHit->GetParentAddress()) : pSliceCaloHit);
+        PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->HandOffCaloHit(pPandora, pCaloHitInMaster));
+    }
+
+    const PfoList *pSlicePfos(nullptr);
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPandora));
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::GetCurrentPfoList(*pPandora, pSlicePfos));
+    slicePfos = *pSlicePfos;
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::RecreateNuOnlySlicePfos(const SliceHypotheses &nuOnlySliceHypotheses) const
+{
+    PfoList newSlicePfoList;
+
+    for (const PfoList &slicePfos : nuOnlySliceHypotheses)
+    {
+        for (const ParticleFlowObject *const pPfo : slicePfos)
+        {
+            // ATTN Daughter pfos are recreated along with their parents
+            if (!pPfo->GetParentPfoList().empty())
+                continue;
+
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Recreate(pPfo, nullptr, newSlicePfoList));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool MasterThreeDAlgorithm::IsWorkerMonitoringEnabled() const
+{
+    for (const PandoraInstanceList *const pWorkerInstances : {&m_crWorkerInstances, &m_sliceNuWorkerPool, &m_sliceCRWorkerPool})
+    {
+        for (const Pandora *const pWorker : *pWorkerInstances)
+        {
+            if (pWorker->GetSettings()->IsMonitoringEnabled())
+                return true;
+        }
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::SetSliceIndices(const SliceHypotheses &sliceHypotheses) const
+{
+    for (unsigned int sliceIndex = 0; sliceIndex < sliceHypotheses.size(); ++sliceIndex)
+    {
+        for (const ParticleFlowObject *const pPfo : sliceHypotheses.at(sliceIndex))
+        {
+            PandoraContentApi::ParticleFlowObject::Metadata metadata;
+            metadata.m_propertiesToAdd["SliceIndex"] = sliceIndex;
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::ParticleFlowObject::AlterMetadata(*this, pPfo, metadata));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 StatusCode MasterThreeDAlgorithm::RunCosmicRayHitRemoval(const PfoList &ambiguousPfos) const
@@ -139,7 +505,7 @@ StatusCode MasterThreeDAlgorithm::RunSlicing(const VolumeIdToHitListMap &volumeI
 
             if (m_shouldRunSlicing)
             {
-                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Copy(m_pSlicingWorkerInstance, pCaloHit));
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->HandOffCaloHit(m_pSlicingWorkerInstance, pCaloHit));
             }
             else
             {
@@ -241,7 +607,11 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     PANDORA_THROW_RESULT_IF(
         STATUS_CODE_SUCCESS, !=, PandoraApi::SetLArTransformationPlugin(*pPandora, new lar_content::LArRotationalTransformationPlugin));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RegisterCustomContent(pPandora));
-    MultiPandoraApi::AddDaughterPandoraInstance(&(this->GetPandora()), pPandora);
+    {
+        const std::lock_guard<std::mutex> lock(workerRegistrationMutex);
+        MultiPandoraApi::AddDaughterPandoraInstance(&(this->GetPandora()), pPandora);
+    }
+    EventTimeBudget::AddWorkerInstance(this->GetPandora(), *pPandora);
 
     // The LArTPC
     PandoraApi::Geometry::LArTPC::Parameters larTPCParameters;
@@ -293,7 +663,7 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     }
 
     // Configuration
-    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, settingsFile));
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->ReadWorkerSettings(pPandora, settingsFile));
     return pPandora;
 }
 
@@ -321,7 +691,11 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     PANDORA_THROW_RESULT_IF(
         STATUS_CODE_SUCCESS, !=, PandoraApi::SetLArTransformationPlugin(*pPandora, new lar_content::LArRotationalTransformationPlugin));
     PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->RegisterCustomContent(pPandora));
-    MultiPandoraApi::AddDaughterPandoraInstance(&(this->GetPandora()), pPandora);
+    {
+        const std::lock_guard<std::mutex> lock(workerRegistrationMutex);
+        MultiPandoraApi::AddDaughterPandoraInstance(&(this->GetPandora()), pPandora);
+    }
+    EventTimeBudget::AddWorkerInstance(this->GetPandora(), *pPandora);
 
     // The Parent LArTPC
     const LArTPC *const pFirstLArTPC(larTPCMap.begin()->second);
@@ -379,7 +753,7 @@ const Pandora *MasterThreeDAlgorithm::CreateWorkerInstance(
     }
 
     // Configuration
-    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPandora, settingsFile));
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->ReadWorkerSettings(pPandora, settingsFile));
     return pPandora;
 }
 
@@ -391,13 +765,27 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
     if (m_workerInstancesInitialized)
         return STATUS_CODE_ALREADY_INITIALIZED;
 
+    const auto startTime{std::chrono::steady_clock::now()};
+
     try
     {
+        if (m_shouldRunAllHitsCosmicReco || m_shouldRunCosmicRecoOption)
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->LoadSettingsDocument(m_crSettingsFile));
+
+        if (m_shouldRunNeutrinoRecoOption)
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->LoadSettingsDocument(m_nuSettingsFile));
+
+        if (m_shouldRunSlicing)
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->LoadSettingsDocument(m_slicingSettingsFile));
+
         const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
         const DetectorGapList &gapList(this->GetPandora().GetGeometry()->GetDetectorGapList());
 
         for (const LArTPCMap::value_type &mapEntry : larTPCMap)
         {
+            if (m_createCRWorkersOnDemand)
+                break;
+
             const unsigned int volumeId(mapEntry.second->GetLArTPCVolumeId());
             m_crWorkerInstances.push_back(
                 this->CreateWorkerInstance(*(mapEntry.second), gapList, m_crSettingsFile, "CRWorkerInstance" + std::to_string(volumeId)));
@@ -411,6 +799,23 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
 
         if (m_shouldRunCosmicRecoOption)
             m_pSliceCRWorkerInstance = this->CreateWorkerInstance(larTPCMap, gapList, m_crSettingsFile, "SliceCRWorker");
+
+        if (m_shouldRunNeutrinoRecoOption)
+            m_sliceNuWorkerPool.push_back(m_pSliceNuWorkerInstance);
+
+        if (m_shouldRunCosmicRecoOption)
+            m_sliceCRWorkerPool.push_back(m_pSliceCRWorkerInstance);
+
+        for (unsigned int workerPairIndex = 1; workerPairIndex < m_nSliceWorkerPairs; ++workerPairIndex)
+        {
+            const std::string suffix(std::to_string(workerPairIndex));
+
+            if (m_shouldRunNeutrinoRecoOption)
+                m_sliceNuWorkerPool.push_back(this->CreateWorkerInstance(larTPCMap, gapList, m_nuSettingsFile, "SliceNuWorker" + suffix));
+
+            if (m_shouldRunCosmicRecoOption)
+                m_sliceCRWorkerPool.push_back(this->CreateWorkerInstance(larTPCMap, gapList, m_crSettingsFile, "SliceCRWorker" + suffix));
+        }
     }
     catch (const StatusCodeException &statusCodeException)
     {
@@ -418,12 +823,114 @@ StatusCode MasterThreeDAlgorithm::InitializeWorkerInstances()
         return statusCodeException.GetStatusCode();
     }
 
+    std::cout << "MasterThreeDAlgorithm: Worker instance startup took "
+              << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() << " ms" << std::endl;
+
     m_workerInstancesInitialized = true;
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+StatusCode MasterThreeDAlgorithm::ResetWorkerInstances()
+{
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, this->Reset());
+
+    // ATTN The standard slice workers, the first pool entries, have just been reset by the master algorithm
+    for (const PandoraInstanceList *const pWorkerPool : {&m_sliceNuWorkerPool, &m_sliceCRWorkerPool})
+    {
+        for (const Pandora *const pPandoraWorker : *pWorkerPool)
+        {
+            if ((pPandoraWorker != m_pSliceNuWorkerInstance) && (pPandoraWorker != m_pSliceCRWorkerInstance))
+                PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPandoraWorker));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::CreateCosmicRayWorkerInstances(const VolumeIdToHitListMap &volumeIdToHitListMap)
+{
+    const auto startTime{std::chrono::steady_clock::now()};
+    unsigned int nNewWorkers(0);
+
+    try
+    {
+        const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
+        const DetectorGapList &gapList(this->GetPandora().GetGeometry()->GetDetectorGapList());
+
+        for (const VolumeIdToHitListMap::value_type &mapEntry : volumeIdToHitListMap)
+        {
+            const unsigned int volumeId(mapEntry.first);
+
+            // ATTN Keep the workers ordered by volume id, as if they had all been created up front, so pfos are recreated in the same order
+            PandoraInstanceList::iterator insertIter(std::lower_bound(m_crWorkerInstances.begin(), m_crWorkerInstances.end(), volumeId,
+                [](const Pandora *const pCRWorker, const unsigned int id)
+                { return pCRWorker->GetGeometry()->GetLArTPC().GetLArTPCVolumeId() < id; }));
+
+            if ((m_crWorkerInstances.end() != insertIter) && ((*insertIter)->GetGeometry()->GetLArTPC().GetLArTPCVolumeId() == volumeId))
+                continue;
+
+            const std::string name("CRWorkerInstance" + std::to_string(volumeId));
+            m_crWorkerInstances.insert(insertIter, this->CreateWorkerInstance(*(larTPCMap.at(volumeId)), gapList, m_crSettingsFile, name));
+            ++nNewWorkers;
+        }
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        std::cout << "MasterThreeDAlgorithm: Exception during creation of cosmic-ray worker instances " << statusCodeException.ToString()
+                  << std::endl;
+        return statusCodeException.GetStatusCode();
+    }
+
+    if (nNewWorkers > 0)
+    {
+        std::cout << "MasterThreeDAlgorithm: Created " << nNewWorkers << " cosmic-ray worker instance(s) in "
+                  << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count() << " ms" << std::endl;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::LoadSettingsDocument(const std::string &settingsFile)
+{
+    if (m_settingsDocumentMap.count(settingsFile))
+        return STATUS_CODE_SUCCESS;
+
+    std::unique_ptr<TiXmlDocument> pXmlDocument(new TiXmlDocument(settingsFile));
+
+    if (!pXmlDocument->LoadFile())
+    {
+        std::cout << "MasterThreeDAlgorithm::LoadSettingsDocument - Invalid xml file " << settingsFile << std::endl;
+        return STATUS_CODE_FAILURE;
+    }
+
+    if (AlgorithmProfiler::GetInstance().IsEnabled())
+        AlgorithmProfiler::InsertCheckpoints(pXmlDocument->RootElement());
+
+    m_settingsDocumentMap.emplace(settingsFile, std::move(pXmlDocument));
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::ReadWorkerSettings(const Pandora *const pPandora, const std::string &settingsFile) const
+{
+    SettingsDocumentMap::const_iterator iter(m_settingsDocumentMap.find(settingsFile));
+
+    if (m_settingsDocumentMap.end() == iter)
+        return AlgorithmProfiler::GetInstance().ReadSettings(*pPandora, settingsFile);
+
+    // ATTN Equivalent to reading the file directly: the root element of the parsed document holds the pandora settings
+    return PandoraApi::ReadSettings(*pPandora, iter->second->RootElement());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::GetVolumeIdToHitListMap(VolumeIdToHitListMap &volumeIdToHitListMap) const
 {
     const LArTPCMap &larTPCMap(this->GetPandora().GetGeometry()->GetLArTPCMap());
@@ -459,9 +966,106 @@ StatusCode MasterThreeDAlgorithm::GetVolumeIdToHitListMap(VolumeIdToHitListMap &
     return STATUS_CODE_SUCCESS;
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MasterThreeDAlgorithm::HandOffCaloHit(const Pandora *const pPandora, const CaloHit *const pCaloHitInMaster) const
+{
+    const LArCaloHit *const pLArCaloHit(dynamic_cast<const LArCaloHit *>(pCaloHitInMaster));
+
+    // ATTN Hits that are not LArCaloHits are left to the standard copy, which reports the problem
+    if (!pLArCaloHit)
+        return this->Copy(pPandora, pCaloHitInMaster);
+
+    // ATTN The parameters are built from the current state of the master hit for each hand-off, so nothing is kept between hand-offs
+    LArCaloHitParameters parameters;
+    pLArCaloHit->FillParameters(parameters);
+    parameters.m_pParentAddress = static_cast<const void *>(pLArCaloHit);
+
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPandora, parameters, m_workerCaloHitFactory));
+    ++m_nWorkerHitsCreated;
+
+    // ATTN As in the standard copy, the relationships are set using the master addresses, which are the parent addresses in the worker
+    if (m_passMCParticlesToWorkerInstances)
+    {
+        const MCParticleWeightMap &mcParticleWeightMap(pLArCaloHit->GetMCParticleWeightMap());
+
+        MCParticleVector mcParticleVector;
+        for (const MCParticleWeightMap::value_type &mapEntry : mcParticleWeightMap)
+            mcParticleVector.push_back(mapEntry.first);
+        std::sort(mcParticleVector.begin(), mcParticleVector.end(), LArMCParticleHelper::SortByMomentum);
+
+        for (const MCParticle *const pMCParticle : mcParticleVector)
+        {
+            PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetCaloHitToMCParticleRelationship(*pPandora, pLArCaloHit, pMCParticle, mcParticleWeightMap.at(pMCParticle)));
+        }
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MasterThreeDAlgorithm::PrintHandOffSummary() const
+{
+    const unsigned int nWorkerHits(m_nWorkerHitsCreated);
+
+    std::cout << "Hit hand-off: " << nWorkerHits << " worker hits created from master hits (" << nWorkerHits * sizeof(LArCaloHit) / 1024
+              << " kB)" << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MasterThreeDAlgorithm::ReadSettings(const pandora::TiXmlHandle xmlHandle)
 {
-    return MasterAlgorithm::ReadSettings(xmlHandle);
+    PANDORA_RETURN_RESULT_IF_AND_IF(STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=,
+        XmlHelper::ReadValue(xmlHandle, "CreateCRWorkersOnDemand", m_createCRWorkersOnDemand));
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "NCosmicRayThreads", m_nCosmicRayThreads));
+
+    if (0 == m_nCosmicRayThreads)
+    {
+        std::cout << "MasterThreeDAlgorithm::ReadSettings - NCosmicRayThreads must be at least one" << std::endl;
+        return STATUS_CODE_INVALID_PARAMETER;
+    }
+
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "NSliceWorkerPairs", m_nSliceWorkerPairs));
+
+    if (0 == m_nSliceWorkerPairs)
+    {
+        std::cout << "MasterThreeDAlgorithm::ReadSettings - NSliceWorkerPairs must be at least one" << std::endl;
+        return STATUS_CODE_INVALID_PARAMETER;
+    }
+
+    PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, MasterAlgorithm::ReadSettings(xmlHandle));
+
+    // ATTN Worker instances are registered in the process-wide multi-pandora registry, which is read without locking. With several
+    // concurrent primary instances, all workers must be created with the first event, which the application runs on its own
+    if (this->ExternalParametersPresent())
+    {
+        const ExternalThreeDSteeringParameters *const pExternalParameters(
+            dynamic_cast<const ExternalThreeDSteeringParameters *>(this->GetExternalParameters()));
+
+        if (pExternalParameters && (pExternalParameters->m_nPrimaryInstances > 1) && m_createCRWorkersOnDemand)
+        {
+            std::cout << "MasterThreeDAlgorithm::ReadSettings - CreateCRWorkersOnDemand is not supported with "
+                      << pExternalParameters->m_nPrimaryInstances << " concurrent primary instances, creating all cosmic-ray workers"
+                      << std::endl;
+            m_createCRWorkersOnDemand = false;
+        }
+    }
+
+    // ATTN MC particles are only copied to the standard worker instances, so cheated slice reconstruction must run serially
+    if (m_passMCParticlesToWorkerInstances && (m_nSliceWorkerPairs > 1))
+    {
+        std::cout << "MasterThreeDAlgorithm::ReadSettings - PassMCParticlesToWorkerInstances requires serial slice reconstruction, "
+                  << "using one slice worker pair" << std::endl;
+        m_nSliceWorkerPairs = 1;
+    }
+
+    return STATUS_CODE_SUCCESS;
 }
 
 } // namespace lar_content
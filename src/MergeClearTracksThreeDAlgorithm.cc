@@ -14,6 +14,9 @@
 
 #include "larpandoracontent/LArObjects/LArThreeDSlidingFitResult.h"
 
+#include "larpandoracontent/LArUtility/KDTreeLinkerAlgoT.h"
+
+#include "LArSlidingFitCache.h"
 #include "MergeClearTracksThreeDAlgorithm.h"
 
 using namespace pandora;
@@ -28,22 +31,48 @@ MergeClearTracksThreeDAlgorithm::MergeClearTracksThreeDAlgorithm() :
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+MergeClearTracksThreeDAlgorithm::~MergeClearTracksThreeDAlgorithm()
+{
+    SlidingFitCache::DeleteInstance(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 StatusCode MergeClearTracksThreeDAlgorithm::Run()
 {
+    // Pointing clusters persist across merge rounds, and are only rebuilt for clusters modified by a merge
+    PointingClusterCache pointingClusterCache;
+
     bool madeMerges{true};
     while (madeMerges)
     {
         const ClusterList *pClusterList3D{nullptr};
         PANDORA_RETURN_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraContentApi::GetList(*this, m_inputClusterListName, pClusterList3D));
 
-        madeMerges = this->FindMerges(pClusterList3D);
+        madeMerges = this->FindMerges(pClusterList3D, pointingClusterCache);
     }
+
+    if (PandoraContentApi::GetSettings(*this)->ShouldDisplayAlgorithmInfo())
+    {
+        const SlidingFitCache &slidingFitCache(SlidingFitCache::GetInstance(this->GetPandora()));
+        std::cout << "MergeClearTracksThreeDAlgorithm: sliding fit cache " << slidingFitCache.GetNHits() << " hits, "
+                  << slidingFitCache.GetNMisses() << " misses this event" << std::endl;
+    }
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode MergeClearTracksThreeDAlgorithm::Reset()
+{
+    SlidingFitCache::GetInstance(this->GetPandora()).Reset();
     return STATUS_CODE_SUCCESS;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClusterList) const
+bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClusterList, PointingClusterCache &pointingClusterCache) const
 {
     // Use a cluster vector so that we can sort track-like clusters by the number of hits
     ClusterVector sortedClusters;
@@ -52,6 +81,10 @@ bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClust
         if (MU_MINUS != pCluster->GetParticleId())
             continue;
 
+        // Clusters without a valid sliding fit can never be merged
+        if (!this->GetPointingCluster(pCluster, pointingClusterCache))
+            continue;
+
         sortedClusters.emplace_back(pCluster);
     }
     if (sortedClusters.size() < 2)
@@ -59,14 +92,22 @@ bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClust
 
     std::sort(sortedClusters.begin(), sortedClusters.end(), LArClusterHelper::SortByNHits);
 
+    std::vector<std::vector<unsigned int>> candidateIndices;
+    this->GetCandidatePairs(sortedClusters, pointingClusterCache, candidateIndices);
+
     ClusterMergeMap mergeCandidates;
     ClusterFloatMap mergeClosestDistance;
 
-    for (ClusterVector::iterator iter1 = sortedClusters.begin(); iter1 != sortedClusters.end(); ++iter1)
+    for (unsigned int i = 0; i < sortedClusters.size(); ++i)
     {
-        for (ClusterVector::iterator iter2 = iter1 + 1; iter2 != sortedClusters.end(); ++iter2)
+        const Cluster *const pLargeCluster(sortedClusters.at(i));
+        const LArPointingCluster &largePointingCluster(*pointingClusterCache.at(pLargeCluster));
+
+        for (const unsigned int j : candidateIndices.at(i))
         {
-            this->CanMergeClusters(*iter1, *iter2, mergeCandidates, mergeClosestDistance);
+            const Cluster *const pSmallCluster(sortedClusters.at(j));
+            this->CanMergeClusters(pLargeCluster, pSmallCluster, largePointingCluster, *pointingClusterCache.at(pSmallCluster), mergeCandidates,
+                mergeClosestDistance);
         }
     }
 
@@ -81,6 +122,8 @@ bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClust
                 this->MergeClusters(pair.first, pair.second);
                 usedClusters.insert(pair.first);
                 usedClusters.insert(pair.second);
+                pointingClusterCache.erase(pair.first);
+                pointingClusterCache.erase(pair.second);
             }
         }
         return true;
@@ -91,14 +134,111 @@ bool MergeClearTracksThreeDAlgorithm::FindMerges(const ClusterList *const pClust
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+const LArPointingCluster *MergeClearTracksThreeDAlgorithm::GetPointingCluster(const Cluster *const pCluster, PointingClusterCache &pointingClusterCache) const
+{
+    PointingClusterCache::const_iterator iter(pointingClusterCache.find(pCluster));
+
+    if (pointingClusterCache.end() == iter)
+    {
+        std::unique_ptr<LArPointingCluster> pPointingCluster;
+
+        try
+        {
+            // The sliding fit is shared with the other algorithms, and is refitted by the cache only if the cluster hits have changed
+            const float slidingFitPitch(LArGeometryHelper::GetWireZPitch(this->GetPandora()));
+            pPointingCluster = std::make_unique<LArPointingCluster>(SlidingFitCache::GetInstance(this->GetPandora())
+                    .GetSlidingFitResult(pCluster, static_cast<unsigned int>(m_slidingFitWindow), slidingFitPitch));
+        }
+        catch (const StatusCodeException &)
+        {
+        }
+
+        iter = pointingClusterCache.emplace(pCluster, std::move(pPointingCluster)).first;
+    }
+
+    return iter->second.get();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MergeClearTracksThreeDAlgorithm::GetCandidatePairs(
+    const ClusterVector &sortedClusters, PointingClusterCache &pointingClusterCache, std::vector<std::vector<unsigned int>> &candidateIndices) const
+{
+    // The longitudinal and transverse gaps are the components of the separation between the closest vertices, so clusters can only
+    // pass the gap cuts if they have a pair of end points within this distance
+    const float maxVertexSeparationSquared(m_maxGapLengthCut * m_maxGapLengthCut + m_maxGapTransverseCut * m_maxGapTransverseCut);
+    const float maxVertexSeparation(std::sqrt(maxVertexSeparationSquared));
+
+    ClusterToIndexMap clusterToIndexMap;
+    VertexKDNode2DList vertexKDNode2DList;
+    float minX(std::numeric_limits<float>::max()), maxX(-std::numeric_limits<float>::max());
+    float minZ(std::numeric_limits<float>::max()), maxZ(-std::numeric_limits<float>::max());
+
+    for (unsigned int i = 0; i < sortedClusters.size(); ++i)
+    {
+        const Cluster *const pCluster(sortedClusters.at(i));
+        const LArPointingCluster &pointingCluster(*pointingClusterCache.at(pCluster));
+        clusterToIndexMap[pCluster] = i;
+
+        for (const CartesianVector &position : {pointingCluster.GetInnerVertex().GetPosition(), pointingCluster.GetOuterVertex().GetPosition()})
+        {
+            vertexKDNode2DList.emplace_back(pCluster, position.GetX(), position.GetZ());
+            minX = std::min(minX, position.GetX());
+            maxX = std::max(maxX, position.GetX());
+            minZ = std::min(minZ, position.GetZ());
+            maxZ = std::max(maxZ, position.GetZ());
+        }
+    }
+
+    VertexKDTree2D kdTree;
+    kdTree.build(vertexKDNode2DList, KDTreeBox(minX, maxX, minZ, maxZ));
+
+    candidateIndices.assign(sortedClusters.size(), std::vector<unsigned int>());
+
+    for (unsigned int i = 0; i < sortedClusters.size(); ++i)
+    {
+        const LArPointingCluster &pointingCluster(*pointingClusterCache.at(sortedClusters.at(i)));
+        std::vector<unsigned int> &candidates(candidateIndices.at(i));
+
+        for (const CartesianVector &position : {pointingCluster.GetInnerVertex().GetPosition(), pointingCluster.GetOuterVertex().GetPosition()})
+        {
+            const KDTreeBox searchRegion(position.GetX() - maxVertexSeparation, position.GetX() + maxVertexSeparation,
+                position.GetZ() - maxVertexSeparation, position.GetZ() + maxVertexSeparation);
+
+            VertexKDNode2DList found;
+            kdTree.search(searchRegion, found);
+
+            for (const VertexKDNode2D &node : found)
+            {
+                // Only consider each unordered pair once, with the larger cluster first, as for the full pairwise comparison
+                const unsigned int j(clusterToIndexMap.at(node.data));
+
+                if (j <= i)
+                    continue;
+
+                const LArPointingCluster &otherPointingCluster(*pointingClusterCache.at(node.data));
+                const float distanceSquared(std::min((otherPointingCluster.GetInnerVertex().GetPosition() - position).GetMagnitudeSquared(),
+                    (otherPointingCluster.GetOuterVertex().GetPosition() - position).GetMagnitudeSquared()));
+
+                if (distanceSquared <= maxVertexSeparationSquared)
+                    candidates.emplace_back(j);
+            }
+        }
+
+        // Preserve the original pair ordering, which determines the choice between equidistant merge candidates
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 void MergeClearTracksThreeDAlgorithm::CanMergeClusters(const Cluster *const pLargeCluster, const Cluster *const pSmallCluster,
-    ClusterMergeMap &mergeCandidates, ClusterFloatMap &mergeDistance) const
+    const LArPointingCluster &largePointingCluster, const LArPointingCluster &smallPointingCluster, ClusterMergeMap &mergeCandidates,
+    ClusterFloatMap &mergeDistance) const
 {
     try
     {
-        const LArPointingCluster largePointingCluster(pLargeCluster, m_slidingFitWindow, LArGeometryHelper::GetWireZPitch(this->GetPandora()));
-        const LArPointingCluster smallPointingCluster(pSmallCluster, m_slidingFitWindow, LArGeometryHelper::GetWireZPitch(this->GetPandora()));
-
         LArPointingCluster::Vertex largeClusterVertex, smallClusterVertex;
         LArPointingClusterHelper::GetClosestVertices(largePointingCluster, smallPointingCluster, largeClusterVertex, smallClusterVertex);
 
@@ -0,0 +1,86 @@
+/**
+ *  @file   src/ProfilingCheckpointAlgorithm.cc
+ *
+ *  @brief  Implementation of the profiling checkpoint algorithm class.
+ *
+ *  $Log: $
+ */
+
+#include "Pandora/AlgorithmHeaders.h"
+
+#include "LArAlgorithmProfiler.h"
+#include "ProfilingCheckpointAlgorithm.h"
+
+using namespace pandora;
+
+namespace
+{
+
+/**
+ *  @brief  Get the size of the current list of a given type, which is zero if there is no current list
+ *
+ *  @param  algorithm the calling algorithm
+ *
+ *  @return the size of the current list
+ */
+template <typename T>
+unsigned int GetCurrentListSize(const Algorithm &algorithm)
+{
+    const T *pList(nullptr);
+
+    if ((STATUS_CODE_SUCCESS != PandoraContentApi::GetCurrentList(algorithm, pList)) || !pList)
+        return 0;
+
+    return pList->size();
+}
+
+} // namespace
+
+namespace lar_content
+{
+
+ProfilingCheckpointAlgorithm::ProfilingCheckpointAlgorithm()
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+ProfilingCheckpointAlgorithm::~ProfilingCheckpointAlgorithm()
+{
+    AlgorithmProfiler::GetInstance().DeleteInstanceProfile(this->GetPandora());
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ProfilingCheckpointAlgorithm::Initialize()
+{
+    m_pInstanceProfile = AlgorithmProfiler::GetInstance().GetInstanceProfile(this->GetPandora());
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ProfilingCheckpointAlgorithm::Run()
+{
+    AlgorithmProfiler::ListSizes listSizes;
+    listSizes.m_nCaloHits = GetCurrentListSize<CaloHitList>(*this);
+    listSizes.m_nClusters = GetCurrentListSize<ClusterList>(*this);
+    listSizes.m_nPfos = GetCurrentListSize<PfoList>(*this);
+    listSizes.m_nVertices = GetCurrentListSize<VertexList>(*this);
+
+    AlgorithmProfiler::GetInstance().RecordCheckpoint(*m_pInstanceProfile, m_profiledAlgorithm, listSizes);
+
+    return STATUS_CODE_SUCCESS;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+StatusCode ProfilingCheckpointAlgorithm::ReadSettings(const TiXmlHandle xmlHandle)
+{
+    PANDORA_RETURN_RESULT_IF_AND_IF(
+        STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(xmlHandle, "ProfiledAlgorithm", m_profiledAlgorithm));
+
+    return STATUS_CODE_SUCCESS;
+}
+
+} // namespace lar_content
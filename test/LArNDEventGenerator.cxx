@@ -0,0 +1,793 @@
+/**
+ *  @file   LArRecoND/test/LArNDEventGenerator.cxx
+ *
+ *  @brief  Implementation of the synthetic ND LAr event generator, writing LArSP/LArSPMC format trees
+ *
+ *  $Log: $
+ */
+
+#include "TFile.h"
+#include "TTree.h"
+
+#include "TGeoBBox.h"
+#include "TGeoManager.h"
+#include "TGeoMatrix.h"
+#include "TGeoShape.h"
+#include "TGeoVolume.h"
+
+#include "Pandora/StatusCodes.h"
+
+#include "LArNDEventGenerator.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+using namespace lar_nd_reco;
+using namespace lar_nd_generator;
+
+int main(int argc, char *argv[])
+{
+    int errorNo(0);
+
+    try
+    {
+        GeneratorParameters parameters;
+
+        if (!ParseCommandLine(argc, argv, parameters))
+            return 1;
+
+        LArNDGeomSimple geom;
+
+        if (!CreateGeometry(parameters, geom) || !GenerateEvents(parameters, geom))
+            return 1;
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        std::cerr << "Pandora StatusCodeException: " << statusCodeException.ToString() << statusCodeException.GetBackTrace() << std::endl;
+        errorNo = 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception: " << std::endl;
+        errorNo = 1;
+    }
+
+    return errorNo;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_nd_generator
+{
+
+SyntheticEvent::SyntheticEvent() :
+    m_event(0),
+    m_subrun(0),
+    m_run(0),
+    m_unixTime(0),
+    m_unixTimeUsec(0),
+    m_startTime(0),
+    m_endTime(0),
+    m_triggers(0),
+    m_nhits(0),
+    m_nextParticleID(0),
+    m_nextVertexID(0)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEvent::CreateBranches(TTree *const pTree)
+{
+    pTree->Branch("event", &m_event);
+    pTree->Branch("subrun", &m_subrun);
+    pTree->Branch("run", &m_run);
+    pTree->Branch("unix_ts", &m_unixTime);
+    pTree->Branch("unix_ts_usec", &m_unixTimeUsec);
+    pTree->Branch("event_start_t", &m_startTime);
+    pTree->Branch("event_end_t", &m_endTime);
+    pTree->Branch("triggers", &m_triggers);
+    pTree->Branch("nhits", &m_nhits);
+
+    pTree->Branch("x", &m_x);
+    pTree->Branch("y", &m_y);
+    pTree->Branch("z", &m_z);
+    pTree->Branch("ts", &m_ts);
+    pTree->Branch("charge", &m_charge);
+    pTree->Branch("E", &m_E);
+    pTree->Branch("hit_particleID", &m_hit_particleID);
+    pTree->Branch("hit_packetFrac", &m_hit_packetFrac);
+
+    pTree->Branch("mcp_energy", &m_mcp_energy);
+    pTree->Branch("mcp_pdg", &m_mcp_pdg);
+    pTree->Branch("mcp_nuid", &m_mcp_nuid);
+    pTree->Branch("mcp_vertex_id", &m_mcp_vertex_id);
+    pTree->Branch("mcp_idLocal", &m_mcp_idLocal);
+    pTree->Branch("mcp_id", &m_mcp_id);
+    pTree->Branch("mcp_mother", &m_mcp_mother);
+    pTree->Branch("mcp_px", &m_mcp_px);
+    pTree->Branch("mcp_py", &m_mcp_py);
+    pTree->Branch("mcp_pz", &m_mcp_pz);
+    pTree->Branch("mcp_startx", &m_mcp_startx);
+    pTree->Branch("mcp_starty", &m_mcp_starty);
+    pTree->Branch("mcp_startz", &m_mcp_startz);
+    pTree->Branch("mcp_endx", &m_mcp_endx);
+    pTree->Branch("mcp_endy", &m_mcp_endy);
+    pTree->Branch("mcp_endz", &m_mcp_endz);
+
+    pTree->Branch("vertex_id", &m_vertex_id);
+    pTree->Branch("nuID", &m_nuID);
+    pTree->Branch("nue", &m_nue);
+    pTree->Branch("nuPDG", &m_nuPDG);
+    pTree->Branch("nupx", &m_nupx);
+    pTree->Branch("nupy", &m_nupy);
+    pTree->Branch("nupz", &m_nupz);
+    pTree->Branch("nuvtxx", &m_nuvtxx);
+    pTree->Branch("nuvtxy", &m_nuvtxy);
+    pTree->Branch("nuvtxz", &m_nuvtxz);
+    pTree->Branch("mode", &m_mode);
+    pTree->Branch("ccnc", &m_ccnc);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEvent::Clear()
+{
+    m_x.clear();
+    m_y.clear();
+    m_z.clear();
+    m_ts.clear();
+    m_charge.clear();
+    m_E.clear();
+    m_hit_particleID.clear();
+    m_hit_packetFrac.clear();
+
+    m_mcp_energy.clear();
+    m_mcp_pdg.clear();
+    m_mcp_nuid.clear();
+    m_mcp_vertex_id.clear();
+    m_mcp_idLocal.clear();
+    m_mcp_id.clear();
+    m_mcp_mother.clear();
+    m_mcp_px.clear();
+    m_mcp_py.clear();
+    m_mcp_pz.clear();
+    m_mcp_startx.clear();
+    m_mcp_starty.clear();
+    m_mcp_startz.clear();
+    m_mcp_endx.clear();
+    m_mcp_endy.clear();
+    m_mcp_endz.clear();
+
+    m_vertex_id.clear();
+    m_nuID.clear();
+    m_nue.clear();
+    m_nuPDG.clear();
+    m_nupx.clear();
+    m_nupy.clear();
+    m_nupz.clear();
+    m_nuvtxx.clear();
+    m_nuvtxy.clear();
+    m_nuvtxz.clear();
+    m_mode.clear();
+    m_ccnc.clear();
+
+    m_hitContents.clear();
+    m_voxelToHitMap.clear();
+    m_nhits = 0;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void SyntheticEvent::FillHits()
+{
+    for (const HitContent &hitContent : m_hitContents)
+    {
+        m_x.push_back(hitContent.m_position.GetX());
+        m_y.push_back(hitContent.m_position.GetY());
+        m_z.push_back(hitContent.m_position.GetZ());
+        m_ts.push_back(0.f);
+        m_charge.push_back(hitContent.m_energy);
+        m_E.push_back(hitContent.m_energy);
+        m_hit_particleID.push_back(hitContent.m_particleIDs);
+
+        std::vector<float> packetFractions;
+
+        for (const float particleEnergy : hitContent.m_particleEnergies)
+            packetFractions.push_back(particleEnergy / hitContent.m_energy);
+
+        m_hit_packetFrac.push_back(packetFractions);
+    }
+
+    m_nhits = m_hitContents.size();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool CreateGeometry(const GeneratorParameters &parameters, LArNDGeomSimple &geom)
+{
+    if (parameters.m_geomFileName.empty())
+    {
+        // ND-LAr-like layout: 7 x 5 modules in x and z, each with two TPCs sharing a central cathode
+        const double moduleWidthX(100.), moduleWidthY(300.), moduleWidthZ(100.);
+        int tpcID(0);
+
+        for (int moduleZ = 0; moduleZ < 5; ++moduleZ)
+        {
+            for (int moduleX = 0; moduleX < 7; ++moduleX)
+            {
+                const double minX(-350. + moduleX * moduleWidthX), minZ(400. + moduleZ * moduleWidthZ);
+                geom.AddTPC(minX, minX + 0.5 * moduleWidthX, -0.5 * moduleWidthY, 0.5 * moduleWidthY, minZ, minZ + moduleWidthZ, tpcID++);
+                geom.AddTPC(minX + 0.5 * moduleWidthX, minX + moduleWidthX, -0.5 * moduleWidthY, 0.5 * moduleWidthY, minZ,
+                    minZ + moduleWidthZ, tpcID++);
+            }
+        }
+
+        std::cout << "Using the built-in geometry with " << geom.m_TPCs.size() << " TPCs" << std::endl;
+        return true;
+    }
+
+    // Follows CreateGeometry in PandoraInterface, keeping only the TPC boxes
+    TFile *fileSource = TFile::Open(parameters.m_geomFileName.c_str(), "READ");
+    if (!fileSource)
+    {
+        std::cout << "Error in CreateGeometry(): can't open file " << parameters.m_geomFileName << std::endl;
+        return false;
+    }
+
+    TGeoManager *pSimGeom = dynamic_cast<TGeoManager *>(fileSource->Get(parameters.m_geomManagerName.c_str()));
+    if (!pSimGeom)
+    {
+        std::cout << "Could not find the geometry manager named " << parameters.m_geomManagerName << std::endl;
+        fileSource->Close();
+        return false;
+    }
+
+    std::vector<std::vector<unsigned int>> nodePaths;
+    std::vector<unsigned int> currentPath;
+    RecursiveGeometrySearch(pSimGeom, parameters.m_sensitiveDetName, nodePaths, currentPath);
+
+    for (unsigned int n = 0; n < nodePaths.size(); ++n)
+    {
+        const TGeoNode *pTopNode = pSimGeom->GetCurrentNode();
+        std::unique_ptr<TGeoHMatrix> pVolMatrix = std::make_unique<TGeoHMatrix>(*pTopNode->GetMatrix());
+        for (unsigned int d = 0; d < nodePaths.at(n).size(); ++d)
+        {
+            pSimGeom->CdDown(nodePaths.at(n).at(d));
+            const TGeoNode *pNode = pSimGeom->GetCurrentNode();
+            std::unique_ptr<TGeoHMatrix> pMatrix = std::make_unique<TGeoHMatrix>(*pNode->GetMatrix());
+            pVolMatrix->Multiply(pMatrix.get());
+        }
+        const TGeoNode *pTargetNode = pSimGeom->GetCurrentNode();
+
+        const TGeoBBox *pBox = dynamic_cast<TGeoBBox *>(pTargetNode->GetVolume()->GetShape());
+        if (pBox)
+        {
+            double level1[3] = {0.0, 0.0, 0.0};
+            pTargetNode->LocalToMasterVect(pBox->GetOrigin(), level1);
+
+            const double *pVolTrans = pVolMatrix->GetTranslation();
+            const double centreX(level1[0] + pVolTrans[0]), centreY(level1[1] + pVolTrans[1]), centreZ(level1[2] + pVolTrans[2]);
+            const double dx(pBox->GetDX()), dy(pBox->GetDY()), dz(pBox->GetDZ());
+            geom.AddTPC(centreX - dx, centreX + dx, centreY - dy, centreY + dy, centreZ - dz, centreZ + dz, n);
+        }
+
+        for (unsigned int d = 0; d < nodePaths.at(n).size(); ++d)
+            pSimGeom->CdUp();
+    }
+
+    fileSource->Close();
+
+    if (geom.m_TPCs.empty())
+    {
+        std::cout << "Could not find any volumes containing the name " << parameters.m_sensitiveDetName << std::endl;
+        return false;
+    }
+
+    std::cout << "Created " << geom.m_TPCs.size() << " TPCs from " << parameters.m_geomFileName << std::endl;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetName, std::vector<std::vector<unsigned int>> &nodePaths,
+    std::vector<unsigned int> &currentPath)
+{
+    const std::string nodeName{pSimGeom->GetCurrentNode()->GetName()};
+    if (nodeName.find(targetName) != std::string::npos)
+    {
+        nodePaths.emplace_back(currentPath);
+    }
+    else
+    {
+        for (int i = 0; i < pSimGeom->GetCurrentNode()->GetNdaughters(); ++i)
+        {
+            pSimGeom->CdDown(i);
+            currentPath.emplace_back(i);
+            RecursiveGeometrySearch(pSimGeom, targetName, nodePaths, currentPath);
+            pSimGeom->CdUp();
+            currentPath.pop_back();
+        }
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool GenerateEvents(const GeneratorParameters &parameters, const LArNDGeomSimple &geom)
+{
+    std::unique_ptr<TFile> pOutputFile(TFile::Open(parameters.m_outputFileName.c_str(), "RECREATE"));
+    if (!pOutputFile || pOutputFile->IsZombie())
+    {
+        std::cout << "Error in GenerateEvents(): can't create file " << parameters.m_outputFileName << std::endl;
+        return false;
+    }
+
+    TTree *pTree = new TTree(parameters.m_outputTreeName.c_str(), "Synthetic ND LAr events");
+    SyntheticEvent event;
+    event.CreateBranches(pTree);
+
+    std::mt19937 generator(parameters.m_seed);
+    const auto startTime(std::chrono::steady_clock::now());
+    long nTotalHits(0), nTotalParticles(0);
+
+    for (int iEvt = 0; iEvt < parameters.m_nEvents; ++iEvt)
+    {
+        event.Clear();
+        event.m_event = iEvt;
+        event.m_run = parameters.m_run;
+        event.m_subrun = parameters.m_subrun;
+        event.m_unixTime = iEvt;
+        event.m_startTime = 0;
+        event.m_endTime = 2000;
+        event.m_triggers = 1;
+
+        GenerateEvent(parameters, geom, generator, event);
+        event.FillHits();
+        pTree->Fill();
+
+        nTotalHits += event.m_nhits;
+        nTotalParticles += event.m_mcp_id.size();
+    }
+
+    pOutputFile->cd();
+    pTree->Write();
+    pOutputFile->Close();
+
+    const double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+    const double nEvents(std::max(1, parameters.m_nEvents));
+    std::cout << "Wrote " << parameters.m_nEvents << " events at " << parameters.m_intensity << "x nominal intensity to "
+              << parameters.m_outputFileName << ", with " << nTotalHits / nEvents << " hits and " << nTotalParticles / nEvents
+              << " MC particles per event, in " << seconds << " s" << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void GenerateEvent(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, std::mt19937 &generator, SyntheticEvent &event)
+{
+    const int nInteractions(GetPoissonNumber(parameters.m_intensity * parameters.m_nInteractions, generator));
+
+    for (int i = 0; i < nInteractions; ++i)
+        GenerateInteraction(parameters, geom, generator, event);
+
+    AddNoiseHits(parameters, geom, generator, GetPoissonNumber(parameters.m_intensity * parameters.m_nNoiseHits, generator), event);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void GenerateInteraction(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, std::mt19937 &generator, SyntheticEvent &event)
+{
+    // Species drawn as straight tracks: the dE/dx follows a power law in the residual range, above the minimum ionising value
+    static const TrackType muon{13, 0.10566f, 50.f, 400.f, 8.f};
+    static const TrackType pion{211, 0.13957f, 10.f, 100.f, 8.f};
+    static const TrackType proton{2212, 0.93827f, 2.f, 60.f, 17.f};
+    static const TrackType michel{11, 0.000511f, 2.f, 6.f, 2.1f};
+
+    const long vertexID(event.m_nextVertexID++);
+    const CartesianVector vertex(GetRandomPositionInTPC(geom, generator));
+
+    std::bernoulli_distribution isCCDistribution(0.75), isPionDistribution(0.4), isPhotonDistribution(0.5);
+    std::uniform_real_distribution<float> unitDistribution(0.f, 1.f);
+    std::uniform_real_distribution<float> showerEnergyDistribution(0.05f, 2.f);
+
+    const int nTracks(GetPoissonNumber(parameters.m_nTracks, generator)), nShowers(GetPoissonNumber(parameters.m_nShowers, generator));
+    const bool isCC(nTracks > 0 && isCCDistribution(generator));
+
+    CartesianVector totalMomentum(0.f, 0.f, 0.f);
+    float totalEnergy(0.f);
+    std::vector<long> stoppingTrackLocalIDs;
+    std::vector<CartesianVector> stoppingTrackEnds;
+
+    for (int i = 0; i < nTracks; ++i)
+    {
+        const TrackType &trackType((isCC && (0 == i)) ? muon : (isPionDistribution(generator) ? pion : proton));
+        const CartesianVector direction(GetRandomDirection(generator, (&trackType == &muon) ? 0.f : -1.f));
+        const float length(trackType.m_minLength + unitDistribution(generator) * (trackType.m_maxLength - trackType.m_minLength));
+        const CartesianVector momentum(AddTrack(parameters, geom, trackType, vertex, direction, length, vertexID, -1, event));
+
+        totalMomentum += momentum;
+        totalEnergy += event.m_mcp_energy.back();
+
+        if (trackType.m_pdg != proton.m_pdg)
+        {
+            stoppingTrackLocalIDs.push_back(event.m_mcp_idLocal.back());
+            stoppingTrackEnds.push_back(vertex + direction * length);
+        }
+    }
+
+    for (int i = 0; i < nShowers; ++i)
+    {
+        const int pdg(isPhotonDistribution(generator) ? 22 : 11);
+        const CartesianVector momentum(AddShower(
+            parameters, geom, generator, pdg, showerEnergyDistribution(generator), vertex, GetRandomDirection(generator), vertexID, event));
+
+        totalMomentum += momentum;
+        totalEnergy += event.m_mcp_energy.back();
+    }
+
+    // Michel-like stubs start at the end of a muon or pion track, or at the vertex if there are none
+    const int nMichels(GetPoissonNumber(parameters.m_nMichels, generator));
+
+    for (int i = 0; i < nMichels; ++i)
+    {
+        const unsigned int parentIndex(stoppingTrackLocalIDs.empty() ? 0 : generator() % stoppingTrackLocalIDs.size());
+        const long motherLocalID(stoppingTrackLocalIDs.empty() ? -1 : stoppingTrackLocalIDs.at(parentIndex));
+        const CartesianVector start(stoppingTrackEnds.empty() ? vertex : stoppingTrackEnds.at(parentIndex));
+        const float length(michel.m_minLength + unitDistribution(generator) * (michel.m_maxLength - michel.m_minLength));
+        AddTrack(parameters, geom, michel, start, GetRandomDirection(generator), length, vertexID, motherLocalID, event);
+    }
+
+    event.m_vertex_id.push_back(vertexID);
+    event.m_nuID.push_back(vertexID);
+    event.m_nue.push_back(totalEnergy + 0.1f * unitDistribution(generator));
+    event.m_nuPDG.push_back(14);
+    event.m_nupx.push_back(totalMomentum.GetX());
+    event.m_nupy.push_back(totalMomentum.GetY());
+    event.m_nupz.push_back(totalMomentum.GetZ());
+    event.m_nuvtxx.push_back(vertex.GetX());
+    event.m_nuvtxy.push_back(vertex.GetY());
+    event.m_nuvtxz.push_back(vertex.GetZ());
+    event.m_mode.push_back((nTracks + nShowers > 2) ? 2 : 0);
+    event.m_ccnc.push_back(isCC ? 1 : 0);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CartesianVector AddTrack(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, const TrackType &trackType,
+    const CartesianVector &start, const CartesianVector &direction, const float length, const long vertexID, const long motherLocalID,
+    SyntheticEvent &event)
+{
+    const CartesianVector end(start + direction * length);
+    const long particleID(AddMCParticle(trackType.m_pdg, trackType.m_mass, direction, start, end, vertexID, motherLocalID, event));
+
+    // Half-pitch steps, so that no voxel crossed by the track is missed
+    const float minDEdx(2.1f), step(0.5f * parameters.m_pixelPitch);
+    const int nSteps(std::max(1, static_cast<int>(std::ceil(length / step))));
+    float kineticEnergy(0.f);
+
+    for (int i = 0; i < nSteps; ++i)
+    {
+        const float stepLength(std::min(step, length - i * step));
+        const float residualRange(std::max(0.5f * step, length - (i + 0.5f) * step));
+        const float dEdx(std::max(minDEdx, trackType.m_braggScale * std::pow(residualRange, -0.42f)));
+        const float energy(1.e-3f * dEdx * stepLength);
+
+        kineticEnergy += energy;
+        DepositEnergy(parameters, geom, start + direction * ((i + 0.5f) * step), energy, particleID, event);
+    }
+
+    // The particle range fixes its energy: the momentum follows from the total deposited energy
+    const float totalEnergy(kineticEnergy + trackType.m_mass);
+    const float momentum(std::sqrt(std::max(0.f, totalEnergy * totalEnergy - trackType.m_mass * trackType.m_mass)));
+    const CartesianVector momentumVector(direction * momentum);
+
+    event.m_mcp_energy.back() = totalEnergy;
+    event.m_mcp_px.back() = momentumVector.GetX();
+    event.m_mcp_py.back() = momentumVector.GetY();
+    event.m_mcp_pz.back() = momentumVector.GetZ();
+
+    return momentumVector;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CartesianVector AddShower(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, std::mt19937 &generator, const int pdg,
+    const float energy, const CartesianVector &start, const CartesianVector &direction, const long vertexID, SyntheticEvent &event)
+{
+    // Argon radiation length and critical energy, with a photon conversion distance of 9/7 radiation lengths
+    const float radiationLength(14.f), criticalEnergy(0.032f), energyPerDeposit(1.e-3f);
+    std::exponential_distribution<float> conversionDistribution(7.f / (9.f * radiationLength));
+    const CartesianVector showerStart(22 == pdg ? start + direction * conversionDistribution(generator) : start);
+
+    // Longitudinal profile dE/dt ~ t^(a-1) exp(-bt), with the shower maximum at (a-1)/b = ln(E/Ec) - 0.5 radiation lengths
+    const float b(0.5f);
+    const float a(std::max(1.5f, 1.f + b * (std::log(energy / criticalEnergy) - 0.5f)));
+    std::gamma_distribution<float> depthDistribution(a, radiationLength / b);
+    std::normal_distribution<float> transverseDistribution(0.f, 1.f);
+
+    CartesianVector perpendicular1(direction.GetCrossProduct(std::abs(direction.GetZ()) < 0.9f ? CartesianVector(0.f, 0.f, 1.f)
+                                                                                                  : CartesianVector(1.f, 0.f, 0.f)));
+    perpendicular1 = perpendicular1.GetUnitVector();
+    const CartesianVector perpendicular2(direction.GetCrossProduct(perpendicular1));
+
+    const CartesianVector momentum(direction * energy);
+    const float showerLength(a / b * radiationLength);
+    const long particleID(AddMCParticle(pdg, energy, momentum, start, showerStart + direction * showerLength, vertexID, -1, event));
+
+    const int nDeposits(std::max(1, static_cast<int>(energy / energyPerDeposit)));
+    const float depositEnergy(energy / nDeposits);
+
+    for (int i = 0; i < nDeposits; ++i)
+    {
+        // The transverse spread grows with depth, from a narrow core near the shower start
+        const float depth(depthDistribution(generator));
+        const float sigma(0.5f + 0.1f * depth);
+        const CartesianVector position(showerStart + direction * depth + perpendicular1 * (sigma * transverseDistribution(generator)) +
+            perpendicular2 * (sigma * transverseDistribution(generator)));
+        DepositEnergy(parameters, geom, position, depositEnergy, particleID, event);
+    }
+
+    return momentum;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void AddNoiseHits(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, std::mt19937 &generator,
+    const unsigned int nNoiseHits, SyntheticEvent &event)
+{
+    // Noise at around half a minimum ionising deposit per pixel
+    std::exponential_distribution<float> energyDistribution(1.f / 4.e-4f);
+
+    for (unsigned int i = 0; i < nNoiseHits; ++i)
+        DepositEnergy(parameters, geom, GetRandomPositionInTPC(geom, generator), energyDistribution(generator), -1, event);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+long AddMCParticle(const int pdg, const float energy, const CartesianVector &momentum, const CartesianVector &start,
+    const CartesianVector &end, const long vertexID, const long motherLocalID, SyntheticEvent &event)
+{
+    // The particles of an interaction are contiguous, so the local ids count from zero within each interaction
+    const bool isNewVertex(event.m_mcp_vertex_id.empty() || (event.m_mcp_vertex_id.back() != vertexID));
+    const long localID(isNewVertex ? 0 : event.m_mcp_idLocal.back() + 1);
+    const long particleID(event.m_nextParticleID++);
+
+    event.m_mcp_energy.push_back(energy);
+    event.m_mcp_pdg.push_back(pdg);
+    event.m_mcp_nuid.push_back(vertexID);
+    event.m_mcp_vertex_id.push_back(vertexID);
+    event.m_mcp_idLocal.push_back(localID);
+    event.m_mcp_id.push_back(particleID);
+    event.m_mcp_mother.push_back(motherLocalID);
+    event.m_mcp_px.push_back(momentum.GetX());
+    event.m_mcp_py.push_back(momentum.GetY());
+    event.m_mcp_pz.push_back(momentum.GetZ());
+    event.m_mcp_startx.push_back(start.GetX());
+    event.m_mcp_starty.push_back(start.GetY());
+    event.m_mcp_startz.push_back(start.GetZ());
+    event.m_mcp_endx.push_back(end.GetX());
+    event.m_mcp_endy.push_back(end.GetY());
+    event.m_mcp_endz.push_back(end.GetZ());
+
+    return particleID;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool DepositEnergy(const GeneratorParameters &parameters, const LArNDGeomSimple &geom, const CartesianVector &position, const float energy,
+    const long particleID, SyntheticEvent &event)
+{
+    if (geom.GetTPCNumber(position) < 0)
+        return false;
+
+    // Pack the voxel indices into one key, with an offset so that negative coordinates give positive indices
+    const long offset(1L << 19), nBins(1L << 20);
+    const float pitch(parameters.m_pixelPitch);
+    const long ix(static_cast<long>(std::floor(position.GetX() / pitch)));
+    const long iy(static_cast<long>(std::floor(position.GetY() / pitch)));
+    const long iz(static_cast<long>(std::floor(position.GetZ() / pitch)));
+    const long voxelKey(((ix + offset) * nBins + (iy + offset)) * nBins + (iz + offset));
+
+    auto iter(event.m_voxelToHitMap.find(voxelKey));
+
+    if (event.m_voxelToHitMap.end() == iter)
+    {
+        const CartesianVector voxelCentre((ix + 0.5f) * pitch, (iy + 0.5f) * pitch, (iz + 0.5f) * pitch);
+        iter = event.m_voxelToHitMap.emplace(voxelKey, event.m_hitContents.size()).first;
+        event.m_hitContents.push_back(SyntheticEvent::HitContent{voxelCentre, 0.f, {}, {}});
+    }
+
+    SyntheticEvent::HitContent &hitContent(event.m_hitContents.at(iter->second));
+    hitContent.m_energy += energy;
+
+    // Noise adds energy without a truth contribution
+    if (particleID < 0)
+        return true;
+
+    const auto particleIter(std::find(hitContent.m_particleIDs.begin(), hitContent.m_particleIDs.end(), particleID));
+
+    if (hitContent.m_particleIDs.end() == particleIter)
+    {
+        hitContent.m_particleIDs.push_back(particleID);
+        hitContent.m_particleEnergies.push_back(energy);
+    }
+    else
+    {
+        hitContent.m_particleEnergies.at(std::distance(hitContent.m_particleIDs.begin(), particleIter)) += energy;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+int GetPoissonNumber(const float mean, std::mt19937 &generator)
+{
+    if (mean <= 0.f)
+        return 0;
+
+    std::poisson_distribution<int> distribution(mean);
+    return distribution(generator);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CartesianVector GetRandomPositionInTPC(const LArNDGeomSimple &geom, std::mt19937 &generator)
+{
+    std::vector<const LArNDTPCSimple *> tpcs;
+    std::vector<double> volumes;
+
+    for (const auto &mapEntry : geom.m_TPCs)
+    {
+        const LArNDTPCSimple &tpc(mapEntry.second);
+        tpcs.push_back(&tpc);
+        volumes.push_back((tpc.m_x_max - tpc.m_x_min) * (tpc.m_y_max - tpc.m_y_min) * (tpc.m_z_max - tpc.m_z_min));
+    }
+
+    std::discrete_distribution<unsigned int> tpcDistribution(volumes.begin(), volumes.end());
+    const LArNDTPCSimple *const pTPC(tpcs.at(tpcDistribution(generator)));
+
+    std::uniform_real_distribution<double> xDistribution(pTPC->m_x_min, pTPC->m_x_max), yDistribution(pTPC->m_y_min, pTPC->m_y_max),
+        zDistribution(pTPC->m_z_min, pTPC->m_z_max);
+    const float x(xDistribution(generator)), y(yDistribution(generator)), z(zDistribution(generator));
+
+    return CartesianVector(x, y, z);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+CartesianVector GetRandomDirection(std::mt19937 &generator, const float minCosTheta)
+{
+    std::uniform_real_distribution<float> cosThetaDistribution(minCosTheta, 1.f), phiDistribution(0.f, 2.f * M_PI);
+    const float cosTheta(cosThetaDistribution(generator)), phi(phiDistribution(generator));
+    const float sinTheta(std::sqrt(1.f - cosTheta * cosTheta));
+
+    return CartesianVector(sinTheta * std::cos(phi), sinTheta * std::sin(phi), cosTheta);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ParseCommandLine(int argc, char *argv[], GeneratorParameters &parameters)
+{
+    if (1 == argc)
+        return PrintOptions();
+
+    int cOpt(0);
+
+    while ((cOpt = getopt(argc, argv, "o:k:g:t:d:n:s:I:a:T:S:M:N:w:r:u:h")) != -1)
+    {
+        switch (cOpt)
+        {
+            case 'o':
+                parameters.m_outputFileName = optarg;
+                break;
+            case 'k':
+                parameters.m_outputTreeName = optarg;
+                break;
+            case 'g':
+                parameters.m_geomFileName = optarg;
+                break;
+            case 't':
+                parameters.m_geomManagerName = optarg;
+                break;
+            case 'd':
+                parameters.m_sensitiveDetName = optarg;
+                break;
+            case 'n':
+                parameters.m_nEvents = atoi(optarg);
+                break;
+            case 's':
+                parameters.m_seed = std::stoul(optarg);
+                break;
+            case 'I':
+                parameters.m_intensity = atof(optarg);
+                break;
+            case 'a':
+                parameters.m_nInteractions = atof(optarg);
+                break;
+            case 'T':
+                parameters.m_nTracks = atof(optarg);
+                break;
+            case 'S':
+                parameters.m_nShowers = atof(optarg);
+                break;
+            case 'M':
+                parameters.m_nMichels = atof(optarg);
+                break;
+            case 'N':
+                parameters.m_nNoiseHits = atof(optarg);
+                break;
+            case 'w':
+                parameters.m_pixelPitch = atof(optarg);
+                break;
+            case 'r':
+                parameters.m_run = atoi(optarg);
+                break;
+            case 'u':
+                parameters.m_subrun = atoi(optarg);
+                break;
+            case 'h':
+            default:
+                return PrintOptions();
+        }
+    }
+
+    if (parameters.m_outputFileName.empty())
+    {
+        std::cout << "Missing output file name" << std::endl;
+        return PrintOptions();
+    }
+
+    if ((parameters.m_intensity < 0.f) || (parameters.m_nInteractions < 0.f) || (parameters.m_nTracks < 0.f) ||
+        (parameters.m_nShowers < 0.f) || (parameters.m_nMichels < 0.f) || (parameters.m_nNoiseHits < 0.f) ||
+        (parameters.m_pixelPitch <= 0.f))
+    {
+        std::cout << "The intensity and mean multiplicities must not be negative, and the pixel pitch must be positive" << std::endl;
+        return PrintOptions();
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool PrintOptions()
+{
+    std::cout << std::endl
+              << "./bin/LArNDEventGenerator " << std::endl
+              << "    -o OutputFile          (required) [Output ROOT file, readable by PandoraInterface with the SP or SPMC format]"
+              << std::endl
+              << "    -k EventsTreeName      (optional) [Name of the output events ROOT TTree (default = events)]" << std::endl
+              << "    -g GeometryFile        (optional) [ROOT file containing the TGeoManager geometry (default = built-in 7 x 5 modules)]"
+              << std::endl
+              << "    -t TGeoManagerName     (optional) [TGeoManager name (default = Default)]" << std::endl
+              << "    -d sensitiveDetName    (optional) [ND LAr TPC active volume name (default = volTPCActive)]" << std::endl
+              << "    -n NEvents             (optional) [Number of events to generate (default = 100)]" << std::endl
+              << "    -s Seed                (optional) [Random number seed (default = 12345)]" << std::endl
+              << "    -I Intensity           (optional) [Intensity relative to nominal, scaling interactions and noise (default = 1)]"
+              << std::endl
+              << "    -a NInteractions       (optional) [Mean number of interactions per event at nominal intensity (default = 5)]"
+              << std::endl
+              << "    -T NTracks             (optional) [Mean number of straight tracks per interaction (default = 2)]" << std::endl
+              << "    -S NShowers            (optional) [Mean number of showers per interaction (default = 1)]" << std::endl
+              << "    -M NMichels            (optional) [Mean number of Michel-like stubs per interaction (default = 0.3)]" << std::endl
+              << "    -N NNoiseHits          (optional) [Mean number of noise hits per event at nominal intensity (default = 200)]"
+              << std::endl
+              << "    -w width               (optional) [Pixel pitch (cm), default = 0.4 cm]" << std::endl
+              << "    -r Run                 (optional) [Run number (default = 0)]" << std::endl
+              << "    -u Subrun              (optional) [Subrun number (default = 0)]" << std::endl
+              << std::endl;
+
+    return false;
+}
+
+} // namespace lar_nd_generator
@@ -0,0 +1,239 @@
+/**
+ *  @file   LArRecoND/test/LArNDHitCacheConverter.cxx
+ *
+ *  @brief  Implementation of the converter writing the hits of LArSP/LArSPMC format trees to a memory-mapped hit cache
+ *
+ *  $Log: $
+ */
+
+#include "TChain.h"
+
+#include "Pandora/StatusCodes.h"
+
+#include "LArNDHitCache.h"
+#include "LArNDHitCacheConverter.h"
+#include "LArNDInputFiles.h"
+#include "LArSP.h"
+#include "LArSPMC.h"
+
+#include <chrono>
+#include <getopt.h>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace pandora;
+using namespace lar_nd_reco;
+using namespace lar_nd_converter;
+
+int main(int argc, char *argv[])
+{
+    int errorNo(0);
+
+    try
+    {
+        ConverterParameters parameters;
+
+        if (!ParseCommandLine(argc, argv, parameters))
+            return 1;
+
+        std::vector<std::uint64_t> nEventHits;
+
+        if (!CountEventHits(parameters, nEventHits) || !ConvertEvents(parameters, nEventHits))
+            return 1;
+    }
+    catch (const StatusCodeException &statusCodeException)
+    {
+        std::cerr << "Pandora StatusCodeException: " << statusCodeException.ToString() << statusCodeException.GetBackTrace() << std::endl;
+        errorNo = 1;
+    }
+    catch (...)
+    {
+        std::cerr << "Unknown exception: " << std::endl;
+        errorNo = 1;
+    }
+
+    return errorNo;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+namespace lar_nd_converter
+{
+
+std::unique_ptr<TChain> MakeInputChain(const ConverterParameters &parameters)
+{
+    return lar_nd_reco::MakeInputChain(parameters.m_inputTreeName, parameters.m_inputFileNames, parameters.m_inputCacheSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool CountEventHits(const ConverterParameters &parameters, std::vector<std::uint64_t> &nEventHits)
+{
+    std::unique_ptr<TChain> pInputChain(MakeInputChain(parameters));
+    if (!pInputChain)
+        return false;
+
+    LArSP larsp(pInputChain.get());
+    pInputChain->SetBranchStatus("*", 0);
+    pInputChain->SetBranchStatus("x", 1);
+
+    const Long64_t nEntries(pInputChain->GetEntries());
+    nEventHits.clear();
+    nEventHits.reserve(nEntries);
+
+    for (Long64_t iEntry = 0; iEntry < nEntries; ++iEntry)
+    {
+        larsp.GetEntry(iEntry);
+        nEventHits.emplace_back(larsp.m_x ? larsp.m_x->size() : 0);
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ConvertEvents(const ConverterParameters &parameters, const std::vector<std::uint64_t> &nEventHits)
+{
+    std::unique_ptr<TChain> pInputChain(MakeInputChain(parameters));
+    if (!pInputChain)
+        return false;
+
+    const std::unique_ptr<LArSP> larsp(parameters.m_hasMCTruth ? new LArSPMC(pInputChain.get()) : new LArSP(pInputChain.get()));
+    const LArSPMC *const larspmc(dynamic_cast<const LArSPMC *>(larsp.get()));
+
+    // Only the hit branches are converted, the event header and MC particle branches are still read from the input files
+    pInputChain->SetBranchStatus("*", 0);
+
+    for (const char *const branchName : {"event", "x", "y", "z", "charge"})
+        pInputChain->SetBranchStatus(branchName, 1);
+
+    if (larspmc)
+    {
+        pInputChain->SetBranchStatus("hit_particleID", 1);
+        pInputChain->SetBranchStatus("hit_packetFrac", 1);
+    }
+
+    // The source files are recorded in the cache, so PandoraInterface can check it reads the same files in the same order
+    std::vector<std::string> sourceFileNames;
+    std::vector<std::uint64_t> nSourceFileEntries;
+    GetInputFileEntries(*pInputChain, sourceFileNames, nSourceFileEntries);
+
+    LArNDHitCacheWriter writer(parameters.m_outputFileName, nEventHits, parameters.m_hasMCTruth, sourceFileNames, nSourceFileEntries);
+    if (!writer.IsOpen())
+        return false;
+
+    const auto startTime(std::chrono::steady_clock::now());
+    LArNDCachedHits hits;
+
+    for (std::size_t iEvt = 0; iEvt < nEventHits.size(); ++iEvt)
+    {
+        larsp->GetEntry(iEvt);
+        hits.Clear();
+
+        const std::size_t nHits(larsp->m_x->size());
+
+        for (std::size_t iHit = 0; iHit < nHits; ++iHit)
+        {
+            bool hasMCContribution(false);
+            long trackID(0);
+            float energyFrac(0.f);
+
+            if (larspmc)
+                larspmc->GetDominantContribution(iHit, hasMCContribution, trackID, energyFrac);
+
+            hits.m_x.emplace_back((*larsp->m_x)[iHit]);
+            hits.m_y.emplace_back((*larsp->m_y)[iHit]);
+            hits.m_z.emplace_back((*larsp->m_z)[iHit]);
+            hits.m_charge.emplace_back((*larsp->m_charge)[iHit]);
+            hits.m_trackID.emplace_back(trackID);
+            hits.m_energyFrac.emplace_back(energyFrac);
+            hits.m_hasMCContribution.emplace_back(hasMCContribution ? 1 : 0);
+        }
+
+        if (!writer.WriteEvent(larsp->m_event, hits))
+        {
+            std::cout << "Error in ConvertEvents(): can't write event " << iEvt << " to " << parameters.m_outputFileName << std::endl;
+            writer.Close();
+            return false;
+        }
+    }
+
+    if (!writer.Close())
+        return false;
+
+    const double seconds(std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count());
+    std::cout << "Wrote the hits of " << nEventHits.size() << " events to the hit cache " << parameters.m_outputFileName << " in "
+              << seconds << " s" << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ParseCommandLine(int argc, char *argv[], ConverterParameters &parameters)
+{
+    if (1 == argc)
+        return PrintOptions();
+
+    int cOpt(0);
+    std::string formatOption("SPMC");
+
+    while ((cOpt = getopt(argc, argv, "e:k:o:f:h")) != -1)
+    {
+        switch (cOpt)
+        {
+            case 'e':
+                parameters.m_inputFileName = optarg;
+                break;
+            case 'k':
+                parameters.m_inputTreeName = optarg;
+                break;
+            case 'o':
+                parameters.m_outputFileName = optarg;
+                break;
+            case 'f':
+                formatOption = optarg;
+                break;
+            case 'h':
+            default:
+                return PrintOptions();
+        }
+    }
+
+    if (parameters.m_inputFileName.empty() || parameters.m_outputFileName.empty())
+    {
+        std::cout << "Missing input or output file name" << std::endl;
+        return PrintOptions();
+    }
+
+    if (("SP" != formatOption) && ("SPMC" != formatOption))
+    {
+        std::cout << "Only the SP and SPMC formats can be converted to a hit cache" << std::endl;
+        return PrintOptions();
+    }
+
+    parameters.m_hasMCTruth = ("SPMC" == formatOption);
+
+    // The input files are expanded as by PandoraInterface, so the same option gives the same files in the same order
+    return ExpandInputFileNames(parameters.m_inputFileName, parameters.m_inputFileNames);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool PrintOptions()
+{
+    std::cout << std::endl
+              << "./bin/LArNDHitCacheConverter " << std::endl
+              << "    -e EventsFile          (required) [Input ROOT file, or a glob, comma-separated list or .txt/.list file listing one "
+              << "file per line, as given to PandoraInterface]" << std::endl
+              << "    -o OutputFile          (required) [Output hit cache, read by PandoraInterface with the -H option]" << std::endl
+              << "    -k EventsTreeName      (optional) [Name of the input events ROOT TTree (default = events)]" << std::endl
+              << "    -f Format              (optional) [Input format: SP or SPMC (default = SPMC)]" << std::endl
+              << std::endl;
+
+    return false;
+}
+
+} // namespace lar_nd_converter
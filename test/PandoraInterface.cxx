@@ -6,15 +6,11 @@
  *  $Log: $
  */
 
+#include "TChain.h"
 #include "TFile.h"
+#include "TROOT.h"
 #include "TTree.h"
 
-#include "TGeoBBox.h"
-#include "TGeoManager.h"
-#include "TGeoMatrix.h"
-#include "TGeoShape.h"
-#include "TGeoVolume.h"
-
 #ifdef USE_EDEPSIM
 #include "TG4PrimaryVertex.h"
 #endif
@@ -38,9 +34,16 @@
 #include "larpandoradlcontent/LArDLContent.h"
 #endif
 
+#include "HierarchyAnalysisAlgorithm.h"
+#include "LArAlgorithmProfiler.h"
+#include "LArEventTimeBudget.h"
+#include "LArNDCaloHitFactory.h"
 #include "LArNDContent.h"
 #include "LArNDGeomSimple.h"
-#include "LArRay.h"
+#include "LArNDGeometryCache.h"
+#include "LArNDHitCache.h"
+#include "LArNDInputFiles.h"
+#include "MasterThreeDAlgorithm.h"
 #include "PandoraInterface.h"
 
 #ifdef MONITORING
@@ -48,12 +51,20 @@
 #endif
 
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <cstdio>
+#include <exception>
 #include <getopt.h>
 #include <iostream>
+#include <map>
 #include <memory>
 #include <random>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 using namespace pandora;
@@ -62,45 +73,89 @@ using namespace lar_nd_reco;
 int main(int argc, char *argv[])
 {
     int errorNo(0);
-    const Pandora *pPrimaryPandora(nullptr);
+    Parameters parameters;
+    std::vector<const Pandora *> primaryPandoraInstances;
+    std::vector<EventSubset> eventSubsets;
+    std::string analysisFileName, analysisTreeName;
+    bool mergeAnalysisOutput(false);
 
     try
     {
-        Parameters parameters;
-
         if (!ParseCommandLine(argc, argv, parameters))
             return 1;
 
+        if (!parameters.m_profileFileName.empty())
+            PANDORA_THROW_RESULT_IF(
+                STATUS_CODE_SUCCESS, !=, lar_content::AlgorithmProfiler::GetInstance().Enable(parameters.m_profileFileName));
+
 #ifdef MONITORING
         TApplication *pTApplication = new TApplication("LArReco", &argc, argv);
         pTApplication->SetReturnFromRun(kTRUE);
 #endif
 
-        pPrimaryPandora = new pandora::Pandora();
+        LArNDGeomSimple simpleGeom;
 
-        if (!pPrimaryPandora)
-            throw StatusCodeException(STATUS_CODE_FAILURE);
+        // ATTN Sized up front, as the hierarchy analysis of each instance follows the events recorded in its event subset
+        eventSubsets.resize(parameters.m_nPrimaryInstances);
+
+        // Several primary instances each read and reconstruct their own events, so ROOT must be told to expect concurrent use
+        if (parameters.m_nPrimaryInstances > 1)
+        {
+            ROOT::EnableThreadSafety();
+            mergeAnalysisOutput = GetAnalysisOutputNames(parameters.m_settingsFile, analysisFileName, analysisTreeName);
+        }
+
+        for (int instanceIndex = 0; instanceIndex < parameters.m_nPrimaryInstances; ++instanceIndex)
+        {
+            const Pandora *const pPrimaryPandora = new pandora::Pandora();
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPrimaryPandora));
+            if (!pPrimaryPandora)
+                throw StatusCodeException(STATUS_CODE_FAILURE);
+
+            primaryPandoraInstances.emplace_back(pPrimaryPandora);
+
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterAlgorithms(*pPrimaryPandora));
 #ifdef LIBTORCH_DL
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArDLContent::RegisterAlgorithms(*pPrimaryPandora));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArDLContent::RegisterAlgorithms(*pPrimaryPandora));
 #endif
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterBasicPlugins(*pPrimaryPandora));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArContent::RegisterBasicPlugins(*pPrimaryPandora));
 
-        if (parameters.m_use3D)
-            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArNDContent::RegisterAlgorithms(*pPrimaryPandora));
+            if (parameters.m_use3D)
+                PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, LArNDContent::RegisterAlgorithms(*pPrimaryPandora));
 
-        MultiPandoraApi::AddPrimaryPandoraInstance(pPrimaryPandora);
+            MultiPandoraApi::AddPrimaryPandoraInstance(pPrimaryPandora);
 
-        LArNDGeomSimple simpleGeom;
-        CreateGeometry(parameters, pPrimaryPandora, simpleGeom);
-        ProcessExternalParameters(parameters, pPrimaryPandora);
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPrimaryPandora, new lar_content::LArPseudoLayerPlugin));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=,
-            PandoraApi::SetLArTransformationPlugin(*pPrimaryPandora, new lar_content::LArRotationalTransformationPlugin));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ReadSettings(*pPrimaryPandora, parameters.m_settingsFile));
+            // Only the first instance reads the geometry file, the others copy its LArTPCs
+            if (0 == instanceIndex)
+                CreateGeometry(parameters, pPrimaryPandora, simpleGeom);
+            else
+                CopyGeometry(primaryPandoraInstances.front(), pPrimaryPandora);
 
-        ProcessEvents(parameters, pPrimaryPandora, simpleGeom);
+            ProcessExternalParameters(parameters, pPrimaryPandora);
+
+            // The hierarchy analysis needs to know which events are processed by this instance, and which files they are read from
+            if (mergeAnalysisOutput || (parameters.m_inputFileNames.size() > 1))
+            {
+                const std::string partFileName(mergeAnalysisOutput ? GetAnalysisPartFileName(analysisFileName, instanceIndex) : "");
+                ProcessInstanceParameters(partFileName, eventSubsets.at(instanceIndex), parameters, pPrimaryPandora);
+            }
+
+            PANDORA_THROW_RESULT_IF(
+                STATUS_CODE_SUCCESS, !=, PandoraApi::SetPseudoLayerPlugin(*pPrimaryPandora, new lar_content::LArPseudoLayerPlugin));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=,
+                PandoraApi::SetLArTransformationPlugin(*pPrimaryPandora, new lar_content::LArRotationalTransformationPlugin));
+            PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=,
+                lar_content::AlgorithmProfiler::GetInstance().ReadSettings(*pPrimaryPandora, parameters.m_settingsFile));
+        }
+
+        if (primaryPandoraInstances.size() > 1)
+        {
+            ProcessEventsConcurrently(parameters, primaryPandoraInstances, simpleGeom, eventSubsets);
+        }
+        else
+        {
+            ProcessEvents(parameters, primaryPandoraInstances.front(), simpleGeom, eventSubsets.front());
+        }
     }
     catch (const StatusCodeException &statusCodeException)
     {
@@ -113,7 +168,16 @@ int main(int argc, char *argv[])
         errorNo = 1;
     }
 
-    MultiPandoraApi::DeletePandoraInstances(pPrimaryPandora);
+    // Deleting the instances writes each analysis output file, so merging can only happen afterwards
+    for (const Pandora *const pPrimaryPandora : primaryPandoraInstances)
+        MultiPandoraApi::DeletePandoraInstances(pPrimaryPandora);
+
+    if ((0 == errorNo) && mergeAnalysisOutput)
+        MergeAnalysisOutput(analysisFileName, analysisTreeName, eventSubsets);
+
+    // The worker instances are deleted along with their primary instances, so every algorithm has now been profiled
+    lar_content::AlgorithmProfiler::GetInstance().Finish();
+
     return errorNo;
 }
 
@@ -124,115 +188,39 @@ namespace lar_nd_reco
 
 void CreateGeometry(const Parameters &parameters, const Pandora *const pPrimaryPandora, LArNDGeomSimple &geom)
 {
-    // Get the geometry info from the appropriate ROOT file
-    TFile *fileSource = TFile::Open(parameters.m_geomFileName.c_str(), "READ");
-    if (!fileSource)
-    {
-        std::cout << "Error in CreateGeometry(): can't open file " << parameters.m_geomFileName << std::endl;
-        return;
-    }
-
-    TGeoManager *pSimGeom = dynamic_cast<TGeoManager *>(fileSource->Get(parameters.m_geomManagerName.c_str()));
-    if (!pSimGeom)
-    {
-        std::cout << "Could not find the geometry manager named " << parameters.m_geomManagerName << std::endl;
-        fileSource->Close();
-        return;
-    }
-
-    // Go through the geometry and find the paths to the nodes we are interested in
-    std::vector<std::vector<unsigned int>> nodePaths; // Store the daughter indices in the path to the node
-    std::vector<unsigned int> currentPath;
+    // Find the TPC volumes from the geometry cache, or otherwise from the appropriate ROOT file
     const std::string nameToFind = parameters.m_useModularGeometry ? parameters.m_sensitiveDetName : parameters.m_geometryVolName;
-    RecursiveGeometrySearch(pSimGeom, nameToFind, nodePaths, currentPath);
-    std::cout << "Found " << nodePaths.size() << " matches for volumes containing the name " << nameToFind << std::endl;
-
-    // Navigate to each node and use them to build the pandora geometry
-    for (unsigned int n = 0; n < nodePaths.size(); ++n)
-    {
-        const TGeoNode *pTopNode = pSimGeom->GetCurrentNode();
-        // We have to multiply together matrices at each depth to convert local coordinates to the world volume
-        std::unique_ptr<TGeoHMatrix> pVolMatrix = std::make_unique<TGeoHMatrix>(*pTopNode->GetMatrix());
-        for (unsigned int d = 0; d < nodePaths.at(n).size(); ++d)
-        {
-            pSimGeom->CdDown(nodePaths.at(n).at(d));
-            const TGeoNode *pNode = pSimGeom->GetCurrentNode();
-            std::unique_ptr<TGeoHMatrix> pMatrix = std::make_unique<TGeoHMatrix>(*pNode->GetMatrix());
-            pVolMatrix->Multiply(pMatrix.get());
-        }
-        const TGeoNode *pTargetNode = pSimGeom->GetCurrentNode();
-
-        MakePandoraTPC(pPrimaryPandora, parameters, geom, pVolMatrix, pTargetNode, n);
-
-        for (const unsigned int &daughter : nodePaths.at(n))
-        {
-            (void)daughter;
-            pSimGeom->CdUp();
-        }
-    }
-    std::cout << "Created " << nodePaths.size() << " TPCs" << std::endl;
+    LArNDGeometryCache geometryCache(parameters.m_geomFileName, parameters.m_geomManagerName, nameToFind);
 
-    fileSource->Close();
-}
+    if (!geometryCache.Load(parameters.m_geomCacheFileName))
+        return;
 
-//------------------------------------------------------------------------------------------------------------------------------------------
+    // Use the TPC volumes to build the pandora geometry
+    for (const LArNDTPCBox &tpcBox : geometryCache.GetTPCBoxes())
+        MakePandoraTPC(pPrimaryPandora, parameters, geom, tpcBox);
 
-void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetName, std::vector<std::vector<unsigned int>> &nodePaths,
-    std::vector<unsigned int> &currentPath)
-{
-    const std::string nodeName{pSimGeom->GetCurrentNode()->GetName()};
-    if (nodeName.find(targetName) != std::string::npos)
-    {
-        nodePaths.emplace_back(currentPath);
-    }
-    else
-    {
-        for (unsigned int i = 0; i < pSimGeom->GetCurrentNode()->GetNdaughters(); ++i)
-        {
-            pSimGeom->CdDown(i);
-            currentPath.emplace_back(i);
-            RecursiveGeometrySearch(pSimGeom, targetName, nodePaths, currentPath);
-            pSimGeom->CdUp();
-            currentPath.pop_back();
-        }
-    }
-    return;
+    std::cout << "Created " << geometryCache.GetTPCBoxes().size() << " TPCs" << std::endl;
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom,
-    const std::unique_ptr<TGeoHMatrix> &pVolMatrix, const TGeoNode *pTargetNode, const unsigned int tpcNumber)
+void MakePandoraTPC(
+    const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, LArNDGeomSimple &geom, const LArNDTPCBox &tpcBox)
 {
-    // Get the BBox dimensions from the placement volume, which is assumed to be a cube
-    TGeoVolume *pCurrentVol = pTargetNode->GetVolume();
-    TGeoShape *pCurrentShape = pCurrentVol->GetShape();
-    // pCurrentShape->InspectShape();
-    TGeoBBox *pBox = dynamic_cast<TGeoBBox *>(pCurrentShape);
-
-    // Now can get origin/width data from the BBox
-    const double dx = pBox->GetDX() * parameters.m_lengthScale; // Note these are the half widths
-    const double dy = pBox->GetDY() * parameters.m_lengthScale;
-    const double dz = pBox->GetDZ() * parameters.m_lengthScale;
-    const double *pOrigin = pBox->GetOrigin();
-
-    // std::cout << "Origin = (" << pOrigin[0] << ", " << pOrigin[1] << ", " << pOrigin[2] << ")" << std::endl;
-
-    // Translate local origin to global coordinates
-    double level1[3] = {0.0, 0.0, 0.0};
-    pTargetNode->LocalToMasterVect(pOrigin, level1);
-
-    // std::cout << "Level1 = (" << level1[0] << ", " << level1[1] << ", " << level1[2] << ")" << std::endl;
+    // The box half widths and centre in the world volume were found from the placement volume BBox, which is assumed to be a cube
+    const unsigned int tpcNumber = tpcBox.m_tpcID;
+    const double dx = tpcBox.m_halfWidthX * parameters.m_lengthScale; // Note these are the half widths
+    const double dy = tpcBox.m_halfWidthY * parameters.m_lengthScale;
+    const double dz = tpcBox.m_halfWidthZ * parameters.m_lengthScale;
 
     // Can now create a geometry using the found parameters
     PandoraApi::Geometry::LArTPC::Parameters geoparameters;
 
     try
     {
-        const double *pVolTrans = pVolMatrix->GetTranslation();
-        const double centreX = (level1[0] + pVolTrans[0]) * parameters.m_lengthScale;
-        const double centreY = (level1[1] + pVolTrans[1]) * parameters.m_lengthScale;
-        const double centreZ = (level1[2] + pVolTrans[2]) * parameters.m_lengthScale;
+        const double centreX = tpcBox.m_centreX * parameters.m_lengthScale;
+        const double centreY = tpcBox.m_centreY * parameters.m_lengthScale;
+        const double centreZ = tpcBox.m_centreZ * parameters.m_lengthScale;
         geoparameters.m_centerX = centreX;
         geoparameters.m_centerY = centreY;
         geoparameters.m_centerZ = centreZ;
@@ -275,54 +263,440 @@ void MakePandoraTPC(const pandora::Pandora *const pPrimaryPandora, const Paramet
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void ProcessEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
+void CopyGeometry(const Pandora *const pSourcePandora, const Pandora *const pTargetPandora)
+{
+    for (const auto &mapEntry : pSourcePandora->GetGeometry()->GetLArTPCMap())
+    {
+        const LArTPC *const pLArTPC(mapEntry.second);
+
+        PandoraApi::Geometry::LArTPC::Parameters larTPCParameters;
+        larTPCParameters.m_larTPCVolumeId = pLArTPC->GetLArTPCVolumeId();
+        larTPCParameters.m_centerX = pLArTPC->GetCenterX();
+        larTPCParameters.m_centerY = pLArTPC->GetCenterY();
+        larTPCParameters.m_centerZ = pLArTPC->GetCenterZ();
+        larTPCParameters.m_widthX = pLArTPC->GetWidthX();
+        larTPCParameters.m_widthY = pLArTPC->GetWidthY();
+        larTPCParameters.m_widthZ = pLArTPC->GetWidthZ();
+        larTPCParameters.m_wirePitchU = pLArTPC->GetWirePitchU();
+        larTPCParameters.m_wirePitchV = pLArTPC->GetWirePitchV();
+        larTPCParameters.m_wirePitchW = pLArTPC->GetWirePitchW();
+        larTPCParameters.m_wireAngleU = pLArTPC->GetWireAngleU();
+        larTPCParameters.m_wireAngleV = pLArTPC->GetWireAngleV();
+        larTPCParameters.m_wireAngleW = pLArTPC->GetWireAngleW();
+        larTPCParameters.m_sigmaUVW = pLArTPC->GetSigmaUVW();
+        larTPCParameters.m_isDriftInPositiveX = pLArTPC->IsDriftInPositiveX();
+        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Geometry::LArTPC::Create(*pTargetPandora, larTPCParameters));
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ProcessEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset)
 {
     if (parameters.m_dataFormat == Parameters::LArNDFormat::EDepSim)
     {
 #ifdef USE_EDEPSIM
-        ProcessEDepSimEvents(parameters, pPrimaryPandora, geom);
+        ProcessEDepSimEvents(parameters, pPrimaryPandora, geom, eventSubset);
 #endif
     }
     else if (parameters.m_dataFormat == Parameters::LArNDFormat::SED)
     {
-        ProcessSEDEvents(parameters, pPrimaryPandora, geom);
+        ProcessSEDEvents(parameters, pPrimaryPandora, geom, eventSubset);
     }
     else
     {
-        ProcessSPEvents(parameters, pPrimaryPandora, geom);
+        ProcessSPEvents(parameters, pPrimaryPandora, geom, eventSubset);
     }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
+void ProcessPandoraEvent(const Parameters &parameters, const Pandora *const pPrimaryPandora, const int iEvt, EventSubset &eventSubset)
 {
+    InstanceStartupGate *const pStartupGate(eventSubset.m_processedEvents.empty() ? eventSubset.m_pStartupGate : nullptr);
+
+    if (pStartupGate)
+        pStartupGate->EnterFirstEvent();
 
-    TFile *fileSource = TFile::Open(parameters.m_inputFileName.c_str(), "READ");
-    if (!fileSource)
+    eventSubset.m_processedEvents.emplace_back(iEvt);
+    lar_content::EventTimeBudget::GetInstance(*pPrimaryPandora).StartEvent(1000. * parameters.m_eventTimeBudget);
+
+    if (!pStartupGate)
     {
-        std::cout << "Error in ProcessSPEvents(): can't open file " << parameters.m_inputFileName << std::endl;
+        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
         return;
     }
 
-    TTree *ndsptree = dynamic_cast<TTree *>(fileSource->Get(parameters.m_inputTreeName.c_str()));
-    if (!ndsptree)
+    StatusCode statusCode(STATUS_CODE_FAILURE);
+
+    try
+    {
+        statusCode = PandoraApi::ProcessEvent(*pPrimaryPandora);
+    }
+    catch (...)
+    {
+        pStartupGate->LeaveFirstEvent();
+        throw;
+    }
+
+    pStartupGate->LeaveFirstEvent();
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, statusCode);
+
+    // ATTN No instance moves on to its next event until every worker instance has been created
+    pStartupGate->WaitForFirstEvents();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ProcessEventsConcurrently(const Parameters &parameters, const std::vector<const Pandora *> &primaryPandoraInstances,
+    const LArNDGeomSimple &geom, std::vector<EventSubset> &eventSubsets)
+{
+    // The instances claim the input events from a shared counter as they become free, so a slow event holds up only its own instance.
+    // Each instance reads the events it claims from its own input chain, and the analysis output is merged back into input order
+    const int nInstances(primaryPandoraInstances.size());
+
+    if (static_cast<int>(eventSubsets.size()) != nInstances)
+        throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
+
+    std::atomic<int> nextEventOffset(0);
+    std::vector<std::exception_ptr> exceptions(nInstances);
+    std::vector<std::thread> threads;
+    InstanceStartupGate startupGate(nInstances);
+
+    try
+    {
+        for (int instanceIndex = 0; instanceIndex < nInstances; ++instanceIndex)
+        {
+            EventSubset &eventSubset(eventSubsets.at(instanceIndex));
+            eventSubset.m_pNextEventOffset = &nextEventOffset;
+            eventSubset.m_pStartupGate = &startupGate;
+
+            threads.emplace_back(
+                [&, instanceIndex]()
+                {
+                    try
+                    {
+                        ProcessEvents(parameters, primaryPandoraInstances.at(instanceIndex), geom, eventSubset);
+                    }
+                    catch (...)
+                    {
+                        exceptions.at(instanceIndex) = std::current_exception();
+                    }
+
+                    // An instance that never reached its first event must not hold up the others
+                    if (eventSubset.m_processedEvents.empty())
+                        startupGate.Withdraw();
+                });
+        }
+    }
+    catch (const std::system_error &)
+    {
+        std::cout << "ProcessEventsConcurrently - unable to start a thread for each of the " << nInstances << " primary instances"
+                  << std::endl;
+
+        for (std::size_t instanceIndex = threads.size(); instanceIndex < static_cast<std::size_t>(nInstances); ++instanceIndex)
+            startupGate.Withdraw();
+
+        for (std::thread &thread : threads)
+            thread.join();
+
+        throw StatusCodeException(STATUS_CODE_FAILURE);
+    }
+
+    for (std::thread &thread : threads)
+        thread.join();
+
+    for (const std::exception_ptr &pException : exceptions)
+    {
+        if (pException)
+            std::rethrow_exception(pException);
+    }
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+InstanceStartupGate::InstanceStartupGate(const int nInstances) :
+    m_nPendingInstances(nInstances),
+    m_isFirstEventRunning(false)
+{
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void InstanceStartupGate::EnterFirstEvent()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_conditionVariable.wait(lock, [this]() { return !m_isFirstEventRunning; });
+    m_isFirstEventRunning = true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void InstanceStartupGate::LeaveFirstEvent()
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        m_isFirstEventRunning = false;
+        --m_nPendingInstances;
+    }
+
+    m_conditionVariable.notify_all();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void InstanceStartupGate::Withdraw()
+{
+    {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        --m_nPendingInstances;
+    }
+
+    m_conditionVariable.notify_all();
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void InstanceStartupGate::WaitForFirstEvents()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_conditionVariable.wait(lock, [this]() { return m_nPendingInstances <= 0; });
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool GetAnalysisOutputNames(const std::string &settingsFile, std::string &analysisFileName, std::string &analysisTreeName)
+{
+    TiXmlDocument xmlDocument(settingsFile);
+
+    if (!xmlDocument.LoadFile())
     {
-        std::cout << "Could not find the event tree " << parameters.m_inputTreeName << std::endl;
-        fileSource->Close();
+        std::cout << "GetAnalysisOutputNames - invalid xml file " << settingsFile << std::endl;
+        throw StatusCodeException(STATUS_CODE_INVALID_PARAMETER);
+    }
+
+    const TiXmlHandle xmlDocumentHandle(&xmlDocument);
+    TiXmlElement *pXmlElement(xmlDocumentHandle.FirstChildElement().FirstChildElement("algorithm").Element());
+
+    for (; pXmlElement; pXmlElement = pXmlElement->NextSiblingElement("algorithm"))
+    {
+        const char *const pAlgorithmType(pXmlElement->Attribute("type"));
+
+        if (!pAlgorithmType || (std::string(pAlgorithmType) != "LArHierarchyAnalysis"))
+            continue;
+
+        // Defaults match those of the hierarchy analysis algorithm
+        analysisFileName = "LArRecoND.root";
+        analysisTreeName = "LArRecoND";
+
+        const TiXmlHandle algorithmHandle(pXmlElement);
+        PANDORA_THROW_RESULT_IF_AND_IF(
+            STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(algorithmHandle, "AnalysisFileName", analysisFileName));
+        PANDORA_THROW_RESULT_IF_AND_IF(
+            STATUS_CODE_SUCCESS, STATUS_CODE_NOT_FOUND, !=, XmlHelper::ReadValue(algorithmHandle, "AnalysisTreeName", analysisTreeName));
+        return true;
+    }
+
+    return false;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::string GetAnalysisPartFileName(const std::string &analysisFileName, const int instanceIndex)
+{
+    const std::string partSuffix("_part" + std::to_string(instanceIndex));
+    const size_t extensionPosition(analysisFileName.rfind(".root"));
+
+    if (std::string::npos == extensionPosition)
+        return analysisFileName + partSuffix;
+
+    return analysisFileName.substr(0, extensionPosition) + partSuffix + analysisFileName.substr(extensionPosition);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MergeAnalysisOutput(
+    const std::string &analysisFileName, const std::string &analysisTreeName, const std::vector<EventSubset> &eventSubsets)
+{
+    // Each part file holds one entry per event processed by its instance, in that instance's input order
+    TChain partChain(analysisTreeName.c_str());
+    std::vector<std::pair<int, Long64_t>> inputEventToChainEntry;
+    std::vector<std::string> partFileNames;
+    Long64_t nChainEntries(0);
+
+    for (size_t instanceIndex = 0; instanceIndex < eventSubsets.size(); ++instanceIndex)
+    {
+        const std::vector<int> &processedEvents(eventSubsets.at(instanceIndex).m_processedEvents);
+
+        if (processedEvents.empty())
+            continue;
+
+        const std::string partFileName(GetAnalysisPartFileName(analysisFileName, instanceIndex));
+        std::unique_ptr<TFile> pPartFile(TFile::Open(partFileName.c_str(), "READ"));
+        const TTree *const pPartTree(pPartFile ? dynamic_cast<TTree *>(pPartFile->Get(analysisTreeName.c_str())) : nullptr);
+        const Long64_t nPartEntries(pPartTree ? pPartTree->GetEntries() : 0);
+
+        if (nPartEntries != static_cast<Long64_t>(processedEvents.size()))
+        {
+            std::cout << "MergeAnalysisOutput - " << partFileName << " has " << nPartEntries << " entries for " << processedEvents.size()
+                      << " events, leaving the per-instance analysis files unmerged" << std::endl;
+            return;
+        }
+
+        for (size_t i = 0; i < processedEvents.size(); ++i)
+            inputEventToChainEntry.emplace_back(processedEvents.at(i), nChainEntries + i);
+
+        partChain.Add(partFileName.c_str());
+        nChainEntries += nPartEntries;
+        partFileNames.emplace_back(partFileName);
+    }
+
+    if (inputEventToChainEntry.empty())
+        return;
+
+    std::sort(inputEventToChainEntry.begin(), inputEventToChainEntry.end());
+
+    std::unique_ptr<TFile> pOutputFile(TFile::Open(analysisFileName.c_str(), "RECREATE"));
+
+    if (!pOutputFile || pOutputFile->IsZombie())
+    {
+        std::cout << "MergeAnalysisOutput - can't create file " << analysisFileName << ", leaving the per-instance analysis files unmerged"
+                  << std::endl;
         return;
     }
 
-    std::unique_ptr<LArSP> larsp =
-        parameters.m_dataFormat == Parameters::LArNDFormat::SPMC ? std::make_unique<LArSPMC>(ndsptree) : std::make_unique<LArSP>(ndsptree);
+    TTree *const pOutputTree(partChain.CloneTree(0));
+
+    for (const auto &[inputEvent, chainEntry] : inputEventToChainEntry)
+    {
+        (void)inputEvent;
+        partChain.GetEntry(chainEntry);
+        pOutputTree->Fill();
+    }
+
+    pOutputFile->cd();
+    pOutputTree->Write();
+    pOutputFile->Close();
+
+    for (const std::string &partFileName : partFileNames)
+        std::remove(partFileName.c_str());
+
+    std::cout << "Merged " << inputEventToChainEntry.size() << " events from " << partFileNames.size() << " primary instances into "
+              << analysisFileName << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+std::unique_ptr<TChain> MakeInputChain(const Parameters &parameters)
+{
+    return MakeInputChain(parameters.m_inputTreeName, parameters.m_inputFileNames, parameters.m_inputCacheSize);
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void PrintInputEvent(TChain *const pInputChain, const int iEvt)
+{
+    const Long64_t localEntry(pInputChain->LoadTree(iEvt));
+    const TFile *const pCurrentFile(pInputChain->GetCurrentFile());
+
+    std::cout << std::endl
+              << "   PROCESSING EVENT: " << iEvt << " (entry " << localEntry << " of " << (pCurrentFile ? pCurrentFile->GetName() : "?")
+              << ")" << std::endl
+              << std::endl;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool OpenHitCache(const Parameters &parameters, TChain *const pInputChain, LArNDHitCache &hitCache)
+{
+    if (!hitCache.Open(parameters.m_hitCacheFileName))
+        return false;
+
+    // Event numbers repeat across input files, so the cache must have been converted from the same files, read in the same order.
+    // Only the file names are compared, not their directories, so the input files can be read from another location
+    std::vector<std::string> inputFileNames;
+    std::vector<std::uint64_t> nInputFileEntries;
+    GetInputFileEntries(*pInputChain, inputFileNames, nInputFileEntries);
+
+    const std::vector<std::string> &sourceFileNames(hitCache.GetSourceFileNames());
+    const std::vector<std::uint64_t> &nSourceFileEntries(hitCache.GetNSourceFileEntries());
+
+    if (inputFileNames.size() != sourceFileNames.size())
+    {
+        std::cout << "Error in OpenHitCache(): the hit cache " << parameters.m_hitCacheFileName << " was converted from "
+                  << sourceFileNames.size() << " files, but there are " << inputFileNames.size() << " input files" << std::endl;
+        return false;
+    }
+
+    const auto getBaseName = [](const std::string &fileName) { return fileName.substr(fileName.find_last_of('/') + 1); };
+
+    for (size_t iFile = 0; iFile < inputFileNames.size(); ++iFile)
+    {
+        if ((getBaseName(inputFileNames[iFile]) != getBaseName(sourceFileNames[iFile])) ||
+            (nInputFileEntries[iFile] != nSourceFileEntries[iFile]))
+        {
+            std::cout << "Error in OpenHitCache(): input file " << iFile << " is " << inputFileNames[iFile] << " with "
+                      << nInputFileEntries[iFile] << " events, but the hit cache " << parameters.m_hitCacheFileName
+                      << " was converted from " << sourceFileNames[iFile] << " with " << nSourceFileEntries[iFile] << " events"
+                      << std::endl;
+            return false;
+        }
+    }
+
+    const bool isSPMC(parameters.m_dataFormat == Parameters::LArNDFormat::SPMC);
+
+    if (isSPMC && !hitCache.HasMCTruth())
+    {
+        std::cout << "Error in OpenHitCache(): the hit cache " << parameters.m_hitCacheFileName << " has no MC truth, so can't be used "
+                  << "with the SPMC format" << std::endl;
+        return false;
+    }
+
+    // The event header and MC particle branches are still read from the input chain, to check and complete each cached event
+    for (const char *const branchName : {"x", "y", "z", "ts", "charge", "E"})
+        pInputChain->SetBranchStatus(branchName, 0);
+
+    if (isSPMC)
+    {
+        pInputChain->SetBranchStatus("hit_particleID", 0);
+        pInputChain->SetBranchStatus("hit_packetFrac", 0);
+    }
+
+    std::cout << "Reading the hits of " << hitCache.GetNEvents() << " events from the hit cache " << parameters.m_hitCacheFileName
+              << std::endl;
 
-    // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset)
+{
 
-    // Voxel width
+    std::unique_ptr<TChain> ndsptree(MakeInputChain(parameters));
+    if (!ndsptree)
+        return;
+
+    std::unique_ptr<LArSP> larsp = parameters.m_dataFormat == Parameters::LArNDFormat::SPMC ? std::make_unique<LArSPMC>(ndsptree.get())
+                                                                                          : std::make_unique<LArSP>(ndsptree.get());
+
+    // Pre-decoded hits, read in place from the memory-mapped cache instead of being decompressed from the input files
+    LArNDHitCache hitCache;
+    const bool useHitCache(!parameters.m_hitCacheFileName.empty());
+
+    if (useHitCache && !OpenHitCache(parameters, ndsptree.get(), hitCache))
+        return;
+
+    // Factory for creating LArCaloHits, recycling their memory from one event to the next
+    LArNDCaloHitFactory caloHitFactory;
+
+    // Voxel width, and the grid used to merge the space points of oversized events
     const float voxelWidth(parameters.m_voxelWidth);
+    const LArGrid grid = parameters.m_useModularGeometry ? MakeVoxelisationGrid(geom, parameters) : MakeVoxelisationGrid(pPrimaryPandora, parameters);
 
-    // Total number of entries in the TTree
+    // Total number of entries in the input files
     const int nEntries(ndsptree->GetEntries());
 
     // Starting event
@@ -334,16 +708,24 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    for (int iEvt = eventSubset.GetNextEvent(startEvt, startEvt - 1); iEvt < endEvt; iEvt = eventSubset.GetNextEvent(startEvt, iEvt))
     {
         if (parameters.m_shouldDisplayEventNumber)
-            std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
+            PrintInputEvent(ndsptree.get(), iEvt);
 
         ndsptree->GetEntry(iEvt);
+        const LArNDHitCacheEvent cachedHits(useHitCache ? hitCache.GetEvent(iEvt) : LArNDHitCacheEvent());
 
-        // Stop processing the event if we have too many space points: reco takes too long
-        const int nSP = larsp->m_x->size();
-        if (parameters.m_maxMergedVoxels > 0 && nSP > parameters.m_maxMergedVoxels)
+        if (useHitCache && (cachedHits.m_eventNumber != larsp->m_event))
+        {
+            std::cout << "Error in ProcessSPEvents(): hit cache event " << cachedHits.m_eventNumber << " does not match input event "
+                      << larsp->m_event << " for entry " << iEvt << std::endl;
+            throw StatusCodeException(STATUS_CODE_FAILURE);
+        }
+
+        // Stop processing the event if we have too many space points and cannot coarsen it: reco takes too long
+        const int nSP = useHitCache ? cachedHits.m_nHits : larsp->m_x->size();
+        if (parameters.m_maxMergedVoxels > 0 && nSP > parameters.m_maxMergedVoxels && parameters.m_maxVoxelCoarsening < 2)
         {
             std::cout << "SKIPPING EVENT: number of space points " << nSP << " > " << parameters.m_maxMergedVoxels << std::endl;
             continue;
@@ -355,22 +737,16 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
             continue;
         }
 
-        // Some truth information first
-        if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-        {
-            LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
-            CreateSPMCParticles(*larspmc, pPrimaryPandora, parameters);
-        }
-
-        int hitCounter(0);
+        LArSpacePointList spacePoints;
+        spacePoints.reserve(nSP);
 
-        // Loop over the space points and make them into caloHits
+        // Loop over the space points and find their positions, energies and main true particles
         for (size_t isp = 0; isp < nSP; ++isp)
         {
-            const float voxelX = (*larsp->m_x)[isp];
-            const float voxelY = (*larsp->m_y)[isp];
-            const float voxelZ = (*larsp->m_z)[isp];
-            const float voxelE = (*larsp->m_charge)[isp];
+            const float voxelX = useHitCache ? cachedHits.m_x[isp] : (*larsp->m_x)[isp];
+            const float voxelY = useHitCache ? cachedHits.m_y[isp] : (*larsp->m_y)[isp];
+            const float voxelZ = useHitCache ? cachedHits.m_z[isp] : (*larsp->m_z)[isp];
+            const float voxelE = useHitCache ? cachedHits.m_charge[isp] : (*larsp->m_charge)[isp];
 
             // Skip this hit if its coordinates or energy are NaNs
             if (std::isnan(voxelX) || std::isnan(voxelY) || std::isnan(voxelZ) || std::isnan(voxelE))
@@ -381,116 +757,222 @@ void ProcessSPEvents(const Parameters &parameters, const Pandora *const pPrimary
             }
 
             const pandora::CartesianVector voxelPos(voxelX, voxelY, voxelZ);
-            const float MipE{0.00075};
-            const float voxelMipEquivalentE = voxelE / MipE;
             const int tpcID(geom.GetTPCNumber(voxelPos));
-            lar_content::LArCaloHitParameters caloHitParameters;
-            caloHitParameters.m_positionVector = voxelPos;
-            caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
-            caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
-            caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
-            caloHitParameters.m_cellSize0 = voxelWidth;
-            caloHitParameters.m_cellSize1 = voxelWidth;
-            caloHitParameters.m_cellThickness = voxelWidth;
-            caloHitParameters.m_nCellRadiationLengths = 1.f;
-            caloHitParameters.m_nCellInteractionLengths = 1.f;
-            caloHitParameters.m_time = 0.f;
-            caloHitParameters.m_inputEnergy = voxelE;
-            caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
-            caloHitParameters.m_electromagneticEnergy = voxelE;
-            caloHitParameters.m_hadronicEnergy = voxelE;
-            caloHitParameters.m_isDigital = false;
-            caloHitParameters.m_hitType = pandora::TPC_3D;
-            caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
-            caloHitParameters.m_layer = 0;
-            caloHitParameters.m_isInOuterSamplingLayer = false;
-            caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
-            caloHitParameters.m_larTPCVolumeId = tpcID < 0 ? 0 : tpcID;
-            caloHitParameters.m_daughterVolumeId = 0;
 
             // Only used for truth
+            bool hasMCContribution{false};
             long trackID{0};
             float energyFrac{0.f};
+
             // Set calo hit to MCParticle relation using trackID
             if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
             {
                 LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
-                const std::vector<float> mcContribs = (*larspmc->m_hit_packetFrac)[isp];
-                const int biggestContribIndex = std::distance(mcContribs.begin(), std::max_element(mcContribs.begin(), mcContribs.end()));
-                const std::vector<long> hitPartIDVect = (*larspmc->m_hit_particleID)[isp];
-                trackID = (hitPartIDVect.size() > biggestContribIndex) ? hitPartIDVect[biggestContribIndex] : 0;
-
-                // Due to the merging of hits, the contributions can sometimes add up to more than 1.
-                // Normalise first
-                const float sum = std::accumulate(mcContribs.begin(), mcContribs.end(), 0.f);
-                energyFrac = (biggestContribIndex < mcContribs.size() && std::abs(sum) > 0.0) ? mcContribs[biggestContribIndex] / sum : 0.f;
-                // Make sure the energy fraction is not larger than 1
-                if (energyFrac > 1.f + std::numeric_limits<float>::epsilon())
-                    energyFrac = 1.f;
-
-                if (std::find(larspmc->m_mcp_id->begin(), larspmc->m_mcp_id->end(), trackID) == larspmc->m_mcp_id->end())
+
+                if (useHitCache)
+                {
+                    hasMCContribution = cachedHits.m_hasMCContribution[isp];
+                    trackID = cachedHits.m_trackID[isp];
+                    energyFrac = cachedHits.m_energyFrac[isp];
+                }
+                else
+                {
+                    larspmc->GetDominantContribution(isp, hasMCContribution, trackID, energyFrac);
+                }
+
+                // Hits without any contributions, such as noise, have no MC particle to find
+                if (hasMCContribution &&
+                    std::find(larspmc->m_mcp_id->begin(), larspmc->m_mcp_id->end(), trackID) == larspmc->m_mcp_id->end())
                     std::cout << "Problem? Could not find MC particle with file ID " << trackID << std::endl;
             }
 
-            if (parameters.m_use3D)
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
+            spacePoints.emplace_back(voxelPos, voxelE, tpcID < 0 ? 0 : tpcID, hasMCContribution, trackID, energyFrac);
+        }
 
-            if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+        // Merge the space points in increasingly coarse voxels until there are few enough of them
+        int coarsening(1);
+        LArSpacePointList mergedSpacePoints;
+        const LArSpacePointList *pEventSpacePoints(&spacePoints);
 
-            if (parameters.m_useLArTPC)
+        while ((parameters.m_maxMergedVoxels > 0) && (pEventSpacePoints->size() > parameters.m_maxMergedVoxels) &&
+            (2 * coarsening <= parameters.m_maxVoxelCoarsening))
+        {
+            coarsening *= 2;
+            mergedSpacePoints = MergeSpacePoints(spacePoints, grid.GetCoarseGrid(coarsening));
+            pEventSpacePoints = &mergedSpacePoints;
+            std::cout << "Merged " << spacePoints.size() << " space points into " << mergedSpacePoints.size() << " voxels of width "
+                      << coarsening * voxelWidth << " cm" << std::endl;
+        }
+
+        if ((parameters.m_maxMergedVoxels > 0) && (pEventSpacePoints->size() > parameters.m_maxMergedVoxels))
+        {
+            std::cout << "SKIPPING EVENT: number of space points " << pEventSpacePoints->size() << " > " << parameters.m_maxMergedVoxels
+                      << " with voxel width " << coarsening * voxelWidth << " cm" << std::endl;
+            continue;
+        }
+
+        // Some truth information first
+        if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
+        {
+            LArSPMC *larspmc = dynamic_cast<LArSPMC *>(larsp.get());
+            CreateSPMCParticles(*larspmc, pPrimaryPandora, parameters);
+        }
+
+        int hitCounter(0);
+        MakeCaloHitsFromSpacePoints(*pEventSpacePoints, coarsening * voxelWidth, pPrimaryPandora, caloHitFactory, parameters, hitCounter);
+
+        ProcessPandoraEvent(parameters, pPrimaryPandora, iEvt, eventSubset);
+        ResetEvent(parameters, pPrimaryPandora, caloHitFactory);
+    } // end event loop
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+LArSpacePointList MergeSpacePoints(const LArSpacePointList &spacePoints, const LArGrid &grid)
+{
+    LArSpacePointList mergedSpacePoints;
+    std::unordered_map<long, std::size_t> voxelIndexMap;
+    std::vector<std::map<long, float>> trackEnergyMaps;
+
+    for (const LArSpacePoint &spacePoint : spacePoints)
+    {
+        const LongBin4Array gridBins(grid.GetBinIndices(spacePoint.m_position));
+        const auto iter(voxelIndexMap.find(gridBins[3]));
+        const std::size_t index(voxelIndexMap.end() == iter ? mergedSpacePoints.size() : iter->second);
+
+        // Place each merged space point at the centre of its voxel, keeping the tpc of the first space point
+        if (voxelIndexMap.end() == iter)
+        {
+            voxelIndexMap.emplace(gridBins[3], index);
+            mergedSpacePoints.emplace_back(grid.GetPoint(gridBins) + grid.m_binWidths * 0.5f, 0.f, spacePoint.m_tpcID, false, 0, 0.f);
+            trackEnergyMaps.emplace_back();
+        }
+
+        LArSpacePoint &mergedSpacePoint(mergedSpacePoints[index]);
+        mergedSpacePoint.m_energy += spacePoint.m_energy;
+
+        if (spacePoint.m_hasMCContribution)
+        {
+            mergedSpacePoint.m_hasMCContribution = true;
+            trackEnergyMaps[index][spacePoint.m_trackID] += spacePoint.m_energy * spacePoint.m_energyFrac;
+        }
+    }
+
+    // Choose the true particle with the highest energy, preferring the lowest ID for equal energies
+    for (std::size_t index = 0; index < mergedSpacePoints.size(); ++index)
+    {
+        LArSpacePoint &mergedSpacePoint(mergedSpacePoints[index]);
+        float highestEnergy{-1.f};
+
+        for (const auto &trackEnergy : trackEnergyMaps[index])
+        {
+            if (trackEnergy.second > highestEnergy)
             {
-                // Create LArCaloHits for U, V and W views assuming x is the common drift coordinate
-                const float x0_cm(voxelPos.GetX());
-                const float y0_cm(voxelPos.GetY());
-                const float z0_cm(voxelPos.GetZ());
-
-                // U view
-                lar_content::LArCaloHitParameters caloHitPars_UView(caloHitParameters);
-                caloHitPars_UView.m_hitType = pandora::TPC_VIEW_U;
-                caloHitPars_UView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float upos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(y0_cm, z0_cm));
-                caloHitPars_UView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, upos_cm);
-
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_UView, m_larCaloHitFactory));
-                if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                    PandoraApi::SetCaloHitToMCParticleRelationship(
-                        *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-
-                // V view
-                lar_content::LArCaloHitParameters caloHitPars_VView(caloHitParameters);
-                caloHitPars_VView.m_hitType = pandora::TPC_VIEW_V;
-                caloHitPars_VView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float vpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(y0_cm, z0_cm));
-                caloHitPars_VView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, vpos_cm);
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_VView, m_larCaloHitFactory));
-                if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                    PandoraApi::SetCaloHitToMCParticleRelationship(
-                        *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-                // W view
-                lar_content::LArCaloHitParameters caloHitPars_WView(caloHitParameters);
-                caloHitPars_WView.m_hitType = pandora::TPC_VIEW_W;
-                caloHitPars_WView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
-                const float wpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(y0_cm, z0_cm));
-                caloHitPars_WView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, wpos_cm);
-
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_WView, m_larCaloHitFactory));
-                if (parameters.m_dataFormat == Parameters::LArNDFormat::SPMC)
-                    PandoraApi::SetCaloHitToMCParticleRelationship(
-                        *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+                highestEnergy = trackEnergy.second;
+                mergedSpacePoint.m_trackID = trackEnergy.first;
             }
+        }
 
-        } // end space point loop
+        if (mergedSpacePoint.m_hasMCContribution && std::abs(mergedSpacePoint.m_energy) > 0.f)
+            mergedSpacePoint.m_energyFrac = std::min(1.f, highestEnergy / mergedSpacePoint.m_energy);
+    }
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
-    } // end event loop
+    return mergedSpacePoints;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void MakeCaloHitsFromSpacePoints(const LArSpacePointList &spacePoints, const float voxelWidth,
+    const pandora::Pandora *const pPrimaryPandora, const LArNDCaloHitFactory &caloHitFactory, const Parameters &parameters,
+    int &hitCounter)
+{
+    for (const LArSpacePoint &spacePoint : spacePoints)
+    {
+        const pandora::CartesianVector &voxelPos(spacePoint.m_position);
+        const float voxelE(spacePoint.m_energy);
+        const float MipE{0.00075};
+        const float voxelMipEquivalentE = voxelE / MipE;
+        lar_content::LArCaloHitParameters caloHitParameters;
+        caloHitParameters.m_positionVector = voxelPos;
+        caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
+        caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
+        caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
+        caloHitParameters.m_cellSize0 = voxelWidth;
+        caloHitParameters.m_cellSize1 = voxelWidth;
+        caloHitParameters.m_cellThickness = voxelWidth;
+        caloHitParameters.m_nCellRadiationLengths = 1.f;
+        caloHitParameters.m_nCellInteractionLengths = 1.f;
+        caloHitParameters.m_time = 0.f;
+        caloHitParameters.m_inputEnergy = voxelE;
+        caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
+        caloHitParameters.m_electromagneticEnergy = voxelE;
+        caloHitParameters.m_hadronicEnergy = voxelE;
+        caloHitParameters.m_isDigital = false;
+        caloHitParameters.m_hitType = pandora::TPC_3D;
+        caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
+        caloHitParameters.m_layer = 0;
+        caloHitParameters.m_isInOuterSamplingLayer = false;
+        caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
+        caloHitParameters.m_larTPCVolumeId = spacePoint.m_tpcID;
+        caloHitParameters.m_daughterVolumeId = 0;
+
+        // Only used for truth
+        const bool hasMCContribution(spacePoint.m_hasMCContribution);
+        const long trackID(spacePoint.m_trackID);
+        const float energyFrac(spacePoint.m_energyFrac);
+
+        if (parameters.m_use3D)
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, caloHitFactory));
+
+        if (hasMCContribution)
+            PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+
+        if (parameters.m_useLArTPC)
+        {
+            // Create LArCaloHits for U, V and W views assuming x is the common drift coordinate
+            const float x0_cm(voxelPos.GetX());
+            const float y0_cm(voxelPos.GetY());
+            const float z0_cm(voxelPos.GetZ());
+
+            // U view
+            lar_content::LArCaloHitParameters caloHitPars_UView(caloHitParameters);
+            caloHitPars_UView.m_hitType = pandora::TPC_VIEW_U;
+            caloHitPars_UView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+            const float upos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(y0_cm, z0_cm));
+            caloHitPars_UView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, upos_cm);
+
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_UView, caloHitFactory));
+            if (hasMCContribution)
+                PandoraApi::SetCaloHitToMCParticleRelationship(
+                    *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+
+            // V view
+            lar_content::LArCaloHitParameters caloHitPars_VView(caloHitParameters);
+            caloHitPars_VView.m_hitType = pandora::TPC_VIEW_V;
+            caloHitPars_VView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+            const float vpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(y0_cm, z0_cm));
+            caloHitPars_VView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, vpos_cm);
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_VView, caloHitFactory));
+            if (hasMCContribution)
+                PandoraApi::SetCaloHitToMCParticleRelationship(
+                    *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+            // W view
+            lar_content::LArCaloHitParameters caloHitPars_WView(caloHitParameters);
+            caloHitPars_WView.m_hitType = pandora::TPC_VIEW_W;
+            caloHitPars_WView.m_pParentAddress = (void *)(intptr_t(++hitCounter));
+            const float wpos_cm(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(y0_cm, z0_cm));
+            caloHitPars_WView.m_positionVector = pandora::CartesianVector(x0_cm, 0.f, wpos_cm);
 
-    fileSource->Close();
+            PANDORA_THROW_RESULT_IF(
+                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitPars_WView, caloHitFactory));
+            if (hasMCContribution)
+                PandoraApi::SetCaloHitToMCParticleRelationship(
+                    *pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
+        }
+    }
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -645,36 +1127,26 @@ void CreateSPMCParticles(const LArSPMC &larspmc, const pandora::Pandora *const p
 //------------------------------------------------------------------------------------------------------------------------------------------
 
 #ifdef USE_EDEPSIM
-void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
+void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset)
 {
 
-    TFile *fileSource = TFile::Open(parameters.m_inputFileName.c_str(), "READ");
-    if (!fileSource)
-    {
-        std::cout << "Error in ProcessEDepSimEvents(): can't open file " << parameters.m_inputFileName << std::endl;
-        return;
-    }
-
-    TTree *pEDepSimTree = dynamic_cast<TTree *>(fileSource->Get(parameters.m_inputTreeName.c_str()));
+    std::unique_ptr<TChain> pEDepSimTree(MakeInputChain(parameters));
     if (!pEDepSimTree)
-    {
-        std::cout << "Could not find the event tree " << parameters.m_inputTreeName << std::endl;
-        fileSource->Close();
         return;
-    }
 
     TG4Event *pEDepSimEvent(nullptr);
     pEDepSimTree->SetBranchAddress("Event", &pEDepSimEvent);
 
-    // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
+    // Factory for creating LArCaloHits, recycling their memory from one event to the next
+    LArNDCaloHitFactory caloHitFactory;
 
     const LArGrid grid = parameters.m_useModularGeometry ? MakeVoxelisationGrid(geom, parameters) : MakeVoxelisationGrid(pPrimaryPandora, parameters);
 
     std::cout << "Total grid volume: bot = " << grid.m_bottom << "\n top = " << grid.m_top << std::endl;
     std::cout << "Making voxels with size " << grid.m_binWidths << std::endl;
 
-    // Total number of entries in the TTree
+    // Total number of entries in the input files
     const int nEntries(pEDepSimTree->GetEntries());
 
     // Starting event
@@ -686,10 +1158,10 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    for (int iEvt = eventSubset.GetNextEvent(startEvt, startEvt - 1); iEvt < endEvt; iEvt = eventSubset.GetNextEvent(startEvt, iEvt))
     {
         if (parameters.m_shouldDisplayEventNumber)
-            std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
+            PrintInputEvent(pEDepSimTree.get(), iEvt);
 
         pEDepSimTree->GetEntry(iEvt);
 
@@ -715,9 +1187,9 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
             std::cout << "Show hits for " << detector->first << " (" << detector->second.size() << " hits)" << std::endl;
             std::cout << "                                 " << std::endl;
 
-            LArVoxelList voxelList;
+            LArHitInfoList hitInfos;
+            hitInfos.reserve(detector->second.size());
 
-            // Loop over hit segments and create voxels from them
             for (TG4HitSegment &g4Hit : detector->second)
             {
                 const TLorentzVector &hitStart = g4Hit.GetStart();
@@ -727,37 +1199,33 @@ void ProcessEDepSimEvents(const Parameters &parameters, const Pandora *const pPr
                 const float energy = g4Hit.GetEnergyDeposit();
                 const int g4id = g4Hit.GetContributors()[0];
 
-                const LArHitInfo hitInfo(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
-                const LArVoxelList currentVoxelList = MakeVoxels(hitInfo, grid, parameters, geom);
-
-                for (const LArVoxel &voxel : currentVoxelList)
-                    voxelList.emplace_back(voxel);
+                hitInfos.emplace_back(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
             }
 
-            std::cout << "Produced " << voxelList.size() << " voxels from " << detector->second.size() << " hit segments." << std::endl;
-
-            // Merge voxels with the same IDs
-            const LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
+            // Create voxels from the hit segments, merging voxels with the same IDs as we go, on a coarser grid if there are too many
+            LArVoxelAccumulator voxelAccumulator;
+            const LArGrid eventGrid(VoxeliseHits(hitInfos, grid, parameters, geom, voxelAccumulator));
+            const LArVoxelArray &mergedVoxels = voxelAccumulator.GetMergedVoxels();
 
-            std::cout << "Produced " << mergedVoxels.size() << " merged voxels from " << voxelList.size() << " voxels." << std::endl;
-            voxelList.clear();
+            std::cout << "Produced " << voxelAccumulator.GetNAddedVoxels() << " voxels from " << detector->second.size() << " hit segments."
+                      << std::endl;
+            std::cout << "Produced " << mergedVoxels.GetNVoxels() << " merged voxels from " << voxelAccumulator.GetNAddedVoxels()
+                      << " voxels." << std::endl;
 
-            // Stop processing the event if we have too many voxels: reco takes too long
-            if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels)
+            // Stop processing the event if we still have too many voxels: reco takes too long
+            if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.GetNVoxels() > parameters.m_maxMergedVoxels)
             {
-                std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.size() << " > " << parameters.m_maxMergedVoxels << std::endl;
+                std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.GetNVoxels() << " > "
+                          << parameters.m_maxMergedVoxels << std::endl;
                 break;
             }
 
-            MakeCaloHitsFromVoxels(mergedVoxels, MCEnergyMap, pPrimaryPandora, parameters, hitCounter);
+            MakeCaloHitsFromVoxels(mergedVoxels, eventGrid, MCEnergyMap, pPrimaryPandora, caloHitFactory, parameters, hitCounter);
         } // end segment detector loop
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+        ProcessPandoraEvent(parameters, pPrimaryPandora, iEvt, eventSubset);
+        ResetEvent(parameters, pPrimaryPandora, caloHitFactory);
     }
-
-    // Close input file
-    fileSource->Close();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -960,32 +1428,25 @@ MCParticleEnergyMap CreateEDepSimMCParticles(const TG4Event &event, const pandor
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom)
+void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimaryPandora, const LArNDGeomSimple &geom,
+    EventSubset &eventSubset)
 {
     std::cout << "About to process SED events" << std::endl;
-    TFile *fileSource = TFile::Open(parameters.m_inputFileName.c_str(), "READ");
-    if (!fileSource)
-    {
-        std::cout << "Error in ProcessSEDEvents(): can't open file " << parameters.m_inputFileName << std::endl;
-        return;
-    }
-
-    TTree *ndsim = dynamic_cast<TTree *>(fileSource->Get(parameters.m_inputTreeName.c_str()));
+    std::unique_ptr<TChain> ndsim(MakeInputChain(parameters));
     if (!ndsim)
-    {
-        std::cout << "Could not find the event tree " << parameters.m_inputTreeName << std::endl;
-        fileSource->Close();
         return;
-    }
 
-    const LArSED larsed(ndsim);
+    const LArSED larsed(ndsim.get());
+
+    // Factory for creating LArCaloHits, recycling their memory from one event to the next
+    LArNDCaloHitFactory caloHitFactory;
 
     const LArGrid grid = parameters.m_useModularGeometry ? MakeVoxelisationGrid(geom, parameters) : MakeVoxelisationGrid(pPrimaryPandora, parameters);
 
     std::cout << "Total grid volume: bot = " << grid.m_bottom << "\n top = " << grid.m_top << std::endl;
     std::cout << "Making voxels with size " << grid.m_binWidths << std::endl;
 
-    // Total number of entries in the TTree
+    // Total number of entries in the input files
     const int nEntries(ndsim->GetEntries());
 
     // Starting event
@@ -997,10 +1458,10 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
 
     std::cout << "Start event is " << startEvt << " and end event is " << endEvt - 1 << std::endl;
 
-    for (int iEvt = startEvt; iEvt < endEvt; iEvt++)
+    for (int iEvt = eventSubset.GetNextEvent(startEvt, startEvt - 1); iEvt < endEvt; iEvt = eventSubset.GetNextEvent(startEvt, iEvt))
     {
         if (parameters.m_shouldDisplayEventNumber)
-            std::cout << std::endl << "   PROCESSING EVENT: " << iEvt << std::endl << std::endl;
+            PrintInputEvent(ndsim.get(), iEvt);
 
         ndsim->GetEntry(iEvt);
 
@@ -1012,9 +1473,10 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
         }
         CreateSEDMCParticles(larsed, pPrimaryPandora, parameters);
 
-        LArVoxelList voxelList;
+        LArHitInfoList hitInfos;
+        hitInfos.reserve(larsed.m_sed_det->size());
 
-        // Loop over the energy deposits and create voxels
+        // Loop over the energy deposits in the sensitive detector
         for (size_t ised = 0; ised < larsed.m_sed_det->size(); ++ised)
         {
             if ((*larsed.m_sed_det)[ised] == parameters.m_sensitiveDetName) // usually volTPCActive
@@ -1031,37 +1493,34 @@ void ProcessSEDEvents(const Parameters &parameters, const Pandora *const pPrimar
                 const pandora::CartesianVector start(startx, starty, startz);
                 const pandora::CartesianVector end(endx, endy, endz);
 
-                const LArHitInfo hitInfo(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
-                const LArVoxelList currentVoxelList = MakeVoxels(hitInfo, grid, parameters, geom);
-
-                for (const LArVoxel &voxel : currentVoxelList)
-                    voxelList.emplace_back(voxel);
+                hitInfos.emplace_back(start, end, energy, g4id, parameters.m_lengthScale, parameters.m_energyScale);
             }
         }
 
-        std::cout << "Produced " << voxelList.size() << " voxels from " << larsed.m_sed_det->size() << " hit segments." << std::endl;
+        // Create voxels from the energy deposits, merging voxels with the same IDs as we go, on a coarser grid if there are too many
+        LArVoxelAccumulator voxelAccumulator;
+        const LArGrid eventGrid(VoxeliseHits(hitInfos, grid, parameters, geom, voxelAccumulator));
+        const LArVoxelArray &mergedVoxels = voxelAccumulator.GetMergedVoxels();
 
-        // Merge voxels with the same IDs
-        const LArVoxelList mergedVoxels = MergeSameVoxels(voxelList);
-
-        std::cout << "Produced " << mergedVoxels.size() << " merged voxels from " << voxelList.size() << " voxels." << std::endl;
-        voxelList.clear();
+        std::cout << "Produced " << voxelAccumulator.GetNAddedVoxels() << " voxels from " << larsed.m_sed_det->size() << " hit segments."
+                  << std::endl;
+        std::cout << "Produced " << mergedVoxels.GetNVoxels() << " merged voxels from " << voxelAccumulator.GetNAddedVoxels() << " voxels."
+                  << std::endl;
 
-        // Stop processing the event if we have too many voxels: reco takes too long
-        if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.size() > parameters.m_maxMergedVoxels)
+        // Stop processing the event if we still have too many voxels: reco takes too long
+        if (parameters.m_maxMergedVoxels > 0 && mergedVoxels.GetNVoxels() > parameters.m_maxMergedVoxels)
         {
-            std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.size() << " > " << parameters.m_maxMergedVoxels << std::endl;
-            break;
+            std::cout << "SKIPPING EVENT: number of merged voxels " << mergedVoxels.GetNVoxels() << " > " << parameters.m_maxMergedVoxels
+                      << std::endl;
+            continue;
         }
 
         int hitCounter{0};
-        MakeCaloHitsFromVoxels(mergedVoxels, MCEnergyMap, pPrimaryPandora, parameters, hitCounter);
+        MakeCaloHitsFromVoxels(mergedVoxels, eventGrid, MCEnergyMap, pPrimaryPandora, caloHitFactory, parameters, hitCounter);
 
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::ProcessEvent(*pPrimaryPandora));
-        PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+        ProcessPandoraEvent(parameters, pPrimaryPandora, iEvt, eventSubset);
+        ResetEvent(parameters, pPrimaryPandora, caloHitFactory);
     } // end event loop
-
-    fileSource->Close();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1300,504 +1759,17 @@ std::string GetNuanceReaction(const int ccnc, const int mode)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
-LArGrid MakeVoxelisationGrid(const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters)
-{
-    // Detector volume for voxelising the hits
-    const GeometryManager *geom = pPrimaryPandora->GetGeometry();
-    const LArTPC &tpc = geom->GetLArTPC();
-
-    const float botX = tpc.GetCenterX() - 0.5 * tpc.GetWidthX();
-    const float botY = tpc.GetCenterY() - 0.5 * tpc.GetWidthY();
-    const float botZ = tpc.GetCenterZ() - 0.5 * tpc.GetWidthZ();
-    const float topX = botX + tpc.GetWidthX();
-    const float topY = botY + tpc.GetWidthY();
-    const float topZ = botZ + tpc.GetWidthZ();
-    const float voxelWidth(parameters.m_voxelWidth);
-
-    return LArGrid(pandora::CartesianVector(botX, botY, botZ), pandora::CartesianVector(topX, topY, topZ),
-        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-LArGrid MakeVoxelisationGrid(const LArNDGeomSimple &geom, const Parameters &parameters)
-{
-    double minX{0.f};
-    double maxX{0.f};
-    double minY{0.f};
-    double maxY{0.f};
-    double minZ{0.f};
-    double maxZ{0.f};
-    const float voxelWidth(parameters.m_voxelWidth);
-    geom.GetSurroundingBox(minX, maxX, minY, maxY, minZ, maxZ);
-
-    return LArGrid(pandora::CartesianVector(minX, minY, minZ), pandora::CartesianVector(maxX, maxY, maxZ),
-        pandora::CartesianVector(voxelWidth, voxelWidth, voxelWidth));
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-LArVoxelList MakeVoxels(const LArHitInfo &hitInfo, const LArGrid &grid, const Parameters &parameters, const LArNDGeomSimple &geom)
-{
-    // Code based on
-    // https://github.com/chenel/larcv2/tree/edepsim-formattruth/larcv/app/Supera/Voxelize.cxx
-    // which is made available under the MIT license (which is fully compatible with Pandora's GPLv3 license)
-
-    LArVoxelList currentVoxelList;
-
-    // Start and end positions
-    const pandora::CartesianVector start(hitInfo.m_start);
-    const pandora::CartesianVector stop(hitInfo.m_stop);
-
-    // Direction vector and hit segment length
-    const pandora::CartesianVector dir = stop - start;
-    const float hitLength(dir.GetMagnitude());
-
-    // Check hit length is greater than epsilon limit
-    if (hitLength < std::numeric_limits<float>::epsilon())
-        return currentVoxelList;
-
-    // Hit segment total energy in GeV (Geant4 uses MeV)
-    const float g4HitEnergy(hitInfo.m_energy);
-
-    // Check hit energy is greater than epsilon limit
-    if (g4HitEnergy < std::numeric_limits<float>::epsilon())
-        return currentVoxelList;
-
-    // Get the trackID of the (main) contributing particle.
-    // ATTN: this can very rarely be more than one track
-    const int trackID = hitInfo.m_trackID;
-
-    // Define ray trajectory, which checks dirMag (hitLength) >= epsilon limit
-    const pandora::CartesianVector dirNorm = dir.GetUnitVector();
-    LArRay ray(start, dirNorm);
-
-    // We need to shuffle along the hit segment path and create voxels as we go.
-    // There are 4 cases for the start and end points inside the voxelisation region.
-    // Case 1: start & stop are both inside the voxelisation boundary
-    // Case 2: start & stop are both outside, but path direction intersects boundary
-    // Case 3: start is inside boundary, stop = intersection at region boundary
-    // Case 4: end is inside boundary, start = intersection at region boundary
-
-    double t0(0.0), t1(0.0);
-    pandora::CartesianVector point1(0.f, 0.f, 0.f), point2(0.f, 0.f, 0.f);
-
-    // Check if the start and end points are inside the voxelisation region
-    const bool inStart = grid.Inside(start);
-    const bool inStop = grid.Inside(stop);
-
-    if (inStart && inStop)
-    {
-        // Case 1: Start and end points are inside boundary
-        point1 = start;
-        point2 = stop;
-    }
-    else if (!inStart && !inStop)
-    {
-        // Case 2: Start and end points are outside boundary
-        if (grid.Intersect(ray, t0, t1))
-        {
-            point1 = ray.GetPoint(t0);
-            point2 = ray.GetPoint(t1);
-        }
-        else
-            return currentVoxelList;
-    }
-    else if (inStart && !inStop)
-    {
-        // Case 3: Start inside boundary
-        point1 = start;
-        if (grid.Intersect(ray, t0, t1))
-            point2 = ray.GetPoint(t1);
-        else
-            return currentVoxelList;
-    }
-    else if (!inStart && inStop)
-    {
-        // Case 4: End inside boundary
-        point2 = stop;
-        if (grid.Intersect(ray, t0, t1))
-            point1 = ray.GetPoint(t0);
-        else
-            return currentVoxelList;
-    }
-
-    // Now create voxels between point1 and point2.
-    // Ray direction will be the same, but update starting point
-    ray.UpdateOrigin(point1);
-
-    bool shuffle(true);
-
-    // Keep track of total voxel path length so far
-    float totalPath(0.0);
-    int loop(0);
-
-    while (shuffle)
-    {
-        // Get point along path to define voxel bin (bottom corner)
-        const pandora::CartesianVector voxelPoint = ray.GetPoint(parameters.m_voxelPathShift);
-
-        // Grid 3d bin containing this point; 4th element is the total bin number
-        const LongBin4Array gridBins = grid.GetBinIndices(voxelPoint);
-        const long voxelID = gridBins[3];
-        const long xBin = gridBins[0];
-        const long yBin = gridBins[1];
-        const long zBin = gridBins[2];
-
-        // Voxel bottom and top corners
-        const pandora::CartesianVector voxBot = grid.GetPoint(xBin, yBin, zBin);
-        const pandora::CartesianVector voxTop = grid.GetPoint(xBin + 1, yBin + 1, zBin + 1);
-
-        // Voxel box
-        const LArBox vBox(voxBot, voxTop);
-
-        // Get ray intersections with this box: t0 and t1 are set as the start
-        // and end intersection pathlengths relative to the current ray point.
-        // If we can't find t0 and t1, then stop shuffling along the path
-        if (!vBox.Intersect(ray, t0, t1))
-            shuffle = false;
-
-        // Voxel extent = intersection path difference
-        double dL(t1 - t0);
-        // For the first path length, use the distance from the
-        // starting ray point to the 2nd intersection t1
-        if (loop == 0)
-            dL = t1;
-
-        // Stop processing if we are not moving along the path
-        if (dL < parameters.m_voxelPathShift)
-            shuffle = false;
-
-        totalPath += dL;
-
-        // Stop adding voxels if we have enough
-        if (totalPath > hitLength)
-        {
-            shuffle = false;
-            // Adjust final path according to hit segment total length
-            dL = hitLength - totalPath + dL;
-        }
-
-        // Voxel energy (GeV) using path length fraction w.r.t hit length.
-        // Here, hitLength is guaranteed to be greater than zero
-        const float voxelEnergy(g4HitEnergy * dL / hitLength);
-
-        if (parameters.m_useModularGeometry)
-        {
-            // If using modular geometry we need to assign the tpc number
-            const int tpcID(geom.GetTPCNumber(voxelPoint));
-            if (tpcID != -1)
-            {
-                const LArVoxel voxel(voxelID, voxelEnergy, voxBot, trackID, tpcID);
-                currentVoxelList.emplace_back(voxel);
-            }
-            else
-                std::cout << "Hit not in TPC: " << voxelPoint << std::endl;
-        }
-        else
-        {
-            const LArVoxel voxel(voxelID, voxelEnergy, voxBot, trackID);
-            currentVoxelList.emplace_back(voxel);
-        }
-
-        // Update ray starting position using intersection path difference
-        const pandora::CartesianVector newStart = ray.GetPoint(dL);
-        ray.UpdateOrigin(newStart);
-        loop++;
-    }
-
-    return currentVoxelList;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-LArVoxelList MergeSameVoxels(const LArVoxelList &voxelList)
-{
-    std::cout << "Merging voxels with the same IDs" << std::endl;
-    LArVoxelList mergedVoxels;
-
-    const int nVoxels = voxelList.size();
-    std::vector<bool> processed(nVoxels, false);
-
-    for (int i = 0; i < nVoxels; i++)
-    {
-        // Skip voxel if it was already used in a merge
-        if (processed[i])
-            continue;
-
-        LArVoxel voxel1 = voxelList[i];
-        float voxE1 = voxel1.m_energyInVoxel;
-        std::map<int, float> trackIDToEnergy;
-        trackIDToEnergy[voxel1.m_trackID] = voxE1;
-
-        // Loop over other voxels (from i+1) and check if we have an ID match.
-        // If so, add their energies and only store the combined voxel at the end
-        for (int j = i + 1; j < nVoxels; j++)
-        {
-            // Skip voxel if it was already used in a merge
-            if (processed[j])
-                continue;
-
-            const LArVoxel voxel2 = voxelList[j];
-            const int trackid2 = voxel2.m_trackID;
-            const float voxE2 = voxel2.m_energyInVoxel;
-            if (voxel2.m_voxelID == voxel1.m_voxelID)
-            {
-                // IDs match. Add energy and set processed integer
-                voxE1 += voxE2;
-                processed[j] = true;
-                // Amend the true particle contribution map
-                if (trackIDToEnergy.count(trackid2) != 0)
-                    trackIDToEnergy[trackid2] += voxE2;
-                else
-                    trackIDToEnergy[trackid2] = voxE2;
-            }
-        }
-
-        // Add combined (or untouched) voxel to the merged list
-        voxel1.SetEnergy(voxE1);
-        // Update the track ID if necessary
-        if (trackIDToEnergy.size() > 1)
-        {
-            float highestEnergy{0.f};
-            int bestTrackID{-1};
-            // std::cout << "Merged voxel had contributions from " << trackIDToEnergy.size() << " particles" << std::endl;
-            for (auto const &pair : trackIDToEnergy)
-            {
-                // std::cout << " - " << pair.first << " with energy " << pair.second << std::endl;
-                if (pair.second > highestEnergy)
-                {
-                    highestEnergy = pair.second;
-                    bestTrackID = pair.first;
-                }
-            }
-            // std::cout << " = chose track id " << bestTrackID << std::endl;
-            voxel1.SetTrackID(bestTrackID);
-        }
-
-        mergedVoxels.emplace_back(voxel1);
-
-        // We have processed the ith voxel
-        processed[i] = true;
-    }
-
-    return mergedVoxels;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-LArVoxelProjectionList MergeSameProjections(const LArVoxelProjectionList &hits)
-{
-    LArVoxelProjectionList outputHits;
-    std::vector<bool> areUsed(hits.size(), false);
-
-    for (unsigned int vp1 = 0; vp1 < hits.size(); ++vp1)
-    {
-        if (areUsed.at(vp1))
-            continue;
-
-        LArVoxelProjection voxProj1{hits.at(vp1)};
-        std::map<int, float> trackIDToEnergy;
-        trackIDToEnergy[voxProj1.m_trackID] = voxProj1.m_energy;
-        for (unsigned int vp2 = vp1 + 1; vp2 < hits.size(); ++vp2)
-        {
-            if (areUsed.at(vp2))
-                continue;
-
-            const LArVoxelProjection &voxProj2 = hits.at(vp2);
-            if ((voxProj1.m_wire != voxProj2.m_wire) || (voxProj1.m_drift != voxProj2.m_drift))
-                continue;
-
-            // Add the energy, but keep track of the highest energy contributor
-            voxProj1.m_energy += voxProj2.m_energy;
-            if (trackIDToEnergy.count(voxProj2.m_trackID) != 0)
-                trackIDToEnergy[voxProj2.m_trackID] += voxProj2.m_energy;
-            else
-                trackIDToEnergy[voxProj2.m_trackID] = voxProj2.m_energy;
-
-            areUsed.at(vp2) = true;
-        }
-        // Add the hit to the output
-        areUsed.at(vp1) = true;
-
-        // Update the track ID if necessary
-        if (trackIDToEnergy.size() > 1)
-        {
-            float highestEnergy{0.f};
-            int bestTrackID{-1};
-            for (auto const &pair : trackIDToEnergy)
-            {
-                if (pair.second > highestEnergy)
-                {
-                    highestEnergy = pair.second;
-                    bestTrackID = pair.first;
-                }
-            }
-            voxProj1.m_trackID = bestTrackID;
-            voxProj1.m_parentVoxelID = hits.at(bestTrackID).m_parentVoxelID;
-        }
-        outputHits.emplace_back(voxProj1);
-    }
-
-    std::cout << outputHits.size() << " projected hits remain after merging" << std::endl;
-    return outputHits;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-void MakeCaloHitsFromVoxels(const LArVoxelList &voxels, const MCParticleEnergyMap &mcEnergyMap,
-    const pandora::Pandora *const pPrimaryPandora, const Parameters &parameters, int &hitCounter)
-{
-
-    // Factory for creating LArCaloHits
-    lar_content::LArCaloHitFactory m_larCaloHitFactory;
-    const float voxelWidth(parameters.m_voxelWidth);
-    const float MipE = 0.00075;
-    lar_content::LArCaloHitParameters caloHitParameters = MakeDefaultCaloHitParams(voxelWidth);
-
-    if (parameters.m_use3D)
-    {
-        for (unsigned int v = 0; v < voxels.size(); ++v)
-        {
-            const LArVoxel voxel = voxels.at(v);
-            const pandora::CartesianVector voxelPos(voxel.m_voxelPosVect);
-            const float voxelE = voxel.m_energyInVoxel;
-            const float voxelMipEquivalentE = voxelE / MipE;
-
-            if (voxelMipEquivalentE < parameters.m_minVoxelMipEquivE)
-                continue;
-
-            // Modify the important fields
-            caloHitParameters.m_positionVector = voxelPos;
-            caloHitParameters.m_inputEnergy = voxelE;
-            caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
-            caloHitParameters.m_electromagneticEnergy = voxelE;
-            caloHitParameters.m_hadronicEnergy = voxelE;
-            caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
-            caloHitParameters.m_larTPCVolumeId = voxel.m_tpcID;
-
-            PANDORA_THROW_RESULT_IF(
-                pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
-
-            // Set calo hit voxel to MCParticle relation using trackID
-            const int trackID = voxel.m_trackID;
-            const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
-            PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-        }
-    }
-
-    // Treat the 3 x 2D view case separately as we need to merge hits
-    // on some of the views depending on the geometry
-    if (parameters.m_useLArTPC)
-    {
-        LArVoxelProjectionList voxelProjectionsU;
-        LArVoxelProjectionList voxelProjectionsV;
-        LArVoxelProjectionList voxelProjectionsW;
-
-        for (unsigned int v = 0; v < voxels.size(); ++v)
-        {
-            const LArVoxel &voxel = voxels.at(v);
-
-            const pandora::CartesianVector voxelPos = voxel.m_voxelPosVect;
-            const float uPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoU(voxelPos.GetY(), voxelPos.GetZ()));
-            voxelProjectionsU.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, uPos, voxelPos.GetX(), pandora::TPC_VIEW_U, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
-
-            const float vPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoV(voxelPos.GetY(), voxelPos.GetZ()));
-            voxelProjectionsV.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, vPos, voxelPos.GetX(), pandora::TPC_VIEW_V, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
-
-            const float wPos(pPrimaryPandora->GetPlugins()->GetLArTransformationPlugin()->YZtoW(voxelPos.GetY(), voxelPos.GetZ()));
-            voxelProjectionsW.emplace_back(LArVoxelProjection(
-                voxel.m_energyInVoxel, wPos, voxelPos.GetX(), pandora::TPC_VIEW_W, voxel.m_voxelID, voxel.m_trackID, voxel.m_tpcID));
-        }
-
-        std::vector<LArVoxelProjectionList> viewProjections;
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsU));
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsV));
-        viewProjections.emplace_back(MergeSameProjections(voxelProjectionsW));
-
-        voxelProjectionsU.clear();
-        voxelProjectionsV.clear();
-        voxelProjectionsW.clear();
-
-        for (const LArVoxelProjectionList &view : viewProjections)
-        {
-            for (const LArVoxelProjection &hit : view)
-            {
-                const float voxelE = hit.m_energy;
-                const float voxelMipEquivalentE = voxelE / MipE;
-
-                if (voxelMipEquivalentE < parameters.m_minVoxelMipEquivE)
-                    continue;
-
-                // Modify the important fields
-                caloHitParameters.m_positionVector = pandora::CartesianVector(hit.m_drift, 0.f, hit.m_wire);
-                caloHitParameters.m_inputEnergy = voxelE;
-                caloHitParameters.m_mipEquivalentEnergy = voxelMipEquivalentE;
-                caloHitParameters.m_electromagneticEnergy = voxelE;
-                caloHitParameters.m_hadronicEnergy = voxelE;
-                caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(++hitCounter));
-                caloHitParameters.m_hitType = hit.m_view;
-                caloHitParameters.m_larTPCVolumeId = hit.m_tpcID;
-
-                // Create LArCaloHits for U, V and W views
-                PANDORA_THROW_RESULT_IF(
-                    pandora::STATUS_CODE_SUCCESS, !=, PandoraApi::CaloHit::Create(*pPrimaryPandora, caloHitParameters, m_larCaloHitFactory));
-
-                // Set calo hit voxel to MCParticle relation using trackID
-                const int trackID = hit.m_trackID;
-                const float energyFrac = GetMCEnergyFraction(mcEnergyMap, voxelE, trackID);
-                PandoraApi::SetCaloHitToMCParticleRelationship(*pPrimaryPandora, (void *)((intptr_t)hitCounter), (void *)((intptr_t)trackID), energyFrac);
-            } // end voxel projection loop
-        } // end view loop
-    }
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-float GetMCEnergyFraction(const MCParticleEnergyMap &mcEnergyMap, const float voxelE, const int trackID)
+void ResetEvent(const Parameters &parameters, const pandora::Pandora *const pPrimaryPandora, LArNDCaloHitFactory &caloHitFactory)
 {
-    // Find the energy fraction: voxelHitE/MCParticleE
-    float energyFrac(0.f), MCEnergy(0.f);
-    MCParticleEnergyMap::const_iterator mapIter = mcEnergyMap.find(trackID);
-    if (mapIter != mcEnergyMap.end())
-        MCEnergy = mapIter->second;
+    // The hits are deleted by the reset, returning their memory to the factory pool
+    const auto startTime(std::chrono::steady_clock::now());
+    PANDORA_THROW_RESULT_IF(STATUS_CODE_SUCCESS, !=, PandoraApi::Reset(*pPrimaryPandora));
+    const std::chrono::duration<double, std::milli> resetTime(std::chrono::steady_clock::now() - startTime);
 
-    if (MCEnergy > 0.0)
-        energyFrac = voxelE / MCEnergy;
+    if (parameters.m_printOverallRecoStatus)
+        caloHitFactory.PrintEventSummary(resetTime.count());
 
-    return energyFrac;
-}
-
-//------------------------------------------------------------------------------------------------------------------------------------------
-
-lar_content::LArCaloHitParameters MakeDefaultCaloHitParams(float voxelWidth)
-{
-    lar_content::LArCaloHitParameters caloHitParameters;
-    caloHitParameters.m_positionVector = pandora::CartesianVector(0.f, 0.f, 1.f);
-    caloHitParameters.m_expectedDirection = pandora::CartesianVector(0.f, 0.f, 1.f);
-    caloHitParameters.m_cellNormalVector = pandora::CartesianVector(0.f, 0.f, 1.f);
-    caloHitParameters.m_cellGeometry = pandora::RECTANGULAR;
-    caloHitParameters.m_cellSize0 = voxelWidth;
-    caloHitParameters.m_cellSize1 = voxelWidth;
-    caloHitParameters.m_cellThickness = voxelWidth;
-    caloHitParameters.m_nCellRadiationLengths = 1.f;
-    caloHitParameters.m_nCellInteractionLengths = 1.f;
-    caloHitParameters.m_time = 0.f;
-    caloHitParameters.m_inputEnergy = 0.f;
-    caloHitParameters.m_mipEquivalentEnergy = 0.f;
-    caloHitParameters.m_electromagneticEnergy = 0.f;
-    caloHitParameters.m_hadronicEnergy = 0.f;
-    caloHitParameters.m_isDigital = false;
-    caloHitParameters.m_hitType = pandora::TPC_3D;
-    caloHitParameters.m_hitRegion = pandora::SINGLE_REGION;
-    caloHitParameters.m_layer = 0;
-    caloHitParameters.m_isInOuterSamplingLayer = false;
-    caloHitParameters.m_pParentAddress = (void *)(static_cast<uintptr_t>(0));
-    caloHitParameters.m_larTPCVolumeId = 0;
-    caloHitParameters.m_daughterVolumeId = 0;
-    return caloHitParameters;
+    caloHitFactory.ResetCounters();
 }
 
 //------------------------------------------------------------------------------------------------------------------------------------------
@@ -1817,7 +1789,7 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
     std::string geomVolName("");
     std::string sensDetName("");
 
-    while ((cOpt = getopt(argc, argv, "r:i:e:k:f:g:t:v:d:n:s:j:w:m:b:c:MpNh")) != -1)
+    while ((cOpt = getopt(argc, argv, "r:i:e:k:f:g:G:t:v:d:n:s:j:w:m:x:b:c:P:T:B:H:MpNh")) != -1)
     {
         switch (cOpt)
         {
@@ -1839,6 +1811,9 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'g':
                 parameters.m_geomFileName = optarg;
                 break;
+            case 'G':
+                parameters.m_geomCacheFileName = optarg;
+                break;
             case 't':
                 geomManagerName = optarg;
                 break;
@@ -1869,6 +1844,9 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'm':
                 parameters.m_maxMergedVoxels = atoi(optarg);
                 break;
+            case 'x':
+                parameters.m_maxVoxelCoarsening = atoi(optarg);
+                break;
             case 'b':
                 parameters.m_minNSpacePoints = atoi(optarg);
                 break;
@@ -1878,6 +1856,18 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
             case 'N':
                 parameters.m_shouldDisplayEventNumber = true;
                 break;
+            case 'P':
+                parameters.m_nPrimaryInstances = atoi(optarg);
+                break;
+            case 'T':
+                parameters.m_profileFileName = optarg;
+                break;
+            case 'B':
+                parameters.m_eventTimeBudget = atof(optarg);
+                break;
+            case 'H':
+                parameters.m_hitCacheFileName = optarg;
+                break;
             case 'h':
             default:
                 return PrintOptions();
@@ -1887,7 +1877,14 @@ bool ParseCommandLine(int argc, char *argv[], Parameters &parameters)
     ProcessViewOption(viewOption, parameters);
     const bool gotFormat = ProcessFormatOption(formatOption, inputTreeName, geomManagerName, geomVolName, sensDetName, parameters);
     const bool gotRecoOpt = ProcessRecoOption(recoOption, parameters);
-    const bool passed = gotFormat && gotRecoOpt;
+    const bool gotInstances = ProcessInstancesOption(parameters);
+    const bool gotProfile = ProcessProfileOption(parameters);
+    const bool gotCoarsening = ProcessCoarseningOption(parameters);
+    const bool gotTimeBudget = ProcessTimeBudgetOption(parameters);
+    const bool gotInputFiles = ProcessInputFilesOption(parameters);
+    const bool gotHitCache = ProcessHitCacheOption(parameters);
+    const bool passed =
+        gotFormat && gotRecoOpt && gotInstances && gotProfile && gotCoarsening && gotTimeBudget && gotInputFiles && gotHitCache;
     if (!passed)
     {
         return PrintOptions();
@@ -1904,8 +1901,11 @@ bool PrintOptions()
               << "    -r RecoOption          (required) [Full, AllHitsCR, AllHitsNu, CRRemHitsSliceCR, CRRemHitsSliceNu, AllHitsSliceCR, AllHitsSliceNu]"
               << std::endl
               << "    -i Settings            (required) [Run xml file for setting up the Pandora algorithms]" << std::endl
-              << "    -e EventsFile          (required) [Events input data ROOT file]" << std::endl
+              << "    -e EventsFile          (required) [Events input data ROOT file, or a glob, comma-separated list or .txt/.list file "
+              << "of them]" << std::endl
               << "    -g GeometryFile        (required) [ROOT file containing the TGeoManager geometry]" << std::endl
+              << "    -G GeometryCacheFile   (optional) [TPC volume cache, read instead of the TGeoManager if it matches the geometry, "
+              << "otherwise written]" << std::endl
               << "    -f DataFormat          (optional) [SP (SpacePoint default), SPMC (SpacePoint MC), EDepSim (rooTracker) or SED (LArSoft-like)]"
               << std::endl
               << "    -k EventsTreeName      (optional) [Name of the input events ROOT TTree (default = events)]" << std::endl
@@ -1922,8 +1922,18 @@ bool PrintOptions()
               << "    -w width               (optional) [Voxel bin width (cm), default = 0.4 cm]" << std::endl
               << "    -m maxMergedVoxels     (optional) [Skip events that have N(space points) or N(merged voxels) > maxMergedVoxels (default = no events skipped)]"
               << std::endl
+              << "    -x maxCoarsening       (optional) [Instead of skipping events with > maxMergedVoxels, merge them in voxels up to "
+              << "maxCoarsening (power of 2) times wider (default = 1, i.e. skip them)]" << std::endl
               << "    -b minNSpacePoints     (optional) [Skip events that have N(space points) < minNSpacePoints (default < 2)]" << std::endl
               << "    -c minMipEquivE        (optional) [Minimum MIP equivalent energy, default = 0.3]" << std::endl
+              << "    -P NPrimaryInstances   (optional) [Number of primary instances processing events concurrently (default = 1, 3D only)]"
+              << std::endl
+              << "    -T ProfileFile         (optional) [Per-algorithm timing, memory and list size profile output file (3D only)]"
+              << std::endl
+              << "    -B EventTimeBudget     (optional) [Time (s) per event after which optional stages are skipped and the event flagged "
+              << "(default = no limit, 3D only)]" << std::endl
+              << "    -H HitCacheFile        (optional) [Hit cache written by LArNDHitCacheConverter from the input files, read instead of "
+              << "their hit branches (SP and SPMC only)]" << std::endl
               << std::endl;
 
     return false;
@@ -1961,6 +1971,132 @@ void ProcessViewOption(const std::string &viewOption, Parameters &parameters)
 
 //------------------------------------------------------------------------------------------------------------------------------------------
 
+bool ProcessInstancesOption(const Parameters &parameters)
+{
+    if (parameters.m_nPrimaryInstances < 1)
+    {
+        std::cout << "Number of primary instances must be at least 1" << std::endl;
+        return false;
+    }
+
+    // Only the 3D master algorithm is told about the other primary instances, so that it creates all of its worker instances up front
+    if ((parameters.m_nPrimaryInstances > 1) && !parameters.m_use3D)
+    {
+        std::cout << "Multiple primary instances need the 3D reconstruction (-j Both or 3D)" << std::endl;
+        return false;
+    }
+
+    if (parameters.m_nPrimaryInstances > 1)
+        std::cout << "Using " << parameters.m_nPrimaryInstances << " primary instances, each with its own worker instances" << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ProcessProfileOption(const Parameters &parameters)
+{
+    if (parameters.m_profileFileName.empty())
+        return true;
+
+    // The profiling checkpoint algorithm is part of the ND content, which is only registered for the 3D reconstruction
+    if (!parameters.m_use3D)
+    {
+        std::cout << "Algorithm profiling needs the 3D reconstruction (-j Both or 3D)" << std::endl;
+        return false;
+    }
+
+    std::cout << "Writing the per-algorithm profile to " << parameters.m_profileFileName << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ProcessCoarseningOption(const Parameters &parameters)
+{
+    const int maxCoarsening(parameters.m_maxVoxelCoarsening);
+
+    // Each coarse voxel is made of whole nominal voxels, from the same grid origin
+    if ((maxCoarsening < 1) || (0 != (maxCoarsening & (maxCoarsening - 1))))
+    {
+        std::cout << "Maximum voxel coarsening must be a power of 2, not " << maxCoarsening << std::endl;
+        return false;
+    }
+
+    if (maxCoarsening > 1)
+    {
+        if (parameters.m_maxMergedVoxels <= 0)
+            std::cout << "Voxel coarsening needs the maximum number of merged voxels (-m), so will not be used" << std::endl;
+        else
+            std::cout << "Events with more than " << parameters.m_maxMergedVoxels << " merged voxels will use voxels up to "
+                      << maxCoarsening * parameters.m_voxelWidth << " cm wide" << std::endl;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ProcessTimeBudgetOption(const Parameters &parameters)
+{
+    if (parameters.m_eventTimeBudget < 0.f)
+    {
+        std::cout << "Event time budget must not be negative, not " << parameters.m_eventTimeBudget << std::endl;
+        return false;
+    }
+
+    if (parameters.m_eventTimeBudget > 0.f)
+    {
+        // The time budget is checked by the ND content, which is only registered for the 3D reconstruction
+        if (!parameters.m_use3D)
+        {
+            std::cout << "The event time budget needs the 3D reconstruction (-j Both or 3D)" << std::endl;
+            return false;
+        }
+
+        std::cout << "Skipping optional reconstruction stages for events taking longer than " << parameters.m_eventTimeBudget << " s"
+                  << std::endl;
+    }
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ProcessInputFilesOption(Parameters &parameters)
+{
+    // The converter writing the hit cache expands its input files in the same way, so the same option gives the same event order
+    if (!ExpandInputFileNames(parameters.m_inputFileName, parameters.m_inputFileNames))
+        return false;
+
+    if (parameters.m_inputFileNames.size() > 1)
+        std::cout << "Reading events from " << parameters.m_inputFileNames.size() << " input files" << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+bool ProcessHitCacheOption(const Parameters &parameters)
+{
+    if (parameters.m_hitCacheFileName.empty())
+        return true;
+
+    // The cache holds the pre-decoded space points, so it has no equivalent for the Geant4 step based formats
+    if ((parameters.m_dataFormat != Parameters::LArNDFormat::SP) && (parameters.m_dataFormat != Parameters::LArNDFormat::SPMC))
+    {
+        std::cout << "The hit cache can only be used with the SP and SPMC formats" << std::endl;
+        return false;
+    }
+
+    std::cout << "Using the hit cache " << parameters.m_hitCacheFileName << std::endl;
+
+    return true;
+}
+
+//------------------------------------------------------------------------------------------------------------------------------------------
+
 bool ProcessRecoOption(const std::string &recoOption, Parameters &parameters)
 {
     std::string chosenRecoOption(recoOption);
@@ -2130,7 +2266,7 @@ bool ProcessFormatOption(const std::string &formatOption, const std::string &inp
 
 void ProcessExternalParameters(const Parameters &parameters, const Pandora *const pPandora)
 {
-    auto *const pEventSteeringParameters = new lar_content::MasterAlgorithm::ExternalSteeringParameters;
+    auto *const pEventSteeringParameters = new lar_content::MasterThreeDAlgorithm::ExternalThreeDSteeringParameters;
     pEventSteeringParameters->m_shouldRunAllHitsCosmicReco = parameters.m_shouldRunAllHitsCosmicReco;
     pEventSteeringParameters->m_shouldRunStitching = parameters.m_shouldRunStitching;
     pEventSteeringParameters->m_shouldRunCosmicHitRemoval = parameters.m_shouldRunCosmicHitRemoval;
@@ -2139,6 +2275,7 @@ void ProcessExternalParameters(const Parameters &parameters, const Pandora *cons
     pEventSteeringParameters->m_shouldRunCosmicRecoOption = parameters.m_shouldRunCosmicRecoOption;
     pEventSteeringParameters->m_shouldPerformSliceId = parameters.m_shouldPerformSliceId;
     pEventSteeringParameters->m_printOverallRecoStatus = parameters.m_printOverallRecoStatus;
+    pEventSteeringParameters->m_nPrimaryInstances = parameters.m_nPrimaryInstances;
 
     // LArMaster or LArMasterThreeD algorithms
     if (!parameters.m_use3D)
@@ -2157,4 +2294,22 @@ void ProcessExternalParameters(const Parameters &parameters, const Pandora *cons
 #endif
 }
 
+//------------------------------------------------------------------------------------------------------------------------------------------
+
+void ProcessInstanceParameters(
+    const std::string &analysisFileName, const EventSubset &eventSubset, const Parameters &parameters, const Pandora *const pPandora)
+{
+    // The analysis follows the events the instance actually processes, as these are claimed from the shared input events in turn
+    auto *const pInstanceParameters = new lar_content::HierarchyAnalysisAlgorithm::ExternalInstanceParameters;
+    pInstanceParameters->m_pInputEvents = &eventSubset.m_processedEvents;
+    pInstanceParameters->m_analysisFileName = analysisFileName;
+
+    // Several input files are read through one chain, which the event info read by the analysis must follow
+    if (parameters.m_inputFileNames.size() > 1)
+        pInstanceParameters->m_eventFileNames = parameters.m_inputFileNames;
+
+    PANDORA_THROW_RESULT_IF(
+        STATUS_CODE_SUCCESS, !=, PandoraApi::SetExternalParameters(*pPandora, "LArHierarchyAnalysis", pInstanceParameters));
+}
+
 } // namespace lar_nd_reco
@@ -12,12 +12,6 @@
 #include "TSpline.h"
 #include "TTree.h"
 
-#include "TGeoBBox.h"
-#include "TGeoManager.h"
-#include "TGeoMatrix.h"
-#include "TGeoShape.h"
-#include "TGeoVolume.h"
-
 #include "Api/PandoraApi.h"
 #include "Geometry/LArTPC.h"
 #include "Helpers/XmlHelper.h"
@@ -40,6 +34,7 @@
 
 #include "LArNDContent.h"
 #include "LArNDGeomSimple.h"
+#include "LArNDGeometryCache.h"
 #include "LArRay.h"
 #include "PandoraOuterface.h"
 
@@ -97,89 +92,22 @@ int main(int argc, char *argv[])
 namespace lar_nd_postreco
 {
 
-void RecursiveGeometrySearch(TGeoManager *pSimGeom, const std::string &targetName, std::vector<std::vector<unsigned int>> &nodePaths,
-    std::vector<unsigned int> &currentPath)
-{
-    const std::string nodeName{pSimGeom->GetCurrentNode()->GetName()};
-    if (nodeName.find(targetName) != std::string::npos)
-    {
-        nodePaths.emplace_back(currentPath);
-    }
-    else
-    {
-        for (unsigned int i = 0; i < pSimGeom->GetCurrentNode()->GetNdaughters(); ++i)
-        {
-            pSimGeom->CdDown(i);
-            currentPath.emplace_back(i);
-            RecursiveGeometrySearch(pSimGeom, targetName, nodePaths, currentPath);
-            pSimGeom->CdUp();
-            currentPath.pop_back();
-        }
-    }
-    return;
-}
-
 void GetDetectorBounds(const ParameterStruct &parameters, std::vector<float> &anodePositions, float &xMin, float &xMax, float &yMin,
     float &yMax, float &zMin, float &zMax)
 {
-    // Heavily copies the geometry code in PandoraInterface
-    TFile *fileSource = TFile::Open(parameters.fGeoFileName.c_str(), "READ");
-    if (!fileSource)
-    {
-        std::cout << "Error in CreateGeometry(): can't open file " << parameters.fGeoFileName << std::endl;
-        return;
-    }
+    // Shares the TPC volume search, and its cache, with the geometry code in PandoraInterface
+    lar_nd_reco::LArNDGeometryCache geometryCache(parameters.fGeoFileName, parameters.fGeoManagerName, parameters.fGeoVolumeName);
 
-    TGeoManager *pSimGeom = dynamic_cast<TGeoManager *>(fileSource->Get(parameters.fGeoManagerName.c_str()));
-    if (!pSimGeom)
-    {
-        std::cout << "Could not find the geometry manager named " << parameters.fGeoManagerName << std::endl;
-        fileSource->Close();
+    if (!geometryCache.Load(parameters.fGeoCacheFileName))
         return;
-    }
 
-    // Go through the geometry and find the paths to the nodes we are interested in
-    std::vector<std::vector<unsigned int>> nodePaths; // Store the daughter indices in the path to the node
-    std::vector<unsigned int> currentPath;
-    RecursiveGeometrySearch(pSimGeom, parameters.fGeoVolumeName, nodePaths, currentPath);
+    const lar_nd_reco::LArNDTPCBoxList &tpcBoxes(geometryCache.GetTPCBoxes());
 
-    // Now we've got the Geometry, let's fill up what we need by looping through the nodes
-    std::set<float> uniqueBoundariesX;
-    for (unsigned int n = 0; n < nodePaths.size(); ++n)
+    for (unsigned int n = 0; n < tpcBoxes.size(); ++n)
     {
-        const TGeoNode *pTopNode = pSimGeom->GetCurrentNode();
-        // We have to multiply together matrices at each depth to convert local coordinates to the world volume
-        std::unique_ptr<TGeoHMatrix> pVolMatrix = std::make_unique<TGeoHMatrix>(*pTopNode->GetMatrix());
-        for (unsigned int d = 0; d < nodePaths.at(n).size(); ++d)
-        {
-            pSimGeom->CdDown(nodePaths.at(n).at(d));
-            const TGeoNode *pNode = pSimGeom->GetCurrentNode();
-            std::unique_ptr<TGeoHMatrix> pMatrix = std::make_unique<TGeoHMatrix>(*pNode->GetMatrix());
-            pVolMatrix->Multiply(pMatrix.get());
-        }
-        const TGeoNode *pTargetNode = pSimGeom->GetCurrentNode();
-
-        // This next bit comes from MakePandoraTPC in PandoraInterface with some alterations
-        // Get the BBox dimensions from the placement volume, which is assumed to be a cube
-        TGeoVolume *pCurrentVol = pTargetNode->GetVolume();
-        TGeoShape *pCurrentShape = pCurrentVol->GetShape();
-        TGeoBBox *pBox = dynamic_cast<TGeoBBox *>(pCurrentShape);
-
-        // Now can get origin/width data from the BBox
-        const double dx = pBox->GetDX(); // Note these are the half widths
-        const double dy = pBox->GetDY();
-        const double dz = pBox->GetDZ();
-        const double *pOrigin = pBox->GetOrigin();
-
-        // Translate local origin to global coordinates
-        double level1[3] = {0.0, 0.0, 0.0};
-        pTargetNode->LocalToMasterVect(pOrigin, level1);
-
-        // Get the needed geometry bits from this
-        const double *pVolTrans = pVolMatrix->GetTranslation();
-        const double centreX = (level1[0] + pVolTrans[0]);
-        const double centreY = (level1[1] + pVolTrans[1]);
-        const double centreZ = (level1[2] + pVolTrans[2]);
+        const lar_nd_reco::LArNDTPCBox &tpcBox(tpcBoxes.at(n));
+        const double centreX = tpcBox.m_centreX, centreY = tpcBox.m_centreY, centreZ = tpcBox.m_centreZ;
+        const double dx = tpcBox.m_halfWidthX, dy = tpcBox.m_halfWidthY, dz = tpcBox.m_halfWidthZ; // Note these are the half widths
 
         if (n == 0)
         {
@@ -207,36 +135,10 @@ void GetDetectorBounds(const ParameterStruct &parameters, std::vector<float> &an
             if (centreZ + dz > zMax)
                 zMax = centreZ + dz;
         }
-        uniqueBoundariesX.insert(centreX - dx);
-        uniqueBoundariesX.insert(centreX + dx);
-        // end the bit grabbed from MakeTPC
-        for (const unsigned int &daughter : nodePaths.at(n))
-        {
-            (void)daughter;
-            pSimGeom->CdUp();
-        }
-    }
-    std::cout << "Inspected " << nodePaths.size() << " TPCs" << std::endl;
-
-    // Outer x boundaries are always anodes -- start there and step inward by the appropriate amount to enumerate the anodes
-    // Structure is Anode - Cathode - Cathode - Anode
-    auto itBoundary = uniqueBoundariesX.begin();
-    while (itBoundary != uniqueBoundariesX.end())
-    {
-        // Anode
-        anodePositions.push_back(*itBoundary);
-        // Cathode
-        itBoundary++;
-        // Cathode
-        itBoundary++;
-        // Anode
-        itBoundary++;
-        anodePositions.push_back(*itBoundary);
-        // Next module
-        itBoundary++;
     }
+    std::cout << "Inspected " << tpcBoxes.size() << " TPCs" << std::endl;
 
-    fileSource->Close();
+    anodePositions = geometryCache.GetAnodePositions();
 }
 
 float LifetimeCorrectionFactor(const std::vector<float> &detAnodes, const float inputPos, const float lifetime, const float driftSpeed)
@@ -1099,119 +1001,19 @@ void ProcessPostReco(const ParameterStruct &parameters)
                         {
                             if (parameters.fPIDAlgChi2PID)
                             {
-                                // as in https://github.com/LArSoft/larana/blob/develop/larana/ParticleIdentification/Chi2PIDAlg.cxx#L90
-                                float chi2pro = 0.;
-                                float chi2ka = 0.;
-                                float chi2pi = 0.;
-                                float chi2mu = 0.;
-                                int nbins_dedx_range = parameters.templatesdEdxRR.at("proton")->GetNbinsX();
-                                int npts = 0;
-                                for (unsigned int idxCaloPt = 0; idxCaloPt < trackVecDEDX.size(); ++idxCaloPt)
-                                {
-                                    if (idxCaloPt == 0 || idxCaloPt == trackVecDEDX.size() - 1)
-                                        continue; // ignore 1st and last point
-                                    if (trackVecDEDX[idxCaloPt] > 1000.)
-                                        continue; // ignore if too high dEdx
-                                    if (trackVecDEDX[idxCaloPt] < parameters.fChi2RestrictDEDXLo)
-                                        continue; // also, optionally restrict unexpected low dE/dx. By default just requires it to be positive.
-                                    if (parameters.fChi2RestrictDX &&
-                                        (trackVecDX[idxCaloPt] < parameters.fChi2RestrictDXLo ||
-                                            (parameters.fChi2RestrictDXHi > 0. && trackVecDX[idxCaloPt] > parameters.fChi2RestrictDXHi)))
-                                    {
-                                        continue; // optionally skip this point if dx too small/large
-                                    }
-                                    int bin = parameters.templatesdEdxRR.at("proton")->FindBin(trackVecRR[idxCaloPt]);
-                                    if (bin >= 1 && bin <= nbins_dedx_range)
-                                    {
-                                        // Content
-                                        float bincpro = parameters.templatesdEdxRR.at("proton")->GetBinContent(bin);
-                                        if (bincpro < 1e-6)
-                                            bincpro = (parameters.templatesdEdxRR.at("proton")->GetBinContent(bin - 1) +
-                                                          parameters.templatesdEdxRR.at("proton")->GetBinContent(bin + 1)) /
-                                                2.;
-                                        float bincka = parameters.templatesdEdxRR.at("kaon")->GetBinContent(bin);
-                                        if (bincka < 1e-6)
-                                            bincka = (parameters.templatesdEdxRR.at("kaon")->GetBinContent(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("kaon")->GetBinContent(bin + 1)) /
-                                                2.;
-                                        float bincpi = parameters.templatesdEdxRR.at("pion")->GetBinContent(bin);
-                                        if (bincpi < 1e-6)
-                                            bincpi = (parameters.templatesdEdxRR.at("pion")->GetBinContent(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("pion")->GetBinContent(bin + 1)) /
-                                                2.;
-                                        float bincmu = parameters.templatesdEdxRR.at("muon")->GetBinContent(bin);
-                                        if (bincmu < 1e-6)
-                                            bincmu = (parameters.templatesdEdxRR.at("muon")->GetBinContent(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("muon")->GetBinContent(bin + 1)) /
-                                                2.;
-                                        // Error
-                                        float binepro = parameters.templatesdEdxRR.at("proton")->GetBinError(bin);
-                                        if (binepro < 1e-6)
-                                            binepro = (parameters.templatesdEdxRR.at("proton")->GetBinError(bin - 1) +
-                                                          parameters.templatesdEdxRR.at("proton")->GetBinError(bin + 1)) /
-                                                2.;
-                                        float bineka = parameters.templatesdEdxRR.at("kaon")->GetBinError(bin);
-                                        if (bineka < 1e-6)
-                                            bineka = (parameters.templatesdEdxRR.at("kaon")->GetBinError(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("kaon")->GetBinError(bin + 1)) /
-                                                2.;
-                                        float binepi = parameters.templatesdEdxRR.at("pion")->GetBinError(bin);
-                                        if (binepi < 1e-6)
-                                            binepi = (parameters.templatesdEdxRR.at("pion")->GetBinError(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("pion")->GetBinError(bin + 1)) /
-                                                2.;
-                                        float binemu = parameters.templatesdEdxRR.at("muon")->GetBinError(bin);
-                                        if (binemu < 1e-6)
-                                            binemu = (parameters.templatesdEdxRR.at("muon")->GetBinError(bin - 1) +
-                                                         parameters.templatesdEdxRR.at("muon")->GetBinError(bin + 1)) /
-                                                2.;
-                                        float errdedx = 0.04231 + 0.0001783 * trackVecDEDX[idxCaloPt] * trackVecDEDX[idxCaloPt];
-                                        errdedx *= trackVecDEDX[idxCaloPt];
-                                        float errdedx_square = errdedx * errdedx;
-                                        // chi2 values
-                                        float thisPointDEDX = trackVecDEDX[idxCaloPt];
-                                        if (!parameters.fApplyCalibrationFudgeFactor && parameters.fApplyCalibrationFudgeFactor_PID)
-                                            thisPointDEDX *= parameters.fCalibrationFudgeFactor;
-                                        chi2pro += std::pow(thisPointDEDX - bincpro, 2) / (binepro * binepro + errdedx_square);
-                                        chi2ka += std::pow(thisPointDEDX - bincka, 2) / (bineka * bineka + errdedx_square);
-                                        chi2pi += std::pow(thisPointDEDX - bincpi, 2) / (binepi * binepi + errdedx_square);
-                                        chi2mu += std::pow(thisPointDEDX - bincmu, 2) / (binemu * binemu + errdedx_square);
-                                        npts += 1;
-                                    } // within bins
-                                } // loop calo points
-
-                                if (npts > 0)
+                                int thisPDG(0), npts(0);
+                                float chi2mu(0.f), chi2pi(0.f), chi2ka(0.f), chi2pro(0.f);
+
+                                if (Chi2PID(
+                                        parameters, trackVecDX, trackVecDEDX, trackVecRR, thisPDG, npts, chi2mu, chi2pi, chi2ka, chi2pro))
                                 {
-                                    int thisPDG = 0;
-                                    float thisChi2 = std::numeric_limits<float>::max();
-                                    if (chi2pro / npts < thisChi2)
-                                    {
-                                        thisPDG = 2212;
-                                        thisChi2 = chi2pro / npts;
-                                    }
-                                    if (chi2ka / npts < thisChi2)
-                                    {
-                                        thisPDG = 321;
-                                        thisChi2 = chi2ka / npts;
-                                    }
-                                    if (chi2pi / npts < thisChi2)
-                                    {
-                                        thisPDG = 211;
-                                        thisChi2 = chi2pi / npts;
-                                    }
-                                    if (chi2mu / npts < thisChi2)
-                                    {
-                                        thisPDG = 13;
-                                        thisChi2 = chi2mu / npts;
-                                    }
-                                    // prediction is minimum chi2/npts
                                     filledPID = true;
                                     pid_pdg.push_back(thisPDG);
                                     pid_ndf.push_back(npts);
-                                    pid_muScore.push_back(chi2mu / npts);
-                                    pid_piScore.push_back(chi2pi / npts);
-                                    pid_kScore.push_back(chi2ka / npts);
-                                    pid_proScore.push_back(chi2pro / npts);
+                                    pid_muScore.push_back(chi2mu);
+                                    pid_piScore.push_back(chi2pi);
+                                    pid_kScore.push_back(chi2ka);
+                                    pid_proScore.push_back(chi2pro);
                                 }
                             } // use Chi2PID
                         } // getting PID
@@ -1567,7 +1369,7 @@ bool ParseCommandLine(int argc, char *argv[], ParameterStruct &parameters)
     bool hasInputFile = false;
     bool hasXmlFile = false;
 
-    while ((cOpt = getopt(argc, argv, "x:f:o:g:t:v:h")) != -1)
+    while ((cOpt = getopt(argc, argv, "x:f:o:g:G:t:v:h")) != -1)
     {
         switch (cOpt)
         {
@@ -1586,6 +1388,10 @@ bool ParseCommandLine(int argc, char *argv[], ParameterStruct &parameters)
                 parameters.fGeoFileName = optarg;
                 parameters.fGeoFileSetCmdLine = true;
                 break;
+            case 'G':
+                parameters.fGeoCacheFileName = optarg;
+                parameters.fGeoCacheSetCmdLine = true;
+                break;
             case 't':
                 parameters.fGeoManagerName = optarg;
                 parameters.fGeoManagerSetCmdLine = true;
@@ -1670,6 +1476,9 @@ bool ReadSettings(ParameterStruct &parameters)
         if (!parameters.fGeoVolumeSetCmdLine)
             PANDORA_RETURN_RESULT_IF_AND_IF(pandora::STATUS_CODE_SUCCESS, pandora::STATUS_CODE_NOT_FOUND, !=,
                 XmlHelper::ReadValue(xmlHandle, "GeoVolumeName", parameters.fGeoVolumeName));
+        if (!parameters.fGeoCacheSetCmdLine)
+            PANDORA_RETURN_RESULT_IF_AND_IF(pandora::STATUS_CODE_SUCCESS, pandora::STATUS_CODE_NOT_FOUND, !=,
+                XmlHelper::ReadValue(xmlHandle, "GeoCacheFileName", parameters.fGeoCacheFileName));
 
         PANDORA_RETURN_RESULT_IF_AND_IF(pandora::STATUS_CODE_SUCCESS, pandora::STATUS_CODE_NOT_FOUND, !=,
             XmlHelper::ReadValue(xmlHandle, "ContainDistX", parameters.ContainDistX));
@@ -1791,14 +1600,17 @@ bool ReadSettings(ParameterStruct &parameters)
 bool PrintOptions()
 {
     std::cout << std::endl
-              << "./bin/PandoraOuterface -x [path/file] -f [path/file] -o [out name] -g [geom file] -t [geom manager] -v [geom volume]"
-              << std::endl;
+              << "./bin/PandoraOuterface -x [path/file] -f [path/file] -o [out name] -g [geom file] -G [geom cache file] -t [geom manager] "
+              << "-v [geom volume]" << std::endl;
     std::cout << "    -x = mandatory, path and name of XML settings file" << std::endl;
     std::cout << "    -f = mandatory, path and name of input ROOT file" << std::endl;
     std::cout << "    -o = optional, path and name of output ROOT file." << std::endl;
     std::cout << "         Default: LArRecoND_outerface_test.root" << std::endl;
     std::cout << "    -g = 'optional' - sets geometry (ROOT) file name." << std::endl;
     std::cout << "         Default: empty. If not set here, should be specified in XML" << std::endl;
+    std::cout << "    -G = 'optional' - sets geometry cache file name, read instead of the geometry file if it matches," << std::endl;
+    std::cout << "         otherwise written." << std::endl;
+    std::cout << "         Default: empty (no cache). Can be set here or in XML" << std::endl;
     std::cout << "    -t = 'optional' - sets geometry manager name." << std::endl;
     std::cout << "         Default: Default. Can be set here or in XML" << std::endl;
     std::cout << "    -v = 'optional' - sets geometry volume name." << std::endl;